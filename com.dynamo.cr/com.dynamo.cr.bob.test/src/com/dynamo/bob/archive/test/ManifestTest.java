@@ -115,7 +115,12 @@ public class ManifestTest {
                     { "/main/level2.goc", "9" },
                     { "/main/level2.soundc", "10" },
                     { "/main/shared_go.goc", "11" },
-                    { "/main/shared_go.scriptc", "12" }
+                    { "/main/shared_go.scriptc", "12" },
+                    { "/main/main.collectionfactoryc", "13" },
+                    { "/main/spawn.collectionc", "14" },
+                    { "/main/spawn.goc", "15" },
+                    { "/main/dynamic.factoryc", "16" },
+                    { "/main/dynamic_spawn.goc", "17" }
             };
 
             return resources;
@@ -131,6 +136,12 @@ public class ManifestTest {
             +--/main/main.collectionc
                +--/main/main.goc
                |  +--/main/main.scriptc
+               |  +--/main/main.collectionfactoryc
+               |  |  +--/main/spawn.collectionc
+               |  |     +--/main/spawn.goc
+               |  |
+               |  +--/main/dynamic.factoryc (load dynamically)
+               |     +--/main/dynamic_spawn.goc
                |
                +--/main/shared_go.goc
                |
@@ -159,6 +170,13 @@ public class ManifestTest {
             ResourceNode dynamic_goc = graph.add("/main/dynamic.goc", dynamic_collectionc);
             ResourceNode shared_goc = graph.add("/main/shared_go.goc", main_collectionc);
 
+            ResourceNode main_collectionfactoryc = graph.add("/main/main.collectionfactoryc", main_goc);
+            ResourceNode spawn_collectionc = graph.add("/main/spawn.collectionc", main_collectionfactoryc);
+            graph.add("/main/spawn.goc", spawn_collectionc);
+            ResourceNode dynamic_factoryc = graph.add("/main/dynamic.factoryc", main_goc);
+            dynamic_factoryc.setType(ResourceNode.Type.DynamicFactory);
+            graph.add("/main/dynamic_spawn.goc", dynamic_factoryc);
+
             ResourceNode level1_collectionproxyc = graph.add("/main/level1.collectionproxyc", main_goc);
             ResourceNode level1_collectionc = graph.add("/main/level1.collectionc", level1_collectionproxyc);
             level1_collectionproxyc.setType(ResourceNode.Type.ExcludedCollectionProxy);
@@ -492,4 +510,41 @@ public class ManifestTest {
             }
         }
     }
+
+    private ResourceEntry findEntry(ManifestData data, String url) {
+        for (int i = 0; i < data.getResourcesCount(); ++i) {
+            ResourceEntry current = data.getResources(i);
+            if (current.getUrl().equals(url)) {
+                return current;
+            }
+        }
+        return null;
+    }
+
+    @Test
+    public void testCreateManifest_Children() throws NoSuchAlgorithmException, InvalidKeySpecException, IOException {
+        ManifestInstance instance = new ManifestInstance();
+        ManifestData data = instance.manifestData;
+
+        // Only the direct children, and only the ones that are part of the manifest (no /main/dynamic.collectionc)
+        ResourceEntry mainCollection = findEntry(data, "/main/main.collectionc");
+        assertEquals(2, mainCollection.getChildrenCount());
+        assertTrue(mainCollection.getChildrenList().contains(findEntry(data, "/main/main.goc").getUrlHash()));
+        assertTrue(mainCollection.getChildrenList().contains(findEntry(data, "/main/shared_go.goc").getUrlHash()));
+
+        ResourceEntry level1Goc = findEntry(data, "/main/level1.goc");
+        assertEquals(3, level1Goc.getChildrenCount());
+
+        // The collection of a proxy is loaded separately
+        assertEquals(0, findEntry(data, "/main/level1.collectionproxyc").getChildrenCount());
+        assertEquals(0, findEntry(data, "/main/main.scriptc").getChildrenCount());
+
+        // The prototype of a dynamically loaded factory is loaded on demand
+        assertEquals(0, findEntry(data, "/main/dynamic.factoryc").getChildrenCount());
+
+        // A collection factory loads the prototypes of the instances, not the collection
+        ResourceEntry collectionFactory = findEntry(data, "/main/main.collectionfactoryc");
+        assertEquals(1, collectionFactory.getChildrenCount());
+        assertEquals(findEntry(data, "/main/spawn.goc").getUrlHash(), (long) collectionFactory.getChildren(0));
+    }
 }
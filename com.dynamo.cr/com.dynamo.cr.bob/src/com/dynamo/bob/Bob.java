@@ -515,7 +515,7 @@ public class Bob {
         addOption(options, null, "use-vanilla-lua", false, "DEPRECATED! Use --use-uncompressed-lua-source instead.", true);
         addOption(options, null, "use-uncompressed-lua-source", false, "Use uncompressed and unencrypted Lua source code instead of byte code", true);
         addOption(options, null, "use-lua-bytecode-delta", false, "Use byte code delta compression when building for multiple architectures", true);
-        addOption(options, null, "archive-resource-padding", true, "The alignment of the resources in the game archive. Default is 4", true);
+        addOption(options, null, "archive-resource-padding", true, "The alignment of the resources in the game archive. Default is 16", true);
 
         addOption(options, "l", "liveupdate", true, "Yes if liveupdate content should be published", true);
 
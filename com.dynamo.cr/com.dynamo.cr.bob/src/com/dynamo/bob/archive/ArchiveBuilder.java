@@ -61,6 +61,11 @@ public class ArchiveBuilder {
     public static final int HASH_LENGTH = 20;
     public static final int MD5_HASH_DIGEST_BYTE_LENGTH = 16; // 128 bits
 
+    // Large entries are compressed as separate blocks, so that the runtime can decompress them
+    // in parallel, and read parts of them without decompressing the whole entry
+    public static final int COMPRESSED_BLOCK_SIZE = 256 * 1024;
+    public static final int COMPRESSED_BLOCK_MIN_COUNT = 4;
+
     private List<ArchiveEntry> entries = new ArrayList<ArchiveEntry>();
     private List<ArchiveEntry> excludedEntries = new ArrayList<ArchiveEntry>();
     private Set<String> lookup = new HashSet<String>(); // To see if a resource has already been added
@@ -69,8 +74,9 @@ public class ArchiveBuilder {
     private ManifestBuilder manifestBuilder = null;
     private LZ4Compressor lz4Compressor;
     private byte[] archiveIndexMD5 = new byte[MD5_HASH_DIGEST_BYTE_LENGTH];
-    private int resourcePadding = 4;
+    private int resourcePadding = 16;
     private boolean forceCompression = false; // for building unit tests to create test content
+    private int compressedBlockSize = COMPRESSED_BLOCK_SIZE;
 
     public ArchiveBuilder(String root, ManifestBuilder manifestBuilder, int resourcePadding) {
         this.root = new File(root).getAbsolutePath();
@@ -114,6 +120,39 @@ public class ArchiveBuilder {
         return Arrays.copyOfRange(compressedContent, 0, compressedSize);
     }
 
+    /**
+     * Compress the data as separately compressed LZ4 blocks, preceded by a block table.
+     * See dmResourceArchive::DecompressBlocks() for the format.
+     */
+    public byte[] compressResourceDataBlocks(byte[] buffer, int blockSize) {
+        int blockCount = (buffer.length + blockSize - 1) / blockSize;
+        int tableSize = 8 + 4 * blockCount;
+        byte[] compressedContent = new byte[tableSize + lz4Compressor.maxCompressedLength(blockSize) * blockCount];
+        ByteBuffer table = ByteBuffer.wrap(compressedContent, 0, tableSize); // big endian
+        table.putInt(blockSize);
+        table.putInt(blockCount);
+        int offset = tableSize;
+        for (int i = 0; i < blockCount; ++i) {
+            int start = i * blockSize;
+            int length = Math.min(blockSize, buffer.length - start);
+            offset += lz4Compressor.compress(buffer, start, length, compressedContent, offset, compressedContent.length - offset);
+            table.putInt(offset - tableSize);
+        }
+        return Arrays.copyOfRange(compressedContent, 0, offset);
+    }
+
+    public boolean shouldUseCompressedBlocks(byte[] buffer) {
+        return buffer.length > compressedBlockSize * COMPRESSED_BLOCK_MIN_COUNT;
+    }
+
+    public void setCompressedBlockSize(int compressedBlockSize) {
+        this.compressedBlockSize = compressedBlockSize;
+    }
+
+    public int getCompressedBlockSize() {
+        return compressedBlockSize;
+    }
+
     public void setForceCompression(boolean forceCompression) {
         this.forceCompression = forceCompression;
     }
@@ -186,12 +225,16 @@ public class ArchiveBuilder {
             if (entry.isCompressed()) {
                 TimeProfiler.start("Compresss");
                 // Compress data
-                byte[] compressed = this.compressResourceData(buffer);
+                boolean useBlocks = this.shouldUseCompressedBlocks(buffer);
+                byte[] compressed = useBlocks ? this.compressResourceDataBlocks(buffer, compressedBlockSize) : this.compressResourceData(buffer);
                 if (this.shouldUseCompressedResourceData(buffer, compressed)) {
                     // Note, when forced, the compressed size may be larger than the original size (For unit tests)
                     buffer = compressed;
                     entry.setCompressedSize(compressed.length);
                     entry.setFlag(ArchiveEntry.FLAG_COMPRESSED);
+                    if (useBlocks) {
+                        entry.setFlag(ArchiveEntry.FLAG_COMPRESSED_BLOCKS);
+                    }
                     resourceEntryFlags |= ResourceEntryFlag.COMPRESSED.getNumber();
                 } else {
                     entry.setCompressedSize(ArchiveEntry.FLAG_UNCOMPRESSED);
@@ -311,12 +354,13 @@ public class ArchiveBuilder {
     }
 
     private static void printUsageAndTerminate(String message) {
-        System.err.println("Usage: ArchiveBuilder <root> <output> [-c] <file> [<file> ...]\n");
+        System.err.println("Usage: ArchiveBuilder <root> <output> [-c] [-b <block size>] <file> [<file> ...]\n");
         System.err.println("  <root>            - directorypath to root of input files (<file>)");
         System.err.println("  <output>          - filepath for output content.");
         System.err.println("                      Three files (arci, arcd, dmanifest) will be generated.");
         System.err.println("  <file>            - filepath relative to <root> of file to build.");
         System.err.println("  -c                - Compress archive (default false).");
+        System.err.println("  -b <block size>   - Compress entries larger than " + COMPRESSED_BLOCK_MIN_COUNT + " blocks as separate blocks (default " + COMPRESSED_BLOCK_SIZE + ").");
         if (message != null) {
             System.err.println("\nError: " + message);
         }
@@ -346,10 +390,19 @@ public class ArchiveBuilder {
 
         boolean doCompress = false;
         boolean doOutputManifestHashFile = false;
+        int compressedBlockSize = COMPRESSED_BLOCK_SIZE;
         List<File> inputs = new ArrayList<File>();
         for (int i = 2; i < args.length; ++i) {
             if (args[i].equals("-c")) {
                 doCompress = true;
+            } else if (args[i].equals("-b")) {
+                if (++i >= args.length) {
+                    printUsageAndTerminate("Missing block size");
+                }
+                compressedBlockSize = Integer.parseInt(args[i]);
+                if (compressedBlockSize <= 0) {
+                    printUsageAndTerminate("Invalid block size: " + args[i]);
+                }
             } else if (args[i].equals("-m")) {
                 doOutputManifestHashFile = true;
             } else {
@@ -391,8 +444,9 @@ public class ArchiveBuilder {
 
         int archivedEntries = 0;
         String dirpathRootString = dirpathRoot.toString();
-        ArchiveBuilder archiveBuilder = new ArchiveBuilder(dirpathRoot.toString(), manifestBuilder, 4);
+        ArchiveBuilder archiveBuilder = new ArchiveBuilder(dirpathRoot.toString(), manifestBuilder, 16);
         archiveBuilder.setForceCompression(doCompress);
+        archiveBuilder.setCompressedBlockSize(compressedBlockSize);
         for (File currentInput : inputs) {
             String absolutePath = currentInput.getAbsolutePath();
             boolean encrypt = ( absolutePath.endsWith("luac") ||
@@ -31,10 +31,12 @@ import java.security.PublicKey;
 import java.security.spec.InvalidKeySpecException;
 import java.security.spec.PKCS8EncodedKeySpec;
 import java.security.spec.X509EncodedKeySpec;
+import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Comparator;
 import java.util.HashMap;
 import java.util.HashSet;
+import java.util.List;
 import java.util.Set;
 import java.util.TreeSet;
 
@@ -503,11 +505,10 @@ public class ManifestBuilder {
             String url = entry.getUrl();
             ResourceEntry.Builder resourceEntryBuilder = entry.toBuilder();
 
-            // Since we'll only ever ask collection proxies, we only store those lists
-            ResourceNode proxyNode = resourceGraph.getResourceNodeFromPath(url);
-            // We'll only store the dependencies for the excluded collection proxies
-            if (proxyNode != null && proxyNode.checkType(ResourceNode.Type.ExcludedCollectionProxy)) {
-                HashSet<ResourceNode> allProxyDependants = this.getAllDependants(proxyNode);
+            ResourceNode resourceNode = resourceGraph.getResourceNodeFromPath(url);
+            // Since we'll only ever ask collection proxies, we only store the dependencies for the excluded collection proxies
+            if (resourceNode != null && resourceNode.checkType(ResourceNode.Type.ExcludedCollectionProxy)) {
+                HashSet<ResourceNode> allProxyDependants = this.getAllDependants(resourceNode);
                 for (ResourceNode dependant : allProxyDependants) {
                     // Exclude resources referenced from the main bundle
                     if (dependant.isInMainBundle()) {
@@ -521,6 +522,30 @@ public class ManifestBuilder {
                 }
             }
 
+            // The direct children let the engine preloader issue the loads of a whole tree up front.
+            // Only what the engine resource types would load with their parent is a child: the collection of a proxy
+            // and the prototype of a dynamically loaded factory are loaded separately, and a collection factory
+            // loads the prototypes of its instances rather than its collection.
+            if (resourceNode != null && !resourceNode.checkType(ResourceNode.Type.CollectionProxy) && !resourceNode.checkType(ResourceNode.Type.DynamicFactory)) {
+                List<ResourceNode> childNodes = resourceNode.getChildren();
+                if (resourceNode.checkType(ResourceNode.Type.CollectionFactory)) {
+                    childNodes = new ArrayList<>();
+                    for (ResourceNode collection : resourceNode.getChildren()) {
+                        childNodes.addAll(collection.getChildren());
+                    }
+                }
+                HashSet<Long> children = new HashSet<>();
+                for (ResourceNode child : childNodes) {
+                    ResourceEntry resource = urlToResource.get(child.getPath());
+                    if (resource == null) {
+                        continue;
+                    }
+                    if (children.add(resource.getUrlHash())) {
+                        resourceEntryBuilder.addChildren(resource.getUrlHash());
+                    }
+                }
+            }
+
             builder.addResources(resourceEntryBuilder.build());
         }
 
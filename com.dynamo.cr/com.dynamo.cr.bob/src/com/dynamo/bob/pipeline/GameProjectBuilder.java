@@ -198,7 +198,7 @@ public class GameProjectBuilder extends Builder<Void> {
     }
 
     private int getResourcePadding() throws CompileExceptionError {
-        int resourcePadding = 4;
+        int resourcePadding = 16; // Lets the engine create resources directly from the archive data (see RESOURCE_VIEW_ALIGNMENT)
         String resourcePaddingStr = project.option("archive-resource-padding", null);
         if (resourcePaddingStr != null) {
             // It's already verified by bob, but we have to still parse it again
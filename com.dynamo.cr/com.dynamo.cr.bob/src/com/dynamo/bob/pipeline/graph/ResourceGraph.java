@@ -40,7 +40,9 @@ import com.dynamo.bob.CompileExceptionError;
 import com.dynamo.bob.fs.IResource;
 import com.dynamo.bob.pipeline.graph.ResourceWalker;
 import com.dynamo.bob.pipeline.graph.ResourceWalker.IResourceVisitor;
+import com.dynamo.gamesys.proto.GameSystem.CollectionFactoryDesc;
 import com.dynamo.gamesys.proto.GameSystem.CollectionProxyDesc;
+import com.dynamo.gamesys.proto.GameSystem.FactoryDesc;
 
 import com.google.protobuf.Message;
 
@@ -111,6 +113,20 @@ public class ResourceGraph implements IResourceVisitor {
                 collectionProxyNode.setType(ResourceNode.Type.CollectionProxy);
             }
         }
+        else if (message instanceof FactoryDesc) {
+            if (((FactoryDesc)message).getLoadDynamically()) {
+                resourceToNodeLookup.get(resource).setType(ResourceNode.Type.DynamicFactory);
+            }
+        }
+        else if (message instanceof CollectionFactoryDesc) {
+            ResourceNode collectionFactoryNode = resourceToNodeLookup.get(resource);
+            if (((CollectionFactoryDesc)message).getLoadDynamically()) {
+                collectionFactoryNode.setType(ResourceNode.Type.DynamicFactory);
+            }
+            else {
+                collectionFactoryNode.setType(ResourceNode.Type.CollectionFactory);
+            }
+        }
     }
 
     @Override
@@ -140,6 +156,9 @@ public class ResourceGraph implements IResourceVisitor {
             if (currentResource.getPath().endsWith("collectionproxyc")) {
                 currentNode.setType(ResourceNode.Type.CollectionProxy);
             }
+            else if (currentResource.getPath().endsWith("collectionfactoryc")) {
+                currentNode.setType(ResourceNode.Type.CollectionFactory);
+            }
         }
         parentNode.addChild(currentNode);
         return currentNode;
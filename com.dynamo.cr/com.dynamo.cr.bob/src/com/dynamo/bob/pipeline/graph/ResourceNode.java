@@ -24,7 +24,10 @@ public class ResourceNode {
     public enum Type {
         None,
         CollectionProxy,
-        ExcludedCollectionProxy
+        ExcludedCollectionProxy,
+        CollectionFactory,
+        // A factory or collection factory with load_dynamically set, its prototype is loaded on demand
+        DynamicFactory
     }
 
     private String relativeFilepath;
@@ -299,6 +299,19 @@ namespace dmSys
      */
     Result LoadResource(const char* path, void* buffer, uint32_t buffer_size, uint32_t* resource_size);
 
+    /**
+     * Load part of a resource. That path supplied should
+     * be prepended by the path returned from GetResourcesPath()
+     * @note LoadResourcePartial can only operate on local filesystem
+     * @param path path
+     * @param offset offset in bytes into the resource
+     * @param size number of bytes to read
+     * @param buffer buffer, at least size bytes
+     * @param nread number of bytes read. Less than size at the end of the resource
+     * @return RESULT_OK on success. RESULT_NOENT if the file doesn't exists or isn't a regular file.
+     */
+    Result LoadResourcePartial(const char* path, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread);
+
     /**
      * Open URL in default application
      * @param url url to open
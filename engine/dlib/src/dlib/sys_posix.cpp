@@ -955,6 +955,52 @@ namespace dmSys
     }
 
 
+    Result LoadResourcePartial(const char* path, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+    {
+        *nread = 0;
+#ifdef __ANDROID__
+        const char* asset_path = FixAndroidResourcePath(path);
+
+        AAssetManager* am = g_AndroidApp->activity->assetManager;
+        AAsset* asset = AAssetManager_open(am, asset_path, AASSET_MODE_RANDOM);
+        if (asset) {
+            int r = 0;
+            if (AAsset_seek(asset, offset, SEEK_SET) >= 0) {
+                r = AAsset_read(asset, buffer, size);
+            }
+            AAsset_close(asset);
+            if (r < 0) {
+                return RESULT_IO;
+            }
+            *nread = (uint32_t) r;
+            return RESULT_OK;
+        }
+#endif
+        struct stat file_stat;
+        if (stat(path, &file_stat) == 0) {
+            if (!S_ISREG(file_stat.st_mode)) {
+                return RESULT_NOENT;
+            }
+            if (offset >= (uint32_t) file_stat.st_size) {
+                return RESULT_OK;
+            }
+            FILE* f = fopen(path, "rb");
+            if (!f) {
+                return ErrnoToResult(errno);
+            }
+            fseek(f, offset, SEEK_SET);
+            *nread = (uint32_t) fread(buffer, 1, size, f);
+            int error = ferror(f);
+            fclose(f);
+            if (error) {
+                return RESULT_IO;
+            }
+            return RESULT_OK;
+        } else {
+            return ErrnoToResult(errno);
+        }
+    }
+
     Result Rmdir(const char* path)
     {
         int ret = rmdir(path);
@@ -101,6 +101,15 @@ extern "C" {
 DM_PROPERTY_EXTERN(rmtp_Script);
 DM_PROPERTY_U32(rmtp_LuaMem, 0, FrameReset, "kb", &rmtp_Script); // kilo bytes
 DM_PROPERTY_U32(rmtp_LuaRefs, 0, FrameReset, "# Lua references", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaGOAllocations, 0, FrameReset, "# lua allocations / frame in the game object (or shared) state", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaGOMemory, 0, FrameReset, "kb", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaGOPeakMemory, 0, FrameReset, "kb", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaGuiAllocations, 0, FrameReset, "# lua allocations / frame in the gui state", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaGuiMemory, 0, FrameReset, "kb", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaGuiPeakMemory, 0, FrameReset, "kb", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaRenderAllocations, 0, FrameReset, "# lua allocations / frame in the render state", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaRenderMemory, 0, FrameReset, "kb", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaRenderPeakMemory, 0, FrameReset, "kb", &rmtp_Script);
 
 namespace dmEngine
 {
@@ -232,6 +241,7 @@ namespace dmEngine
     , m_GOScriptContext(0x0)
     , m_RenderScriptContext(0x0)
     , m_GuiScriptContext(0x0)
+    , m_BytecodeCache(0x0)
     , m_Factory(0x0)
     , m_SystemSocket(0x0)
     , m_SystemFontMap(0x0)
@@ -282,8 +292,12 @@ namespace dmEngine
 
         dmHttpClient::ShutdownConnectionPool();
 
+        dmGameSystem::FinalizeTextureStreaming();
+
         // Reregister the types before the rest of the contexts are deleted
         if (engine->m_Factory) {
+            // The cached resources need their type contexts to be destroyed
+            dmResource::SetCacheBudget(engine->m_Factory, 0, 0);
             dmResource::DeregisterTypes(engine->m_Factory, &engine->m_ResourceTypeContexts);
         }
 
@@ -344,6 +358,12 @@ namespace dmEngine
             }
         }
 
+        if (engine->m_BytecodeCache)
+        {
+            dmScript::SaveBytecodeCache(engine->m_BytecodeCache);
+            dmScript::DeleteBytecodeCache(engine->m_BytecodeCache);
+        }
+
         if (engine->m_Factory)
         {
             dmResource::DeleteFactory(engine->m_Factory);
@@ -565,6 +585,12 @@ namespace dmEngine
         }
     }
 
+    // Milliseconds per frame in the config, microseconds for the script context
+    static uint32_t GetGCBudget(dmConfigFile::HConfig config, const char* key)
+    {
+        return (uint32_t)(dmMath::Max(0.0f, dmConfigFile::GetFloat(config, key, 0.0f)) * 1000.0f);
+    }
+
     static dmPlatform::PlatformGraphicsApi AdapterFamilyToGraphicsAPI(dmGraphics::AdapterFamily family)
     {
         switch(family)
@@ -932,6 +958,12 @@ namespace dmEngine
         dmResource::NewFactoryParams params;
         params.m_MaxResources = max_resources;
         params.m_Flags = 0;
+        params.m_LoaderThreadCount = dmConfigFile::GetInt(engine->m_Config, dmResource::LOADER_THREADS_KEY, params.m_LoaderThreadCount);
+        params.m_LoaderQueueSlots = dmConfigFile::GetInt(engine->m_Config, dmResource::LOADER_QUEUE_SLOTS_KEY, params.m_LoaderQueueSlots);
+        params.m_LoaderMaxPendingData = dmConfigFile::GetInt(engine->m_Config, dmResource::LOADER_MAX_PENDING_DATA_KEY, params.m_LoaderMaxPendingData);
+        params.m_JobThread = engine->m_JobThreadContext;
+        params.m_CreateBudget = (uint32_t)(dmConfigFile::GetFloat(engine->m_Config, dmResource::CREATE_BUDGET_KEY, 0.0f) * 1000.0f);
+        params.m_CacheSize = dmConfigFile::GetInt(engine->m_Config, dmResource::CACHE_SIZE_KEY, params.m_CacheSize);
 
         if (dLib::IsDebugMode())
         {
@@ -977,6 +1009,7 @@ namespace dmEngine
             engine->m_GOScriptContext = engine->m_SharedScriptContext;
             engine->m_RenderScriptContext = engine->m_SharedScriptContext;
             engine->m_GuiScriptContext = engine->m_SharedScriptContext;
+            dmScript::SetGCBudget(engine->m_SharedScriptContext, GetGCBudget(engine->m_Config, dmScript::GC_BUDGET_GO_KEY));
             module_script_contexts.SetCapacity(1);
             module_script_contexts.Push(engine->m_SharedScriptContext);
         } else {
@@ -986,12 +1019,34 @@ namespace dmEngine
             dmScript::Initialize(engine->m_RenderScriptContext);
             engine->m_GuiScriptContext = dmScript::NewContext(engine->m_Config, engine->m_Factory, true);
             dmScript::Initialize(engine->m_GuiScriptContext);
+            dmScript::SetGCBudget(engine->m_GOScriptContext, GetGCBudget(engine->m_Config, dmScript::GC_BUDGET_GO_KEY));
+            dmScript::SetGCBudget(engine->m_RenderScriptContext, GetGCBudget(engine->m_Config, dmScript::GC_BUDGET_RENDER_KEY));
+            dmScript::SetGCBudget(engine->m_GuiScriptContext, GetGCBudget(engine->m_Config, dmScript::GC_BUDGET_GUI_KEY));
             module_script_contexts.SetCapacity(3);
             module_script_contexts.Push(engine->m_GOScriptContext);
             module_script_contexts.Push(engine->m_RenderScriptContext);
             module_script_contexts.Push(engine->m_GuiScriptContext);
         }
 
+        if (dmConfigFile::GetInt(engine->m_Config, "script.bytecode_cache", 0))
+        {
+            char application_support_path[DMPATH_MAX_PATH];
+            const char* application_name = dmConfigFile::GetString(engine->m_Config, "project.title_as_file_name", "defold");
+            if (dmSys::GetApplicationSupportPath(application_name, application_support_path, sizeof(application_support_path)) == dmSys::RESULT_OK)
+            {
+                char bytecode_cache_path[DMPATH_MAX_PATH];
+                dmPath::Concat(application_support_path, "bytecode.cache", bytecode_cache_path, sizeof(bytecode_cache_path));
+                engine->m_BytecodeCache = dmScript::NewBytecodeCache(bytecode_cache_path, dmEngineVersion::VERSION_SHA1);
+            }
+        }
+
+        bool lazy_modules = dmConfigFile::GetInt(engine->m_Config, "script.lazy_modules", 0) != 0;
+        for (uint32_t i = 0; i < module_script_contexts.Size(); ++i)
+        {
+            dmScript::SetLazyModules(module_script_contexts[i], lazy_modules);
+            dmScript::SetBytecodeCache(module_script_contexts[i], engine->m_BytecodeCache);
+        }
+
         dmSound::InitializeParams sound_params;
         sound_params.m_OutputDevice = "default";
 #if defined(__EMSCRIPTEN__)
@@ -1115,6 +1170,19 @@ namespace dmEngine
         }
         physics_params.m_ContactImpulseLimit = dmConfigFile::GetFloat(engine->m_Config, "physics.contact_impulse_limit", 0.0f);
         physics_params.m_AllowDynamicTransforms = dmConfigFile::GetInt(engine->m_Config, "physics.allow_dynamic_transforms", 1) ? 1 : 0;
+        const char* broadphase_3d = dmConfigFile::GetString(engine->m_Config, "physics.broadphase_3d", "axis_sweep");
+        if (dmStrCaseCmp(broadphase_3d, "dbvt") == 0)
+        {
+            physics_params.m_Broadphase3D = dmPhysics::BROADPHASE_3D_DBVT;
+        }
+        else if (dmStrCaseCmp(broadphase_3d, "axis_sweep") != 0)
+        {
+            dmLogWarning("Unsupported 3D physics broadphase '%s'. Defaults to axis_sweep", broadphase_3d);
+        }
+        if (dmConfigFile::GetInt(engine->m_Config, "physics.multithreaded_3d", 0))
+        {
+            physics_params.m_JobThread = engine->m_JobThreadContext;
+        }
         if (dmStrCaseCmp(physics_type, "3D") == 0)
         {
             engine->m_PhysicsContext.m_3D = true;
@@ -1218,6 +1286,16 @@ namespace dmEngine
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
+        {
+            dmGameSystem::TextureStreamingParams texture_streaming_params;
+            texture_streaming_params.m_Factory         = engine->m_Factory;
+            texture_streaming_params.m_GraphicsContext = engine->m_GraphicsContext;
+            texture_streaming_params.m_JobThread       = engine->m_JobThreadContext;
+            texture_streaming_params.m_MipMaps         = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::TEXTURE_STREAM_MIPMAPS_KEY, 0);
+            texture_streaming_params.m_MemoryBudget    = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::TEXTURE_STREAM_BUDGET_KEY, 0) * 1024*1024; // MB -> bytes
+            dmGameSystem::InitializeTextureStreaming(texture_streaming_params);
+        }
+
         go_result = dmGameSystem::RegisterComponentTypes(engine->m_Factory, engine->m_Register, engine->m_RenderContext, &engine->m_PhysicsContext, &engine->m_ParticleFXContext, &engine->m_SpriteContext,
                                                                                                 &engine->m_CollectionProxyContext, &engine->m_FactoryContext, &engine->m_CollectionFactoryContext,
                                                                                                 &engine->m_ModelContext, &engine->m_LabelContext, &engine->m_TilemapContext,
@@ -1337,6 +1415,12 @@ namespace dmEngine
             goto bail;
         dmGameObject::Init(engine->m_MainCollection);
 
+        // Store the chunks compiled while loading the main collection, so the next launch skips parsing them
+        if (engine->m_BytecodeCache)
+        {
+            dmScript::SaveBytecodeCache(engine->m_BytecodeCache);
+        }
+
         engine->m_LastReloadMTime = 0;
 
 #if defined(__NX__)
@@ -1508,6 +1592,36 @@ bail:
         return memcount;
     }
 
+    // The allocator statistics are reported per Lua state, since the peaks of different states don't add up
+    static void UpdateLuaAllocatorProperties(HEngine engine)
+    {
+        dmScript::LuaAllocatorStats stats;
+        if (dmScript::GetLuaAllocatorStats(engine->m_GOScriptContext, &stats))
+        {
+            DM_PROPERTY_SET_U32(rmtp_LuaGOAllocations, stats.m_AllocationCount);
+            DM_PROPERTY_SET_U32(rmtp_LuaGOMemory, (uint32_t)(stats.m_Bytes / 1024));
+            DM_PROPERTY_SET_U32(rmtp_LuaGOPeakMemory, (uint32_t)(stats.m_PeakBytes / 1024));
+            dmScript::ResetLuaAllocatorCounters(engine->m_GOScriptContext);
+        }
+        if (engine->m_SharedScriptContext)
+            return;
+
+        if (dmScript::GetLuaAllocatorStats(engine->m_GuiScriptContext, &stats))
+        {
+            DM_PROPERTY_SET_U32(rmtp_LuaGuiAllocations, stats.m_AllocationCount);
+            DM_PROPERTY_SET_U32(rmtp_LuaGuiMemory, (uint32_t)(stats.m_Bytes / 1024));
+            DM_PROPERTY_SET_U32(rmtp_LuaGuiPeakMemory, (uint32_t)(stats.m_PeakBytes / 1024));
+            dmScript::ResetLuaAllocatorCounters(engine->m_GuiScriptContext);
+        }
+        if (dmScript::GetLuaAllocatorStats(engine->m_RenderScriptContext, &stats))
+        {
+            DM_PROPERTY_SET_U32(rmtp_LuaRenderAllocations, stats.m_AllocationCount);
+            DM_PROPERTY_SET_U32(rmtp_LuaRenderMemory, (uint32_t)(stats.m_Bytes / 1024));
+            DM_PROPERTY_SET_U32(rmtp_LuaRenderPeakMemory, (uint32_t)(stats.m_PeakBytes / 1024));
+            dmScript::ResetLuaAllocatorCounters(engine->m_RenderScriptContext);
+        }
+    }
+
     static void StepFrame(HEngine engine, float dt)
     {
         dmProfiler::SetUpdateFrequency((uint32_t)(1.0f / dt));
@@ -1570,6 +1684,7 @@ bail:
                 }
 
                 dmJobThread::Update(engine->m_JobThreadContext);
+                dmGameSystem::UpdateTextureStreaming();
 
                 {
                     DM_PROFILE("Script");
@@ -1710,6 +1825,7 @@ bail:
 
             DM_PROPERTY_SET_U32(rmtp_LuaRefs, dmScript::GetLuaRefCount());
             DM_PROPERTY_SET_U32(rmtp_LuaMem, GetLuaMemCount(engine));
+            UpdateLuaAllocatorProperties(engine);
 
             if (dLib::IsDebugMode())
             {
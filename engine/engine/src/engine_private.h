@@ -130,6 +130,7 @@ namespace dmEngine
         dmScript::HContext                          m_GOScriptContext;
         dmScript::HContext                          m_RenderScriptContext;
         dmScript::HContext                          m_GuiScriptContext;
+        dmScript::HBytecodeCache                    m_BytecodeCache;
         dmResource::HFactory                        m_Factory;
         dmGui::HContext                             m_GuiContext;
         dmMessage::HSocket                          m_SystemSocket;
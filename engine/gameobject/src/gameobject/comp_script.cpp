@@ -242,8 +242,8 @@ namespace dmGameObject
             }
         }
 
-        // TODO: Find out if the scripts actually sent any transform events
-        update_result.m_TransformsUpdated = true;
+        // Transform writes from the scripts (go.set_position, go.set_parent etc) mark the collection transforms
+        // as dirty in the game object API, so update_result.m_TransformsUpdated is left untouched
 
         assert(top == lua_gettop(L));
         return result;
@@ -320,10 +320,7 @@ namespace dmGameObject
                 // Try to find the message name via id and reverse hash
                 message_name = (const char*)dmHashReverse64(message->m_Id, 0);
             }
-            if (message->m_DataSize > 0)
-                dmScript::PushTable(L, (const char*)message->m_Data, message->m_DataSize);
-            else
-                lua_newtable(L);
+            dmScript::PushMessageTable(L, message);
         }
 
         dmScript::PushURL(L, message->m_Sender);
@@ -51,6 +51,10 @@ namespace dmGameObject
 
     static Prototype EMPTY_PROTOTYPE;
 
+    // Counter for Instance::m_Generation. It's shared by all collections, so that a new collection allocated at the
+    // address of a deleted one doesn't hand out the same generations again.
+    static uint32_t g_InstanceGeneration = 0;
+
     static void Unlink(Collection* collection, Instance* instance);
 
 #define PROP_FLOAT(var_name, prop_name)\
@@ -753,6 +757,7 @@ namespace dmGameObject
         instance->m_ScaleAlongZ = collection->m_ScaleAlongZ;
         uint16_t instance_index = collection->m_InstanceIndices.Pop();
         instance->m_Index = instance_index;
+        instance->m_Generation = ++g_InstanceGeneration;
         assert(collection->m_Instances[instance_index] == 0);
         collection->m_Instances[instance_index] = instance;
 
@@ -1256,8 +1261,20 @@ namespace dmGameObject
         }
     }
 
+    // Local transform writes are flushed to the world transforms by the next UpdateTransforms
+    static inline void SetDirtyTransforms(HInstance instance)
+    {
+        instance->m_Collection->m_DirtyTransforms = 1;
+    }
+
     static void ReparentChildNodes(Collection* collection, HInstance instance)
     {
+        // The world transforms of the children are now relative to the new parent
+        if (instance->m_FirstChildIndex != INVALID_INSTANCE_INDEX)
+        {
+            SetDirtyTransforms(instance);
+        }
+
         // Reparent child nodes
         uint32_t index = instance->m_FirstChildIndex;
         while (index != INVALID_INSTANCE_INDEX)
@@ -2136,6 +2153,7 @@ namespace dmGameObject
 
     uint32_t SetBoneTransforms(HInstance instance, dmTransform::Transform& component_transform, dmTransform::Transform* transforms, uint32_t transform_count)
     {
+        SetDirtyTransforms(instance);
         return DoSetBoneTransforms(instance->m_Collection->m_HCollection, &component_transform, instance->m_Index, transforms, transform_count);
     }
 
@@ -2969,6 +2987,7 @@ namespace dmGameObject
 
     void SetPosition(HInstance instance, Point3 position)
     {
+        SetDirtyTransforms(instance);
         instance->m_Transform.SetTranslation(Vector3(position));
     }
 
@@ -2979,6 +2998,7 @@ namespace dmGameObject
 
     void SetRotation(HInstance instance, Quat rotation)
     {
+        SetDirtyTransforms(instance);
         instance->m_Transform.SetRotation(rotation);
     }
 
@@ -2989,11 +3009,13 @@ namespace dmGameObject
 
     void SetScale(HInstance instance, float scale)
     {
+        SetDirtyTransforms(instance);
         instance->m_Transform.SetUniformScale(scale);
     }
 
     void SetScale(HInstance instance, Vector3 scale)
     {
+        SetDirtyTransforms(instance);
         instance->m_Transform.SetScale(scale);
     }
 
@@ -3082,6 +3104,8 @@ namespace dmGameObject
             assert(collection->m_LevelIndices[0].Size() < collection->m_MaxInstances);
         }
 
+        SetDirtyTransforms(child);
+
         if (child->m_Parent != INVALID_INSTANCE_INDEX)
         {
             Unlink(collection, child);
@@ -3371,41 +3395,7 @@ namespace dmGameObject
             uint16_t component_index;
             if (RESULT_OK == GetComponentIndex(instance, component_id, &component_index))
             {
-                Prototype::Component* components = instance->m_Prototype->m_Components;
-                Prototype::Component& component = components[component_index];
-                ComponentType* type = component.m_Type;
-                if (type->m_GetPropertyFunction)
-                {
-                    uintptr_t* user_data = 0;
-                    if (type->m_InstanceHasUserData)
-                    {
-                        uint32_t next_component_instance_data = 0;
-                        for (uint32_t i = 0; i < component_index; ++i)
-                        {
-                            if (components[i].m_Type->m_InstanceHasUserData)
-                                ++next_component_instance_data;
-                        }
-                        user_data = &instance->m_ComponentInstanceUserData[next_component_instance_data];
-                    }
-                    ComponentGetPropertyParams p;
-                    p.m_Context = type->m_Context;
-                    p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
-                    p.m_Instance = instance;
-                    p.m_PropertyId = property_id;
-                    p.m_Options = options;
-                    p.m_UserData = user_data;
-                    PropertyDesc prop_desc;
-                    PropertyResult result = type->m_GetPropertyFunction(p, prop_desc);
-                    if (result == PROPERTY_RESULT_OK)
-                    {
-                        out_value = prop_desc;
-                    }
-                    return result;
-                }
-                else
-                {
-                    return PROPERTY_RESULT_NOT_FOUND;
-                }
+                return GetComponentProperty(instance, component_index, GetComponentUserDataIndex(instance, component_index), property_id, options, out_value);
             }
             else
             {
@@ -3414,12 +3404,52 @@ namespace dmGameObject
         }
     }
 
+    uint16_t GetComponentUserDataIndex(HInstance instance, uint16_t component_index)
+    {
+        Prototype::Component* components = instance->m_Prototype->m_Components;
+        if (!components[component_index].m_Type->m_InstanceHasUserData)
+            return INVALID_USER_DATA_INDEX;
+
+        uint16_t next_component_instance_data = 0;
+        for (uint32_t i = 0; i < component_index; ++i)
+        {
+            if (components[i].m_Type->m_InstanceHasUserData)
+                ++next_component_instance_data;
+        }
+        return next_component_instance_data;
+    }
+
+    PropertyResult GetComponentProperty(HInstance instance, uint16_t component_index, uint16_t user_data_index, dmhash_t property_id, PropertyOptions options, PropertyDesc& out_value)
+    {
+        Prototype::Component& component = instance->m_Prototype->m_Components[component_index];
+        ComponentType* type = component.m_Type;
+        if (!type->m_GetPropertyFunction)
+            return PROPERTY_RESULT_NOT_FOUND;
+
+        ComponentGetPropertyParams p;
+        p.m_Context = type->m_Context;
+        p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
+        p.m_Instance = instance;
+        p.m_PropertyId = property_id;
+        p.m_Options = options;
+        p.m_UserData = user_data_index != INVALID_USER_DATA_INDEX ? &instance->m_ComponentInstanceUserData[user_data_index] : 0;
+        PropertyDesc prop_desc;
+        PropertyResult result = type->m_GetPropertyFunction(p, prop_desc);
+        if (result == PROPERTY_RESULT_OK)
+        {
+            out_value = prop_desc;
+        }
+        return result;
+    }
+
     PropertyResult SetProperty(HInstance instance, dmhash_t component_id, dmhash_t property_id, PropertyOptions options, const PropertyVar& value)
     {
         if (instance == 0)
             return PROPERTY_RESULT_INVALID_INSTANCE;
         if (component_id == 0)
         {
+            // All the instance properties are transform properties
+            SetDirtyTransforms(instance);
             float* position = instance->m_Transform.GetPositionPtr();
             float* rotation = instance->m_Transform.GetRotationPtr();
             float* scale = instance->m_Transform.GetScalePtr();
@@ -3572,36 +3602,7 @@ namespace dmGameObject
             uint16_t component_index;
             if (RESULT_OK == GetComponentIndex(instance, component_id, &component_index))
             {
-                Prototype::Component* components = instance->m_Prototype->m_Components;
-                Prototype::Component& component = components[component_index];
-                ComponentType* type = component.m_Type;
-                if (type->m_SetPropertyFunction)
-                {
-                    uintptr_t* user_data = 0;
-                    if (type->m_InstanceHasUserData)
-                    {
-                        uint32_t next_component_instance_data = 0;
-                        for (uint32_t i = 0; i < component_index; ++i)
-                        {
-                            if (components[i].m_Type->m_InstanceHasUserData)
-                                ++next_component_instance_data;
-                        }
-                        user_data = &instance->m_ComponentInstanceUserData[next_component_instance_data];
-                    }
-                    ComponentSetPropertyParams p;
-                    p.m_Context = type->m_Context;
-                    p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
-                    p.m_Instance = instance;
-                    p.m_PropertyId = property_id;
-                    p.m_UserData = user_data;
-                    p.m_Value = value;
-                    p.m_Options = options;
-                    return type->m_SetPropertyFunction(p);
-                }
-                else
-                {
-                    return PROPERTY_RESULT_NOT_FOUND;
-                }
+                return SetComponentProperty(instance, component_index, GetComponentUserDataIndex(instance, component_index), property_id, options, value);
             }
             else
             {
@@ -3611,6 +3612,24 @@ namespace dmGameObject
         return PROPERTY_RESULT_OK;
     }
 
+    PropertyResult SetComponentProperty(HInstance instance, uint16_t component_index, uint16_t user_data_index, dmhash_t property_id, PropertyOptions options, const PropertyVar& value)
+    {
+        Prototype::Component& component = instance->m_Prototype->m_Components[component_index];
+        ComponentType* type = component.m_Type;
+        if (!type->m_SetPropertyFunction)
+            return PROPERTY_RESULT_NOT_FOUND;
+
+        ComponentSetPropertyParams p;
+        p.m_Context = type->m_Context;
+        p.m_World = instance->m_Collection->m_ComponentWorlds[component.m_TypeIndex];
+        p.m_Instance = instance;
+        p.m_PropertyId = property_id;
+        p.m_UserData = user_data_index != INVALID_USER_DATA_INDEX ? &instance->m_ComponentInstanceUserData[user_data_index] : 0;
+        p.m_Value = value;
+        p.m_Options = options;
+        return type->m_SetPropertyFunction(p);
+    }
+
     // Recreate the instance at the given index with a new prototype.
     // Specifically:
     //  - recreate components and call init/final functions
@@ -3629,6 +3648,8 @@ namespace dmGameObject
         new_instance->m_Collection = instance->m_Collection;
         // hierarchy-related
         new_instance->m_Index = instance->m_Index;
+        // The components have changed, so references to the old instance are stale
+        new_instance->m_Generation = ++g_InstanceGeneration;
         new_instance->m_LevelIndex = instance->m_LevelIndex;
         new_instance->m_Depth = instance->m_Depth;
         new_instance->m_Bone = instance->m_Bone;
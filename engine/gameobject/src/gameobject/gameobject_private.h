@@ -118,6 +118,7 @@ namespace dmGameObject
             m_NextToAdd = INVALID_INSTANCE_INDEX;
             m_ToBeDeleted = 0;
             m_ToBeAdded = 0;
+            m_Generation = 0;
         }
 
         ~Instance()
@@ -183,6 +184,9 @@ namespace dmGameObject
         uint16_t        m_FirstChildIndex : 15;
         uint16_t        m_Pad4 : 1;
 
+        // Unique for each instance created in a slot of Collection::m_Instances. Used to detect stale references
+        uint32_t        m_Generation;
+
         uint32_t        m_ComponentInstanceUserDataCount;
         uintptr_t       m_ComponentInstanceUserData[0];
     };
@@ -328,6 +332,13 @@ namespace dmGameObject
     void ReleaseInputFocus(Collection* collection, HInstance instance);
     UpdateResult DispatchInput(Collection* collection, InputAction* input_actions, uint32_t input_action_count);
 
+    // Component property access with the component already resolved, used by the cached property handles (go.property_handle)
+    const uint16_t INVALID_USER_DATA_INDEX = 0xffff;
+    // Returns the index into Instance::m_ComponentInstanceUserData, or INVALID_USER_DATA_INDEX if the component has no user data
+    uint16_t GetComponentUserDataIndex(HInstance instance, uint16_t component_index);
+    PropertyResult GetComponentProperty(HInstance instance, uint16_t component_index, uint16_t user_data_index, dmhash_t property_id, PropertyOptions options, PropertyDesc& out_value);
+    PropertyResult SetComponentProperty(HInstance instance, uint16_t component_index, uint16_t user_data_index, dmhash_t property_id, PropertyOptions options, const PropertyVar& value);
+
     // Unit test functions
     uint32_t GetAddToUpdateCount(HCollection collection); // Returns the number of items scheduled to be added to update
     uint32_t GetRemoveFromUpdateCount(HCollection collection); // Returns the number of items scheduled to be removed from update
@@ -147,9 +147,11 @@ namespace dmGameObject
 
 #define SCRIPTINSTANCE "GOScriptInstance"
 #define SCRIPT "GOScript"
+#define PROPERTYHANDLE "GOPropertyHandle"
 
     static uint32_t SCRIPT_TYPE_HASH = 0;
     static uint32_t SCRIPTINSTANCE_TYPE_HASH = 0;
+    static uint32_t PROPERTYHANDLE_TYPE_HASH = 0;
 
     using namespace dmPropertiesDDF;
 
@@ -349,6 +351,28 @@ namespace dmGameObject
         return 1;
     }
 
+    // The game object scripts of a collection all run in the same Lua state
+    static int ScriptInstanceIsScriptReceiver(lua_State* L)
+    {
+        ScriptInstance* i = (ScriptInstance*)lua_touserdata(L, 1);
+        dmMessage::URL* url = dmScript::CheckURL(L, 2);
+        bool result = false;
+        if (i != 0x0 && i->m_Instance != 0x0)
+        {
+            Instance* instance = i->m_Instance;
+            Collection* collection = instance->m_Collection;
+            Instance* receiver = url->m_Socket == collection->m_ComponentSocket ? GetInstanceFromIdentifier(collection, url->m_Path) : 0x0;
+            uint16_t component_index;
+            if (receiver != 0x0 && GetComponentIndex(receiver, url->m_Fragment, &component_index) == RESULT_OK)
+            {
+                uint32_t script_type_index = instance->m_Prototype->m_Components[i->m_ComponentIndex].m_TypeIndex;
+                result = receiver->m_Prototype->m_Components[component_index].m_TypeIndex == script_type_index;
+            }
+        }
+        lua_pushboolean(L, result);
+        return 1;
+    }
+
     static int ScriptGetInstanceContextTableRef(lua_State* L)
     {
         DM_LUA_STACK_CHECK(L, 1);
@@ -387,6 +411,7 @@ namespace dmGameObject
         {dmScript::META_TABLE_IS_VALID,                 ScriptInstanceIsValid},
         {dmScript::META_GET_INSTANCE_CONTEXT_TABLE_REF, ScriptGetInstanceContextTableRef},
         {dmScript::META_GET_INSTANCE_DATA_TABLE_REF,    ScriptGetInstanceDataTableRef},
+        {dmScript::META_TABLE_IS_SCRIPT_RECEIVER,       ScriptInstanceIsScriptReceiver},
         {0, 0}
     };
 
@@ -1049,6 +1074,242 @@ namespace dmGameObject
         return 0;
     }
 
+    // A property with its instance and component resolved, see go.property_handle
+    struct PropertyHandle
+    {
+        dmMessage::URL  m_Target;
+        dmhash_t        m_PropertyId;
+        Collection*     m_Collection;
+        Instance*       m_Instance;
+        // Instance::m_Generation when the handle was created, the handle is stale if the instance in the slot has changed
+        uint32_t        m_Generation;
+        uint16_t        m_InstanceIndex;
+        uint16_t        m_ComponentIndex;
+        uint16_t        m_UserDataIndex;
+    };
+
+    static PropertyHandle* CheckPropertyHandle(lua_State* L)
+    {
+        PropertyHandle* handle = (PropertyHandle*)dmScript::CheckUserType(L, 1, PROPERTYHANDLE_TYPE_HASH, 0);
+        ScriptInstance* i = ScriptInstance_Check(L);
+        if (handle->m_Collection != i->m_Instance->m_Collection)
+        {
+            luaL_error(L, "A property handle can only be used within the collection it was created in.");
+        }
+        Instance* instance = handle->m_Collection->m_Instances[handle->m_InstanceIndex];
+        if (instance != handle->m_Instance || instance->m_Generation != handle->m_Generation)
+        {
+            DM_HASH_REVERSE_MEM(hash_ctx, 256);
+            luaL_error(L, "The instance '%s' of the property handle has been deleted.", dmHashReverseSafe64Alloc(&hash_ctx, handle->m_Target.m_Path));
+        }
+        return handle;
+    }
+
+    static PropertyResult GetHandleProperty(PropertyHandle* handle, const PropertyOptions& options, PropertyDesc& out_value)
+    {
+        if (handle->m_Target.m_Fragment == 0)
+            return GetProperty(handle->m_Instance, 0, handle->m_PropertyId, options, out_value);
+        return GetComponentProperty(handle->m_Instance, handle->m_ComponentIndex, handle->m_UserDataIndex, handle->m_PropertyId, options, out_value);
+    }
+
+    static PropertyResult SetHandleProperty(PropertyHandle* handle, const PropertyOptions& options, const PropertyVar& value)
+    {
+        if (handle->m_Target.m_Fragment == 0)
+            return SetProperty(handle->m_Instance, 0, handle->m_PropertyId, options, value);
+        return SetComponentProperty(handle->m_Instance, handle->m_ComponentIndex, handle->m_UserDataIndex, handle->m_PropertyId, options, value);
+    }
+
+    // Gets the value of the property, arrays are returned as a table like go.get
+    static int PropertyHandle_Get(lua_State* L)
+    {
+        PropertyHandle* handle = CheckPropertyHandle(L);
+
+        PropertyOptions property_options;
+        property_options.m_Index = 0;
+        property_options.m_HasKey = 0;
+
+        PropertyDesc property_desc;
+        PropertyResult result = GetHandleProperty(handle, property_options, property_desc);
+        if (result != PROPERTY_RESULT_OK)
+        {
+            // The error messages refers to the url at index 1
+            dmScript::PushURL(L, handle->m_Target);
+            lua_replace(L, 1);
+            return CheckGoGetResult(L, result, property_desc, handle->m_PropertyId, handle->m_Instance, handle->m_Target, property_options, false);
+        }
+
+        if (property_desc.m_ValueType == PROP_VALUE_ARRAY && property_desc.m_ArrayLength > 1)
+        {
+            lua_newtable(L);
+            LuaPushVar(L, property_desc.m_Variant);
+            lua_rawseti(L, -2, 1);
+            for (int i = 1; i < property_desc.m_ArrayLength; ++i)
+            {
+                property_options.m_Index = i;
+                result = GetHandleProperty(handle, property_options, property_desc);
+                if (result != PROPERTY_RESULT_OK)
+                {
+                    dmScript::PushURL(L, handle->m_Target);
+                    lua_replace(L, 1);
+                    return CheckGoGetResult(L, result, property_desc, handle->m_PropertyId, handle->m_Instance, handle->m_Target, property_options, false);
+                }
+                LuaPushVar(L, property_desc.m_Variant);
+                lua_rawseti(L, -2, i + 1);
+            }
+            return 1;
+        }
+
+        LuaPushVar(L, property_desc.m_Variant);
+        return 1;
+    }
+
+    // Sets the value of the property, a table sets the elements of an array property like go.set
+    static int PropertyHandle_Set(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        PropertyHandle* handle = CheckPropertyHandle(L);
+
+        PropertyOptions property_options;
+        property_options.m_Index = 0;
+        property_options.m_HasKey = 0;
+
+        PropertyResult result = PROPERTY_RESULT_OK;
+        if (lua_istable(L, 2))
+        {
+            lua_pushnil(L);
+            while (lua_next(L, 2) != 0)
+            {
+                if (!lua_isnumber(L, -2) || lua_tonumber(L, -2) < 1)
+                {
+                    DM_HASH_REVERSE_MEM(hash_ctx, 256);
+                    return luaL_error(L, "Trying to set property value '%s' as array with a non-positive integer key.", dmHashReverseSafe64Alloc(&hash_ctx, handle->m_PropertyId));
+                }
+                property_options.m_Index = (int32_t)lua_tonumber(L, -2) - 1;
+
+                PropertyVar property_var;
+                result = LuaToVar(L, -1, property_var);
+                if (result == PROPERTY_RESULT_OK)
+                {
+                    result = SetHandleProperty(handle, property_options, property_var);
+                }
+                lua_pop(L, 1);
+                if (result != PROPERTY_RESULT_OK)
+                {
+                    lua_pop(L, 1);
+                    break;
+                }
+            }
+        }
+        else
+        {
+            PropertyVar property_var;
+            result = LuaToVar(L, 2, property_var);
+            if (result == PROPERTY_RESULT_OK)
+            {
+                result = SetHandleProperty(handle, property_options, property_var);
+            }
+        }
+
+        if (result != PROPERTY_RESULT_OK)
+        {
+            // The error messages refers to the url at index 1
+            dmScript::PushURL(L, handle->m_Target);
+            lua_replace(L, 1);
+            return HandleGoSetResult(L, result, handle->m_PropertyId, handle->m_Instance, handle->m_Target, property_options);
+        }
+        return 0;
+    }
+
+    static int PropertyHandle_tostring(lua_State* L)
+    {
+        PropertyHandle* handle = (PropertyHandle*)lua_touserdata(L, 1);
+        DM_HASH_REVERSE_MEM(hash_ctx, 256);
+        lua_pushfstring(L, "PropertyHandle: %s#%s.%s", dmHashReverseSafe64Alloc(&hash_ctx, handle->m_Target.m_Path),
+                                                       dmHashReverseSafe64Alloc(&hash_ctx, handle->m_Target.m_Fragment),
+                                                       dmHashReverseSafe64Alloc(&hash_ctx, handle->m_PropertyId));
+        return 1;
+    }
+
+    static const luaL_reg PropertyHandle_meta[] =
+    {
+        {"get",         PropertyHandle_Get},
+        {"set",         PropertyHandle_Set},
+        {"__tostring",  PropertyHandle_tostring},
+        {0, 0}
+    };
+
+    /*# creates a cached handle to a named property of a game object or component
+     * Resolves the url and property once, so that repeated reads and writes of the same
+     * property avoid the lookups done by [ref:go.get] and [ref:go.set].
+     *
+     * The handle has the functions `handle:get()` and `handle:set(value)`, which behave like
+     * `go.get(url, property)` and `go.set(url, property, value)`.
+     * Using a handle after its game object has been deleted is an error.
+     *
+     * @name go.property_handle
+     * @param url [type:string|hash|url] url of the game object or component having the property
+     * @param property [type:string|hash] id of the property
+     * @return handle [type:userdata] the property handle
+     * @examples
+     *
+     * ```lua
+     * function init(self)
+     *     self.speed = go.property_handle("#player", "speed")
+     * end
+     *
+     * function update(self, dt)
+     *     self.speed:set(self.speed:get() * 0.99)
+     * end
+     * ```
+     */
+    int Script_PropertyHandle(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+        DM_HASH_REVERSE_MEM(hash_ctx, 256);
+
+        ScriptInstance* i = ScriptInstance_Check(L);
+        Instance* instance = i->m_Instance;
+        dmMessage::URL sender;
+        dmScript::GetURL(L, &sender);
+        dmMessage::URL target;
+        dmScript::ResolveURL(L, 1, &target, &sender);
+        if (target.m_Socket != dmGameObject::GetMessageSocket(instance->m_Collection->m_HCollection))
+        {
+            return luaL_error(L, "go.property_handle can only access instances within the same collection.");
+        }
+        dmhash_t property_id = dmScript::CheckHashOrString(L, 2);
+
+        Instance* target_instance = GetInstanceFromIdentifier(instance->m_Collection, target.m_Path);
+        if (target_instance == 0)
+        {
+            return luaL_error(L, "Could not find any instance with id '%s'.", dmHashReverseSafe64Alloc(&hash_ctx, target.m_Path));
+        }
+
+        uint16_t component_index = 0;
+        uint16_t user_data_index = INVALID_USER_DATA_INDEX;
+        if (target.m_Fragment != 0)
+        {
+            if (GetComponentIndex(target_instance, target.m_Fragment, &component_index) != RESULT_OK)
+            {
+                return luaL_error(L, "Could not find component '%s' when resolving '%s'", dmHashReverseSafe64Alloc(&hash_ctx, target.m_Fragment), lua_tostring(L, 1));
+            }
+            user_data_index = GetComponentUserDataIndex(target_instance, component_index);
+        }
+
+        PropertyHandle* handle = (PropertyHandle*)lua_newuserdata(L, sizeof(PropertyHandle));
+        handle->m_Target = target;
+        handle->m_PropertyId = property_id;
+        handle->m_Collection = instance->m_Collection;
+        handle->m_Instance = target_instance;
+        handle->m_Generation = target_instance->m_Generation;
+        handle->m_InstanceIndex = target_instance->m_Index;
+        handle->m_ComponentIndex = component_index;
+        handle->m_UserDataIndex = user_data_index;
+        luaL_getmetatable(L, PROPERTYHANDLE);
+        lua_setmetatable(L, -2);
+        return 1;
+    }
+
     /*# gets the position of a game object instance
      * The position is relative the parent (if any). Use [ref:go.get_world_position] to retrieve the global world position.
      *
@@ -1293,6 +1554,239 @@ namespace dmGameObject
         return 0;
     }
 
+    enum BulkTransform
+    {
+        BULK_TRANSFORM_POSITION,
+        BULK_TRANSFORM_ROTATION,
+        BULK_TRANSFORM_SCALE,
+    };
+
+    // Number of values per instance in the flat value tables
+    static const uint32_t BULK_TRANSFORM_VALUE_COUNT[] = {3, 4, 3};
+
+    // Resolves ids[index], hashes are used as is to avoid parsing a url per instance
+    static Instance* ResolveBulkInstance(lua_State* L, Collection* collection, int ids_arg, uint32_t index)
+    {
+        lua_rawgeti(L, ids_arg, index);
+        dmhash_t id;
+        if (dmScript::IsHash(L, -1))
+        {
+            id = dmScript::CheckHash(L, -1);
+        }
+        else
+        {
+            dmMessage::URL receiver;
+            dmScript::ResolveURL(L, -1, &receiver, 0x0);
+            if (receiver.m_Socket != dmGameObject::GetMessageSocket(collection->m_HCollection))
+            {
+                luaL_error(L, "function called can only access instances within the same collection.");
+            }
+            id = receiver.m_Path;
+        }
+        lua_pop(L, 1);
+
+        Instance* instance = GetInstanceFromIdentifier(collection, id);
+        if (!instance)
+        {
+            DM_HASH_REVERSE_MEM(hash_ctx, 256);
+            luaL_error(L, "Instance %s not found", dmHashReverseSafe64Alloc(&hash_ctx, id));
+        }
+        return instance;
+    }
+
+    static int GetBulkTransforms(lua_State* L, BulkTransform transform)
+    {
+        DM_LUA_STACK_CHECK(L, 1);
+        ScriptInstance* i = ScriptInstance_Check(L);
+        Collection* collection = i->m_Instance->m_Collection;
+
+        luaL_checktype(L, 1, LUA_TTABLE);
+        uint32_t count = lua_objlen(L, 1);
+        uint32_t value_count = BULK_TRANSFORM_VALUE_COUNT[transform];
+
+        if (lua_gettop(L) > 1 && !lua_isnil(L, 2))
+        {
+            luaL_checktype(L, 2, LUA_TTABLE);
+            lua_pushvalue(L, 2);
+        }
+        else
+        {
+            lua_createtable(L, count * value_count, 0);
+        }
+
+        float values[4];
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            Instance* instance = ResolveBulkInstance(L, collection, 1, n + 1);
+            switch (transform)
+            {
+            case BULK_TRANSFORM_POSITION:
+                {
+                    Point3 p = GetPosition(instance);
+                    values[0] = p.getX(); values[1] = p.getY(); values[2] = p.getZ();
+                }
+                break;
+            case BULK_TRANSFORM_ROTATION:
+                {
+                    Quat q = GetRotation(instance);
+                    values[0] = q.getX(); values[1] = q.getY(); values[2] = q.getZ(); values[3] = q.getW();
+                }
+                break;
+            case BULK_TRANSFORM_SCALE:
+                {
+                    Vector3 v = GetScale(instance);
+                    values[0] = v.getX(); values[1] = v.getY(); values[2] = v.getZ();
+                }
+                break;
+            }
+
+            for (uint32_t c = 0; c < value_count; ++c)
+            {
+                lua_pushnumber(L, values[c]);
+                lua_rawseti(L, -2, n * value_count + c + 1);
+            }
+        }
+        return 1;
+    }
+
+    static int SetBulkTransforms(lua_State* L, BulkTransform transform, const char* function_name)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        ScriptInstance* i = ScriptInstance_Check(L);
+        Collection* collection = i->m_Instance->m_Collection;
+
+        luaL_checktype(L, 1, LUA_TTABLE);
+        luaL_checktype(L, 2, LUA_TTABLE);
+        uint32_t count = lua_objlen(L, 1);
+        uint32_t value_count = BULK_TRANSFORM_VALUE_COUNT[transform];
+        if (lua_objlen(L, 2) < count * value_count)
+        {
+            return luaL_error(L, "%s expects %d values per instance, got %d values for %d instances", function_name, value_count, (int)lua_objlen(L, 2), count);
+        }
+
+        float values[4];
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            Instance* instance = ResolveBulkInstance(L, collection, 1, n + 1);
+            for (uint32_t c = 0; c < value_count; ++c)
+            {
+                lua_rawgeti(L, 2, n * value_count + c + 1);
+                values[c] = (float)luaL_checknumber(L, -1);
+                lua_pop(L, 1);
+            }
+
+            switch (transform)
+            {
+            case BULK_TRANSFORM_POSITION:
+                SetPosition(instance, Point3(values[0], values[1], values[2]));
+                break;
+            case BULK_TRANSFORM_ROTATION:
+                SetRotation(instance, Quat(values[0], values[1], values[2], values[3]));
+                break;
+            case BULK_TRANSFORM_SCALE:
+                if (values[0] <= 0.0f || values[1] <= 0.0f || values[2] <= 0.0f)
+                {
+                    return luaL_error(L, "Scale passed to %s contains components that are below or equal to zero", function_name);
+                }
+                SetScale(instance, Vector3(values[0], values[1], values[2]));
+                break;
+            }
+        }
+        return 0;
+    }
+
+    /*# gets the positions of several game object instances
+     * Reads the positions of all instances in one call, without creating a vector per instance.
+     * The positions are relative the parent (if any).
+     *
+     * @name go.get_positions
+     * @param ids [type:table] array of ids (string, hash or url) of the game object instances
+     * @param [positions] [type:table] optional table to store the positions in, to avoid creating a new table
+     * @return positions [type:table] flat array with the x, y and z of each instance, in the order of the ids
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     self.positions = go.get_positions(self.ids, self.positions)
+     *     for i = 1, #self.positions, 3 do
+     *         self.positions[i + 1] = self.positions[i + 1] - 10 * dt
+     *     end
+     *     go.set_positions(self.ids, self.positions)
+     * end
+     * ```
+     */
+    int Script_GetPositions(lua_State* L)
+    {
+        return GetBulkTransforms(L, BULK_TRANSFORM_POSITION);
+    }
+
+    /*# gets the rotations of several game object instances
+     * Reads the rotations of all instances in one call, without creating a quaternion per instance.
+     * The rotations are relative the parent (if any).
+     *
+     * @name go.get_rotations
+     * @param ids [type:table] array of ids (string, hash or url) of the game object instances
+     * @param [rotations] [type:table] optional table to store the rotations in, to avoid creating a new table
+     * @return rotations [type:table] flat array with the x, y, z and w of each instance, in the order of the ids
+     */
+    int Script_GetRotations(lua_State* L)
+    {
+        return GetBulkTransforms(L, BULK_TRANSFORM_ROTATION);
+    }
+
+    /*# gets the scales of several game object instances
+     * Reads the non uniform scales of all instances in one call, without creating a vector per instance.
+     * The scales are relative the parent (if any).
+     *
+     * @name go.get_scales
+     * @param ids [type:table] array of ids (string, hash or url) of the game object instances
+     * @param [scales] [type:table] optional table to store the scales in, to avoid creating a new table
+     * @return scales [type:table] flat array with the x, y and z of each instance, in the order of the ids
+     */
+    int Script_GetScales(lua_State* L)
+    {
+        return GetBulkTransforms(L, BULK_TRANSFORM_SCALE);
+    }
+
+    /*# sets the positions of several game object instances
+     * Sets the positions of all instances in one call.
+     * The positions are relative to the parent (if any).
+     *
+     * @name go.set_positions
+     * @param ids [type:table] array of ids (string, hash or url) of the game object instances
+     * @param positions [type:table] flat array with the x, y and z of each instance, in the order of the ids
+     */
+    int Script_SetPositions(lua_State* L)
+    {
+        return SetBulkTransforms(L, BULK_TRANSFORM_POSITION, "go.set_positions");
+    }
+
+    /*# sets the rotations of several game object instances
+     * Sets the rotations of all instances in one call.
+     * The rotations are relative to the parent (if any).
+     *
+     * @name go.set_rotations
+     * @param ids [type:table] array of ids (string, hash or url) of the game object instances
+     * @param rotations [type:table] flat array with the x, y, z and w of each instance, in the order of the ids
+     */
+    int Script_SetRotations(lua_State* L)
+    {
+        return SetBulkTransforms(L, BULK_TRANSFORM_ROTATION, "go.set_rotations");
+    }
+
+    /*# sets the scales of several game object instances
+     * Sets the non uniform scales of all instances in one call.
+     * The scales are relative to the parent (if any).
+     *
+     * @name go.set_scales
+     * @param ids [type:table] array of ids (string, hash or url) of the game object instances
+     * @param scales [type:table] flat array with the x, y and z of each instance, in the order of the ids
+     */
+    int Script_SetScales(lua_State* L)
+    {
+        return SetBulkTransforms(L, BULK_TRANSFORM_SCALE, "go.set_scales");
+    }
+
     /*# sets the parent for a specific game object instance
      * Sets the parent for a game object instance. This means that the instance will exist in the geometrical space of its parent,
      * like a basic transformation hierarchy or scene graph. If no parent is specified, the instance will be detached from any parent and exist in world
@@ -2318,6 +2812,7 @@ namespace dmGameObject
     {
         {"get",                     Script_Get},
         {"set",                     Script_Set},
+        {"property_handle",         Script_PropertyHandle},
         {"get_position",            Script_GetPosition},
         {"get_rotation",            Script_GetRotation},
         {"get_scale",               Script_GetScale},
@@ -2328,6 +2823,12 @@ namespace dmGameObject
         {"set_rotation",            Script_SetRotation},
         {"set_scale",               Script_SetScale},
         {"set_parent",              Script_SetParent},
+        {"get_positions",           Script_GetPositions},
+        {"get_rotations",           Script_GetRotations},
+        {"get_scales",              Script_GetScales},
+        {"set_positions",           Script_SetPositions},
+        {"set_rotations",           Script_SetRotations},
+        {"set_scales",              Script_SetScales},
         {"get_world_position",      Script_GetWorldPosition},
         {"get_world_rotation",      Script_GetWorldRotation},
         {"get_world_scale",         Script_GetWorldScale},
@@ -2358,6 +2859,8 @@ namespace dmGameObject
 
         SCRIPTINSTANCE_TYPE_HASH = dmScript::RegisterUserType(L, SCRIPTINSTANCE, ScriptInstance_methods, ScriptInstance_meta);
 
+        PROPERTYHANDLE_TYPE_HASH = dmScript::RegisterUserTypeLocal(L, PROPERTYHANDLE, PropertyHandle_meta);
+
         luaL_register(L, "go", GO_methods);
 
 #define SETPLAYBACK(name) \
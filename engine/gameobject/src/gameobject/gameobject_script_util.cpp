@@ -17,12 +17,35 @@
 #include <stdint.h>
 #include <ddf/ddf.h>
 #include <resource/resource.h>
+#include <resource/resource_util.h>
 #include <dmsdk/gameobject/res_lua.h>
 #include "../proto/gameobject/lua_ddf.h"
 #include "gameobject_script_util.h"
 
 namespace dmGameObject
 {
+    // Loads a module added with dmScript::AddLazyModule, on its first require
+    static bool LoadLazyModule(dmScript::HContext script_context, const char* resource_path, void* user_context, void** resource, dmLuaDDF::LuaSource** source)
+    {
+        dmResource::HFactory factory = (dmResource::HFactory) user_context;
+        LuaScript* module_script = 0;
+        dmResource::Result r = dmResource::Get(factory, resource_path, (void**) (&module_script));
+        if (r != dmResource::RESULT_OK)
+        {
+            return false;
+        }
+
+        if (!RegisterSubModules(factory, script_context, module_script->m_LuaModule))
+        {
+            dmResource::Release(factory, module_script);
+            return false;
+        }
+
+        *resource = module_script;
+        *source = &module_script->m_LuaModule->m_Source;
+        return true;
+    }
+
     bool RegisterSubModules(dmResource::HFactory factory, dmScript::HContext script_context, dmLuaDDF::LuaModule* lua_module)
     {
         uint32_t n_modules = lua_module->m_Modules.m_Count;
@@ -30,6 +53,24 @@ namespace dmGameObject
         {
             const char* module_resource = lua_module->m_Resources[i];
             const char* module_name = lua_module->m_Modules[i];
+
+            if (dmScript::GetLazyModules(script_context))
+            {
+                // The module resource is loaded on the first require of the module
+                char canonical_path[dmResource::RESOURCE_PATH_MAX];
+                uint32_t canonical_path_len = dmResource::GetCanonicalPath(module_resource, canonical_path);
+                dmhash_t path_hash = dmHashBuffer64(canonical_path, canonical_path_len);
+                if (dmScript::ModuleLoaded(script_context, path_hash))
+                {
+                    continue;
+                }
+                if (dmScript::AddLazyModule(script_context, module_name, module_resource, path_hash, LoadLazyModule, factory) != dmScript::RESULT_OK)
+                {
+                    return false;
+                }
+                continue;
+            }
+
             LuaScript* module_script = 0;
             dmResource::Result r = dmResource::Get(factory, module_resource, (void**) (&module_script));
             if (r == dmResource::RESULT_OK)
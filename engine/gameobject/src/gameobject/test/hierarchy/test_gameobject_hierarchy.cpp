@@ -998,6 +998,51 @@ static void SetProperties(dmGameObject::HInstance instance)
     }
 }
 
+TEST_F(HierarchyTest, TestDirtyTransforms)
+{
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance child = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::Collection* collection = m_Collection->m_Collection;
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+
+    dmGameObject::SetPosition(child, Point3(1, 2, 3));
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+    dmGameObject::UpdateTransforms(m_Collection);
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+
+    dmGameObject::SetScale(child, 2.0f);
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+    dmGameObject::UpdateTransforms(m_Collection);
+
+    dmGameObject::SetParent(child, parent);
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+    dmGameObject::UpdateTransforms(m_Collection);
+
+    dmGameObject::PropertyOptions opt;
+    opt.m_Index = 0;
+    opt.m_HasKey = 0;
+    ASSERT_EQ(dmGameObject::PROPERTY_RESULT_OK, dmGameObject::SetProperty(parent, 0, dmHashString64("position"), opt, dmGameObject::PropertyVar(Vector3(1, 0, 0))));
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+
+    // Scripts that don't move anything leave the transforms clean
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+    ASSERT_NEAR(1.0f, dmGameObject::GetWorldPosition(child).getX(), EPSILON);
+
+    // Deleting the parent without its children moves them up in the hierarchy
+    dmGameObject::Delete(m_Collection, parent, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_TRUE(collection->m_DirtyTransforms);
+    dmGameObject::UpdateTransforms(m_Collection);
+    ASSERT_FALSE(collection->m_DirtyTransforms);
+    ASSERT_NEAR(dmGameObject::GetPosition(child).getX(), dmGameObject::GetWorldPosition(child).getX(), EPSILON);
+
+    dmGameObject::Delete(m_Collection, child, false);
+}
+
 // Testing the debug inspection api
 TEST_F(HierarchyTest, TestIterateHierarchy)
 {
@@ -572,3 +572,30 @@ TEST_F(ScriptTest, TestExists)
 
     ASSERT_TRUE(dmGameObject::Init(m_Collection));
 }
+
+TEST_F(ScriptTest, TestPropertyHandleStale)
+{
+    lua_State* L = dmScript::GetLuaState(m_ScriptContext);
+
+    dmGameObject::HInstance go_a = dmGameObject::New(m_Collection, "/null.goc");
+    ASSERT_NE((void*) 0, (void*) go_a);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, go_a, "a"));
+
+    dmGameObject::HInstance go = dmGameObject::New(m_Collection, "/property_handle.goc");
+    ASSERT_NE((void*) 0, (void*) go);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    // The new instance may get the slot, and the memory, of the deleted one
+    dmGameObject::Delete(m_Collection, go_a, false);
+    dmGameObject::PostUpdate(m_Collection);
+    go_a = dmGameObject::New(m_Collection, "/null.goc");
+    ASSERT_NE((void*) 0, (void*) go_a);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, go_a, "a"));
+
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    lua_getglobal(L, "PROPERTY_HANDLE_STALE");
+    ASSERT_EQ(1, lua_toboolean(L, -1));
+    lua_pop(L, 1);
+}
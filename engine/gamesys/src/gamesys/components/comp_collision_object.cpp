@@ -110,6 +110,9 @@ namespace dmGameSystem
 
         dmPhysics::HCollisionShape3D* m_ShapeBuffer;
 
+        // World transform of the instance when last checked by the physics world
+        dmVMath::Matrix4 m_LastWorldTransform;
+
         uint16_t m_Mask;
         uint16_t m_ComponentIndex;
         // True if the physics is 3D
@@ -159,6 +162,18 @@ namespace dmGameSystem
         world_transform = dmGameObject::GetWorldTransform(instance);
     }
 
+    static bool WorldTransformChanged(void* user_data)
+    {
+        if (!user_data)
+            return false;
+        CollisionComponent* component = (CollisionComponent*)user_data;
+        const dmVMath::Matrix4& world_transform = dmGameObject::GetWorldMatrix(component->m_Instance);
+        if (memcmp(&world_transform, &component->m_LastWorldTransform, sizeof(dmVMath::Matrix4)) == 0)
+            return false;
+        component->m_LastWorldTransform = world_transform;
+        return true;
+    }
+
     // TODO: Allow the SetWorldTransform to have a physics context which we can check instead!!
     static int g_NumPhysicsTransformsUpdated = 0;
 
@@ -198,6 +213,7 @@ namespace dmGameSystem
         dmPhysics::NewWorldParams world_params;
         world_params.m_GetWorldTransformCallback = GetWorldTransform;
         world_params.m_SetWorldTransformCallback = SetWorldTransform;
+        world_params.m_WorldTransformChangedCallback = WorldTransformChanged;
         world_params.m_MaxCollisionObjectsCount = comp_count;
 
         dmPhysics::HWorld2D world2D;
@@ -465,6 +481,8 @@ namespace dmGameSystem
         component->m_FlippedX = 0;
         component->m_FlippedY = 0;
         component->m_ShapeBuffer = 0;
+        // An all-zero matrix is never a valid world transform, which forces the first synchronization
+        memset(&component->m_LastWorldTransform, 0, sizeof(component->m_LastWorldTransform));
 
         CollisionWorld* world = (CollisionWorld*)params.m_World;
         if (!CreateCollisionObject(physics_context, world, params.m_Instance, component, false))
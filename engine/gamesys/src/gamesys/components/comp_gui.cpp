@@ -1108,6 +1108,7 @@ namespace dmGameSystem
         ro.m_VertexStart       = gui_world->m_ClientVertexBuffer.Size();
         ro.m_Material          = GetNodeMaterial(gui_context, scene, first_node);
         ro.m_Textures[0]       = texture;
+        RequestTextureMipMap(texture, 0);
 
         // Offset capacity to fit vertices for all emitters we are about to render
         uint32_t vertex_count = 0;
@@ -1307,6 +1308,8 @@ namespace dmGameSystem
         dmGraphics::HTexture texture = dmGameSystem::GetNodeTexture(scene, first_node);
         if (texture) {
             ro.m_Textures[0] = texture;
+            // No streaming feedback from gui nodes yet, so they keep the full texture resident
+            RequestTextureMipMap(texture, 0);
         } else {
             ro.m_Textures[0] = gui_world->m_WhiteTexture;
         }
@@ -1354,7 +1357,10 @@ namespace dmGameSystem
         // Set default texture
         dmGraphics::HTexture texture = dmGameSystem::GetNodeTexture(scene, first_node);
         if (texture)
+        {
             ro.m_Textures[0] = texture;
+            RequestTextureMipMap(texture, 0);
+        }
         else
             ro.m_Textures[0] = gui_world->m_WhiteTexture;
 
@@ -1672,7 +1678,10 @@ namespace dmGameSystem
         // Set default texture
         dmGraphics::HTexture texture = dmGameSystem::GetNodeTexture(scene, first_node);
         if (texture)
+        {
             ro.m_Textures[0] = texture;
+            RequestTextureMipMap(texture, 0);
+        }
         else
             ro.m_Textures[0] = gui_world->m_WhiteTexture;
 
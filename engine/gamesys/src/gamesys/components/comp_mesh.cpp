@@ -42,6 +42,7 @@
 #include <dmsdk/gamesys/resources/res_material.h>
 
 #include "../resources/res_mesh.h"
+#include "../resources/res_texture.h"
 
 DM_PROPERTY_EXTERN(rmtp_Components);
 DM_PROPERTY_U32(rmtp_Mesh, 0, FrameReset, "# components", &rmtp_Components);
@@ -547,6 +548,8 @@ namespace dmGameSystem
             {
                 ro.m_Textures[i] = textures_resource[i]->m_Texture;
             }
+            // No streaming feedback from meshes yet, so they keep the full texture resident
+            RequestTextureMipMap(ro.m_Textures[i], 0);
         }
 
         if (constants)
@@ -357,6 +357,8 @@ namespace dmGameSystem
             }
 
             ro->m_Textures[i] = texture_res ? texture_res->m_Texture : 0;
+            // No streaming feedback from models yet, so they keep the full texture resident
+            RequestTextureMipMap(ro->m_Textures[i], 0);
         }
     }
     static void HashMaterial(HashState32* state, const dmGameSystem::MaterialResource* material)
@@ -34,6 +34,7 @@
 
 #include "resources/res_particlefx.h"
 #include "resources/res_textureset.h"
+#include "resources/res_texture.h"
 #include "resources/res_material.h"
 
 DM_PROPERTY_EXTERN(rmtp_Components);
@@ -347,6 +348,8 @@ namespace dmGameSystem
         ro.m_VertexDeclaration = dmRender::GetVertexDeclaration(material_res->m_Material);
         ro.m_Textures[0]       = texture;
         ro.m_VertexStart       = vertex_offset;
+        // No streaming feedback from particles yet, so they keep the full texture resident
+        RequestTextureMipMap(texture, 0);
         ro.m_VertexCount       = ro_vertex_count;
         ro.m_VertexBuffer      = (dmGraphics::HVertexBuffer) dmRender::GetBuffer(render_context, pfx_world->m_VertexBuffer);
         ro.m_PrimitiveType     = dmGraphics::PRIMITIVE_TRIANGLES;
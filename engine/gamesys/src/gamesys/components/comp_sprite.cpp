@@ -33,6 +33,7 @@
 #include <gameobject/gameobject_ddf.h>
 
 #include "../resources/res_sprite.h"
+#include "../resources/res_texture.h"
 #include "../gamesys.h"
 #include "../gamesys_private.h"
 #include "comp_private.h"
@@ -1256,6 +1257,35 @@ namespace dmGameSystem
         *ib_where = indices;
     }
 
+    // Texture streaming feedback: the largest mipmap where a texel still covers at least a pixel on screen, for all sprites in the batch
+    static uint32_t GetRequiredMipMap(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        const Matrix4& view_proj    = dmRender::GetViewProjectionMatrix(render_context);
+        dmGraphics::HContext context = dmRender::GetGraphicsContext(render_context);
+        float half_width            = dmGraphics::GetWindowWidth(context) * 0.5f;
+        float half_height           = dmGraphics::GetWindowHeight(context) * 0.5f;
+
+        float min_texels_per_pixel = FLT_MAX;
+        for (uint32_t *i = begin; i != end; ++i)
+        {
+            const SpriteComponent* component = (const SpriteComponent*) &sprite_world->m_Components.GetRawObjects()[(uint32_t)buf[*i].m_UserData];
+            // The world matrix is scaled by the size, so the x and y axes span the sprite on screen
+            Vector4 center = view_proj * component->m_World.getCol3();
+            Vector4 x_axis = view_proj * component->m_World.getCol0();
+            Vector4 y_axis = view_proj * component->m_World.getCol1();
+            float inv_w    = 1.0f / dmMath::Max(center.getW(), 0.0001f);
+
+            float width_px  = sqrtf(x_axis.getX() * x_axis.getX() * half_width * half_width + x_axis.getY() * x_axis.getY() * half_height * half_height) * inv_w;
+            float height_px = sqrtf(y_axis.getX() * y_axis.getX() * half_width * half_width + y_axis.getY() * y_axis.getY() * half_height * half_height) * inv_w;
+            float texels_per_pixel = dmMath::Min(component->m_Size.getX() / width_px, component->m_Size.getY() / height_px);
+            min_texels_per_pixel = dmMath::Min(min_texels_per_pixel, texels_per_pixel);
+        }
+
+        if (!(min_texels_per_pixel > 1.0f))
+            return 0;
+        return (uint32_t) dmMath::Min(log2f(min_texels_per_pixel), 15.0f);
+    }
+
     static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE("SpriteRenderBatch");
@@ -1309,9 +1339,16 @@ namespace dmGameSystem
         ro.m_VertexBuffer = (dmGraphics::HVertexBuffer) dmRender::GetBuffer(render_context, sprite_world->m_VertexBuffer);
         ro.m_IndexBuffer = (dmGraphics::HIndexBuffer) dmRender::GetBuffer(render_context, sprite_world->m_IndexBuffer);
         ro.m_Material = material;
+        uint32_t required_mipmap = 0xFFFFFFFF;
         for(uint32_t i = 0; i < resource->m_NumTextures; ++i)
         {
             ro.m_Textures[i] = GetMaterialTexture(first, i);
+            if (IsTextureStreamed(ro.m_Textures[i]))
+            {
+                if (required_mipmap == 0xFFFFFFFF)
+                    required_mipmap = GetRequiredMipMap(sprite_world, render_context, buf, begin, end);
+                RequestTextureMipMap(ro.m_Textures[i], required_mipmap);
+            }
         }
 
         ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
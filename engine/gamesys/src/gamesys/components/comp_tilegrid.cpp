@@ -34,6 +34,7 @@
 #include "../gamesys.h"
 #include "../resources/res_material.h"
 #include "../resources/res_textureset.h"
+#include "../resources/res_texture.h"
 #include "../resources/res_tilegrid.h"
 #include <gamesys/physics_ddf.h>
 #include <gamesys/tile_ddf.h>
@@ -663,6 +664,8 @@ namespace dmGameSystem
         ro.m_VertexCount = (world->m_VertexBufferWritePtr - vb_begin);
         ro.m_Material = GetMaterial(first);
         ro.m_Textures[0] = texture_set->m_Texture->m_Texture;
+        // No streaming feedback from tilemaps yet, so they keep the full texture resident
+        RequestTextureMipMap(ro.m_Textures[0], 0);
 
         if (first->m_RenderConstants) {
             dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
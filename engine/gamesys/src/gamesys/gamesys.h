@@ -192,6 +192,29 @@ namespace dmGameSystem
         uint32_t m_MaxCollectionFactoryCount;
     };
 
+    /// game.project keys of the texture streaming settings
+    extern const char* TEXTURE_STREAM_MIPMAPS_KEY;
+    extern const char* TEXTURE_STREAM_BUDGET_KEY;
+
+    struct TextureStreamingParams
+    {
+        TextureStreamingParams()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+        dmResource::HFactory    m_Factory;
+        dmGraphics::HContext    m_GraphicsContext;
+        dmJobThread::HContext   m_JobThread;
+        /// Number of top mipmaps that are loaded on demand. 0 disables texture streaming
+        uint32_t                m_MipMaps;
+        /// Max size in bytes of the streamed textures on the GPU. 0 means no limit
+        uint32_t                m_MemoryBudget;
+    };
+
+    void InitializeTextureStreaming(const TextureStreamingParams& params);
+    void FinalizeTextureStreaming();
+    void UpdateTextureStreaming();
+
     bool InitializeScriptLibs(const ScriptLibContext& context);
     void FinalizeScriptLibs(const ScriptLibContext& context);
     void UpdateScriptLibs(const ScriptLibContext& context);
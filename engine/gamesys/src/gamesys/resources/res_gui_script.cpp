@@ -52,7 +52,8 @@ namespace dmGameSystem
 
         dmGameObject::PatchLuaBytecode(&lua_module->m_Source);
 
-        uint32_t n_modules = lua_module->m_Modules.m_Count;
+        // Lazy modules are loaded on their first require instead
+        uint32_t n_modules = dmScript::GetLazyModules(((ResGuiContexts*) params.m_Context)->m_ScriptContext) ? 0 : lua_module->m_Modules.m_Count;
         for (uint32_t i = 0; i < n_modules; ++i)
         {
             dmResource::PreloadHint(params.m_HintInfo, lua_module->m_Resources[i]);
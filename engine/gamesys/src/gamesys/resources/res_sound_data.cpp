@@ -12,6 +12,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <stdlib.h>
 #include <string.h>
 #include <sound/sound.h>
 #include "res_sound_data.h"
@@ -41,6 +42,41 @@ namespace dmGameSystem
         return type;
     }
 
+    // Owned by the sound data, since it may outlive the resource while an instance is still playing it
+    struct SoundDataReadContext
+    {
+        dmResource::HFactory m_Factory;
+        char*                m_Path;
+    };
+
+    // Called from the sound threads when playing streamed sound data
+    static dmSound::Result ReadSoundData(void* context, uint32_t offset, uint32_t size, void* out, uint32_t* nread)
+    {
+        SoundDataReadContext* read_context = (SoundDataReadContext*) context;
+        dmResource::Result r = dmResource::GetRawPartial(read_context->m_Factory, read_context->m_Path, offset, size, out, nread);
+        if (r != dmResource::RESULT_OK)
+        {
+            return dmSound::RESULT_INVALID_STREAM_DATA;
+        }
+        return dmSound::RESULT_OK;
+    }
+
+    static void DeleteReadContext(void* context)
+    {
+        SoundDataReadContext* read_context = (SoundDataReadContext*) context;
+        free(read_context->m_Path);
+        delete read_context;
+    }
+
+    static dmSound::Result NewSoundData(dmResource::HFactory factory, const char* path, const void* buffer, uint32_t buffer_size,
+                                        dmSound::SoundDataType type, dmSound::HSoundData* sound_data, dmhash_t name)
+    {
+        SoundDataReadContext* read_context = new SoundDataReadContext;
+        read_context->m_Factory = factory;
+        read_context->m_Path = strdup(path);
+        return dmSound::NewSoundDataStreaming(ReadSoundData, DeleteReadContext, read_context, buffer, buffer_size, buffer_size, type, sound_data, name);
+    }
+
     dmResource::Result ResSoundDataCreate(const dmResource::ResourceCreateParams& params)
     {
         dmSound::HSoundData sound_data;
@@ -53,7 +89,7 @@ namespace dmGameSystem
             type = dmSound::SOUND_DATA_TYPE_OGG_VORBIS;
         }
 
-        dmSound::Result r = dmSound::NewSoundData(params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
+        dmSound::Result r = NewSoundData(params.m_Factory, params.m_Filename, params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
         if (r != dmSound::RESULT_OK)
         {
             return dmResource::RESULT_OUT_OF_RESOURCES;
@@ -88,7 +124,7 @@ namespace dmGameSystem
 
         dmSound::HSoundData sound_data;
         dmSound::SoundDataType type = TryToGetTypeFromBuffer((char*)params.m_Buffer, (dmSound::SoundDataType)sound_data_res->m_Type, params.m_BufferSize);
-        dmSound::Result r = dmSound::NewSoundData(params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
+        dmSound::Result r = NewSoundData(params.m_Factory, params.m_Filename, params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
 
         if (r != dmSound::RESULT_OK)
         {
@@ -14,9 +14,14 @@
 
 #include "res_texture.h"
 #include "gamesys_private.h"
+#include "../gamesys.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 #include <dmsdk/gamesys/resources/res_texture.h>
 
+#include <dlib/hashtable.h>
 #include <dlib/log.h>
 #include <dlib/profile.h>
 #include <dlib/time.h>
@@ -32,6 +37,21 @@ namespace dmGameSystem
         dmGraphics::TextureImage* m_DDFImage;
         uint8_t*                  m_DecompressedData[MAX_MIPMAP_COUNT];
         uint32_t                  m_DecompressedDataSize[MAX_MIPMAP_COUNT];
+
+        // Set when the preload (on a loader thread) has picked the alternative and transcoded it if needed
+        bool                      m_Transcoded;
+        int32_t                   m_TranscodedAlternative;
+        dmGraphics::TextureFormat m_TranscodedFormat;
+        uint32_t                  m_TranscodedMipMapCount;
+
+        // Mipmaps left to upload, if the upload is spread over several frames
+        dmGraphics::TextureImage::Image* m_UploadImage;
+        dmGraphics::TextureParams        m_UploadParams;
+        uint32_t                         m_MipMapCount;
+        uint32_t                         m_NextMipMap;
+
+        // Number of top mipmaps to leave out when uploading (see texture streaming)
+        uint32_t                         m_SkipMipMaps;
     };
 
 #define CASE_TT(_X, _T) case dmGraphics::TextureImage::_X: return dmGraphics::TEXTURE_ ## _T
@@ -108,8 +128,45 @@ namespace dmGameSystem
         dmGraphics::SetTextureAsync(texture, params, 0, (void*) 0);
     }
 
+    // Uploads the mipmaps from m_NextMipMap and onwards, until the time budget (in microseconds) is used up.
+    // At least one mipmap is always uploaded. Returns true when all mipmaps are uploaded.
+    static bool UploadMipMaps(dmGraphics::HTexture texture, ImageDesc* image_desc, uint32_t budget)
+    {
+        dmGraphics::TextureImage::Image* image = image_desc->m_UploadImage;
+        dmGraphics::TextureParams& params      = image_desc->m_UploadParams;
+        uint64_t start                         = dmTime::GetTime();
+
+        while (image_desc->m_NextMipMap < image_desc->m_MipMapCount)
+        {
+            uint32_t i = image_desc->m_NextMipMap++;
+            uint32_t src = i + image_desc->m_SkipMipMaps;
+            if (image_desc->m_DecompressedData[src] == 0)
+            {
+                params.m_Data     = &image->m_Data[image->m_MipMapOffset[src]];
+                params.m_DataSize = image->m_MipMapSize[src];
+            }
+            else
+            {
+                params.m_Data     = image_desc->m_DecompressedData[src];
+                params.m_DataSize = image_desc->m_DecompressedDataSize[src];
+            }
+
+            params.m_MipMap = i;
+            params.m_Width  = dmMath::Max((uint16_t)1, dmGraphics::GetMipmapSize(image->m_Width, src));
+            params.m_Height = dmMath::Max((uint16_t)1, dmGraphics::GetMipmapSize(image->m_Height, src));
+            dmGraphics::SetTextureAsync(texture, params, 0, 0);
+
+            if (dmTime::GetTime() - start >= budget)
+            {
+                break;
+            }
+        }
+        return image_desc->m_NextMipMap == image_desc->m_MipMapCount;
+    }
+
+    // The budget is the time in microseconds that may be spent uploading mipmaps, the rest are left for UploadMipMaps
     static dmResource::Result AcquireResources(const char* path, dmResource::SResourceDescriptor* resource_desc, dmGraphics::HContext context, ImageDesc* image_desc,
-        ResTextureUploadParams upload_params, dmGraphics::HTexture texture, dmGraphics::HTexture* texture_out)
+        ResTextureUploadParams upload_params, dmGraphics::HTexture texture, dmGraphics::HTexture* texture_out, uint32_t budget)
     {
         DM_PROFILE_DYN(path, 0);
 
@@ -122,7 +179,17 @@ namespace dmGameSystem
             uint32_t num_mips                         = image->m_MipMapOffset.m_Count;
             bool specific_mip_requested               = upload_params.m_UploadSpecificMipmap;
 
-            if (dmGraphics::IsFormatTranscoded(image->m_CompressionType))
+            if (image_desc->m_Transcoded && image_desc->m_TranscodedAlternative == (int32_t) i)
+            {
+                output_format = image_desc->m_TranscodedFormat;
+                num_mips      = image_desc->m_TranscodedMipMapCount;
+            }
+            else if (image_desc->m_Transcoded && dmGraphics::IsFormatTranscoded(image->m_CompressionType))
+            {
+                // The preload already failed to transcode this alternative
+                continue;
+            }
+            else if (dmGraphics::IsFormatTranscoded(image->m_CompressionType))
             {
                 num_mips = MAX_MIPMAP_COUNT;
                 output_format = dmGraphics::GetSupportedCompressionFormat(context, output_format, image->m_Width, image->m_Height);
@@ -140,12 +207,18 @@ namespace dmGameSystem
 
             result = dmResource::RESULT_OK;
 
+            // The smallest mipmap is always uploaded
+            uint32_t skip_mips = specific_mip_requested || num_mips == 0 ? 0 : dmMath::Min(image_desc->m_SkipMipMaps, num_mips - 1);
+            image_desc->m_SkipMipMaps = skip_mips;
+            uint16_t width  = dmMath::Max((uint16_t)1, dmGraphics::GetMipmapSize(image->m_Width, skip_mips));
+            uint16_t height = dmMath::Max((uint16_t)1, dmGraphics::GetMipmapSize(image->m_Height, skip_mips));
+
             dmGraphics::TextureParams params;
             dmGraphics::GetDefaultTextureFilters(context, params.m_MinFilter, params.m_MagFilter);
 
             params.m_Format    = output_format;
-            params.m_Width     = image->m_Width;
-            params.m_Height    = image->m_Height;
+            params.m_Width     = width;
+            params.m_Height    = height;
             params.m_Depth     = image_desc->m_DDFImage->m_Count;
             params.m_X         = upload_params.m_X;
             params.m_Y         = upload_params.m_Y;
@@ -157,12 +230,12 @@ namespace dmGameSystem
                 dmGraphics::TextureCreationParams creation_params;
 
                 creation_params.m_Type           = TextureImageToTextureType(image_desc->m_DDFImage->m_Type);
-                creation_params.m_Width          = image->m_Width;
-                creation_params.m_Height         = image->m_Height;
+                creation_params.m_Width          = width;
+                creation_params.m_Height         = height;
                 creation_params.m_Depth          = image_desc->m_DDFImage->m_Count;
                 creation_params.m_OriginalWidth  = image->m_OriginalWidth;
                 creation_params.m_OriginalHeight = image->m_OriginalHeight;
-                creation_params.m_MipMapCount    = num_mips;
+                creation_params.m_MipMapCount    = num_mips - skip_mips;
                 texture                          = dmGraphics::NewTexture(context, creation_params);
             }
             else
@@ -228,33 +301,11 @@ namespace dmGameSystem
             }
             else
             {
-                for (uint32_t i = 0; i < num_mips; ++i)
-                {
-                    if (image_desc->m_DecompressedData[i] == 0)
-                    {
-                        params.m_Data     = &image->m_Data[image->m_MipMapOffset[i]];
-                        params.m_DataSize = image->m_MipMapSize[i];
-                    }
-                    else
-                    {
-                        params.m_Data     = image_desc->m_DecompressedData[i];
-                        params.m_DataSize = image_desc->m_DecompressedDataSize[i];
-                    }
-
-                    params.m_MipMap   = i;
-                    dmGraphics::SetTextureAsync(texture, params, 0, 0);
-
-                    params.m_Width >>= 1;
-                    params.m_Height >>= 1;
-                    if (params.m_Width == 0)
-                    {
-                        params.m_Width = 1;
-                    }
-                    if (params.m_Height == 0)
-                    {
-                        params.m_Height = 1;
-                    }
-                }
+                image_desc->m_UploadImage  = image;
+                image_desc->m_UploadParams = params;
+                image_desc->m_MipMapCount  = num_mips - skip_mips;
+                image_desc->m_NextMipMap   = 0;
+                UploadMipMaps(texture, image_desc, budget);
             }
             break;
         }
@@ -297,9 +348,46 @@ namespace dmGameSystem
         ImageDesc* image_desc = new ImageDesc;
         memset(image_desc, 0x0, sizeof(ImageDesc));
         image_desc->m_DDFImage = texture_image;
+        image_desc->m_TranscodedAlternative = -1;
         return image_desc;
     }
 
+    // Picks the alternative the same way as AcquireResources, and transcodes it if needed.
+    // Called from the preload, so that the transcoding runs on the loader threads instead of the main thread.
+    static void TranscodeImage(const char* path, dmGraphics::HContext context, ImageDesc* image_desc)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        for (uint32_t i = 0; i < image_desc->m_DDFImage->m_Alternatives.m_Count; ++i)
+        {
+            dmGraphics::TextureImage::Image* image = &image_desc->m_DDFImage->m_Alternatives[i];
+            dmGraphics::TextureFormat format       = TextureImageToTextureFormat(image->m_Format);
+
+            if (!dmGraphics::IsFormatTranscoded(image->m_CompressionType))
+            {
+                if (dmGraphics::IsTextureFormatSupported(context, format))
+                {
+                    break;
+                }
+                continue;
+            }
+
+            uint32_t num_mips = MAX_MIPMAP_COUNT;
+            format = dmGraphics::GetSupportedCompressionFormat(context, format, image->m_Width, image->m_Height);
+            if (!dmGraphics::Transcode(path, image, image_desc->m_DDFImage->m_Count, format, image_desc->m_DecompressedData, image_desc->m_DecompressedDataSize, &num_mips))
+            {
+                dmLogError("Failed to transcode %s", path);
+                continue;
+            }
+
+            image_desc->m_TranscodedAlternative = (int32_t) i;
+            image_desc->m_TranscodedFormat      = format;
+            image_desc->m_TranscodedMipMapCount = num_mips;
+            break;
+        }
+        image_desc->m_Transcoded = true;
+    }
+
     static void DestroyImage(ImageDesc* image_desc)
     {
         for (uint32_t i = 0; i < MAX_MIPMAP_COUNT; ++i)
@@ -313,6 +401,438 @@ namespace dmGameSystem
         delete image_desc;
     }
 
+    // Texture streaming
+    //
+    // Textures loaded from file are created without their top mipmaps. The render path requests the mipmap level
+    // it needs (see RequestTextureMipMap), and the texture is then reloaded on the job thread and uploaded with the
+    // larger mipmaps. Textures that haven't been requested for a while, or that don't fit in the memory budget,
+    // are reloaded with only their base mipmaps again.
+
+    const char* TEXTURE_STREAM_MIPMAPS_KEY = "graphics.texture_stream_mipmaps";
+    const char* TEXTURE_STREAM_BUDGET_KEY  = "graphics.texture_stream_budget";
+
+    static const uint32_t TEXTURE_STREAM_MAX_PENDING  = 4;   // Max number of textures being streamed at the same time
+    static const uint32_t TEXTURE_STREAM_EVICT_FRAMES = 120; // Frames without requests before a texture is streamed out
+
+    struct StreamedTexture
+    {
+        char*    m_Path;
+        dmhash_t m_NameHash;         // The resource, looked up when the stream job is done
+        uint32_t m_Id;               // Identifies the texture in the stream jobs, since a texture handle may be reused
+        uint32_t m_LastRequestFrame;
+        uint32_t m_Size;             // Current size on the GPU
+        uint16_t m_Width;            // Size at full resolution
+        uint16_t m_Height;
+        uint8_t  m_MipMapCount;      // Mipmap count at full resolution
+        uint8_t  m_BaseMipMap;       // The largest mipmap that is always uploaded
+        uint8_t  m_ResidentMipMap;   // The largest mipmap currently uploaded
+        uint8_t  m_RequestedMipMap;  // The largest mipmap requested since the last update
+        uint8_t  m_Pending : 1;      // A stream job is loading or uploading the texture
+    };
+
+    struct TextureStreamJob
+    {
+        dmGraphics::HTexture      m_Texture;
+        uint32_t                  m_Id;
+        uint32_t                  m_MipMap;
+        char*                     m_Path;
+        dmGraphics::TextureImage* m_TextureImage;
+        ImageDesc*                m_ImageDesc;
+    };
+
+    struct TextureStreamingContext
+    {
+        TextureStreamingParams         m_Params;
+        dmHashTable64<StreamedTexture> m_Textures;
+        dmArray<TextureStreamJob*>     m_Uploading;
+        uint32_t                       m_NextId;
+        uint32_t                       m_Frame;
+        uint32_t                       m_Size;    // Total size on the GPU of the streamed textures
+        uint32_t                       m_Pending; // Number of stream jobs loading or uploading
+    };
+
+    static TextureStreamingContext* g_TextureStreaming = 0;
+
+    static StreamedTexture* GetStreamedTexture(TextureStreamingContext* ctx, dmGraphics::HTexture texture, uint32_t id)
+    {
+        StreamedTexture* streamed = ctx->m_Textures.Get(texture);
+        return streamed && streamed->m_Id == id ? streamed : 0;
+    }
+
+    static void DeleteTextureStreamJob(TextureStreamJob* job)
+    {
+        if (job->m_ImageDesc)
+            DestroyImage(job->m_ImageDesc);
+        if (job->m_TextureImage)
+            dmDDF::FreeMessage(job->m_TextureImage);
+        free(job->m_Path);
+        delete job;
+    }
+
+    // Runs on the job thread
+    static int TextureStreamJobProcess(void* context, void* data)
+    {
+        DM_PROFILE(__FUNCTION__);
+        TextureStreamingContext* ctx = (TextureStreamingContext*) context;
+        TextureStreamJob* job        = (TextureStreamJob*) data;
+
+        void* buffer;
+        uint32_t buffer_size;
+        if (dmResource::GetRaw(ctx->m_Params.m_Factory, job->m_Path, &buffer, &buffer_size) != dmResource::RESULT_OK)
+        {
+            return 0;
+        }
+
+        dmDDF::Result e = dmDDF::LoadMessage<dmGraphics::TextureImage>(buffer, buffer_size, &job->m_TextureImage);
+        free(buffer);
+        if (e != dmDDF::RESULT_OK)
+        {
+            job->m_TextureImage = 0;
+            return 0;
+        }
+
+        job->m_ImageDesc = CreateImage(ctx->m_Params.m_GraphicsContext, job->m_TextureImage);
+        job->m_ImageDesc->m_SkipMipMaps = job->m_MipMap;
+        TranscodeImage(job->m_Path, ctx->m_Params.m_GraphicsContext, job->m_ImageDesc);
+        return 1;
+    }
+
+    // Uploads the mipmaps loaded by a stream job. The upload may still be in progress when this returns.
+    static bool UploadStreamedTexture(TextureStreamingContext* ctx, StreamedTexture* streamed, TextureStreamJob* job)
+    {
+        dmResource::SResourceDescriptor* resource_desc = dmResource::FindByHash(ctx->m_Params.m_Factory, streamed->m_NameHash);
+        if (!resource_desc)
+        {
+            return false;
+        }
+
+        ResTextureUploadParams upload_params = {};
+        dmGraphics::HTexture texture = job->m_Texture;
+        SynchronizeTexture(texture, true);
+        return AcquireResources(job->m_Path, resource_desc, ctx->m_Params.m_GraphicsContext, job->m_ImageDesc, upload_params, texture, &texture, 0xFFFFFFFF) == dmResource::RESULT_OK;
+    }
+
+    static void TextureStreamJobCallback(void* context, void* data, int result)
+    {
+        TextureStreamingContext* ctx = (TextureStreamingContext*) context;
+        TextureStreamJob* job        = (TextureStreamJob*) data;
+        StreamedTexture* streamed    = GetStreamedTexture(ctx, job->m_Texture, job->m_Id);
+
+        if (streamed && result)
+        {
+            if (UploadStreamedTexture(ctx, streamed, job))
+            {
+                // The image data is kept until the upload is done, see UpdateTextureStreaming
+                streamed->m_ResidentMipMap = (uint8_t) job->m_ImageDesc->m_SkipMipMaps;
+                if (ctx->m_Uploading.Full())
+                    ctx->m_Uploading.OffsetCapacity(TEXTURE_STREAM_MAX_PENDING);
+                ctx->m_Uploading.Push(job);
+                return;
+            }
+        }
+
+        if (streamed)
+        {
+            // Keep the texture as it is, but don't try again
+            dmLogWarning("Failed to stream texture '%s'", job->m_Path);
+            streamed->m_BaseMipMap = streamed->m_ResidentMipMap;
+            streamed->m_Pending    = 0;
+        }
+        ctx->m_Pending--;
+        DeleteTextureStreamJob(job);
+    }
+
+    static TextureStreamJob* NewTextureStreamJob(dmGraphics::HTexture texture, StreamedTexture* streamed, uint32_t mipmap)
+    {
+        TextureStreamJob* job = new TextureStreamJob;
+        memset(job, 0, sizeof(TextureStreamJob));
+        job->m_Texture = texture;
+        job->m_Id      = streamed->m_Id;
+        job->m_MipMap  = mipmap;
+        job->m_Path    = strdup(streamed->m_Path);
+        return job;
+    }
+
+    static void PushTextureStreamJob(TextureStreamingContext* ctx, dmGraphics::HTexture texture, StreamedTexture* streamed, uint32_t mipmap)
+    {
+        TextureStreamJob* job = NewTextureStreamJob(texture, streamed, mipmap);
+        streamed->m_Pending = 1;
+        ctx->m_Pending++;
+        dmJobThread::PushJob(ctx->m_Params.m_JobThread, TextureStreamJobProcess, TextureStreamJobCallback, ctx, job);
+    }
+
+    // Deletes the stream jobs that are done uploading
+    static void UpdateTextureStreamUploads(TextureStreamingContext* ctx)
+    {
+        uint32_t i = 0;
+        while (i < ctx->m_Uploading.Size())
+        {
+            TextureStreamJob* job     = ctx->m_Uploading[i];
+            StreamedTexture* streamed = GetStreamedTexture(ctx, job->m_Texture, job->m_Id);
+            if (streamed)
+            {
+                if (!SynchronizeTexture(job->m_Texture, false))
+                {
+                    ++i;
+                    continue;
+                }
+                uint32_t size = dmGraphics::GetTextureResourceSize(job->m_Texture);
+                ctx->m_Size         = ctx->m_Size - streamed->m_Size + size;
+                streamed->m_Size    = size;
+                streamed->m_Pending = 0;
+
+                dmResource::SResourceDescriptor* resource_desc = dmResource::FindByHash(ctx->m_Params.m_Factory, streamed->m_NameHash);
+                if (resource_desc)
+                {
+                    resource_desc->m_ResourceSize = size;
+                }
+            }
+            ctx->m_Pending--;
+            ctx->m_Uploading.EraseSwap(i);
+            DeleteTextureStreamJob(job);
+        }
+    }
+
+    struct TextureStreamUpdate
+    {
+        TextureStreamingContext* m_Context;
+        dmGraphics::HTexture     m_Evict; // The least recently requested texture with streamed in mipmaps
+        uint32_t                 m_EvictFrame;
+    };
+
+    static void UpdateStreamedTexture(TextureStreamUpdate* update, const uint64_t* key, StreamedTexture* streamed)
+    {
+        TextureStreamingContext* ctx = update->m_Context;
+        dmGraphics::HTexture texture = (dmGraphics::HTexture) *key;
+        uint32_t requested           = streamed->m_RequestedMipMap;
+        streamed->m_RequestedMipMap  = streamed->m_BaseMipMap;
+
+        if (streamed->m_Pending)
+        {
+            return;
+        }
+
+        if (streamed->m_ResidentMipMap < streamed->m_BaseMipMap)
+        {
+            if (ctx->m_Frame - streamed->m_LastRequestFrame > TEXTURE_STREAM_EVICT_FRAMES)
+            {
+                PushTextureStreamJob(ctx, texture, streamed, streamed->m_BaseMipMap);
+                return;
+            }
+            if (update->m_Evict == 0 || streamed->m_LastRequestFrame < update->m_EvictFrame)
+            {
+                update->m_Evict      = texture;
+                update->m_EvictFrame = streamed->m_LastRequestFrame;
+            }
+        }
+
+        if (requested >= streamed->m_ResidentMipMap || ctx->m_Pending >= TEXTURE_STREAM_MAX_PENDING)
+        {
+            return;
+        }
+
+        // Stream in as many mipmaps as fit in the budget. Each mipmap is four times the size of the next one.
+        uint32_t budget = ctx->m_Params.m_MemoryBudget;
+        while (requested < streamed->m_ResidentMipMap && budget != 0)
+        {
+            uint64_t size = (uint64_t) streamed->m_Size << (2 * (streamed->m_ResidentMipMap - requested));
+            if (ctx->m_Size - streamed->m_Size + size <= budget)
+                break;
+            ++requested;
+        }
+
+        if (requested < streamed->m_ResidentMipMap)
+        {
+            PushTextureStreamJob(ctx, texture, streamed, requested);
+        }
+    }
+
+    static void AddStreamedTexture(dmGraphics::HTexture texture, dmResource::SResourceDescriptor* resource_desc, const char* path, ImageDesc* image_desc)
+    {
+        TextureStreamingContext* ctx = g_TextureStreaming;
+        if (ctx->m_Textures.Full())
+        {
+            uint32_t capacity = ctx->m_Textures.Capacity() + 64;
+            ctx->m_Textures.SetCapacity(capacity / 2 + 1, capacity);
+        }
+
+        StreamedTexture streamed;
+        memset(&streamed, 0, sizeof(StreamedTexture));
+        streamed.m_Path             = strdup(path);
+        streamed.m_NameHash         = resource_desc->m_NameHash;
+        streamed.m_Id               = ++ctx->m_NextId;
+        streamed.m_LastRequestFrame = ctx->m_Frame;
+        streamed.m_Size             = dmGraphics::GetTextureResourceSize(texture);
+        streamed.m_Width            = image_desc->m_UploadImage->m_Width;
+        streamed.m_Height           = image_desc->m_UploadImage->m_Height;
+        streamed.m_MipMapCount      = (uint8_t) (image_desc->m_MipMapCount + image_desc->m_SkipMipMaps);
+        streamed.m_BaseMipMap       = (uint8_t) image_desc->m_SkipMipMaps;
+        streamed.m_ResidentMipMap   = (uint8_t) image_desc->m_SkipMipMaps;
+        streamed.m_RequestedMipMap  = (uint8_t) image_desc->m_SkipMipMaps;
+        ctx->m_Textures.Put(texture, streamed);
+        ctx->m_Size += streamed.m_Size;
+    }
+
+    // If restore is set, the texture is reloaded at full resolution before it's removed. Changes to parts of
+    // the texture, or to a specific mipmap, are relative to the full size.
+    static void RemoveStreamedTexture(dmGraphics::HTexture texture, bool restore)
+    {
+        TextureStreamingContext* ctx = g_TextureStreaming;
+        StreamedTexture* streamed    = ctx ? ctx->m_Textures.Get(texture) : 0;
+        if (!streamed)
+        {
+            return;
+        }
+
+        // A stream job for the texture is deleted when it's done, but the upload must finish before the texture is changed
+        if (streamed->m_Pending)
+        {
+            SynchronizeTexture(texture, true);
+        }
+
+        if (restore && streamed->m_ResidentMipMap > 0)
+        {
+            TextureStreamJob* job = NewTextureStreamJob(texture, streamed, 0);
+            if (!TextureStreamJobProcess(ctx, job) || !UploadStreamedTexture(ctx, streamed, job))
+            {
+                dmLogWarning("Failed to stream texture '%s'", job->m_Path);
+            }
+            SynchronizeTexture(texture, true);
+            DeleteTextureStreamJob(job);
+        }
+        ctx->m_Size -= streamed->m_Size;
+        free(streamed->m_Path);
+        ctx->m_Textures.Erase(texture);
+    }
+
+    // Only textures loaded from file can be streamed, since they are reloaded when streamed in
+    static uint32_t GetStreamedMipMaps(dmResource::HFactory factory, dmResource::SResourceDescriptor* resource_desc, ImageDesc* image_desc)
+    {
+        if (g_TextureStreaming == 0 || !dmResource::IsCacheable(factory, resource_desc->m_NameHash) || image_desc->m_DDFImage->m_Type != dmGraphics::TextureImage::TYPE_2D)
+        {
+            return 0;
+        }
+        return g_TextureStreaming->m_Params.m_MipMaps;
+    }
+
+    void InitializeTextureStreaming(const TextureStreamingParams& params)
+    {
+        assert(g_TextureStreaming == 0);
+        if (params.m_MipMaps == 0)
+        {
+            return;
+        }
+
+        TextureStreamingContext* ctx = new TextureStreamingContext;
+        ctx->m_Params  = params;
+        ctx->m_NextId  = 0;
+        ctx->m_Frame   = 0;
+        ctx->m_Size    = 0;
+        ctx->m_Pending = 0;
+        ctx->m_Textures.SetCapacity(33, 64);
+        ctx->m_Uploading.SetCapacity(TEXTURE_STREAM_MAX_PENDING);
+        g_TextureStreaming = ctx;
+    }
+
+    static void FreeStreamedTexturePath(void*, const uint64_t*, StreamedTexture* streamed)
+    {
+        free(streamed->m_Path);
+    }
+
+    void FinalizeTextureStreaming()
+    {
+        TextureStreamingContext* ctx = g_TextureStreaming;
+        if (ctx == 0)
+        {
+            return;
+        }
+
+        // The stream jobs use the resource factory, so they need to finish first
+        while (ctx->m_Pending > 0)
+        {
+            dmJobThread::Update(ctx->m_Params.m_JobThread);
+            UpdateTextureStreamUploads(ctx);
+            if (ctx->m_Pending > 0)
+            {
+                dmTime::Sleep(1000);
+            }
+        }
+
+        ctx->m_Textures.Iterate(FreeStreamedTexturePath, (void*) 0);
+        delete ctx;
+        g_TextureStreaming = 0;
+    }
+
+    void UpdateTextureStreaming()
+    {
+        TextureStreamingContext* ctx = g_TextureStreaming;
+        if (ctx == 0)
+        {
+            return;
+        }
+        DM_PROFILE(__FUNCTION__);
+
+        UpdateTextureStreamUploads(ctx);
+
+        TextureStreamUpdate update;
+        update.m_Context    = ctx;
+        update.m_Evict      = 0;
+        update.m_EvictFrame = 0;
+        ctx->m_Textures.Iterate(UpdateStreamedTexture, &update);
+
+        uint32_t budget = ctx->m_Params.m_MemoryBudget;
+        if (budget != 0 && ctx->m_Size > budget && update.m_Evict != 0)
+        {
+            StreamedTexture* streamed = ctx->m_Textures.Get(update.m_Evict);
+            if (!streamed->m_Pending)
+            {
+                PushTextureStreamJob(ctx, update.m_Evict, streamed, streamed->m_BaseMipMap);
+            }
+        }
+
+        ++ctx->m_Frame;
+    }
+
+    bool IsTextureStreamed(dmGraphics::HTexture texture)
+    {
+        return g_TextureStreaming != 0 && g_TextureStreaming->m_Textures.Get(texture) != 0;
+    }
+
+    static StreamedTexture* GetStreamedTexture(dmGraphics::HTexture texture)
+    {
+        return g_TextureStreaming ? g_TextureStreaming->m_Textures.Get(texture) : 0;
+    }
+
+    uint16_t GetFullTextureWidth(dmGraphics::HTexture texture)
+    {
+        StreamedTexture* streamed = GetStreamedTexture(texture);
+        return streamed ? streamed->m_Width : dmGraphics::GetTextureWidth(texture);
+    }
+
+    uint16_t GetFullTextureHeight(dmGraphics::HTexture texture)
+    {
+        StreamedTexture* streamed = GetStreamedTexture(texture);
+        return streamed ? streamed->m_Height : dmGraphics::GetTextureHeight(texture);
+    }
+
+    uint8_t GetFullTextureMipmapCount(dmGraphics::HTexture texture)
+    {
+        StreamedTexture* streamed = GetStreamedTexture(texture);
+        return streamed ? streamed->m_MipMapCount : dmGraphics::GetTextureMipmapCount(texture);
+    }
+
+    void RequestTextureMipMap(dmGraphics::HTexture texture, uint32_t mipmap)
+    {
+        TextureStreamingContext* ctx = g_TextureStreaming;
+        StreamedTexture* streamed    = ctx ? ctx->m_Textures.Get(texture) : 0;
+        if (streamed)
+        {
+            if (mipmap < streamed->m_RequestedMipMap)
+                streamed->m_RequestedMipMap = (uint8_t) mipmap;
+            streamed->m_LastRequestFrame = ctx->m_Frame;
+        }
+    }
+
     dmResource::Result ResTexturePreload(const dmResource::ResourcePreloadParams& params)
     {
         DM_PROFILE(__FUNCTION__);
@@ -324,6 +844,7 @@ namespace dmGameSystem
         }
 
         ImageDesc* image_desc = CreateImage((dmGraphics::HContext) params.m_Context, texture_image);
+        TranscodeImage(params.m_Filename, (dmGraphics::HContext) params.m_Context, image_desc);
         *params.m_PreloadData = image_desc;
         return dmResource::RESULT_OK;
     }
@@ -332,13 +853,22 @@ namespace dmGameSystem
     {
         // Poll state of texture async texture processing and return state. RESULT_PENDING indicates we need to poll again.
         TextureResource* texture_res = (TextureResource*) params.m_Resource->m_Resource;
+        ImageDesc* image_desc = (ImageDesc*) params.m_PreloadData;
+
+        // Continue with the mipmaps that didn't fit in the create budget
+        if (image_desc->m_NextMipMap < image_desc->m_MipMapCount)
+        {
+            if (!UploadMipMaps(texture_res->m_Texture, image_desc, dmResource::GetCreateBudgetLeft(params.m_Factory)))
+            {
+                return dmResource::RESULT_PENDING;
+            }
+        }
 
         if(!SynchronizeTexture(texture_res->m_Texture, false))
         {
             return dmResource::RESULT_PENDING;
         }
 
-        ImageDesc* image_desc = (ImageDesc*) params.m_PreloadData;
         dmDDF::FreeMessage(image_desc->m_DDFImage);
         DestroyImage(image_desc);
         params.m_Resource->m_ResourceSize = dmGraphics::GetTextureResourceSize(texture_res->m_Texture);
@@ -355,12 +885,19 @@ namespace dmGameSystem
 
         if (image_desc->m_DDFImage->m_Alternatives.m_Count > 0)
         {
-            dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, upload_params, 0, &texture);
+            image_desc->m_SkipMipMaps = GetStreamedMipMaps(params.m_Factory, params.m_Resource, image_desc);
+            dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, upload_params, 0, &texture, dmResource::GetCreateBudgetLeft(params.m_Factory));
             if (r == dmResource::RESULT_OK)
             {
                 TextureResource* texture_res = new TextureResource();
                 texture_res->m_Texture = texture;
                 params.m_Resource->m_Resource = (void*) texture_res;
+
+                // A blank texture is used if the image couldn't be uploaded
+                if (image_desc->m_SkipMipMaps > 0 && image_desc->m_UploadImage)
+                {
+                    AddStreamedTexture(texture, params.m_Resource, params.m_Filename, image_desc);
+                }
             }
             return r;
         }
@@ -380,6 +917,7 @@ namespace dmGameSystem
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams& params)
     {
         TextureResource* texture_res = (TextureResource*) params.m_Resource->m_Resource;
+        RemoveStreamedTexture(texture_res->m_Texture, false);
         dmGraphics::DeleteTexture(texture_res->m_Texture);
         delete texture_res;
         return dmResource::RESULT_OK;
@@ -409,10 +947,6 @@ namespace dmGameSystem
         TextureResource* texture_res = (TextureResource*) params.m_Resource->m_Resource;
         dmGraphics::HTexture texture = texture_res->m_Texture;
 
-        // Create the image from the DDF data.
-        // Note that the image desc for performance reasons keeps references to the DDF image, meaning they're invalid after the DDF message has been free'd!
-        ImageDesc* image_desc = CreateImage((dmGraphics::HContext) params.m_Context, texture_image);
-
         ResTextureUploadParams upload_params = {};
 
         if (recreate_params)
@@ -420,9 +954,16 @@ namespace dmGameSystem
             upload_params = recreate_params->m_UploadParams;
         }
 
+        // The new data replaces the file data, so the texture can't be streamed anymore
+        RemoveStreamedTexture(texture, upload_params.m_SubUpdate || upload_params.m_UploadSpecificMipmap);
+
+        // Create the image from the DDF data.
+        // Note that the image desc for performance reasons keeps references to the DDF image, meaning they're invalid after the DDF message has been free'd!
+        ImageDesc* image_desc = CreateImage((dmGraphics::HContext) params.m_Context, texture_image);
+
         // Set up the new texture (version), wait for it to finish before issuing new requests
         SynchronizeTexture(texture, true);
-        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, upload_params, texture, &texture);
+        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, upload_params, texture, &texture, 0xFFFFFFFF);
 
         // Texture might have changed
         texture_res->m_Texture = texture;
@@ -40,6 +40,16 @@ namespace dmGameSystem
     dmGraphics::TextureType TextureImageToTextureType(dmGraphics::TextureImage::Type type);
     dmGraphics::TextureFormat TextureImageToTextureFormat(dmGraphics::TextureImage::TextureFormat format);
 
+    bool IsTextureStreamed(dmGraphics::HTexture texture);
+
+    // Texture streaming feedback from the render path: the largest mipmap (0 is full size) that is needed this frame
+    void RequestTextureMipMap(dmGraphics::HTexture texture, uint32_t mipmap);
+
+    // The size of the texture at full resolution. Streamed textures are smaller on the GPU while their top mipmaps aren't loaded.
+    uint16_t GetFullTextureWidth(dmGraphics::HTexture texture);
+    uint16_t GetFullTextureHeight(dmGraphics::HTexture texture);
+    uint8_t  GetFullTextureMipmapCount(dmGraphics::HTexture texture);
+
     dmResource::Result ResTexturePreload(const dmResource::ResourcePreloadParams& params);
 
     dmResource::Result ResTextureCreate(const dmResource::ResourceCreateParams& params);
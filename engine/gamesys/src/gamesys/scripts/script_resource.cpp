@@ -318,7 +318,9 @@ static void PreCreateResource(lua_State* L, const char* path_str, const char* pa
     }
 
     dmhash_t canonical_path_hash = GetCanonicalPathHash(path_str);
-    if (dmResource::FindByHash(g_ResourceModule.m_Factory, canonical_path_hash))
+    // Released resources in the resource cache are replaced when creating the new resource
+    dmResource::SResourceDescriptor* rd = dmResource::FindByHash(g_ResourceModule.m_Factory, canonical_path_hash);
+    if (rd && rd->m_ReferenceCount > 0)
     {
         luaL_error(L, "Unable to create resource, a resource is already registered at path '%s'", path_str);
     }
@@ -1244,7 +1246,8 @@ static int ReleaseResource(lua_State* L)
     dmhash_t path_hash = dmScript::CheckHashOrString(L, 1);
 
     dmResource::SResourceDescriptor* rd = dmResource::FindByHash(g_ResourceModule.m_Factory, path_hash);
-    if (!rd)
+    // Resources in the resource cache have no references left to release
+    if (!rd || rd->m_ReferenceCount == 0)
     {
         return DM_LUA_ERROR("Could not get resource: %s", dmHashReverseSafe64(path_hash));
     }
@@ -1260,6 +1263,101 @@ static int ReleaseResource(lua_State* L)
     return 0;
 }
 
+/*# prefetch resources
+ * Loads resources in the background and keeps them in the resource cache, without referencing them.
+ * When the resources are later needed, e.g. when a collection proxy using them is loaded, they
+ * are taken from the cache instead of being loaded again.
+ *
+ * The resource cache is enabled by setting "resource.cache_size" in the "game.project" settings file.
+ * Cached resources are evicted, least recently used first, to stay within the cache size.
+ *
+ * @name resource.prefetch
+ *
+ * @param paths [type:string|table] The path of the resource, or a table of resource paths, to prefetch
+ * @return success [type:boolean] false if the resource cache is disabled
+ *
+ * @examples
+ *
+ * ```lua
+ * function on_message(self, message_id, message, sender)
+ *     if message_id == hash("level_started") then
+ *         -- warm up the next level while playing this one
+ *         resource.prefetch({"/levels/level2.collectionc", "/levels/level2_music.oggc"})
+ *     end
+ * end
+ * ```
+ */
+static int Prefetch(lua_State* L)
+{
+    DM_LUA_STACK_CHECK(L, 1);
+
+    dmArray<const char*> paths;
+    if (lua_istable(L, 1))
+    {
+        paths.SetCapacity(lua_objlen(L, 1));
+        lua_pushnil(L);
+        while (lua_next(L, 1) != 0)
+        {
+            paths.Push(luaL_checkstring(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    else
+    {
+        paths.SetCapacity(1);
+        paths.Push(luaL_checkstring(L, 1));
+    }
+
+    if (paths.Empty())
+    {
+        return DM_LUA_ERROR("No resources to prefetch");
+    }
+
+    dmResource::Result r = dmResource::Prefetch(g_ResourceModule.m_Factory, paths);
+    if (r == dmResource::RESULT_NOT_SUPPORTED)
+    {
+        dmLogWarning("Unable to prefetch resources, the resource cache is disabled (see resource.cache_size in game.project)");
+    }
+    lua_pushboolean(L, r == dmResource::RESULT_OK);
+    return 1;
+}
+
+/*# set the resource cache budget
+ * Sets the max number of bytes of unreferenced resources kept in the resource cache.
+ * The budget can be set for all resources, or for the resources of one type.
+ * Cached resources are evicted, least recently used first, to stay within the new budget.
+ *
+ * @name resource.set_cache_budget
+ *
+ * @param size [type:number] The budget in bytes. A total budget of 0 disables the resource cache
+ * @param [ext] [type:string] The resource type extension (e.g. "texturec"). If omitted, the total budget is set
+ *
+ * @examples
+ *
+ * ```lua
+ * function init(self)
+ *     -- keep at most 32MB of textures and 8MB of sounds around for the next level
+ *     resource.set_cache_budget(48 * 1024 * 1024)
+ *     resource.set_cache_budget(32 * 1024 * 1024, "texturec")
+ *     resource.set_cache_budget(8 * 1024 * 1024, "oggc")
+ * end
+ * ```
+ */
+static int SetCacheBudget(lua_State* L)
+{
+    DM_LUA_STACK_CHECK(L, 0);
+
+    uint32_t size = (uint32_t) luaL_checkinteger(L, 1);
+    const char* ext = luaL_optstring(L, 2, 0);
+
+    dmResource::Result r = dmResource::SetCacheBudget(g_ResourceModule.m_Factory, ext, size);
+    if (r != dmResource::RESULT_OK)
+    {
+        return DM_LUA_ERROR("Unknown resource type: %s", ext);
+    }
+    return 0;
+}
+
 /*# set a texture
  * Sets the pixel data for a specific texture.
  *
@@ -1576,10 +1674,10 @@ static int SetTexture(lua_State* L)
 
 static void PushTextureInfo(lua_State* L, dmGraphics::HTexture texture_handle)
 {
-    uint32_t texture_width               = dmGraphics::GetTextureWidth(texture_handle);
-    uint32_t texture_height              = dmGraphics::GetTextureHeight(texture_handle);
+    uint32_t texture_width               = GetFullTextureWidth(texture_handle);
+    uint32_t texture_height              = GetFullTextureHeight(texture_handle);
     uint32_t texture_depth               = dmGraphics::GetTextureDepth(texture_handle);
-    uint32_t texture_mipmaps             = dmGraphics::GetTextureMipmapCount(texture_handle);
+    uint32_t texture_mipmaps             = GetFullTextureMipmapCount(texture_handle);
     dmGraphics::TextureType texture_type = dmGraphics::GetTextureType(texture_handle);
 
     lua_pushnumber(L, texture_handle);
@@ -1967,8 +2065,8 @@ static void MakeTextureSetFromLua(lua_State* L, dmhash_t texture_path_hash, dmGr
     texture_set_ddf->m_Texture     = 0;
     texture_set_ddf->m_TextureHash = texture_path_hash;
 
-    float tex_width            = dmGraphics::GetTextureWidth(texture);
-    float tex_height           = dmGraphics::GetTextureHeight(texture);
+    float tex_width            = GetFullTextureWidth(texture);
+    float tex_height           = GetFullTextureHeight(texture);
     uint32_t frame_index_count = 0;
 
     texture_set_ddf->m_Geometries.m_Data  = new dmGameSystemDDF::SpriteGeometry[num_geometries];
@@ -2578,8 +2676,8 @@ static int GetAtlas(lua_State* L)
     dmGameSystemDDF::TextureSet* texture_set = texture_set_res->m_TextureSet;
     assert(texture_set);
 
-    float tex_width  = (float) dmGraphics::GetTextureWidth(texture_set_res->m_Texture->m_Texture);
-    float tex_height = (float) dmGraphics::GetTextureHeight(texture_set_res->m_Texture->m_Texture);
+    float tex_width  = (float) GetFullTextureWidth(texture_set_res->m_Texture->m_Texture);
+    float tex_height = (float) GetFullTextureHeight(texture_set_res->m_Texture->m_Texture);
 
     #define SET_LUA_TABLE_FIELD(set_fn, key, val) \
         set_fn(L, val); \
@@ -2962,6 +3060,9 @@ static int GetBuffer(lua_State* L)
         return luaL_error(L, "The buffer handle is invalid");
     }
 
+    // The script may write to the buffer
+    dmResource::SetUncacheable(g_ResourceModule.m_Factory, path_hash);
+
     dmResource::IncRef(g_ResourceModule.m_Factory, buffer_resource);
     dmScript::LuaHBuffer luabuf(g_ResourceModule.m_Factory, (void*)buffer_resource);
     PushBuffer(L, luabuf);
@@ -3044,6 +3145,8 @@ static int SetBuffer(lua_State* L)
     dmGameSystem::BufferResource* buffer_resource = (dmGameSystem::BufferResource*)resource;
     dmBuffer::HBuffer dst_buffer                  = buffer_resource->m_Buffer;
 
+    dmResource::SetUncacheable(g_ResourceModule.m_Factory, path_hash);
+
     if (transfer_ownership)
     {
         if (src_buffer != dst_buffer)
@@ -3224,6 +3327,8 @@ static const luaL_reg Module_methods[] =
     {"create_texture", CreateTexture},
     {"create_texture_async", CreateTextureAsync},
     {"release", ReleaseResource},
+    {"prefetch", Prefetch},
+    {"set_cache_budget", SetCacheBudget},
     {"set_atlas", SetAtlas},
     {"get_atlas", GetAtlas},
     {"set_texture", SetTexture},
@@ -14,6 +14,9 @@
 
 #include <dlib/opaque_handle_container.h>
 #include <dlib/job_thread.h>
+#include <dlib/atomic.h>
+#include <dlib/memory.h>
+#include <dlib/time.h>
 
 #include <resource/resource.h>
 
@@ -59,12 +62,36 @@ namespace dmGameSystem
         RequestStatus              m_Status;
     };
 
+    enum SaveState
+    {
+        SAVE_STATE_QUEUED    = 0, // Waiting for the previous save to finish
+        SAVE_STATE_PENDING   = 1, // Pushed to the job thread
+        SAVE_STATE_WRITING   = 2,
+        SAVE_STATE_DONE      = 3, // Written, waiting for the job completion callback
+        SAVE_STATE_COMPLETED = 4, // Ready for the Lua callback
+    };
+
+    struct SaveRequest
+    {
+        dmScript::LuaCallbackInfo* m_CallbackInfo;
+        char*                      m_Path;
+        char*                      m_Data;
+        uint32_t                   m_DataSize;
+        int32_atomic_t             m_State;
+        char                       m_Error[256];
+        bool                       m_Result;    // Written by the job
+        bool                       m_Abandoned; // Freed by the job completion callback
+    };
+
     struct SysModule
     {
         dmResource::HFactory                m_Factory;
         dmJobThread::HContext               m_JobThread;
         dmOpaqueHandleContainer<LuaRequest> m_LoadRequests;
         dmMutex::HMutex                     m_LoadRequestsMutex;
+        // Saves are written one at a time, in the order they were issued.
+        // Only accessed from the main thread, the job only touches its own request.
+        dmArray<SaveRequest*>               m_SaveRequests;
         uint8_t                             m_LastUpdateResult : 1; // For tests
     } g_SysModule;
 
@@ -371,10 +398,190 @@ namespace dmGameSystem
         return 1;
     }
 
+    static void FreeSaveRequest(SaveRequest* request)
+    {
+        dmMemory::AlignedFree(request->m_Data);
+        free(request->m_Path);
+        delete request;
+    }
+
+    static void WriteSaveRequest(SaveRequest* request)
+    {
+        request->m_Result = dmScript::WriteSaveFile(request->m_Path, request->m_Data, request->m_DataSize, request->m_Error, sizeof(request->m_Error));
+        dmAtomicStore32(&request->m_State, SAVE_STATE_DONE);
+    }
+
+    // Called from job thread
+    static int SaveFunctionCallback(void* context, void* data)
+    {
+        SaveRequest* request = (SaveRequest*) context;
+        // The save may already have been written by ScriptSysGameSysFinalize
+        if (dmAtomicCompareStore32(&request->m_State, SAVE_STATE_WRITING, SAVE_STATE_PENDING) == SAVE_STATE_PENDING)
+        {
+            WriteSaveRequest(request);
+        }
+        return 0;
+    }
+
+    // Called from the main thread
+    static void SaveCompleteCallback(void* context, void* data, int result)
+    {
+        SaveRequest* request = (SaveRequest*) context;
+        if (request->m_Abandoned)
+        {
+            FreeSaveRequest(request);
+            return;
+        }
+        dmAtomicStore32(&request->m_State, SAVE_STATE_COMPLETED);
+    }
+
+    static void DispatchSaveRequest(SaveRequest* request)
+    {
+        dmAtomicStore32(&request->m_State, SAVE_STATE_PENDING);
+        dmJobThread::PushJob(g_SysModule.m_JobThread,
+            SaveFunctionCallback,
+            SaveCompleteCallback,
+            (void*) request, 0);
+    }
+
+    static bool HandleSaveCompleted(SaveRequest* request)
+    {
+        bool result = true;
+        if (!request->m_Result)
+        {
+            dmLogError("sys.save_async failed: %s", request->m_Error);
+        }
+
+        if (request->m_CallbackInfo && dmScript::IsCallbackValid(request->m_CallbackInfo))
+        {
+            lua_State* L = dmScript::GetCallbackLuaContext(request->m_CallbackInfo);
+            DM_LUA_STACK_CHECK(L, 0);
+
+            // callback has the format:
+            // function(self, filename, result)
+            //  result contains:
+            //      - status: request status
+            //      - error: if unsuccessful, a description of the error
+            if (dmScript::SetupCallback(request->m_CallbackInfo))
+            {
+                lua_pushstring(L, request->m_Path);
+
+                lua_newtable(L);
+                lua_pushnumber(L, request->m_Result ? REQUEST_STATUS_FINISHED : REQUEST_STATUS_ERROR_IO_ERROR);
+                lua_setfield(L, -2, "status");
+
+                if (!request->m_Result)
+                {
+                    lua_pushstring(L, request->m_Error);
+                    lua_setfield(L, -2, "error");
+                }
+
+                result = dmScript::PCall(L, 3, 0) == 0;
+                dmScript::TeardownCallback(request->m_CallbackInfo);
+            }
+            else
+            {
+                dmLogError("Failed to setup sys.save_async callback (has the calling script been destroyed?)");
+                result = false;
+            }
+        }
+
+        if (request->m_CallbackInfo)
+        {
+            dmScript::DestroyCallback(request->m_CallbackInfo);
+        }
+        FreeSaveRequest(request);
+        return result;
+    }
+
+    /*# saves a lua table to a file stored on disk asynchronously
+     * The table is serialized before the function returns, and the file is written on a
+     * worker thread, so later changes to the table are not included in the file.
+     * The format is the same as for <code>sys.save</code>, and the file can later be loaded
+     * by <code>sys.load</code>.
+     *
+     * Saves are written in the order they were issued. Until the callback has been invoked,
+     * <code>sys.load</code> may return the previous contents of the file.
+     * Pending saves are written before the engine shuts down.
+     *
+     * @name sys.save_async
+     * @param filename [type:string] file to write to
+     * @param table [type:table] lua table to save
+     * @param [status_callback] [type:function(self, filename, result)] A status callback that will be invoked when the file has been written, or an error occured. The result is a table containing:
+     *
+     * `status`
+     * : [type:number] The status of the request, supported values are:
+     *
+     * - `sys.REQUEST_STATUS_FINISHED`
+     * - `sys.REQUEST_STATUS_ERROR_IO_ERROR`
+     *
+     * `error`
+     * : [type:string] If the request failed, this contains a description of the error, and nil otherwise.
+     *
+     * @examples
+     *
+     * Save data in the background:
+     *
+     * ```lua
+     * local my_table = {}
+     * table.insert(my_table, "my_value")
+     * local my_file_path = sys.get_save_file("my_game", "my_file")
+     * sys.save_async(my_file_path, my_table, function(self, filename, result)
+     *     if result.status ~= sys.REQUEST_STATUS_FINISHED then
+     *         print("Failed to save", filename, result.error)
+     *     end
+     * end)
+     * ```
+     */
+    static int Sys_SaveAsync(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        const char* filename = luaL_checkstring(L, 1);
+        luaL_checktype(L, 2, LUA_TTABLE);
+
+        char* data = 0;
+        uint32_t data_size = dmScript::SerializeTable(L, 2, &data);
+
+        dmScript::LuaCallbackInfo* callback_info = 0;
+        if (!lua_isnoneornil(L, 3))
+        {
+            luaL_checktype(L, 3, LUA_TFUNCTION);
+            callback_info = dmScript::CreateCallback(dmScript::GetMainThread(L), 3);
+            if (callback_info == 0x0)
+            {
+                dmMemory::AlignedFree(data);
+                return DM_LUA_ERROR("sys.save_async failed to create callback");
+            }
+        }
+
+        SaveRequest* request     = new SaveRequest();
+        request->m_CallbackInfo  = callback_info;
+        request->m_Path          = strdup(filename);
+        request->m_Data          = data;
+        request->m_DataSize      = data_size;
+        request->m_State         = SAVE_STATE_QUEUED;
+        request->m_Error[0]      = 0;
+        request->m_Result        = false;
+        request->m_Abandoned     = false;
+
+        if (g_SysModule.m_SaveRequests.Full())
+        {
+            g_SysModule.m_SaveRequests.OffsetCapacity(4);
+        }
+        g_SysModule.m_SaveRequests.Push(request);
+
+        if (g_SysModule.m_SaveRequests.Size() == 1)
+        {
+            DispatchSaveRequest(request);
+        }
+        return 0;
+    }
+
     static const luaL_reg ScriptImage_methods[] =
     {
         {"load_buffer",       Sys_LoadBuffer},
         {"load_buffer_async", Sys_LoadBufferAsync},
+        {"save_async",        Sys_SaveAsync},
         {0, 0}
     };
 
@@ -439,6 +646,20 @@ namespace dmGameSystem
             dmMutex::Unlock(g_SysModule.m_LoadRequestsMutex);
         }
 
+        dmArray<SaveRequest*>& save_requests = g_SysModule.m_SaveRequests;
+        while (!save_requests.Empty() && dmAtomicGet32(&save_requests[0]->m_State) == SAVE_STATE_COMPLETED)
+        {
+            SaveRequest* request = save_requests[0];
+            uint32_t remaining = save_requests.Size() - 1;
+            memmove(save_requests.Begin(), save_requests.Begin() + 1, sizeof(SaveRequest*) * remaining);
+            save_requests.SetSize(remaining);
+            if (!save_requests.Empty())
+            {
+                DispatchSaveRequest(save_requests[0]);
+            }
+            result &= HandleSaveCompleted(request);
+        }
+
         g_SysModule.m_LastUpdateResult = result;
     }
 
@@ -461,6 +682,50 @@ namespace dmGameSystem
             }
         }
 
+        // Make sure all saves reach the disk. The callbacks are not invoked, since the scripts are going away.
+        dmArray<SaveRequest*>& save_requests = g_SysModule.m_SaveRequests;
+        for (uint32_t i = 0; i < save_requests.Size(); ++i)
+        {
+            SaveRequest* request = save_requests[i];
+            if (request->m_CallbackInfo)
+            {
+                dmScript::DestroyCallback(request->m_CallbackInfo);
+                request->m_CallbackInfo = 0;
+            }
+
+            int32_t state = dmAtomicGet32(&request->m_State);
+            if (state == SAVE_STATE_QUEUED || dmAtomicCompareStore32(&request->m_State, SAVE_STATE_WRITING, SAVE_STATE_PENDING) == SAVE_STATE_PENDING)
+            {
+                // The job (if any) will see that the save is already taken care of
+                WriteSaveRequest(request);
+            }
+            else
+            {
+                while (dmAtomicGet32(&request->m_State) == SAVE_STATE_WRITING)
+                {
+                    dmTime::Sleep(1000);
+                }
+            }
+
+            if (!request->m_Result)
+            {
+                dmLogError("sys.save_async failed: %s", request->m_Error);
+            }
+
+            if (state == SAVE_STATE_QUEUED || dmAtomicGet32(&request->m_State) == SAVE_STATE_COMPLETED)
+            {
+                FreeSaveRequest(request);
+            }
+            else
+            {
+                // The job completion callback hasn't run yet
+                dmMemory::AlignedFree(request->m_Data);
+                request->m_Data = 0;
+                request->m_Abandoned = true;
+            }
+        }
+        save_requests.SetSize(0);
+
         g_SysModule.m_Factory           = 0;
         g_SysModule.m_LoadRequestsMutex = 0;
     }
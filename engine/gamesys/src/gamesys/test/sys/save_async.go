@@ -0,0 +1,4 @@
+components {
+  id: "script"
+  component: "/sys/save_async.script"
+}
@@ -3206,6 +3206,71 @@ ResourceFailParams invalid_texture_resources[] =
 };
 INSTANTIATE_TEST_CASE_P(Texture, ResourceFailTest, jc_test_values_in(invalid_texture_resources));
 
+// valid_png is 64x64 with all mipmaps, and is created at 16x16 when two mipmaps are streamed
+TEST_F(TextureStreamingTest, StreamIn)
+{
+    InitializeTextureStreaming(2, 0);
+
+    dmGameSystem::TextureResource* texture_res;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/texture/valid_png.texturec", (void**) &texture_res));
+    dmGraphics::HTexture texture = texture_res->m_Texture;
+    ASSERT_TRUE(dmGameSystem::IsTextureStreamed(texture));
+    ASSERT_EQ(16, dmGraphics::GetTextureWidth(texture));
+
+    // The reported size doesn't change while the texture is streamed
+    ASSERT_EQ(64, dmGameSystem::GetFullTextureWidth(texture));
+    ASSERT_EQ(64, dmGameSystem::GetFullTextureHeight(texture));
+    ASSERT_EQ(7, dmGameSystem::GetFullTextureMipmapCount(texture));
+
+    ASSERT_TRUE(WaitForTextureWidth(texture, 0, 64));
+    ASSERT_EQ(64, dmGraphics::GetTextureHeight(texture));
+    ASSERT_EQ(64, dmGameSystem::GetFullTextureWidth(texture));
+    ASSERT_TRUE(dmGameSystem::IsTextureStreamed(texture));
+
+    dmResource::Release(m_Factory, texture_res);
+}
+
+TEST_F(TextureStreamingTest, StreamOut)
+{
+    InitializeTextureStreaming(2, 0);
+
+    dmGameSystem::TextureResource* texture_res;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/texture/valid_png.texturec", (void**) &texture_res));
+    dmGraphics::HTexture texture = texture_res->m_Texture;
+    ASSERT_TRUE(WaitForTextureWidth(texture, 0, 64));
+
+    // Without requests, the texture falls back to its base mipmap
+    ASSERT_TRUE(WaitForTextureWidth(texture, -1, 16));
+    ASSERT_EQ(64, dmGameSystem::GetFullTextureWidth(texture));
+
+    dmResource::Release(m_Factory, texture_res);
+}
+
+TEST_F(TextureStreamingTest, StreamInOverBudget)
+{
+    InitializeTextureStreaming(2, 0);
+
+    dmGameSystem::TextureResource* texture_res;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/texture/valid_png.texturec", (void**) &texture_res));
+    uint32_t size = dmGraphics::GetTextureResourceSize(texture_res->m_Texture);
+    dmResource::Release(m_Factory, texture_res);
+    dmGameSystem::FinalizeTextureStreaming();
+
+    // Each mipmap is four times the size of the next one, so only the first streamed mipmap fits
+    InitializeTextureStreaming(2, size * 4);
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/texture/valid_png.texturec", (void**) &texture_res));
+    dmGraphics::HTexture texture = texture_res->m_Texture;
+    ASSERT_EQ(size, dmGraphics::GetTextureResourceSize(texture));
+    ASSERT_TRUE(WaitForTextureWidth(texture, 0, 32));
+
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        ASSERT_TRUE(WaitForTextureWidth(texture, 0, 32));
+    }
+
+    dmResource::Release(m_Factory, texture_res);
+}
+
 /* Vertex Program */
 
 const char* valid_vp_resources[] = {"/vertex_program/valid.vpc"};
@@ -5016,6 +5081,44 @@ TEST_F(SysTest, LoadBufferASync)
     dmJobThread::Destroy(scriptlibcontext.m_JobThread);
 }
 
+TEST_F(SysTest, SaveAsync)
+{
+    dmJobThread::JobThreadCreationParams job_thread_create_param;
+    job_thread_create_param.m_ThreadNames[0] = "test_gamesys_thread";
+    job_thread_create_param.m_ThreadCount    = 1;
+
+    dmGameSystem::ScriptLibContext scriptlibcontext;
+    scriptlibcontext.m_Factory         = m_Factory;
+    scriptlibcontext.m_Register        = m_Register;
+    scriptlibcontext.m_LuaState        = dmScript::GetLuaState(m_ScriptContext);
+    scriptlibcontext.m_GraphicsContext = m_GraphicsContext;
+    scriptlibcontext.m_ScriptContext   = m_ScriptContext;
+    scriptlibcontext.m_JobThread       = dmJobThread::Create(job_thread_create_param);
+
+    dmGameSystem::InitializeScriptLibs(scriptlibcontext);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/sys/save_async.goc", dmHashString64("/save_async"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    // Ordered writes
+    ASSERT_TRUE(RunTestLoadBufferASync(1, scriptlibcontext, m_Collection, &m_UpdateContext, false));
+
+    // Invalid path
+    ASSERT_TRUE(RunTestLoadBufferASync(2, scriptlibcontext, m_Collection, &m_UpdateContext, false));
+
+    // No callback
+    ASSERT_TRUE(RunTestLoadBufferASync(3, scriptlibcontext, m_Collection, &m_UpdateContext, false));
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    dmGameSystem::FinalizeScriptLibs(scriptlibcontext);
+
+    dmJobThread::Destroy(scriptlibcontext.m_JobThread);
+
+    dmSys::Unlink("build/src/gamesys/test/sys/save_async.save");
+}
+
 #ifdef DM_HAVE_PLATFORM_COMPUTE_SUPPORT
 
 TEST_F(ShaderTest, Compute)
@@ -19,6 +19,7 @@
 
 #include <dlib/buffer.h>
 #include <dlib/testutil.h>
+#include <dlib/time.h>
 #include <hid/hid.h>
 
 #include <sound/sound.h>
@@ -28,6 +29,7 @@
 
 #include "gamesys/gamesys.h"
 #include "gamesys/scripts/script_buffer.h"
+#include "gamesys/resources/res_texture.h"
 #include "../components/comp_gui_private.h" // BoxVertex
 #include "../components/comp_gui.h" // The GuiGetURLCallback et.al
 #include "../../../../graphics/src/graphics_private.h" // for unit test functions
@@ -236,6 +238,49 @@ public:
     virtual ~ResourceFailTest() {}
 };
 
+class TextureStreamingTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~TextureStreamingTest() {}
+protected:
+    virtual void TearDown()
+    {
+        dmGameSystem::FinalizeTextureStreaming();
+        GamesysTest<const char*>::TearDown();
+    }
+
+    void InitializeTextureStreaming(uint32_t mipmaps, uint32_t memory_budget)
+    {
+        dmGameSystem::TextureStreamingParams params;
+        params.m_Factory         = m_Factory;
+        params.m_GraphicsContext = m_GraphicsContext;
+        params.m_JobThread       = m_JobThread;
+        params.m_MipMaps         = mipmaps;
+        params.m_MemoryBudget    = memory_budget;
+        dmGameSystem::InitializeTextureStreaming(params);
+    }
+
+    // Updates the texture streaming until the texture has the width, requesting the mipmap each frame unless it's -1
+    bool WaitForTextureWidth(dmGraphics::HTexture texture, int32_t mipmap, uint16_t width)
+    {
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            if (mipmap >= 0)
+            {
+                dmGameSystem::RequestTextureMipMap(texture, (uint32_t) mipmap);
+            }
+            dmJobThread::Update(m_JobThread);
+            dmGameSystem::UpdateTextureStreaming();
+            if (dmGraphics::GetTextureWidth(texture) == width)
+            {
+                return true;
+            }
+            dmTime::Sleep(1000);
+        }
+        return false;
+    }
+};
+
 class InvalidVertexSpaceTest : public GamesysTest<const char*>
 {
 public:
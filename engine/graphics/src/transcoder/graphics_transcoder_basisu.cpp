@@ -15,6 +15,8 @@
 #include <dlib/log.h>
 #include <dlib/math.h>
 #include <dlib/profile.h>
+#include <dlib/time.h>
+#include <dmsdk/dlib/atomic.h>
 #include "graphics.h"
 #include <basis/transcoder/basisu_transcoder.h>
 
@@ -287,6 +289,27 @@ namespace dmGraphics
         return true;
     }
 
+    // Transcoding happens on the resource loader threads, so the one-time init must be thread safe
+    static int32_atomic_t g_TranscoderInitState = 0; // 0: not initialized, 1: initializing, 2: initialized
+
+    static void InitTranscoder()
+    {
+        if (dmAtomicGet32(&g_TranscoderInitState) == 2)
+            return;
+
+        if (dmAtomicCompareStore32(&g_TranscoderInitState, 1, 0) == 0)
+        {
+            basist::basisu_transcoder_init();
+            dmAtomicStore32(&g_TranscoderInitState, 2);
+            return;
+        }
+
+        while (dmAtomicGet32(&g_TranscoderInitState) != 2)
+        {
+            dmTime::Sleep(100);
+        }
+    }
+
     bool Transcode(const char* path, dmGraphics::TextureImage::Image* image, uint8_t image_count, dmGraphics::TextureFormat format,
                     uint8_t** images, uint32_t* sizes, uint32_t* num_transcoded_mips)
     {
@@ -294,12 +317,7 @@ namespace dmGraphics
 
         assert(image_count > 0);
 
-        static int first = 1;
-        if (first)
-        {
-            first = 0;
-            basist::basisu_transcoder_init();
-        }
+        InitTranscoder();
 
         basist::transcoder_texture_format transcoder_format;
         if (!TextureFormatToBasisFormat(format, transcoder_format))
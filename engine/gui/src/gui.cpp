@@ -1826,14 +1826,7 @@ namespace dmGui
                             // Try to find the message name via id and reverse hash
                             message_name = (const char*)dmHashReverse64(message->m_Id, 0);
                         }
-                        if (message->m_DataSize > 0)
-                        {
-                            dmScript::PushTable(L, (const char*) message->m_Data, message->m_DataSize);
-                        }
-                        else
-                        {
-                            lua_newtable(L);
-                        }
+                        dmScript::PushMessageTable(L, message);
                     }
 
                     dmScript::PushURL(L, message->m_Sender);
@@ -83,6 +83,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_sleepTime = 0.0f;
 
+	// Defold modifications. Never matches a real transform, forcing an initial synchronization
+	m_syncPosition.Set(b2_maxFloat, b2_maxFloat);
+	m_syncAngle = b2_maxFloat;
+
 	m_type = bd->type;
 
 	if (m_type == b2_dynamicBody)
@@ -391,6 +391,10 @@ public:
 
     void SynchronizeFixtures();
 
+    // Defold modifications
+    b2Vec2 m_syncPosition; // DEFOLD: Body position when last synchronized with the external transform
+    float32 m_syncAngle; // DEFOLD: Body angle when last synchronized with the external transform
+
 private:
 
 	friend class b2World;
@@ -20,6 +20,7 @@
 #include <dmsdk/dlib/vmath.h>
 
 #include <dlib/hash.h>
+#include <dlib/job_thread.h>
 #include <dlib/message.h>
 #include <dlib/transform.h>
 
@@ -39,6 +40,14 @@ namespace dmPhysics
         COLLISION_OBJECT_TYPE_COUNT
     };
 
+    enum Broadphase3D
+    {
+        /// Sweep and prune, limited to the world AABB
+        BROADPHASE_3D_AXIS_SWEEP,
+        /// Dynamic AABB trees, without world bounds
+        BROADPHASE_3D_DBVT,
+    };
+
     enum JointType
     {
         JOINT_TYPE_SPRING,
@@ -131,6 +140,14 @@ namespace dmPhysics
      * @param rotation Rotation that the external object will obtain
      */
     typedef void (*SetWorldTransformCallback)(void* user_data, const dmVMath::Point3& position, const dmVMath::Quat& rotation);
+    /**
+     * Callback used to check if the world transform of an external object has changed since the previous call.
+     * Objects reported as unchanged are not synchronized into the physics simulation.
+     *
+     * @param user_data User data pointing to the external object
+     * @return true if the world transform might have changed since the previous call
+     */
+    typedef bool (*WorldTransformChangedCallback)(void* user_data);
 
     /**
      * Callback used to signal collisions.
@@ -247,6 +264,10 @@ namespace dmPhysics
         uint32_t m_RayCastLimit3D;
         /// Maximum number of overlapping triggers
         uint32_t m_TriggerOverlapCapacity;
+        /// Broadphase used by 3D worlds
+        Broadphase3D m_Broadphase3D;
+        /// Job thread used to run the 3D narrowphase in parallel with the calling thread, 0x0 to run it single threaded
+        dmJobThread::HContext m_JobThread;
         /// If true, the collision objects will retrieve the position of its game object
         uint8_t m_AllowDynamicTransforms:1;
         uint8_t :7;
@@ -309,6 +330,8 @@ namespace dmPhysics
         GetWorldTransformCallback m_GetWorldTransformCallback;
         /// param set_world_transform Callback for copying the transform from the collision object to the corresponding user data
         SetWorldTransformCallback m_SetWorldTransformCallback;
+        /// param world_transform_changed Optional callback for checking if the transform of the corresponding user data has changed
+        WorldTransformChangedCallback m_WorldTransformChangedCallback;
         /// max number of collision objects
         uint32_t m_MaxCollisionObjectsCount;
     };
@@ -56,6 +56,7 @@ namespace dmPhysics
     , m_ContactListener(this)
     , m_GetWorldTransformCallback(params.m_GetWorldTransformCallback)
     , m_SetWorldTransformCallback(params.m_SetWorldTransformCallback)
+    , m_WorldTransformChangedCallback(params.m_WorldTransformChangedCallback)
     , m_AllowDynamicTransforms(context->m_AllowDynamicTransforms)
     {
         m_RayCastRequests.SetCapacity(context->m_RayCastLimit);
@@ -371,11 +372,8 @@ namespace dmPhysics
         return dmMath::Min(v[0], v[1]);
     }
 
-    static void UpdateScale(HWorld2D world, b2Body* body)
+    static void UpdateScale(b2Body* body, dmTransform::Transform& world_transform)
     {
-        dmTransform::Transform world_transform;
-        (*world->m_GetWorldTransformCallback)(body->GetUserData(), world_transform);
-
         float object_scale = GetUniformScale2D(world_transform);
 
         b2Fixture* fix = body->GetFixtureList();
@@ -434,39 +432,54 @@ namespace dmPhysics
             {
                 bool retrieve_gameworld_transform = world->m_AllowDynamicTransforms && body->GetType() != b2_staticBody;
 
+                if (!retrieve_gameworld_transform && body->GetType() != b2_kinematicBody)
+                {
+                    continue;
+                }
+
+                // Skip bodies where neither the external transform nor the body has changed since the last synchronization
+                if (world->m_WorldTransformChangedCallback
+                    && body->GetPosition() == body->m_syncPosition && body->GetAngle() == body->m_syncAngle
+                    && !(*world->m_WorldTransformChangedCallback)(body->GetUserData()))
+                {
+                    body->SetSleepingAllowed(true);
+                    continue;
+                }
+
+                dmTransform::Transform world_transform;
+                (*world->m_GetWorldTransformCallback)(body->GetUserData(), world_transform);
+
                 // translate & rotation
-                if (retrieve_gameworld_transform || body->GetType() == b2_kinematicBody)
+                Point3 old_position = GetWorldPosition2D(context, body);
+                Point3 position = Point3(world_transform.GetTranslation());
+                // Ignore z-component
+                position.setZ(0.0f);
+                Quat rotation = world_transform.GetRotation();
+                float dp = distSqr(old_position, position);
+                float angle = atan2(2.0f * (rotation.getW() * rotation.getZ() + rotation.getX() * rotation.getY()), 1.0f - 2.0f * (rotation.getY() * rotation.getY() + rotation.getZ() * rotation.getZ()));
+                float old_angle = body->GetAngle();
+                float da = old_angle - angle;
+
+                if (dp > POS_EPSILON || fabsf(da) > ROT_EPSILON)
                 {
-                    Point3 old_position = GetWorldPosition2D(context, body);
-                    dmTransform::Transform world_transform;
-                    (*world->m_GetWorldTransformCallback)(body->GetUserData(), world_transform);
-                    Point3 position = Point3(world_transform.GetTranslation());
-                    // Ignore z-component
-                    position.setZ(0.0f);
-                    Quat rotation = world_transform.GetRotation();
-                    float dp = distSqr(old_position, position);
-                    float angle = atan2(2.0f * (rotation.getW() * rotation.getZ() + rotation.getX() * rotation.getY()), 1.0f - 2.0f * (rotation.getY() * rotation.getY() + rotation.getZ() * rotation.getZ()));
-                    float old_angle = body->GetAngle();
-                    float da = old_angle - angle;
-
-                    if (dp > POS_EPSILON || fabsf(da) > ROT_EPSILON)
-                    {
-                        b2Vec2 b2_position;
-                        ToB2(position, b2_position, scale);
-                        body->SetTransform(b2_position, angle);
-                        body->SetSleepingAllowed(false);
-                    }
-                    else
-                    {
-                        body->SetSleepingAllowed(true);
-                    }
+                    b2Vec2 b2_position;
+                    ToB2(position, b2_position, scale);
+                    body->SetTransform(b2_position, angle);
+                    body->SetSleepingAllowed(false);
+                }
+                else
+                {
+                    body->SetSleepingAllowed(true);
                 }
 
                 // Scaling
                 if(retrieve_gameworld_transform)
                 {
-                    UpdateScale(world, body);
+                    UpdateScale(body, world_transform);
                 }
+
+                body->m_syncPosition = body->GetPosition();
+                body->m_syncAngle = body->GetAngle();
             }
         }
         {
@@ -474,16 +487,25 @@ namespace dmPhysics
             world->m_ContactListener.SetStepWorldContext(&step_context);
             world->m_World.Step(dt, 10, 10);
             float inv_scale = world->m_Context->m_InvScale;
-            // Update transforms of dynamic bodies
+            // Update transforms of dynamic bodies that moved during the step
             if (world->m_SetWorldTransformCallback)
             {
                 for (b2Body* body = world->m_World.GetBodyList(); body; body = body->GetNext())
                 {
                     if (body->GetType() == b2_dynamicBody && body->IsActive())
                     {
+                        const b2Vec2& b2_position = body->GetPosition();
+                        float angle = body->GetAngle();
+                        if (b2_position == body->m_syncPosition && angle == body->m_syncAngle)
+                        {
+                            continue;
+                        }
+                        body->m_syncPosition = b2_position;
+                        body->m_syncAngle = angle;
+
                         Point3 position;
-                        FromB2(body->GetPosition(), position, inv_scale);
-                        Quat rotation = Quat::rotationZ(body->GetAngle());
+                        FromB2(b2_position, position, inv_scale);
+                        Quat rotation = Quat::rotationZ(angle);
                         (*world->m_SetWorldTransformCallback)(body->GetUserData(), position, rotation);
                     }
                 }
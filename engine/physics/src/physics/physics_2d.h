@@ -54,6 +54,7 @@ namespace dmPhysics
         ContactListener             m_ContactListener;
         GetWorldTransformCallback   m_GetWorldTransformCallback;
         SetWorldTransformCallback   m_SetWorldTransformCallback;
+        WorldTransformChangedCallback m_WorldTransformChangedCallback;
         uint8_t                     m_AllowDynamicTransforms:1;
         uint8_t                     :7;
     };
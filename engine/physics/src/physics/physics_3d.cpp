@@ -25,6 +25,7 @@
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
 
 #include "physics_3d.h"
+#include "physics_3d_mt.h"
 
 #include <stdio.h>
 
@@ -123,6 +124,8 @@ namespace dmPhysics
     , m_TriggerEnterLimit(0.0f)
     , m_RayCastLimit(0)
     , m_TriggerOverlapCapacity(0)
+    , m_Broadphase(BROADPHASE_3D_AXIS_SWEEP)
+    , m_JobThread(0x0)
     , m_AllowDynamicTransforms(0)
     {
 
@@ -134,16 +137,31 @@ namespace dmPhysics
     , m_Context(context)
     , m_AllowDynamicTransforms(context->m_AllowDynamicTransforms)
     {
-        m_CollisionConfiguration = new btDefaultCollisionConfiguration();
-        m_Dispatcher = new btCollisionDispatcher(m_CollisionConfiguration);
+        if (context->m_JobThread != 0x0)
+        {
+            m_CollisionConfiguration = new CollisionConfigurationMt(CollisionConfigurationMt::GetConstructionInfo());
+            m_Dispatcher = new CollisionDispatcherMt(m_CollisionConfiguration, context->m_JobThread);
+        }
+        else
+        {
+            m_CollisionConfiguration = new btDefaultCollisionConfiguration();
+            m_Dispatcher = new btCollisionDispatcher(m_CollisionConfiguration);
+        }
 
-        ///the maximum size of the collision world. Make sure objects stay within these boundaries
-        ///Don't make the world AABB size too large, it will harm simulation quality and performance
-        btVector3 world_aabb_min;
-        ToBt(params.m_WorldMin, world_aabb_min, context->m_Scale);
-        btVector3 world_aabb_max;
-        ToBt(params.m_WorldMax, world_aabb_max, context->m_Scale);
-        m_OverlappingPairCache = new btAxisSweep3(world_aabb_min,world_aabb_max, params.m_MaxCollisionObjectsCount);
+        if (context->m_Broadphase == BROADPHASE_3D_DBVT)
+        {
+            m_OverlappingPairCache = new btDbvtBroadphase();
+        }
+        else
+        {
+            ///the maximum size of the collision world. Make sure objects stay within these boundaries
+            ///Don't make the world AABB size too large, it will harm simulation quality and performance
+            btVector3 world_aabb_min;
+            ToBt(params.m_WorldMin, world_aabb_min, context->m_Scale);
+            btVector3 world_aabb_max;
+            ToBt(params.m_WorldMax, world_aabb_max, context->m_Scale);
+            m_OverlappingPairCache = new btAxisSweep3(world_aabb_min,world_aabb_max, params.m_MaxCollisionObjectsCount);
+        }
 
         m_Solver = new btSequentialImpulseConstraintSolver;
 
@@ -291,6 +309,8 @@ namespace dmPhysics
         context->m_RayCastLimit = params.m_RayCastLimit3D;
         context->m_TriggerOverlapCapacity = params.m_TriggerOverlapCapacity;
         context->m_AllowDynamicTransforms = params.m_AllowDynamicTransforms;
+        context->m_Broadphase = params.m_Broadphase3D;
+        context->m_JobThread = params.m_JobThread;
         dmMessage::Result result = dmMessage::NewSocket(PHYSICS_SOCKET_NAME, &context->m_Socket);
         if (result != dmMessage::RESULT_OK)
         {
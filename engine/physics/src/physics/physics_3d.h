@@ -36,7 +36,7 @@ namespace dmPhysics
         HContext3D                              m_Context;
         btDefaultCollisionConfiguration*        m_CollisionConfiguration;
         btCollisionDispatcher*                  m_Dispatcher;
-        btAxisSweep3*                           m_OverlappingPairCache;
+        btBroadphaseInterface*                  m_OverlappingPairCache;
         btSequentialImpulseConstraintSolver*    m_Solver;
         btDiscreteDynamicsWorld*                m_DynamicsWorld;
         GetWorldTransformCallback               m_GetWorldTransform;
@@ -59,6 +59,8 @@ namespace dmPhysics
         float                       m_TriggerEnterLimit;
         int                         m_RayCastLimit;
         int                         m_TriggerOverlapCapacity;
+        Broadphase3D                m_Broadphase;
+        dmJobThread::HContext       m_JobThread;
         uint8_t                     m_AllowDynamicTransforms:1;
         uint8_t                     :7;
     };
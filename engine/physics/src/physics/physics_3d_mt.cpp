@@ -0,0 +1,324 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <new>
+
+#include <dlib/math.h>
+#include <dlib/profile.h>
+#include <dmsdk/dlib/atomic.h>
+#include <dmsdk/dlib/condition_variable.h>
+
+#include "physics_3d_mt.h"
+
+#include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+#include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
+
+namespace dmPhysics
+{
+    // Number of pairs processed per grab from the shared pair counter
+    static const int32_t PAIR_BATCH_SIZE = 32;
+
+    // Below this number of pairs, the overhead of waking the workers isn't worth it
+    static const int32_t MIN_PARALLEL_PAIR_COUNT = 2 * PAIR_BATCH_SIZE;
+
+    static uint32_t GetBodyMutexIndex(void* body)
+    {
+        return (uint32_t)(((uintptr_t)body >> 4) & (CollisionDispatcherMt::BODY_MUTEX_COUNT - 1));
+    }
+
+    class ConvexConvexAlgorithmMt : public btConvexConvexAlgorithm
+    {
+    public:
+        // The base class only stores the solver pointer, so passing the (not yet constructed) member is fine
+        ConvexConvexAlgorithmMt(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, btCollisionObject* body0, btCollisionObject* body1, btConvexPenetrationDepthSolver* pd_solver)
+        : btConvexConvexAlgorithm(mf, ci, body0, body1, &m_SimplexSolver, pd_solver, 0, 3)
+        {
+        }
+
+        btVoronoiSimplexSolver m_SimplexSolver;
+
+        struct CreateFunc : public btCollisionAlgorithmCreateFunc
+        {
+            CreateFunc(btConvexPenetrationDepthSolver* pd_solver)
+            : m_PdSolver(pd_solver)
+            {
+            }
+
+            virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, btCollisionObject* body0, btCollisionObject* body1)
+            {
+                void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(ConvexConvexAlgorithmMt));
+                return new(mem) ConvexConvexAlgorithmMt(ci.m_manifold, ci, body0, body1, m_PdSolver);
+            }
+
+            btConvexPenetrationDepthSolver* m_PdSolver;
+        };
+    };
+
+    CollisionConfigurationMt::CollisionConfigurationMt(const btDefaultCollisionConstructionInfo& construction_info)
+    : btDefaultCollisionConfiguration(construction_info)
+    {
+        void* mem = btAlignedAlloc(sizeof(ConvexConvexAlgorithmMt::CreateFunc), 16);
+        m_ConvexConvexCreateFuncMt = new(mem) ConvexConvexAlgorithmMt::CreateFunc(m_pdSolver);
+    }
+
+    CollisionConfigurationMt::~CollisionConfigurationMt()
+    {
+        m_ConvexConvexCreateFuncMt->~btCollisionAlgorithmCreateFunc();
+        btAlignedFree(m_ConvexConvexCreateFuncMt);
+    }
+
+    btCollisionAlgorithmCreateFunc* CollisionConfigurationMt::getCollisionAlgorithmCreateFunc(int proxy_type0, int proxy_type1)
+    {
+        btCollisionAlgorithmCreateFunc* create_func = btDefaultCollisionConfiguration::getCollisionAlgorithmCreateFunc(proxy_type0, proxy_type1);
+        if (create_func == m_convexConvexCreateFunc)
+            return m_ConvexConvexCreateFuncMt;
+        return create_func;
+    }
+
+    btDefaultCollisionConstructionInfo CollisionConfigurationMt::GetConstructionInfo()
+    {
+        btDefaultCollisionConstructionInfo construction_info;
+        construction_info.m_customCollisionAlgorithmMaxElementSize = sizeof(ConvexConvexAlgorithmMt);
+        return construction_info;
+    }
+
+    /// Pairs shared between the calling thread and the job workers for one dispatch.
+    /// Reference counted since a worker might not pick up its job until after the dispatch is done
+    /// (or the dispatcher is deleted). Such a late worker finds no pairs left, and only touches the batch itself.
+    struct PairBatch
+    {
+        btBroadphasePair*                   m_Pairs;
+        btCollisionDispatcher*              m_Dispatcher;
+        const btDispatcherInfo*             m_DispatchInfo;
+        btNearCallback                      m_NearCallback;
+        dmMutex::HMutex*                    m_BodyMutexes;
+        dmMutex::HMutex                     m_Mutex;
+        dmConditionVariable::HConditionVariable m_Done;
+        int32_t                             m_Count;
+        int32_atomic_t                      m_Next;
+        int32_t                             m_Active;   // Guarded by m_Mutex
+        int32_atomic_t                      m_RefCount;
+    };
+
+    static void ReleasePairBatch(PairBatch* batch)
+    {
+        if (dmAtomicDecrement32(&batch->m_RefCount) == 1)
+        {
+            dmConditionVariable::Delete(batch->m_Done);
+            dmMutex::Delete(batch->m_Mutex);
+            delete batch;
+        }
+    }
+
+    static void ProcessPairBatch(PairBatch* batch)
+    {
+        {
+            DM_MUTEX_SCOPED_LOCK(batch->m_Mutex);
+            batch->m_Active++;
+        }
+        while (true)
+        {
+            int32_t start = dmAtomicAdd32(&batch->m_Next, PAIR_BATCH_SIZE);
+            if (start >= batch->m_Count)
+                break;
+            int32_t end = dmMath::Min(start + PAIR_BATCH_SIZE, batch->m_Count);
+            for (int32_t i = start; i < end; ++i)
+            {
+                // The compound algorithm temporarily swaps the shape and transform of the collision object
+                // while processing its children, so pairs sharing a body can't be processed at the same time
+                btBroadphasePair& pair = batch->m_Pairs[i];
+                uint32_t index0 = GetBodyMutexIndex(pair.m_pProxy0->m_clientObject);
+                uint32_t index1 = GetBodyMutexIndex(pair.m_pProxy1->m_clientObject);
+                if (index0 > index1)
+                {
+                    uint32_t tmp = index0;
+                    index0 = index1;
+                    index1 = tmp;
+                }
+                dmMutex::Lock(batch->m_BodyMutexes[index0]);
+                if (index1 != index0)
+                    dmMutex::Lock(batch->m_BodyMutexes[index1]);
+
+                batch->m_NearCallback(pair, *batch->m_Dispatcher, *batch->m_DispatchInfo);
+
+                if (index1 != index0)
+                    dmMutex::Unlock(batch->m_BodyMutexes[index1]);
+                dmMutex::Unlock(batch->m_BodyMutexes[index0]);
+            }
+        }
+        DM_MUTEX_SCOPED_LOCK(batch->m_Mutex);
+        if (--batch->m_Active == 0)
+        {
+            dmConditionVariable::Broadcast(batch->m_Done);
+        }
+    }
+
+    // Wait until no thread is processing pairs. Only called once all pairs have been taken,
+    // so a worker starting after this has nothing to process.
+    static void WaitPairBatch(PairBatch* batch)
+    {
+        DM_PROFILE("PhysicsNarrowphaseWait");
+        DM_MUTEX_SCOPED_LOCK(batch->m_Mutex);
+        while (batch->m_Active != 0)
+        {
+            dmConditionVariable::Wait(batch->m_Done, batch->m_Mutex);
+        }
+    }
+
+    static int ProcessPairBatchJob(void* context, void* data)
+    {
+        DM_PROFILE("PhysicsNarrowphase");
+        PairBatch* batch = (PairBatch*)data;
+        ProcessPairBatch(batch);
+        ReleasePairBatch(batch);
+        return 0;
+    }
+
+    CollisionDispatcherMt::CollisionDispatcherMt(btCollisionConfiguration* collision_configuration, dmJobThread::HContext job_thread)
+    : btCollisionDispatcher(collision_configuration)
+    , m_JobThread(job_thread)
+    , m_Mutex(dmMutex::New())
+    , m_WorkerCount(job_thread ? dmJobThread::GetWorkerCount(job_thread) : 0)
+    {
+        for (uint32_t i = 0; i < BODY_MUTEX_COUNT; ++i)
+        {
+            m_BodyMutexes[i] = dmMutex::New();
+        }
+    }
+
+    CollisionDispatcherMt::~CollisionDispatcherMt()
+    {
+        for (uint32_t i = 0; i < BODY_MUTEX_COUNT; ++i)
+        {
+            dmMutex::Delete(m_BodyMutexes[i]);
+        }
+        dmMutex::Delete(m_Mutex);
+    }
+
+    btPersistentManifold* CollisionDispatcherMt::getNewManifold(void* b0, void* b1)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        return btCollisionDispatcher::getNewManifold(b0, b1);
+    }
+
+    void CollisionDispatcherMt::releaseManifold(btPersistentManifold* manifold)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        btCollisionDispatcher::releaseManifold(manifold);
+    }
+
+    btCollisionAlgorithm* CollisionDispatcherMt::findAlgorithm(btCollisionObject* body0, btCollisionObject* body1, btPersistentManifold* shared_manifold)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        return btCollisionDispatcher::findAlgorithm(body0, body1, shared_manifold);
+    }
+
+    void* CollisionDispatcherMt::allocateCollisionAlgorithm(int size)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+    }
+
+    void CollisionDispatcherMt::freeCollisionAlgorithm(void* ptr)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+    }
+
+    void CollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache* pair_cache, const btDispatcherInfo& dispatch_info, btDispatcher* dispatcher)
+    {
+        int32_t pair_count = pair_cache->getNumOverlappingPairs();
+        // Time of impact queries write back to the dispatch info and are kept serial
+        if (m_WorkerCount == 0 || pair_count < MIN_PARALLEL_PAIR_COUNT || dispatch_info.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE)
+        {
+            btCollisionDispatcher::dispatchAllCollisionPairs(pair_cache, dispatch_info, dispatcher);
+            return;
+        }
+
+        btBroadphasePair* pairs = pair_cache->getOverlappingPairArrayPtr();
+
+        // Create any missing algorithms up front, since that touches the shared pools
+        for (int32_t i = 0; i < pair_count; ++i)
+        {
+            btBroadphasePair& pair = pairs[i];
+            if (pair.m_algorithm == 0x0)
+            {
+                btCollisionObject* body0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+                btCollisionObject* body1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+                if (needsCollision(body0, body1))
+                    pair.m_algorithm = btCollisionDispatcher::findAlgorithm(body0, body1, 0x0);
+            }
+        }
+
+        PairBatch* batch = new PairBatch;
+        batch->m_Pairs = pairs;
+        batch->m_Dispatcher = this;
+        batch->m_DispatchInfo = &dispatch_info;
+        batch->m_NearCallback = getNearCallback();
+        batch->m_BodyMutexes = m_BodyMutexes;
+        batch->m_Mutex = dmMutex::New();
+        batch->m_Done = dmConditionVariable::New();
+        batch->m_Count = pair_count;
+        batch->m_Next = 0;
+        batch->m_Active = 0;
+        batch->m_RefCount = 1 + m_WorkerCount;
+
+        for (uint32_t i = 0; i < m_WorkerCount; ++i)
+        {
+            dmJobThread::PushJob(m_JobThread, ProcessPairBatchJob, 0x0, 0x0, batch);
+        }
+
+        ProcessPairBatch(batch);
+
+        // All pairs are taken at this point, wait for the workers still processing theirs
+        WaitPairBatch(batch);
+        ReleasePairBatch(batch);
+
+        SortManifolds(pairs, pair_count);
+    }
+
+    // Manifolds are created by the workers in whatever order they happen to get to the pairs.
+    // Since the solver processes them in array order, they are put in pair order to keep the simulation deterministic.
+    void CollisionDispatcherMt::SortManifolds(btBroadphasePair* pairs, int32_t pair_count)
+    {
+        if (getNumManifolds() == 0)
+            return;
+
+        btPersistentManifold** manifolds = getInternalManifoldPointer();
+        int32_t next = 0;
+        for (int32_t i = 0; i < pair_count; ++i)
+        {
+            btCollisionAlgorithm* algorithm = pairs[i].m_algorithm;
+            if (algorithm == 0x0)
+                continue;
+
+            m_ManifoldScratch.resize(0);
+            algorithm->getAllContactManifolds(m_ManifoldScratch);
+            for (int32_t j = 0; j < m_ManifoldScratch.size(); ++j)
+            {
+                btPersistentManifold* manifold = m_ManifoldScratch[j];
+                int32_t index = manifold->m_index1a;
+                if (index < next)
+                    continue; // Already placed (shared between algorithms)
+
+                btPersistentManifold* other = manifolds[next];
+                manifolds[next] = manifold;
+                manifold->m_index1a = next;
+                manifolds[index] = other;
+                other->m_index1a = index;
+                ++next;
+            }
+        }
+    }
+}
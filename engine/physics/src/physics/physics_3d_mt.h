@@ -0,0 +1,79 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef PHYSICS_3D_MT_H
+#define PHYSICS_3D_MT_H
+
+#include <dlib/job_thread.h>
+#include <dmsdk/dlib/mutex.h>
+
+#include "btBulletDynamicsCommon.h"
+
+namespace dmPhysics
+{
+    /**
+     * Collision configuration where the convex-convex algorithms own their simplex solver,
+     * instead of sharing the single solver of the configuration.
+     * This makes the narrowphase of separate pairs safe to run concurrently.
+     */
+    class CollisionConfigurationMt : public btDefaultCollisionConfiguration
+    {
+    public:
+        CollisionConfigurationMt(const btDefaultCollisionConstructionInfo& construction_info);
+        virtual ~CollisionConfigurationMt();
+
+        virtual btCollisionAlgorithmCreateFunc* getCollisionAlgorithmCreateFunc(int proxy_type0, int proxy_type1);
+
+        static btDefaultCollisionConstructionInfo GetConstructionInfo();
+
+    private:
+        btCollisionAlgorithmCreateFunc* m_ConvexConvexCreateFuncMt;
+    };
+
+    /**
+     * Collision dispatcher that processes the narrowphase of all overlapping pairs in parallel,
+     * on the calling thread and the workers of a job thread context.
+     * Algorithm creation is done serially up front, and the shared pools are guarded by a mutex
+     * for algorithms that lazily create manifolds or child algorithms. Pairs that share a collision
+     * object are never processed at the same time.
+     */
+    class CollisionDispatcherMt : public btCollisionDispatcher
+    {
+    public:
+        /// Number of locks the collision objects are spread over (power of two)
+        static const uint32_t BODY_MUTEX_COUNT = 64;
+
+        CollisionDispatcherMt(btCollisionConfiguration* collision_configuration, dmJobThread::HContext job_thread);
+        virtual ~CollisionDispatcherMt();
+
+        virtual btPersistentManifold* getNewManifold(void* b0, void* b1);
+        virtual void releaseManifold(btPersistentManifold* manifold);
+        virtual btCollisionAlgorithm* findAlgorithm(btCollisionObject* body0, btCollisionObject* body1, btPersistentManifold* shared_manifold);
+        virtual void* allocateCollisionAlgorithm(int size);
+        virtual void freeCollisionAlgorithm(void* ptr);
+
+        virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pair_cache, const btDispatcherInfo& dispatch_info, btDispatcher* dispatcher);
+
+    private:
+        void SortManifolds(btBroadphasePair* pairs, int32_t pair_count);
+
+        dmJobThread::HContext   m_JobThread;
+        dmMutex::HMutex         m_Mutex;
+        dmMutex::HMutex         m_BodyMutexes[BODY_MUTEX_COUNT];
+        uint32_t                m_WorkerCount;
+        btManifoldArray         m_ManifoldScratch;
+    };
+}
+
+#endif // PHYSICS_3D_MT_H
@@ -31,6 +31,8 @@ namespace dmPhysics
     , m_RayCastLimit2D(0)
     , m_RayCastLimit3D(0)
     , m_TriggerOverlapCapacity(0)
+    , m_Broadphase3D(BROADPHASE_3D_AXIS_SWEEP)
+    , m_JobThread(0x0)
     , m_AllowDynamicTransforms(0)
     {
 
@@ -43,6 +45,7 @@ namespace dmPhysics
     , m_WorldMax(WORLD_EXTENT, WORLD_EXTENT, WORLD_EXTENT)
     , m_GetWorldTransformCallback(0x0)
     , m_SetWorldTransformCallback(0x0)
+    , m_WorldTransformChangedCallback(0x0)
     {
 
     }
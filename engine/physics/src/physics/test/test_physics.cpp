@@ -16,6 +16,8 @@
 #include <jc_test/jc_test.h>
 
 #include "test_physics.h"
+#include <dlib/array.h>
+#include <dlib/job_thread.h>
 #include <dlib/math.h>
 
 
@@ -2226,6 +2228,108 @@ TYPED_TEST(PhysicsTest, DisabledFromStart)
     (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
 }
 
+// A grid of boxes resting next to each other on the ground, enough pairs for the narrowphase to run in parallel
+static void RunBoxGrid3D(dmJobThread::HContext job_thread, dmArray<VisualObject>& box_visual_objects)
+{
+    const uint32_t grid_size = 12;
+    const float box_half_ext = 0.5f;
+    const float ground_height_half_ext = 1.0f;
+
+    dmPhysics::NewContextParams context_params = dmPhysics::NewContextParams();
+    context_params.m_Scale = PHYSICS_SCALE;
+    context_params.m_RayCastLimit3D = 128;
+    context_params.m_TriggerOverlapCapacity = 16;
+    context_params.m_JobThread = job_thread;
+    dmPhysics::HContext3D context = dmPhysics::NewContext3D(context_params);
+    dmPhysics::NewWorldParams world_params;
+    world_params.m_GetWorldTransformCallback = GetWorldTransform;
+    world_params.m_SetWorldTransformCallback = SetWorldTransform;
+    world_params.m_MaxCollisionObjectsCount = 1024;
+    dmPhysics::HWorld3D world = dmPhysics::NewWorld3D(context, world_params);
+
+    VisualObject ground_visual_object;
+    dmPhysics::CollisionObjectData ground_data;
+    dmPhysics::HCollisionShape3D ground_shape = dmPhysics::NewBoxShape3D(context, Vector3(100, ground_height_half_ext, 100));
+    ground_data.m_Mass = 0.0f;
+    ground_data.m_Restitution = 0.0f;
+    ground_data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_STATIC;
+    ground_data.m_UserData = &ground_visual_object;
+    dmPhysics::HCollisionObject3D ground_co = dmPhysics::NewCollisionObject3D(world, ground_data, &ground_shape, 1u);
+
+    dmPhysics::HCollisionShape3D box_shape = dmPhysics::NewBoxShape3D(context, Vector3(box_half_ext, box_half_ext, box_half_ext));
+    box_visual_objects.SetCapacity(grid_size * grid_size);
+    box_visual_objects.SetSize(grid_size * grid_size);
+    dmArray<dmPhysics::HCollisionObject3D> box_cos;
+    box_cos.SetCapacity(grid_size * grid_size);
+    for (uint32_t i = 0; i < grid_size * grid_size; ++i)
+    {
+        VisualObject& box_visual_object = box_visual_objects[i];
+        box_visual_object = VisualObject();
+        box_visual_object.m_Position = Point3((i % grid_size) * 2.0f * box_half_ext, 2.0f, (i / grid_size) * 2.0f * box_half_ext);
+        dmPhysics::CollisionObjectData box_data;
+        box_data.m_Restitution = 0.0f;
+        box_data.m_UserData = &box_visual_object;
+        box_cos.Push(dmPhysics::NewCollisionObject3D(world, box_data, &box_shape, 1u));
+    }
+
+    int collision_count = 0;
+    dmPhysics::StepWorldContext step_context;
+    step_context.m_DT = 1.0f / 60.0f;
+    step_context.m_CollisionCallback = CollisionCallback;
+    step_context.m_CollisionUserData = &collision_count;
+    step_context.m_MaxFixedTimeSteps = 2;
+    for (int i = 0; i < 200; ++i)
+    {
+        dmPhysics::StepWorld3D(world, step_context);
+    }
+
+    for (uint32_t i = 0; i < box_cos.Size(); ++i)
+    {
+        dmPhysics::DeleteCollisionObject3D(world, box_cos[i]);
+    }
+    dmPhysics::DeleteCollisionObject3D(world, ground_co);
+    dmPhysics::DeleteCollisionShape3D(box_shape);
+    dmPhysics::DeleteCollisionShape3D(ground_shape);
+    dmPhysics::DeleteWorld3D(context, world);
+    dmPhysics::DeleteContext3D(context);
+}
+
+TEST(PhysicsTest3D, ParallelNarrowphase)
+{
+    dmJobThread::JobThreadCreationParams job_thread_create_param;
+    job_thread_create_param.m_ThreadNames[0] = "test_physics_thread_0";
+    job_thread_create_param.m_ThreadNames[1] = "test_physics_thread_1";
+    job_thread_create_param.m_ThreadNames[2] = "test_physics_thread_2";
+    job_thread_create_param.m_ThreadCount    = 3;
+    dmJobThread::HContext job_thread = dmJobThread::Create(job_thread_create_param);
+
+    dmArray<VisualObject> serial;
+    RunBoxGrid3D(0x0, serial);
+
+    dmArray<VisualObject> parallel;
+    RunBoxGrid3D(job_thread, parallel);
+    dmArray<VisualObject> parallel2;
+    RunBoxGrid3D(job_thread, parallel2);
+
+    ASSERT_EQ(serial.Size(), parallel.Size());
+    for (uint32_t i = 0; i < serial.Size(); ++i)
+    {
+        // All boxes come to rest on the ground, whether the narrowphase runs in parallel or not
+        ASSERT_NEAR(serial[i].m_Position.getY(), parallel[i].m_Position.getY(), 0.05f);
+        ASSERT_NEAR(1.5f, parallel[i].m_Position.getY(), 0.05f);
+
+        // The manifolds are solved in the same order regardless of which worker processed the pairs
+        ASSERT_EQ(parallel[i].m_Position.getX(), parallel2[i].m_Position.getX());
+        ASSERT_EQ(parallel[i].m_Position.getY(), parallel2[i].m_Position.getY());
+        ASSERT_EQ(parallel[i].m_Position.getZ(), parallel2[i].m_Position.getZ());
+        ASSERT_EQ(parallel[i].m_CollisionCount, parallel2[i].m_CollisionCount);
+    }
+
+    // Process any jobs that were picked up after their world was deleted
+    dmJobThread::Update(job_thread);
+    dmJobThread::Destroy(job_thread);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
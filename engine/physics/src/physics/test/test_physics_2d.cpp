@@ -1842,6 +1842,50 @@ TYPED_TEST(PhysicsTest, ScriptApiBox2D)
     (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, dynamic_co);
 }
 
+static bool WorldTransformChangedFalse(void* visual_object)
+{
+    return false;
+}
+
+TYPED_TEST(PhysicsTest, WorldTransformChanged)
+{
+    dmPhysics::NewWorldParams world_params;
+    world_params.m_GetWorldTransformCallback = GetWorldTransform;
+    world_params.m_SetWorldTransformCallback = SetWorldTransform;
+    world_params.m_WorldTransformChangedCallback = WorldTransformChangedFalse;
+    world_params.m_MaxCollisionObjectsCount = 16;
+    dmPhysics::HWorld2D world = dmPhysics::NewWorld2D(TestFixture::m_Context, world_params);
+
+    VisualObject vo;
+    vo.m_Position = dmVMath::Point3(1.0f, 2.0f, 0.0f);
+    dmPhysics::CollisionObjectData data;
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_KINEMATIC;
+    data.m_Mass = 0.0f;
+    data.m_UserData = &vo;
+    typename TypeParam::CollisionShapeType shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, dmVMath::Vector3(0.5f, 0.5f, 0.0f));
+    typename TypeParam::CollisionObjectType co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(world, data, &shape, 1u);
+
+    // The first step always synchronizes
+    dmPhysics::StepWorld2D(world, TestFixture::m_StepWorldContext);
+    ASSERT_NEAR(1.0f, dmPhysics::GetWorldPosition2D(TestFixture::m_Context, co).getX(), 0.0001f);
+
+    // Reported as unchanged, so the new transform is not picked up
+    vo.m_Position = dmVMath::Point3(3.0f, 2.0f, 0.0f);
+    dmPhysics::StepWorld2D(world, TestFixture::m_StepWorldContext);
+    ASSERT_NEAR(1.0f, dmPhysics::GetWorldPosition2D(TestFixture::m_Context, co).getX(), 0.0001f);
+
+    // Moving the body itself forces a synchronization
+    dmPhysics::SetLinearVelocity2D(TestFixture::m_Context, co, dmVMath::Vector3(10.0f, 0.0f, 0.0f));
+    dmPhysics::StepWorld2D(world, TestFixture::m_StepWorldContext);
+    dmPhysics::SetLinearVelocity2D(TestFixture::m_Context, co, dmVMath::Vector3(0.0f, 0.0f, 0.0f));
+    dmPhysics::StepWorld2D(world, TestFixture::m_StepWorldContext);
+    ASSERT_NEAR(3.0f, dmPhysics::GetWorldPosition2D(TestFixture::m_Context, co).getX(), 0.0001f);
+
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(world, co);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
+    dmPhysics::DeleteWorld2D(TestFixture::m_Context, world);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
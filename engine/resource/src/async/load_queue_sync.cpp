@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include "resource.h"
+#include "resource_mounts.h"
 #include "resource_private.h"
 #include "load_queue.h"
 
@@ -29,6 +30,8 @@ namespace dmLoadQueue
         const char* m_Name;
         const char* m_CanonicalPath;
         PreloadInfo m_PreloadInfo;
+        // Set when the data is read directly from a memory mapped archive
+        dmResourceMounts::ResourceView m_View;
     };
 
     struct Queue
@@ -73,7 +76,17 @@ namespace dmLoadQueue
             return RESULT_INVALID_PARAM;
         }
 
-        load_result->m_LoadResult    = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size);
+        load_result->m_LoadResult    = dmResource::GetResourceView(queue->m_Factory, request->m_CanonicalPath, &request->m_View);
+        if (load_result->m_LoadResult == dmResource::RESULT_OK)
+        {
+            *buf  = (void*)request->m_View.m_Data;
+            *size = request->m_View.m_Size;
+        }
+        else
+        {
+            request->m_View.m_Archive = 0;
+            load_result->m_LoadResult = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size);
+        }
         load_result->m_PreloadResult = dmResource::RESULT_PENDING;
         load_result->m_PreloadData   = 0;
 
@@ -93,6 +106,10 @@ namespace dmLoadQueue
 
     void FreeLoad(HQueue queue, HRequest request)
     {
+        if (request->m_View.m_Archive)
+        {
+            dmResource::ReleaseResourceView(queue->m_Factory, &request->m_View);
+        }
         queue->m_ActiveRequest   = 0;
         request->m_Name          = 0x0;
         request->m_CanonicalPath = 0x0;
@@ -13,12 +13,14 @@
 // specific language governing permissions and limitations under the License.
 
 #include "resource.h"
+#include "resource_mounts.h"
 #include "resource_private.h"
 #include "load_queue.h"
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
 #include <dlib/array.h>
+#include <dlib/math.h>
 #include <dlib/thread.h>
 #include <dlib/mutex.h>
 #include <dlib/time.h>
@@ -26,43 +28,46 @@
 
 namespace dmLoadQueue
 {
-    // Implementation of dmLoadQueue with a thread that loads items in the order they are supplied,
+    // Implementation of dmLoadQueue with a pool of threads that pick up items in the order they are supplied.
+    // Items may complete out of order. The file reads are serialized by the factory, but the preload functions
+    // (e.g. ddf parsing and texture transcoding) of different items run in parallel, and overlap the reads.
 
     // Default to small buffers since a lot of what is loaded are just small objects anyway.
     // That way we can have more in flight, but throttle when max pending data grows too large anyway
     const uint64_t DEFAULT_CAPACITY = 5 * 1024;
 
-    // Once the loader has this amount not picked up, it will stop loading more.
-    // This sets the bandwidth of the loader.
-    const uint64_t MAX_PENDING_DATA = 4 * 1024 * 1024;
-    const uint32_t QUEUE_SLOTS      = 16;
-
     struct Request
     {
         const char*                m_Name;
         const char*                m_CanonicalPath;
         dmResource::LoadBufferType m_Buffer;
+        // Set instead of m_Buffer when the data is read directly from a memory mapped archive
+        dmResourceMounts::ResourceView m_View;
         PreloadInfo                m_PreloadInfo;
         LoadResult                 m_Result;
     };
 
     struct Queue
     {
-        Request                                 m_Request[QUEUE_SLOTS];
+        Request*                                m_Request;
+        dmArray<dmThread::Thread>               m_Threads;
         dmResource::HFactory                    m_Factory;
         dmMutex::HMutex                         m_Mutex;
         dmConditionVariable::HConditionVariable m_WakeupCond;
-        dmThread::Thread                        m_Thread;
+        uint32_t                                m_QueueSlots;
         uint32_t                                m_Front;
         uint32_t                                m_Back;
-        uint32_t                                m_Loaded;
+        uint32_t                                m_Next;
+        // Once the loader has this amount not picked up, it will stop loading more.
+        // This sets the bandwidth of the loader.
+        uint64_t                                m_MaxPendingData;
         uint64_t                                m_BytesWaiting;
         bool                                    m_Shutdown;
 
         // Circular queue with indexing as follow (exclusive end)
         //
-        //          m_Back           m_Loaded   m_Front
-        // [N/A]   [loaded] [loaded] [to-load]  [N/A]
+        //          m_Back                       m_Next      m_Front
+        // [N/A]   [loaded/loading] [loaded/loading] [to-load]  [N/A]
         //
     };
 
@@ -72,17 +77,17 @@ namespace dmLoadQueue
         // that are waiting to be picked up by the preloader. In the case of the queue being filled
         // with only large requests (say only 4Mb textures), this throttles a bit so memory consumption
         // does not run away.
-        if (queue->m_BytesWaiting >= MAX_PENDING_DATA)
+        if (queue->m_BytesWaiting >= queue->m_MaxPendingData)
         {
             return 0x0;
         }
 
-        if (queue->m_Loaded == queue->m_Front)
+        if (queue->m_Next == queue->m_Front)
         {
             return 0x0;
         }
 
-        return &queue->m_Request[queue->m_Loaded % QUEUE_SLOTS];
+        return &queue->m_Request[(queue->m_Next++) % queue->m_QueueSlots];
     }
 
     static void LoadThread(void* arg)
@@ -98,7 +103,6 @@ namespace dmLoadQueue
                 {
                     // Just finished one (from previous iteration)
                     queue->m_BytesWaiting += current->m_Buffer.Capacity();
-                    queue->m_Loaded++;
                     current->m_Result = result;
                     current           = 0;
                 }
@@ -110,11 +114,11 @@ namespace dmLoadQueue
                 current = GetNextRequest(queue);
                 if (current == 0x0)
                 {
-                    // Nothing to do, reset any buffers of inactive requests that are not at default capacity
-                    for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
+                    // Nothing to do, reset any buffers of unused requests that are not at default capacity
+                    for (uint32_t i = 0; i < queue->m_QueueSlots; ++i)
                     {
                         Request* r = &queue->m_Request[i];
-                        if (r->m_Buffer.Size() == 0)
+                        if (r->m_Name == 0x0)
                         {
                             if (r->m_Buffer.Capacity() > DEFAULT_CAPACITY)
                             {
@@ -124,7 +128,7 @@ namespace dmLoadQueue
                         }
                     }
                     dmConditionVariable::Wait(queue->m_WakeupCond, queue->m_Mutex);
-                    current = GetNextRequest(queue);
+                    current = queue->m_Shutdown ? 0x0 : GetNextRequest(queue);
                 }
             }
 
@@ -132,27 +136,42 @@ namespace dmLoadQueue
             {
                 // We use the temporary result object here to fill in the data so it can be written with the mutex held.
                 uint32_t size = 0;
+                const void* data = 0;
 
                 assert(current->m_Buffer.Size() == 0);
-                if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+                assert(current->m_View.m_Archive == 0);
+
+                // Skip the copy if the data can be used directly from the archive
+                result.m_LoadResult = dmResource::GetResourceView(queue->m_Factory, current->m_CanonicalPath, &current->m_View);
+                if (result.m_LoadResult == dmResource::RESULT_OK)
                 {
-                    current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+                    data = current->m_View.m_Data;
+                    size = current->m_View.m_Size;
                 }
+                else
+                {
+                    current->m_View.m_Archive = 0;
+                    if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+                    {
+                        current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+                    }
 
-                result.m_LoadResult = dmResource::LoadResourceFromBuffer(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer);
+                    result.m_LoadResult = dmResource::LoadResourceFromBuffer(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer);
+                    assert(result.m_LoadResult != dmResource::RESULT_OK || current->m_Buffer.Size() == size);
+                    data = current->m_Buffer.Begin();
+                }
                 result.m_PreloadResult = dmResource::RESULT_PENDING;
                 result.m_PreloadData   = 0;
 
                 if (result.m_LoadResult == dmResource::RESULT_OK)
                 {
-                    assert(current->m_Buffer.Size() == size);
                     if (current->m_PreloadInfo.m_CompleteFunction)
                     {
                         dmResource::ResourcePreloadParams params;
                         params.m_Factory       = queue->m_Factory;
                         params.m_Context       = current->m_PreloadInfo.m_Context;
-                        params.m_Buffer        = current->m_Buffer.Begin();
-                        params.m_BufferSize    = current->m_Buffer.Size();
+                        params.m_Buffer        = data;
+                        params.m_BufferSize    = size;
                         params.m_HintInfo      = &current->m_PreloadInfo.m_HintInfo;
                         params.m_PreloadData   = &result.m_PreloadData;
                         result.m_PreloadResult = current->m_PreloadInfo.m_CompleteFunction(params);
@@ -168,16 +187,37 @@ namespace dmLoadQueue
 
     HQueue CreateQueue(dmResource::HFactory factory)
     {
-        Queue* q          = new Queue();
-        q->m_Factory      = factory;
-        q->m_Front        = 0;
-        q->m_Back         = 0;
-        q->m_Loaded       = 0;
-        q->m_Shutdown     = false;
-        q->m_BytesWaiting = 0;
-        q->m_Mutex        = dmMutex::New();
-        q->m_WakeupCond   = dmConditionVariable::New();
-        q->m_Thread       = dmThread::New(&LoadThread, 128 * 1024, q, "AsyncLoad");
+        const dmResource::LoadQueueParams* params = dmResource::GetLoadQueueParams(factory);
+
+        Queue* q            = new Queue();
+        q->m_Factory        = factory;
+        q->m_QueueSlots     = params->m_QueueSlots;
+        q->m_Request        = new Request[q->m_QueueSlots];
+        q->m_Front          = 0;
+        q->m_Back           = 0;
+        q->m_Next           = 0;
+        q->m_Shutdown       = false;
+        q->m_MaxPendingData = params->m_MaxPendingData;
+        q->m_BytesWaiting   = 0;
+        q->m_Mutex          = dmMutex::New();
+        q->m_WakeupCond     = dmConditionVariable::New();
+
+        for (uint32_t i = 0; i < q->m_QueueSlots; ++i)
+        {
+            q->m_Request[i].m_Name           = 0x0;
+            q->m_Request[i].m_CanonicalPath  = 0x0;
+            q->m_Request[i].m_View.m_Archive = 0x0;
+        }
+
+        // No point in having more threads than there are requests to work on
+        uint32_t thread_count = dmMath::Min(params->m_ThreadCount, q->m_QueueSlots);
+        q->m_Threads.SetCapacity(thread_count);
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            char name[32];
+            dmSnPrintf(name, sizeof(name), i == 0 ? "AsyncLoad" : "AsyncLoad%u", i);
+            q->m_Threads.Push(dmThread::New(&LoadThread, 128 * 1024, q, name));
+        }
 
         return q;
     }
@@ -187,12 +227,16 @@ namespace dmLoadQueue
         {
             dmMutex::ScopedLock lk(queue->m_Mutex);
             queue->m_Shutdown = true;
-            // Wake up the worker so it can exit and allow us to join
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            // Wake up the workers so they can exit and allow us to join
+            dmConditionVariable::Broadcast(queue->m_WakeupCond);
+        }
+        for (uint32_t i = 0; i < queue->m_Threads.Size(); ++i)
+        {
+            dmThread::Join(queue->m_Threads[i]);
         }
-        dmThread::Join(queue->m_Thread);
         dmConditionVariable::Delete(queue->m_WakeupCond);
         dmMutex::Delete(queue->m_Mutex);
+        delete[] queue->m_Request;
         delete queue;
     }
 
@@ -206,16 +250,13 @@ namespace dmLoadQueue
         dmMutex::ScopedLock lk(queue->m_Mutex);
 
         // Refuse more if full.
-        if ((queue->m_Front - queue->m_Back) == QUEUE_SLOTS)
+        if ((queue->m_Front - queue->m_Back) == queue->m_QueueSlots)
             return 0;
 
-        if (queue->m_Loaded == queue->m_Front)
-        {
-            // The worker is sleeping waiting for request, wake it up
-            dmConditionVariable::Signal(queue->m_WakeupCond);
-        }
+        // Wake up one of the workers, in case they are all sleeping waiting for requests
+        dmConditionVariable::Signal(queue->m_WakeupCond);
 
-        Request* req         = &queue->m_Request[(queue->m_Front++) % QUEUE_SLOTS];
+        Request* req         = &queue->m_Request[(queue->m_Front++) % queue->m_QueueSlots];
         req->m_Name          = name;
         req->m_CanonicalPath = canonical_path;
 
@@ -231,8 +272,16 @@ namespace dmLoadQueue
         if (request->m_Result.m_LoadResult == dmResource::RESULT_PENDING)
             return RESULT_PENDING;
 
-        *buf         = request->m_Buffer.Begin();
-        *size        = request->m_Buffer.Size();
+        if (request->m_View.m_Archive)
+        {
+            *buf  = (void*)request->m_View.m_Data;
+            *size = request->m_View.m_Size;
+        }
+        else
+        {
+            *buf  = request->m_Buffer.Begin();
+            *size = request->m_Buffer.Size();
+        }
         *load_result = request->m_Result;
 
         return RESULT_OK;
@@ -242,26 +291,31 @@ namespace dmLoadQueue
     {
         dmMutex::ScopedLock lk(queue->m_Mutex);
 
-        uint32_t old_bytes_waiting = queue->m_BytesWaiting;
+        uint64_t old_bytes_waiting = queue->m_BytesWaiting;
 
         // Make sure we don't copy any data if we reallocate the buffer
         request->m_Buffer.SetSize(0);
 
+        if (request->m_View.m_Archive)
+        {
+            dmResource::ReleaseResourceView(queue->m_Factory, &request->m_View);
+        }
+
         uint32_t buffer_capacity = request->m_Buffer.Capacity();
         queue->m_BytesWaiting -= buffer_capacity;
-        // If we either have blocked further processing by exceeding MAX_PENDING_DATA or
-        // the buffer has a non-default capacity, we want to wake up the worker
-        if (buffer_capacity != DEFAULT_CAPACITY || (old_bytes_waiting >= MAX_PENDING_DATA && queue->m_BytesWaiting < MAX_PENDING_DATA))
+        // If we either have blocked further processing by exceeding the max pending data or
+        // the buffer has a non-default capacity, we want to wake up the workers
+        if (buffer_capacity != DEFAULT_CAPACITY || (old_bytes_waiting >= queue->m_MaxPendingData && queue->m_BytesWaiting < queue->m_MaxPendingData))
         {
-            // Wake up thread, we can now fit a new request
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            // Wake up threads, we can now fit new requests
+            dmConditionVariable::Broadcast(queue->m_WakeupCond);
         }
 
         // Clean up picked up requests
         request->m_Name          = 0x0;
         request->m_CanonicalPath = 0x0;
 
-        while (queue->m_Back != queue->m_Loaded && queue->m_Request[queue->m_Back % QUEUE_SLOTS].m_Name == 0x0)
+        while (queue->m_Back != queue->m_Next && queue->m_Request[queue->m_Back % queue->m_QueueSlots].m_Name == 0x0)
         {
             queue->m_Back++;
         }
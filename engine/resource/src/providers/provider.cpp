@@ -14,6 +14,8 @@
 
 #include <assert.h>
 #include <stdio.h> // debug: printf
+#include <stdlib.h>
+#include <string.h>
 
 #include "provider.h"
 #include "provider_private.h"
@@ -21,6 +23,7 @@
 
 #include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/static_assert.h>
 
 namespace dmResourceProvider
@@ -135,6 +138,41 @@ Result ReadFile(HArchive archive, dmhash_t path_hash, const char* path, uint8_t*
     return archive->m_Loader->m_ReadFile(archive->m_Internal, path_hash, path, buffer, buffer_len);
 }
 
+Result ReadFilePartial(HArchive archive, dmhash_t path_hash, const char* path, uint32_t offset, uint32_t size, uint8_t* buffer, uint32_t* nread)
+{
+    if (archive->m_Loader->m_ReadFilePartial)
+        return archive->m_Loader->m_ReadFilePartial(archive->m_Internal, path_hash, path, offset, size, buffer, nread);
+
+    *nread = 0;
+    uint32_t file_size;
+    Result result = GetFileSize(archive, path_hash, path, &file_size);
+    if (result != RESULT_OK)
+        return result;
+    if (offset >= file_size)
+        return RESULT_OK;
+
+    uint8_t* temp_buffer = (uint8_t*)malloc(file_size);
+    result = ReadFile(archive, path_hash, path, temp_buffer, file_size);
+    if (result == RESULT_OK)
+    {
+        *nread = dmMath::Min(size, file_size - offset);
+        memcpy(buffer, temp_buffer + offset, *nread);
+    }
+    free(temp_buffer);
+    return result;
+}
+
+Result GetFileView(HArchive archive, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* size)
+{
+    if (archive->m_Loader->m_GetFileView)
+        return archive->m_Loader->m_GetFileView(archive->m_Internal, path_hash, path, data, size);
+
+    Result result = GetFileSize(archive, path_hash, path, size);
+    if (result != RESULT_OK)
+        return result;
+    return RESULT_NOT_SUPPORTED;
+}
+
 Result GetManifest(HArchive archive, dmResource::HManifest* out_manifest)
 {
     if (archive->m_Loader->m_GetManifest)
@@ -149,6 +187,13 @@ Result SetManifest(HArchive archive, dmResource::HManifest manifest)
     return RESULT_NOT_SUPPORTED;
 }
 
+Result SetJobThread(HArchive archive, dmJobThread::HContext job_thread)
+{
+    if (archive->m_Loader->m_SetJobThread)
+        return archive->m_Loader->m_SetJobThread(archive->m_Internal, job_thread);
+    return RESULT_OK;
+}
+
 Result GetUri(HArchive archive, dmURI::Parts* out_uri)
 {
     memcpy(out_uri, &archive->m_Uri, sizeof(dmURI::Parts));
@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 #include <dlib/hash.h>
+#include <dlib/job_thread.h>
 #include <dlib/uri.h>
 
 namespace dmResource
@@ -50,9 +51,12 @@ namespace dmResourceProvider
 
     typedef Result (*FGetFileSize)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint32_t* file_size);
     typedef Result (*FReadFile)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len);
+    typedef Result (*FReadFilePartial)(HArchiveInternal archive, dmhash_t path_hash, const char* path, uint32_t offset, uint32_t size, uint8_t* buffer, uint32_t* nread);
+    typedef Result (*FGetFileView)(HArchiveInternal archive, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* size);
     typedef Result (*FWriteFile)(HArchiveInternal archive, dmhash_t path_hash, const char* path, const uint8_t* buffer, uint32_t buffer_len);
     typedef Result (*FGetManifest)(HArchiveInternal, dmResource::HManifest*); // In order for other providers to get the base manifest
     typedef Result (*FSetManifest)(HArchiveInternal, dmResource::HManifest);  // In order to set a downloaded manifest to a provider
+    typedef Result (*FSetJobThread)(HArchiveInternal, dmJobThread::HContext); // In order to decompress files in parallel
 
 
     // The resource loader types
@@ -71,7 +75,14 @@ namespace dmResourceProvider
 
     Result GetFileSize(HArchive archive, dmhash_t path_hash, const char* path, uint32_t* file_size);
     Result ReadFile(HArchive archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len);
+    // Reads 'size' bytes at 'offset'. Providers not supporting partial reads read the full file into a temporary buffer.
+    Result ReadFilePartial(HArchive archive, dmhash_t path_hash, const char* path, uint32_t offset, uint32_t size, uint8_t* buffer, uint32_t* nread);
+    // Gets a read-only pointer to the file data, valid while the archive is mounted.
+    // Returns RESULT_NOT_SUPPORTED if the file exists, but can only be read by copying it.
+    Result GetFileView(HArchive archive, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* size);
     Result WriteFile(HArchive archive, dmhash_t path_hash, const char* path, const uint8_t* buffer, uint32_t buffer_len);
+    // Sets the job thread the archive may use when reading files. Ignored by providers that don't use one.
+    Result SetJobThread(HArchive archive, dmJobThread::HContext job_thread);
 
 
     // Plugin API
@@ -153,6 +153,7 @@ namespace dmResourceProviderArchive
     // printf("Archive:\n");
     // dmResourceProviderArchivePrivate::DebugPrintArchiveIndex(archive->m_ArchiveIndex);
 
+        dmResourceArchive::CreateLookupTable(archive->m_ArchiveIndex);
         CreateEntryMap(archive);
 
         archive->m_Manifest->m_ArchiveIndex = archive->m_ArchiveIndex;
@@ -200,6 +201,7 @@ namespace dmResourceProviderArchive
 
         archive->m_ArchiveIndex = archive->m_Manifest->m_ArchiveIndex;
 
+        dmResourceArchive::CreateLookupTable(archive->m_ArchiveIndex);
         CreateEntryMap(archive);
 
         *out_archive = archive;
@@ -234,6 +236,36 @@ namespace dmResourceProviderArchive
         return dmResourceProvider::RESULT_NOT_FOUND;
     }
 
+    static dmResourceProvider::Result ReadFilePartial(dmResourceProvider::HArchiveInternal internal, dmhash_t path_hash, const char* path, uint32_t offset, uint32_t size, uint8_t* buffer, uint32_t* nread)
+    {
+        GameArchiveFile* archive = (GameArchiveFile*)internal;
+        EntryInfo* entry = archive->m_EntryMap.Get(path_hash);
+        if (entry)
+        {
+            dmResourceArchive::Result result = dmResourceArchive::ReadEntryPartial(archive->m_ArchiveIndex, entry->m_ArchiveInfo, offset, size, buffer, nread);
+            if (dmResourceArchive::RESULT_OK != result)
+                return dmResourceProvider::RESULT_IO_ERROR;
+            return dmResourceProvider::RESULT_OK;
+        }
+
+        return dmResourceProvider::RESULT_NOT_FOUND;
+    }
+
+    static dmResourceProvider::Result GetFileView(dmResourceProvider::HArchiveInternal internal, dmhash_t path_hash, const char* path, const uint8_t** data, uint32_t* size)
+    {
+        GameArchiveFile* archive = (GameArchiveFile*)internal;
+        EntryInfo* entry = archive->m_EntryMap.Get(path_hash);
+        if (entry)
+        {
+            if (dmResourceArchive::RESULT_OK != dmResourceArchive::GetEntryDataView(archive->m_ArchiveIndex, entry->m_ArchiveInfo, data))
+                return dmResourceProvider::RESULT_NOT_SUPPORTED;
+            *size = dmEndian::ToNetwork(entry->m_ArchiveInfo->m_ResourceSize);
+            return dmResourceProvider::RESULT_OK;
+        }
+
+        return dmResourceProvider::RESULT_NOT_FOUND;
+    }
+
     static dmResourceProvider::Result GetManifest(dmResourceProvider::HArchiveInternal internal, dmResource::HManifest* out_manifest)
     {
         GameArchiveFile* archive = (GameArchiveFile*)internal;
@@ -245,6 +277,13 @@ namespace dmResourceProviderArchive
         return dmResourceProvider::RESULT_NOT_FOUND;
     }
 
+    static dmResourceProvider::Result SetJobThread(dmResourceProvider::HArchiveInternal _archive, dmJobThread::HContext job_thread)
+    {
+        GameArchiveFile* archive = (GameArchiveFile*)_archive;
+        dmResourceArchive::SetJobThread(archive->m_ArchiveIndex, job_thread);
+        return dmResourceProvider::RESULT_OK;
+    }
+
     static void SetupArchiveLoader(dmResourceProvider::ArchiveLoader* loader)
     {
         loader->m_CanMount      = MatchesUri;
@@ -253,6 +292,9 @@ namespace dmResourceProviderArchive
         loader->m_GetManifest   = GetManifest;
         loader->m_GetFileSize   = GetFileSize;
         loader->m_ReadFile      = ReadFile;
+        loader->m_ReadFilePartial = ReadFilePartial;
+        loader->m_GetFileView   = GetFileView;
+        loader->m_SetJobThread  = SetJobThread;
     }
 
     DM_DECLARE_ARCHIVE_LOADER(ResourceProviderArchive, "archive", SetupArchiveLoader);
@@ -328,6 +328,7 @@ namespace dmResourceProviderArchiveMutable
             return dmResourceProvider::RESULT_SIGNATURE_MISMATCH;
         }
 
+        dmResourceArchive::CreateLookupTable(archive->m_ArchiveContainer);
         CreateEntryMap(archive);
 
         archive->m_Manifest->m_ArchiveIndex = archive->m_ArchiveContainer;
@@ -438,6 +439,26 @@ namespace dmResourceProviderArchiveMutable
         return dmResourceProvider::RESULT_OK;
     }
 
+    static dmResourceProvider::Result ReadFilePartial(dmResourceProvider::HArchiveInternal internal, dmhash_t path_hash, const char* path, uint32_t offset, uint32_t size, uint8_t* buffer, uint32_t* nread)
+    {
+        GameArchiveFile* archive = (GameArchiveFile*)internal;
+        if (!archive->m_ArchiveContainer)
+            return dmResourceProvider::RESULT_NOT_FOUND;
+        if (archive->m_EntryMap.Empty())
+            return dmResourceProvider::RESULT_NOT_FOUND;
+
+        EntryInfo* entry = archive->m_EntryMap.Get(path_hash);
+        if (!entry)
+            return dmResourceProvider::RESULT_NOT_FOUND;
+
+        dmResourceArchive::Result result = dmResourceArchive::ReadEntryPartial(archive->m_ArchiveContainer, entry->m_ArchiveInfo, offset, size, buffer, nread);
+        if (dmResourceArchive::RESULT_OK != result)
+        {
+            return dmResourceProvider::RESULT_IO_ERROR;
+        }
+        return dmResourceProvider::RESULT_OK;
+    }
+
     static dmResourceProvider::Result VerifyResource(const dmResource::HManifest manifest, const uint8_t* expected, uint32_t expected_length, const uint8_t* data, uint32_t data_length)
     {
         if (manifest == 0x0 || data == 0x0)
@@ -567,6 +588,13 @@ namespace dmResourceProviderArchiveMutable
         return dmResourceProvider::RESULT_OK;
     }
 
+    static dmResourceProvider::Result SetJobThread(dmResourceProvider::HArchiveInternal _archive, dmJobThread::HContext job_thread)
+    {
+        GameArchiveFile* archive = (GameArchiveFile*)_archive;
+        dmResourceArchive::SetJobThread(archive->m_ArchiveContainer, job_thread);
+        return dmResourceProvider::RESULT_OK;
+    }
+
     static void SetupArchiveLoader(dmResourceProvider::ArchiveLoader* loader)
     {
         loader->m_CanMount      = MatchesUri;
@@ -576,7 +604,9 @@ namespace dmResourceProviderArchiveMutable
         loader->m_SetManifest   = SetManifest;
         loader->m_GetFileSize   = GetFileSize;
         loader->m_ReadFile      = ReadFile;
+        loader->m_ReadFilePartial = ReadFilePartial;
         loader->m_WriteFile     = WriteFile;
+        loader->m_SetJobThread  = SetJobThread;
     }
 
     DM_DECLARE_ARCHIVE_LOADER(ResourceProviderArchiveMutable, "mutable", SetupArchiveLoader);
@@ -38,7 +38,10 @@ namespace dmResourceProvider
 
         FGetFileSize            m_GetFileSize;
         FReadFile               m_ReadFile;
+        FReadFilePartial        m_ReadFilePartial;  // Optional
+        FGetFileView            m_GetFileView;      // Optional
         FWriteFile              m_WriteFile;        // For writeable archives
+        FSetJobThread           m_SetJobThread;     // Optional
 
         void Verify();
 
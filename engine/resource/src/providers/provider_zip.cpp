@@ -49,6 +49,7 @@ struct ZipProviderContext
     dmZip::HZip                 m_Zip;
     dmResource::HManifest       m_Manifest;
     dmHashTable64<EntryInfo>    m_EntryMap; // url hash -> entry in the manifest
+    dmJobThread::HContext       m_JobThread;
 };
 
 
@@ -248,7 +249,7 @@ static dmResourceProvider::Result GetFileSize(dmResourceProvider::HArchiveIntern
     return dmResourceProvider::RESULT_NOT_FOUND;
 }
 
-static dmResourceProvider::Result UnpackData(const char* path, dmLiveUpdateDDF::ResourceEntry* entry, uint8_t* raw_resource, uint32_t raw_resource_size, uint8_t* out_buffer)
+static dmResourceProvider::Result UnpackData(ZipProviderContext* archive, const char* path, dmLiveUpdateDDF::ResourceEntry* entry, uint8_t* raw_resource, uint32_t raw_resource_size, uint8_t* out_buffer)
 {
     dmResourceArchive::LiveUpdateResource resource(raw_resource, raw_resource_size);
 
@@ -268,7 +269,16 @@ static dmResourceProvider::Result UnpackData(const char* path, dmLiveUpdateDDF::
         }
     }
 
-    if (compressed)
+    if (compressed && (resource.m_Header->m_Flags & dmResourceArchive::ENTRY_FLAG_COMPRESSED_BLOCKS))
+    {
+        dmResourceArchive::Result r = dmResourceArchive::DecompressBlocks(archive->m_JobThread, resource.m_Data, compressed_size, resource_size, out_buffer);
+        if (dmResourceArchive::RESULT_OK != r)
+        {
+            dmLogError("Failed to decompress resource: '%s", path);
+            return dmResourceProvider::RESULT_IO_ERROR;
+        }
+    }
+    else if (compressed)
     {
         int decompressed_size;
         dmLZ4::Result r = dmLZ4::DecompressBuffer((const uint8_t*)resource.m_Data, compressed_size, out_buffer, resource_size, &decompressed_size);
@@ -307,7 +317,7 @@ static dmResourceProvider::Result ReadFile(dmResourceProvider::HArchiveInternal
         dmZip::GetEntrySize(archive->m_Zip, &raw_data_size);
         uint8_t* raw_data = new uint8_t[raw_data_size];
         dmZip::GetEntryData(archive->m_Zip, (void*)raw_data, raw_data_size);
-        result = UnpackData(path, entry->m_ManifestEntry, raw_data, raw_data_size, buffer);
+        result = UnpackData(archive, path, entry->m_ManifestEntry, raw_data, raw_data_size, buffer);
         delete[] raw_data;
     } else
     {
@@ -331,6 +341,13 @@ static dmResourceProvider::Result GetManifest(dmResourceProvider::HArchiveIntern
     return dmResourceProvider::RESULT_NOT_FOUND;
 }
 
+static dmResourceProvider::Result SetJobThread(dmResourceProvider::HArchiveInternal _archive, dmJobThread::HContext job_thread)
+{
+    ZipProviderContext* archive = (ZipProviderContext*)_archive;
+    archive->m_JobThread = job_thread;
+    return dmResourceProvider::RESULT_OK;
+}
+
 static void SetupArchiveLoaderHttpZip(dmResourceProvider::ArchiveLoader* loader)
 {
     loader->m_CanMount      = MatchesUri;
@@ -339,6 +356,7 @@ static void SetupArchiveLoaderHttpZip(dmResourceProvider::ArchiveLoader* loader)
     loader->m_GetManifest   = GetManifest;
     loader->m_GetFileSize   = GetFileSize;
     loader->m_ReadFile      = ReadFile;
+    loader->m_SetJobThread  = SetJobThread;
 }
 
 DM_DECLARE_ARCHIVE_LOADER(ResourceProviderZip, "zip", SetupArchiveLoaderHttpZip);
@@ -41,6 +41,7 @@
 #include <dlib/uri.h>
 
 #include "resource.h"
+#include "resource_archive.h"
 #include "resource_manifest.h"
 #include "resource_mounts.h"
 #include "resource_private.h"
@@ -63,6 +64,8 @@
  */
 
 DM_PROPERTY_U32(rmtp_Resource, 0, FrameReset, "# resources");
+DM_PROPERTY_U32(rmtp_ResourceCreateTime, 0, FrameReset, "us spent creating preloaded resources");
+DM_PROPERTY_U32(rmtp_ResourceCache, 0, FrameReset, "# bytes in the resource cache");
 
 namespace dmResource
 {
@@ -77,6 +80,14 @@ const char* BUNDLE_PUBLIC_KEY_FILENAME          = "game.public.der";
 
 
 const char* MAX_RESOURCES_KEY = "resource.max_resources";
+const char* LOADER_THREADS_KEY = "resource.loader_threads";
+const char* LOADER_QUEUE_SLOTS_KEY = "resource.loader_queue_slots";
+const char* LOADER_MAX_PENDING_DATA_KEY = "resource.loader_max_pending_data";
+const char* CREATE_BUDGET_KEY = "resource.create_budget";
+const char* CACHE_SIZE_KEY = "resource.cache_size";
+
+// Below 1ms, UpdatePreloader doesn't sleep while waiting for the loads
+const uint32_t PREFETCH_TIME_LIMIT = 500;
 
 struct ResourceReloadedCallbackPair
 {
@@ -84,11 +95,21 @@ struct ResourceReloadedCallbackPair
     void*                       m_UserData;
 };
 
+// Unreferenced resource kept alive in the resource cache
+struct CacheEntry
+{
+    dmhash_t       m_NameHash;
+    SResourceType* m_ResourceType;
+    uint32_t       m_Size;
+};
+
 struct SResourceFactory
 {
     // TODO: Arg... budget. Two hash-maps. Really necessary?
     dmHashTable64<SResourceDescriptor>*          m_Resources;
     dmHashTable<uintptr_t, uint64_t>*            m_ResourceToHash;
+    // Resources that can't be cached, since they weren't loaded from file or were changed after they were loaded
+    dmHashTable64<bool>*                         m_Uncacheable;
     // Only valid if RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT is set
     // Used for reloading of resources
     dmHashTable64<const char*>*                  m_ResourceHashToFilename;
@@ -120,6 +141,25 @@ struct SResourceFactory
     dmResourceProvider::HArchive                 m_BuiltinMount;
     dmResourceProvider::HArchive                 m_BaseArchiveMount;
 
+    // Settings for the load queues created by the preloaders
+    LoadQueueParams                              m_LoadQueueParams;
+
+    // Used by the archives to decompress large entries in parallel
+    dmJobThread::HContext                        m_JobThread;
+
+    // Time in microseconds the preloaders may spend creating resources each frame (0 means no limit)
+    uint32_t                                     m_CreateBudget;
+    uint32_t                                     m_CreateTimeSpent;
+    // Set while a preloader calls a create or post create function within the budget
+    bool                                         m_PreloaderCreate;
+
+    // Unreferenced resources, least recently released first
+    dmArray<CacheEntry>                          m_Cache;
+    uint32_t                                     m_CacheSize;
+    uint32_t                                     m_CacheBudget;
+    // Preloaders of resource.prefetch, their resources end up in the cache when they complete
+    dmArray<HPreloader>                          m_Prefetches;
+
     // Serial version that increases per resource insertion
     uint16_t                                     m_Version;
 };
@@ -167,6 +207,9 @@ void SetDefaultNewFactoryParams(struct NewFactoryParams* params)
     memset(params, 0, sizeof(NewFactoryParams));
     params->m_MaxResources = 1024;
     params->m_Flags = RESOURCE_FACTORY_FLAGS_EMPTY;
+    params->m_LoaderThreadCount = 2;
+    params->m_LoaderQueueSlots = 16;
+    params->m_LoaderMaxPendingData = 4 * 1024 * 1024;
 
     params->m_ArchiveManifest.m_Data = 0;
     params->m_ArchiveManifest.m_Size = 0;
@@ -341,6 +384,9 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
     factory->m_ResourceToHash = new dmHashTable<uintptr_t, uint64_t>();
     factory->m_ResourceToHash->SetCapacity(table_size, params->m_MaxResources);
 
+    factory->m_Uncacheable = new dmHashTable64<bool>();
+    factory->m_Uncacheable->SetCapacity(table_size, params->m_MaxResources);
+
     if (params->m_Flags & RESOURCE_FACTORY_FLAGS_RELOAD_SUPPORT)
     {
         factory->m_ResourceHashToFilename = new dmHashTable64<const char*>();
@@ -361,6 +407,20 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
         AddBuiltinMount(factory, params);
     }
 
+    factory->m_LoadQueueParams.m_ThreadCount    = dmMath::Max(1u, params->m_LoaderThreadCount);
+    factory->m_LoadQueueParams.m_QueueSlots     = dmMath::Max(1u, params->m_LoaderQueueSlots);
+    factory->m_LoadQueueParams.m_MaxPendingData = dmMath::Max(1u, params->m_LoaderMaxPendingData);
+
+    factory->m_JobThread = params->m_JobThread;
+    factory->m_CreateBudget = params->m_CreateBudget;
+    factory->m_CreateTimeSpent = 0;
+    factory->m_PreloaderCreate = false;
+    factory->m_CacheBudget = params->m_CacheSize;
+    if (factory->m_Mounts)
+    {
+        dmResourceMounts::SetJobThread(factory->m_Mounts, factory->m_JobThread);
+    }
+
     factory->m_LoadMutex = dmMutex::New();
     return factory;
 }
@@ -372,6 +432,9 @@ static void ResourceIteratorCallback(void*, const dmhash_t* id, SResourceDescrip
 
 void DeleteFactory(HFactory factory)
 {
+    // Destroy the cached resources, while the mounts and load mutex are still around
+    SetCacheBudget(factory, 0, 0);
+
     if (factory->m_Socket)
     {
         dmMessage::DeleteSocket(factory->m_Socket);
@@ -395,6 +458,7 @@ void DeleteFactory(HFactory factory)
     free((void*)factory->m_PublicKeyPath);
     delete factory->m_Resources;
     delete factory->m_ResourceToHash;
+    delete factory->m_Uncacheable;
     if (factory->m_ResourceHashToFilename)
         delete factory->m_ResourceHashToFilename;
     if (factory->m_ResourceReloadedCallbacks)
@@ -438,7 +502,233 @@ void UpdateFactory(HFactory factory)
 {
     DM_PROFILE(__FUNCTION__);
     dmMessage::Dispatch(factory->m_Socket, &Dispatch, factory);
+
+    // Prefetches get what's left of the create budget this frame
+    for (uint32_t i = 0; i < factory->m_Prefetches.Size();)
+    {
+        HPreloader preloader = factory->m_Prefetches[i];
+        Result r = UpdatePreloader(preloader, 0, 0, PREFETCH_TIME_LIMIT);
+        if (r == RESULT_PENDING)
+        {
+            ++i;
+            continue;
+        }
+        if (r != RESULT_OK)
+        {
+            dmLogWarning("Failed to prefetch resources: %s", ResultToString(r));
+        }
+        factory->m_Prefetches.EraseSwap(i);
+        DeletePreloader(preloader);
+    }
+
     DM_PROPERTY_ADD_U32(rmtp_Resource, factory->m_Resources->Size());
+    DM_PROPERTY_ADD_U32(rmtp_ResourceCache, factory->m_CacheSize);
+    DM_PROPERTY_ADD_U32(rmtp_ResourceCreateTime, factory->m_CreateTimeSpent);
+    factory->m_CreateTimeSpent = 0;
+}
+
+static void DestroyResource(HFactory factory, SResourceDescriptor* rd)
+{
+    SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
+
+    DM_PROFILE_DYN(resource_type->m_Extension, 0);
+
+    // The destroy function may release other resources, so don't rely on the descriptor afterwards
+    dmhash_t name_hash = rd->m_NameHash;
+    void* resource = rd->m_Resource;
+
+    ResourceDestroyParams params;
+    params.m_Factory = factory;
+    params.m_Context = resource_type->m_Context;
+    params.m_Resource = rd;
+    resource_type->m_DestroyFunction(params);
+
+    factory->m_ResourceToHash->Erase((uintptr_t) resource);
+    factory->m_Resources->Erase(name_hash);
+    factory->m_Uncacheable->Erase(name_hash);
+    if (factory->m_ResourceHashToFilename)
+    {
+        const char** s = factory->m_ResourceHashToFilename->Get(name_hash);
+        factory->m_ResourceHashToFilename->Erase(name_hash);
+        assert(s);
+        free((void*) *s);
+    }
+}
+
+static CacheEntry TakeCacheEntry(HFactory factory, uint32_t index)
+{
+    CacheEntry entry = factory->m_Cache[index];
+    // Keep the order, the front is evicted first
+    CacheEntry* entries = factory->m_Cache.Begin();
+    memmove(entries + index, entries + index + 1, (factory->m_Cache.Size() - index - 1) * sizeof(CacheEntry));
+    factory->m_Cache.SetSize(factory->m_Cache.Size() - 1);
+    factory->m_CacheSize -= entry.m_Size;
+    entry.m_ResourceType->m_CacheSize -= entry.m_Size;
+    return entry;
+}
+
+static void RemoveFromCache(HFactory factory, dmhash_t name_hash)
+{
+    // Recently released resources are the most likely to be reused
+    for (uint32_t i = factory->m_Cache.Size(); i > 0; --i)
+    {
+        if (factory->m_Cache[i - 1].m_NameHash == name_hash)
+        {
+            TakeCacheEntry(factory, i - 1);
+            return;
+        }
+    }
+}
+
+static void EvictCacheEntry(HFactory factory, uint32_t index)
+{
+    CacheEntry entry = TakeCacheEntry(factory, index);
+    SResourceDescriptor* rd = factory->m_Resources->Get(entry.m_NameHash);
+    assert(rd && rd->m_ReferenceCount == 0);
+    DestroyResource(factory, rd);
+}
+
+// Evicts the least recently released resources until the cache (and the cached resources of the type, if given) is within budget
+static void EvictCache(HFactory factory, SResourceType* resource_type)
+{
+    while (resource_type && resource_type->m_CacheSize > resource_type->m_CacheBudget)
+    {
+        uint32_t i = 0;
+        while (factory->m_Cache[i].m_ResourceType != resource_type)
+        {
+            ++i;
+        }
+        EvictCacheEntry(factory, i);
+    }
+    while (factory->m_CacheSize > factory->m_CacheBudget)
+    {
+        EvictCacheEntry(factory, 0);
+    }
+}
+
+// Cached resources give up their slots to new resources
+static void EvictForNewResource(HFactory factory)
+{
+    while (factory->m_Resources->Full() && !factory->m_Cache.Empty())
+    {
+        EvictCacheEntry(factory, 0);
+    }
+}
+
+bool IsCacheable(HFactory factory, dmhash_t name_hash)
+{
+    return factory->m_Uncacheable->Get(name_hash) == 0;
+}
+
+void SetUncacheable(HFactory factory, dmhash_t name_hash)
+{
+    // The table has room for all resources, but a resource that is being created may not fit in the factory
+    if (!factory->m_Uncacheable->Full())
+    {
+        factory->m_Uncacheable->Put(name_hash, true);
+    }
+}
+
+// Returns false if the resource can't be cached and should be destroyed
+static bool AddToCache(HFactory factory, SResourceDescriptor* rd)
+{
+    SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
+    uint32_t size = rd->m_ResourceSize != 0 ? rd->m_ResourceSize : rd->m_ResourceSizeOnDisc;
+    if (factory->m_CacheBudget == 0 || !IsCacheable(factory, rd->m_NameHash) || size > factory->m_CacheBudget || size > resource_type->m_CacheBudget)
+    {
+        return false;
+    }
+
+    if (factory->m_Cache.Full())
+    {
+        factory->m_Cache.OffsetCapacity(64);
+    }
+    CacheEntry entry;
+    entry.m_NameHash = rd->m_NameHash;
+    entry.m_ResourceType = resource_type;
+    entry.m_Size = size;
+    factory->m_Cache.Push(entry);
+    factory->m_CacheSize += size;
+    resource_type->m_CacheSize += size;
+
+    EvictCache(factory, resource_type);
+    return true;
+}
+
+Result SetCacheBudget(HFactory factory, const char* extension, uint32_t size)
+{
+    if (extension)
+    {
+        SResourceType* resource_type = FindResourceType(factory, extension);
+        if (!resource_type)
+        {
+            return RESULT_UNKNOWN_RESOURCE_TYPE;
+        }
+        resource_type->m_CacheBudget = size;
+        EvictCache(factory, resource_type);
+        return RESULT_OK;
+    }
+
+    factory->m_CacheBudget = size;
+    if (size == 0)
+    {
+        // Nothing left to prefetch into
+        for (uint32_t i = 0; i < factory->m_Prefetches.Size(); ++i)
+        {
+            DeletePreloader(factory->m_Prefetches[i]);
+        }
+        factory->m_Prefetches.SetSize(0);
+    }
+    EvictCache(factory, 0);
+    return RESULT_OK;
+}
+
+Result Prefetch(HFactory factory, const dmArray<const char*>& names)
+{
+    if (factory->m_CacheBudget == 0)
+    {
+        return RESULT_NOT_SUPPORTED;
+    }
+    if (names.Empty())
+    {
+        return RESULT_INVAL;
+    }
+
+    if (factory->m_Prefetches.Full())
+    {
+        factory->m_Prefetches.OffsetCapacity(4);
+    }
+    factory->m_Prefetches.Push(NewPreloader(factory, names));
+    return RESULT_OK;
+}
+
+uint32_t GetCreateBudgetLeft(HFactory factory)
+{
+    // Only the preloaders spread the creation over frames, other resources must complete in one go
+    if (factory->m_CreateBudget == 0 || !factory->m_PreloaderCreate || factory->m_RecursionDepth != 0)
+        return 0xFFFFFFFF;
+    if (factory->m_CreateTimeSpent >= factory->m_CreateBudget)
+        return 0;
+    return factory->m_CreateBudget - factory->m_CreateTimeSpent;
+}
+
+bool HasCreateBudget(HFactory factory, uint32_t cost)
+{
+    if (factory->m_CreateBudget == 0 || factory->m_CreateTimeSpent == 0)
+        return true;
+    return factory->m_CreateTimeSpent + cost <= factory->m_CreateBudget;
+}
+
+void SetPreloaderCreate(HFactory factory, bool preloader_create)
+{
+    factory->m_PreloaderCreate = preloader_create;
+}
+
+void AddCreateTime(HFactory factory, uint32_t* cost, uint32_t time)
+{
+    factory->m_CreateTimeSpent += time;
+    // Keep a moving average, but let it catch up quickly with an expensive item
+    *cost = time > *cost ? time : (*cost * 3 + time) / 4;
 }
 
 Result RegisterType(HFactory factory,
@@ -472,6 +762,7 @@ Result RegisterType(HFactory factory,
     resource_type.m_PostCreateFunction = post_create_function;
     resource_type.m_DestroyFunction = destroy_function;
     resource_type.m_RecreateFunction = recreate_function;
+    resource_type.m_CacheBudget = 0xFFFFFFFF;
 
     factory->m_ResourceTypes[factory->m_ResourceTypesCount++] = resource_type;
 
@@ -561,6 +852,18 @@ Result LoadResourceFromBuffer(HFactory factory, const char* path, const char* or
     return LoadResourceFromBufferLocked(factory, path, original_name, resource_size, buffer);
 }
 
+Result GetResourceView(HFactory factory, const char* path, dmResourceMounts::ResourceView* view)
+{
+    char normalized_path[RESOURCE_PATH_MAX];
+    GetCanonicalPath(path, normalized_path);
+    return dmResourceMounts::GetResourceView(factory->m_Mounts, dmHashString64(normalized_path), normalized_path, view);
+}
+
+void ReleaseResourceView(HFactory factory, dmResourceMounts::ResourceView* view)
+{
+    dmResourceMounts::ReleaseResourceView(factory->m_Mounts, view);
+}
+
 // Assumes m_LoadMutex is already held
 Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size)
 {
@@ -586,8 +889,9 @@ const char* GetExtFromPath(const char* path)
 }
 
 // Assumes m_LoadMutex is already held
+// Only resources loaded from file are cacheable, since they can be loaded again as they were
 static Result DoCreateResource(HFactory factory, SResourceType* resource_type, const char* name, const char* canonical_path,
-    dmhash_t canonical_path_hash, void* buffer, uint32_t buffer_size, void** resource_out)
+    dmhash_t canonical_path_hash, void* buffer, uint32_t buffer_size, bool cacheable, void** resource_out)
 {
     // TODO: We should *NOT* allocate SResource dynamically...
     SResourceDescriptor tmp_resource;
@@ -596,6 +900,16 @@ static Result DoCreateResource(HFactory factory, SResourceType* resource_type, c
     tmp_resource.m_ReferenceCount = 1;
     tmp_resource.m_ResourceType   = (void*) resource_type;
 
+    // Marked before the create, so that the resource type can check it (see IsCacheable)
+    if (!cacheable)
+    {
+        SetUncacheable(factory, canonical_path_hash);
+    }
+
+    // A resource created from within a preloader create isn't part of the create budget
+    bool preloader_create = factory->m_PreloaderCreate;
+    factory->m_PreloaderCreate = false;
+
     void *preload_data = 0;
     Result create_error = RESULT_OK;
 
@@ -635,6 +949,7 @@ static Result DoCreateResource(HFactory factory, SResourceType* resource_type, c
         params.m_Context     = resource_type->m_Context;
         params.m_PreloadData = preload_data;
         params.m_Resource    = &tmp_resource;
+        // Without a create budget the post create only returns pending while it waits for asynchronous work (e.g. texture uploads)
         for(;;)
         {
             create_error = resource_type->m_PostCreateFunction(params);
@@ -643,6 +958,7 @@ static Result DoCreateResource(HFactory factory, SResourceType* resource_type, c
             dmTime::Sleep(1000);
         }
     }
+    factory->m_PreloaderCreate = preloader_create;
 
     // Restore to default buffer size
     factory->m_Buffer.SetSize(0);
@@ -665,12 +981,14 @@ static Result DoCreateResource(HFactory factory, SResourceType* resource_type, c
             params.m_Context  = resource_type->m_Context;
             params.m_Resource = &tmp_resource;
             resource_type->m_DestroyFunction(params);
+            factory->m_Uncacheable->Erase(canonical_path_hash);
             return insert_error;
         }
     }
     else
     {
         dmLogWarning("Unable to create resource: %s: %s", canonical_path, ResultToString(create_error));
+        factory->m_Uncacheable->Erase(canonical_path_hash);
         return create_error;
     }
 }
@@ -685,11 +1003,12 @@ static Result PrepareResourceCreation(HFactory factory, const char* canonical_pa
     if (rd)
     {
         assert(factory->m_ResourceToHash->Get((uintptr_t) rd->m_Resource));
-        rd->m_ReferenceCount++;
+        IncRef(factory, rd);
         *resource_out = rd->m_Resource;
         return RESULT_OK;
     }
 
+    EvictForNewResource(factory);
     if (factory->m_Resources->Full())
     {
         dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_Resources->Capacity(), MAX_RESOURCES_KEY);
@@ -743,16 +1062,26 @@ static Result CreateAndLoadResource(HFactory factory, const char* name, void** r
         return RESULT_OK;
     }
 
+    // Create directly from the archive data if possible
+    dmResourceMounts::ResourceView view;
+    Result result = GetResourceView(factory, canonical_path, &view);
+    if (result == RESULT_OK)
+    {
+        result = DoCreateResource(factory, resource_type, name, canonical_path, canonical_path_hash, (void*)view.m_Data, view.m_Size, true, resource);
+        ReleaseResourceView(factory, &view);
+        return result;
+    }
+
     void* buffer         = 0;
     uint32_t buffer_size = 0;
-    Result result = LoadResource(factory, canonical_path, name, &buffer, &buffer_size);
+    result = LoadResource(factory, canonical_path, name, &buffer, &buffer_size);
     if (result != RESULT_OK)
     {
         return result;
     }
     assert(buffer == factory->m_Buffer.Begin());
 
-    return DoCreateResource(factory, resource_type, name, canonical_path, canonical_path_hash, buffer, buffer_size, resource);
+    return DoCreateResource(factory, resource_type, name, canonical_path, canonical_path_hash, buffer, buffer_size, true, resource);
 }
 
 Result CreateResource(HFactory factory, const char* name, void* data, uint32_t data_size, void** resource)
@@ -768,6 +1097,14 @@ Result CreateResource(HFactory factory, const char* name, void* data, uint32_t d
     GetCanonicalPath(name, canonical_path);
     dmhash_t canonical_path_hash = dmHashBuffer64(canonical_path, strlen(canonical_path));
 
+    // A cached resource is unloaded as far as the user is concerned, so it is replaced by the new data
+    SResourceDescriptor* rd = factory->m_Resources->Get(canonical_path_hash);
+    if (rd && rd->m_ReferenceCount == 0)
+    {
+        RemoveFromCache(factory, canonical_path_hash);
+        DestroyResource(factory, rd);
+    }
+
     SResourceType* resource_type;
     Result res = PrepareResourceCreation(factory, canonical_path, canonical_path_hash, resource, &resource_type);
 
@@ -781,7 +1118,7 @@ Result CreateResource(HFactory factory, const char* name, void* data, uint32_t d
         return RESULT_OK;
     }
 
-    return DoCreateResource(factory, resource_type, name, canonical_path, canonical_path_hash, data, data_size, resource);
+    return DoCreateResource(factory, resource_type, name, canonical_path, canonical_path_hash, data, data_size, false, resource);
 }
 
 Result Get(HFactory factory, const char* name, void** resource)
@@ -851,6 +1188,7 @@ SResourceDescriptor* FindByHash(HFactory factory, uint64_t canonical_path_hash)
 
 Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, SResourceDescriptor* descriptor)
 {
+    EvictForNewResource(factory);
     if (factory->m_Resources->Full())
     {
         dmLogError("The max number of resources (%d) has been passed, tweak \"%s\" in the config file.", factory->m_Resources->Capacity(), MAX_RESOURCES_KEY);
@@ -907,6 +1245,27 @@ Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* res
     return result;
 }
 
+Result GetRawPartial(HFactory factory, const char* name, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+{
+    DM_PROFILE(__FUNCTION__);
+
+    assert(name);
+    assert(buffer);
+    assert(nread);
+
+    *nread = 0;
+
+    Result chk = CheckSuppliedResourcePath(name);
+    if (chk != RESULT_OK)
+        return chk;
+
+    char canonical_path[RESOURCE_PATH_MAX];
+    GetCanonicalPath(name, canonical_path);
+    dmhash_t canonical_path_hash = dmHashString64(canonical_path);
+
+    return dmResourceMounts::ReadResourcePartial(factory->m_Mounts, canonical_path_hash, canonical_path, offset, size, (uint8_t*)buffer, nread);
+}
+
 static Result DoReloadResource(HFactory factory, const char* name, SResourceDescriptor** out_descriptor)
 {
     char canonical_path[RESOURCE_PATH_MAX];
@@ -1026,10 +1385,21 @@ Result SetResource(HFactory factory, uint64_t hashed_name, void* data, uint32_t
         return RESULT_RESOURCE_NOT_FOUND;
     }
 
+    // A cached resource is unloaded as far as the user is concerned, and the next Get loads it from file again
+    if (rd->m_ReferenceCount == 0)
+    {
+        RemoveFromCache(factory, hashed_name);
+        DestroyResource(factory, rd);
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
     SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
     if (!resource_type->m_RecreateFunction)
         return RESULT_NOT_SUPPORTED;
 
+    // The resource no longer matches the file, so it can't be reused once it's released
+    SetUncacheable(factory, hashed_name);
+
     assert(data);
     assert(datasize > 0);
 
@@ -1081,10 +1451,21 @@ Result SetResource(HFactory factory, uint64_t hashed_name, void* message)
         return RESULT_RESOURCE_NOT_FOUND;
     }
 
+    // A cached resource is unloaded as far as the user is concerned, and the next Get loads it from file again
+    if (rd->m_ReferenceCount == 0)
+    {
+        RemoveFromCache(factory, hashed_name);
+        DestroyResource(factory, rd);
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
     SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
     if (!resource_type->m_RecreateFunction)
         return RESULT_NOT_SUPPORTED;
 
+    // The resource no longer matches the file, so it can't be reused once it's released
+    SetUncacheable(factory, hashed_name);
+
     ResourceRecreateParams params;
     params.m_Factory = factory;
     params.m_Context = resource_type->m_Context;
@@ -1132,7 +1513,6 @@ Result GetType(HFactory factory, void* resource, ResourceType* type)
 
     SResourceDescriptor* rd = factory->m_Resources->Get(*resource_hash);
     assert(rd);
-    assert(rd->m_ReferenceCount > 0);
     *type = (ResourceType) rd->m_ResourceType;
 
     return RESULT_OK;
@@ -1222,8 +1602,15 @@ void IncRef(HFactory factory, void* resource)
 
     SResourceDescriptor* rd = factory->m_Resources->Get(*resource_hash);
     assert(rd);
-    assert(rd->m_ReferenceCount > 0);
-    ++rd->m_ReferenceCount;
+    IncRef(factory, rd);
+}
+
+void IncRef(HFactory factory, SResourceDescriptor* rd)
+{
+    if (rd->m_ReferenceCount++ == 0)
+    {
+        RemoveFromCache(factory, rd->m_NameHash);
+    }
 }
 
 uint16_t GetVersion(HFactory factory, void* resource)
@@ -1269,24 +1656,9 @@ void Release(HFactory factory, void* resource)
 
     if (rd->m_ReferenceCount == 0)
     {
-        SResourceType* resource_type = (SResourceType*) rd->m_ResourceType;
-
-        DM_PROFILE_DYN(resource_type->m_Extension, 0);
-
-        ResourceDestroyParams params;
-        params.m_Factory = factory;
-        params.m_Context = resource_type->m_Context;
-        params.m_Resource = rd;
-        resource_type->m_DestroyFunction(params);
-
-        factory->m_ResourceToHash->Erase((uintptr_t) resource);
-        factory->m_Resources->Erase(*resource_hash);
-        if (factory->m_ResourceHashToFilename)
+        if (!AddToCache(factory, rd))
         {
-            const char** s = factory->m_ResourceHashToFilename->Get(*resource_hash);
-            factory->m_ResourceHashToFilename->Erase(*resource_hash);
-            assert(s);
-            free((void*) *s);
+            DestroyResource(factory, rd);
         }
     }
 }
@@ -1356,6 +1728,11 @@ dmMutex::HMutex GetLoadMutex(const dmResource::HFactory factory)
     return factory->m_LoadMutex;
 }
 
+const LoadQueueParams* GetLoadQueueParams(HFactory factory)
+{
+    return &factory->m_LoadQueueParams;
+}
+
 dmResourceMounts::HContext GetMountsContext(const dmResource::HFactory factory)
 {
     return factory->m_Mounts;
@@ -1365,8 +1742,10 @@ void ReleaseBuiltinsArchive(HFactory factory)
 {
     if (factory->m_BuiltinMount)
     {
-        dmResourceMounts::RemoveMount(factory->m_Mounts, factory->m_BuiltinMount);
-        dmResourceProvider::Unmount(factory->m_BuiltinMount);
+        if (dmResourceMounts::RemoveMount(factory->m_Mounts, factory->m_BuiltinMount) != RESULT_PENDING)
+        {
+            dmResourceProvider::Unmount(factory->m_BuiltinMount);
+        }
         factory->m_BuiltinMount = 0;
     }
 }
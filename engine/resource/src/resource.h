@@ -20,6 +20,7 @@
 #include <dlib/array.h>
 #include <dlib/hash.h>
 #include <dlib/hashtable.h>
+#include <dlib/job_thread.h>
 #include <dlib/mutex.h>
 
 namespace dmResourceArchive
@@ -30,6 +31,7 @@ namespace dmResourceArchive
 namespace dmResourceMounts
 {
     typedef struct ResourceMountsContext* HContext;
+    struct ResourceView;
 }
 
 namespace dmResourceProvider
@@ -49,6 +51,23 @@ namespace dmResource
      */
     extern const char* MAX_RESOURCES_KEY;
 
+    /**
+     * Configuration keys used to tweak the background loader (see NewFactoryParams)
+     */
+    extern const char* LOADER_THREADS_KEY;
+    extern const char* LOADER_QUEUE_SLOTS_KEY;
+    extern const char* LOADER_MAX_PENDING_DATA_KEY;
+
+    /**
+     * Configuration key used to set the per frame time budget for creating preloaded resources, in milliseconds
+     */
+    extern const char* CREATE_BUDGET_KEY;
+
+    /**
+     * Configuration key used to set the memory budget of the cache of unreferenced resources, in bytes
+     */
+    extern const char* CACHE_SIZE_KEY;
+
     extern const char* BUNDLE_INDEX_FILENAME;
     extern const char* BUNDLE_DATA_FILENAME;
 
@@ -132,7 +151,21 @@ namespace dmResource
         EmbeddedResource m_ArchiveData;
         EmbeddedResource m_ArchiveManifest;
 
-        uint32_t m_Reserved[5];
+        /// Number of threads loading and preloading resources for each preloader. Default is 2
+        uint32_t m_LoaderThreadCount;
+        /// Max number of loads in flight for each preloader. Default is 16
+        uint32_t m_LoaderQueueSlots;
+        /// Once this many bytes of loaded data is waiting to be picked up, the loader pauses. Default is 4MB
+        uint32_t m_LoaderMaxPendingData;
+
+        /// Job thread used to decompress large archive entries in parallel. Default is 0 (no job thread)
+        dmJobThread::HContext m_JobThread;
+
+        /// Max time in microseconds spent creating preloaded resources each frame (see UpdateFactory). Default is 0 (no limit)
+        uint32_t m_CreateBudget;
+
+        /// Max bytes of unreferenced resources kept alive for reuse (see SetCacheBudget). Default is 0 (no cache)
+        uint32_t m_CacheSize;
 
         NewFactoryParams()
         {
@@ -156,10 +189,57 @@ namespace dmResource
 
     /**
      * Update resource factory. Required to be called periodically when http server support is enabled.
+     * Also starts a new frame of the resource create budget.
      * @param factory Factory handle
      */
     void UpdateFactory(HFactory factory);
 
+    /**
+     * Returns the time left this frame of the budget for creating preloaded resources (see NewFactoryParams::m_CreateBudget).
+     * Resource types can use it to spread expensive work (e.g. texture uploads) over several post create calls.
+     * @param factory Factory handle
+     * @return Time left in microseconds, or 0xFFFFFFFF if there's no limit (or the resource isn't created by a preloader)
+     */
+    uint32_t GetCreateBudgetLeft(HFactory factory);
+
+    /**
+     * Set the memory budget of the resource cache. Resources loaded from file aren't destroyed when their
+     * reference count reaches zero, but are kept in the cache until they are needed again, or evicted
+     * (least recently released first) to stay within the budgets.
+     * Setting the total budget to 0 completes any prefetches and destroys all cached resources.
+     * @param factory Factory handle
+     * @param extension Resource type extension (e.g. "texturec"), or 0 to set the total budget
+     * @param size Budget in bytes
+     * @return RESULT_OK on success, RESULT_UNKNOWN_RESOURCE_TYPE if the extension isn't registered
+     */
+    Result SetCacheBudget(HFactory factory, const char* extension, uint32_t size);
+
+    /**
+     * Load resources in the background (see UpdateFactory) and leave them in the resource cache,
+     * so that a later Get or preload of them is a cache hit.
+     * @param factory Factory handle
+     * @param names Resources to load
+     * @return RESULT_OK on success, RESULT_NOT_SUPPORTED if the resource cache is disabled
+     */
+    Result Prefetch(HFactory factory, const dmArray<const char*>& names);
+
+    /**
+     * Check if a resource can be kept in the resource cache, i.e. it was loaded from file and hasn't been changed
+     * with SetResource since. Valid from the create function of the resource type and onwards.
+     * @param factory Factory handle
+     * @param name_hash Canonical path hash of the resource
+     * @return True if the resource can be loaded again as it is
+     */
+    bool IsCacheable(HFactory factory, dmhash_t name_hash);
+
+    /**
+     * Keep a resource out of the resource cache, since it has been changed and can't be loaded again as it is.
+     * Resources changed with SetResource are marked automatically.
+     * @param factory Factory handle
+     * @param name_hash Canonical path hash of the resource
+     */
+    void SetUncacheable(HFactory factory, dmhash_t name_hash);
+
     /**
      * Find a resource by a canonical path hash.
      * @param factory Factory handle
@@ -197,6 +277,19 @@ namespace dmResource
      */
     Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* resource_size);
 
+    /**
+     * Read part of the raw resource data, e.g. for streaming.
+     * Doesn't take the load lock, so it can be called from other threads while resources are loading.
+     * @param factory Factory handle
+     * @param name Resource name
+     * @param offset Offset in bytes into the resource
+     * @param size Number of bytes to read
+     * @param buffer Buffer to read to, at least size bytes
+     * @param nread Number of bytes read. Less than size at the end of the resource
+     * @return RESULT_OK on success
+     */
+    Result GetRawPartial(HFactory factory, const char* name, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread);
+
     /**
      * Updates a preexisting resource with new data
      * @param factory Factory handle
@@ -273,7 +366,7 @@ namespace dmResource
     Result GetDescriptorWithExt(HFactory factory, uint64_t hashed_name, const uint64_t* exts, uint32_t ext_count, SResourceDescriptor* descriptor);
 
     /**
-     * Increase resource reference count
+     * Increase resource reference count. Also takes a cached resource out of the resource cache
      * @param factory Factory handle
      * @param resource Resource
      */
@@ -410,6 +503,10 @@ namespace dmResource
     Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size);
     // load with own buffer
     Result LoadResourceFromBuffer(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer);
+    // get a read-only view of the resource data without copying, if it's stored uncompressed in a memory mapped archive.
+    // returns RESULT_NOT_SUPPORTED if the resource must be loaded into a buffer instead. The view must be released.
+    Result GetResourceView(HFactory factory, const char* path, dmResourceMounts::ResourceView* view);
+    void ReleaseResourceView(HFactory factory, dmResourceMounts::ResourceView* view);
 }
 
 #endif // RESOURCE_H
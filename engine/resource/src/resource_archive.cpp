@@ -27,9 +27,14 @@
 #include <dlib/endian.h>
 #include <dlib/log.h>
 #include <dlib/lz4.h>
+#include <dlib/condition_variable.h>
+#include <dlib/math.h>
 #include <dlib/memory.h>
+#include <dlib/mutex.h>
 #include <dlib/path.h>
+#include <dlib/profile.h>
 #include <dlib/sys.h>
+#include <dmsdk/dlib/atomic.h>
 
 #define DEBUG_LOG 1
 #if defined(DEBUG_LOG)
@@ -193,6 +198,7 @@ namespace dmResourceArchive
     void Delete(HArchiveIndexContainer &archive)
     {
         DeleteArchiveFileIndex(archive->m_ArchiveFileIndex);
+        delete[] archive->m_LookupTable;
 
         if (!archive->m_IsMemMapped)
         {
@@ -211,24 +217,96 @@ namespace dmResourceArchive
         }
     }
 
-    dmResourceArchive::Result FindEntry(dmResourceArchive::HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, dmResourceArchive::EntryData** entry)
+    static void GetHashesAndEntries(HArchiveIndexContainer archive, uint8_t** hashes, EntryData** entries)
     {
-        uint32_t entry_count = dmEndian::ToNetwork(archive->m_ArchiveIndex->m_EntryDataCount);
-        uint32_t entry_offset = dmEndian::ToNetwork(archive->m_ArchiveIndex->m_EntryDataOffset);
-        uint32_t hash_offset = dmEndian::ToNetwork(archive->m_ArchiveIndex->m_HashOffset);
-        uint8_t* hashes = 0;
-        dmResourceArchive::EntryData* entries = 0;
-
         // If archive is loaded from file use the member arrays for hashes and entries, otherwise read with mem offsets.
         if (!archive->m_IsMemMapped)
         {
-            hashes = archive->m_ArchiveFileIndex->m_Hashes;
-            entries = archive->m_ArchiveFileIndex->m_Entries;
+            *hashes = archive->m_ArchiveFileIndex->m_Hashes;
+            *entries = archive->m_ArchiveFileIndex->m_Entries;
         }
         else
         {
-            hashes = (uint8_t*)((uintptr_t)archive->m_ArchiveIndex + hash_offset);
-            entries = (dmResourceArchive::EntryData*)((uintptr_t)archive->m_ArchiveIndex + entry_offset);
+            uint32_t entry_offset = dmEndian::ToNetwork(archive->m_ArchiveIndex->m_EntryDataOffset);
+            uint32_t hash_offset = dmEndian::ToNetwork(archive->m_ArchiveIndex->m_HashOffset);
+            *hashes = (uint8_t*)((uintptr_t)archive->m_ArchiveIndex + hash_offset);
+            *entries = (EntryData*)((uintptr_t)archive->m_ArchiveIndex + entry_offset);
+        }
+    }
+
+    static const uint32_t LOOKUP_TABLE_EMPTY = 0xFFFFFFFF;
+
+    static inline uint32_t GetLookupSlot(const uint8_t* hash, uint32_t mask)
+    {
+        // The digests are cryptographic hashes, so any part of them is evenly distributed
+        uint32_t key;
+        memcpy(&key, hash, sizeof(key));
+        return key & mask;
+    }
+
+    static void BuildLookupTable(HArchiveIndexContainer archive)
+    {
+        uint32_t entry_count = dmEndian::ToNetwork(archive->m_ArchiveIndex->m_EntryDataCount);
+        uint8_t* hashes;
+        EntryData* entries;
+        GetHashesAndEntries(archive, &hashes, &entries);
+
+        // Keep the load factor at or below 0.5, so that the probe sequences stay short
+        uint32_t capacity = 16;
+        while (capacity < entry_count * 2)
+            capacity *= 2;
+
+        delete[] archive->m_LookupTable;
+        archive->m_LookupTable = new uint32_t[capacity];
+        archive->m_LookupTableMask = capacity - 1;
+        memset(archive->m_LookupTable, 0xFF, capacity * sizeof(uint32_t));
+
+        for (uint32_t i = 0; i < entry_count; ++i)
+        {
+            uint32_t slot = GetLookupSlot(hashes + dmResourceArchive::MAX_HASH * i, archive->m_LookupTableMask);
+            while (archive->m_LookupTable[slot] != LOOKUP_TABLE_EMPTY)
+            {
+                slot = (slot + 1) & archive->m_LookupTableMask;
+            }
+            archive->m_LookupTable[slot] = i;
+        }
+    }
+
+    Result CreateLookupTable(HArchiveIndexContainer archive)
+    {
+        if (archive->m_ArchiveIndex == 0)
+            return RESULT_INVALID_DATA;
+        BuildLookupTable(archive);
+        return RESULT_OK;
+    }
+
+    dmResourceArchive::Result FindEntry(dmResourceArchive::HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, dmResourceArchive::EntryData** entry)
+    {
+        uint32_t entry_count = dmEndian::ToNetwork(archive->m_ArchiveIndex->m_EntryDataCount);
+        uint8_t* hashes = 0;
+        dmResourceArchive::EntryData* entries = 0;
+        GetHashesAndEntries(archive, &hashes, &entries);
+
+        if (archive->m_LookupTable)
+        {
+            // The table always has empty slots, so the probing ends
+            uint32_t mask = archive->m_LookupTableMask;
+            for (uint32_t slot = GetLookupSlot(hash, mask); ; slot = (slot + 1) & mask)
+            {
+                uint32_t index = archive->m_LookupTable[slot];
+                if (index == LOOKUP_TABLE_EMPTY)
+                {
+                    return dmResourceArchive::RESULT_NOT_FOUND;
+                }
+                if (memcmp(hash, hashes + dmResourceArchive::MAX_HASH * index, hash_len) == 0)
+                {
+                    if (entry != 0)
+                    {
+                        *entry = &entries[index];
+                    }
+                    return dmResourceArchive::RESULT_OK;
+                }
+            }
         }
 
         // Search for hash with binary search (entries are sorted on hash)
@@ -499,6 +577,287 @@ namespace dmResourceArchive
         return RESULT_OK;
     }
 
+    static const uint32_t BLOCK_HEADER_SIZE = 8; // block size + block count
+
+    // Below this number of blocks, the overhead of waking the workers isn't worth it
+    static const uint32_t MIN_PARALLEL_BLOCK_COUNT = 4;
+
+    struct BlockTable
+    {
+        const uint8_t*  m_BlockEnds;    // Big endian end offset of each compressed block
+        uint32_t        m_BlockSize;
+        uint32_t        m_BlockCount;
+        uint32_t        m_ResourceSize;
+        uint32_t        m_TableSize;    // Size of the header and the block ends
+    };
+
+    static inline uint32_t ReadBigEndian32(const uint8_t* p)
+    {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    }
+
+    // Validates the header, and gets the size of the complete block table
+    static Result ReadBlockHeader(const uint8_t* header, uint32_t resource_size, uint32_t compressed_size, BlockTable* table)
+    {
+        table->m_BlockEnds = 0;
+        table->m_BlockSize = ReadBigEndian32(header);
+        table->m_BlockCount = ReadBigEndian32(header + 4);
+        table->m_ResourceSize = resource_size;
+        if (table->m_BlockSize == 0 || table->m_BlockCount != (uint32_t)(((uint64_t)resource_size + table->m_BlockSize - 1) / table->m_BlockSize))
+            return RESULT_INVALID_DATA;
+
+        uint64_t table_size = BLOCK_HEADER_SIZE + 4 * (uint64_t)table->m_BlockCount;
+        if (table_size > compressed_size)
+            return RESULT_INVALID_DATA;
+        table->m_TableSize = (uint32_t)table_size;
+        return RESULT_OK;
+    }
+
+    // Validates the block ends, so that the blocks can later be decompressed without any further checks
+    static Result ReadBlockEnds(const uint8_t* table_data, uint32_t compressed_size, BlockTable* table)
+    {
+        const uint8_t* block_ends = table_data + BLOCK_HEADER_SIZE;
+        uint32_t data_size = compressed_size - table->m_TableSize;
+        uint32_t prev_end = 0;
+        for (uint32_t i = 0; i < table->m_BlockCount; ++i)
+        {
+            uint32_t end = ReadBigEndian32(block_ends + 4 * i);
+            if (end < prev_end || end > data_size)
+                return RESULT_INVALID_DATA;
+            prev_end = end;
+        }
+        table->m_BlockEnds = block_ends;
+        return RESULT_OK;
+    }
+
+    static inline uint32_t GetBlockStart(const BlockTable* table, uint32_t index)
+    {
+        return index == 0 ? 0 : ReadBigEndian32(table->m_BlockEnds + 4 * (index - 1));
+    }
+
+    static inline uint32_t GetBlockEnd(const BlockTable* table, uint32_t index)
+    {
+        return ReadBigEndian32(table->m_BlockEnds + 4 * index);
+    }
+
+    static inline uint32_t GetBlockUncompressedSize(const BlockTable* table, uint32_t index)
+    {
+        return dmMath::Min(table->m_BlockSize, table->m_ResourceSize - index * table->m_BlockSize);
+    }
+
+    // The data holds the compressed blocks, starting at the compressed offset data_offset
+    static Result DecompressBlock(const BlockTable* table, uint32_t index, const uint8_t* data, uint32_t data_offset, uint8_t* out)
+    {
+        uint32_t start = GetBlockStart(table, index);
+        uint32_t end = GetBlockEnd(table, index);
+        uint32_t size = GetBlockUncompressedSize(table, index);
+
+        int decompressed_size;
+        dmLZ4::Result r = dmLZ4::DecompressBuffer(data + (start - data_offset), end - start, out, size, &decompressed_size);
+        if (dmLZ4::RESULT_OK != r || (uint32_t)decompressed_size != size)
+            return RESULT_OUTBUFFER_TOO_SMALL;
+        return RESULT_OK;
+    }
+
+    /// Blocks shared between the reading thread and the job workers for one entry.
+    /// Reference counted since a worker might not pick up its job until after the entry is done.
+    struct BlockBatch
+    {
+        BlockTable                              m_Table;
+        const uint8_t*                          m_Data;
+        uint8_t*                                m_Buffer;
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_Done;     // Signaled when m_Active reaches 0
+        uint32_t                                m_Active;   // Threads decompressing blocks. Protected by m_Mutex
+        int32_atomic_t                          m_Next;
+        int32_atomic_t                          m_Failed;
+        int32_atomic_t                          m_RefCount;
+    };
+
+    static void ReleaseBlockBatch(BlockBatch* batch)
+    {
+        if (dmAtomicDecrement32(&batch->m_RefCount) == 1)
+        {
+            dmConditionVariable::Delete(batch->m_Done);
+            dmMutex::Delete(batch->m_Mutex);
+            delete batch;
+        }
+    }
+
+    static void ProcessBlockBatch(BlockBatch* batch)
+    {
+        {
+            DM_MUTEX_SCOPED_LOCK(batch->m_Mutex);
+            batch->m_Active++;
+        }
+        while (true)
+        {
+            uint32_t index = (uint32_t)dmAtomicIncrement32(&batch->m_Next);
+            if (index >= batch->m_Table.m_BlockCount)
+                break;
+            uint8_t* out = batch->m_Buffer + index * batch->m_Table.m_BlockSize;
+            if (RESULT_OK != DecompressBlock(&batch->m_Table, index, batch->m_Data, 0, out))
+                dmAtomicStore32(&batch->m_Failed, 1);
+        }
+        DM_MUTEX_SCOPED_LOCK(batch->m_Mutex);
+        if (--batch->m_Active == 0)
+            dmConditionVariable::Broadcast(batch->m_Done);
+    }
+
+    static int ProcessBlockBatchJob(void* context, void* data)
+    {
+        DM_PROFILE("DecompressBlocks");
+        BlockBatch* batch = (BlockBatch*)data;
+        ProcessBlockBatch(batch);
+        ReleaseBlockBatch(batch);
+        return 0;
+    }
+
+    Result DecompressBlocks(dmJobThread::HContext job_thread, const uint8_t* data, uint32_t data_size, uint32_t resource_size, void* buffer)
+    {
+        if (data_size < BLOCK_HEADER_SIZE)
+            return RESULT_INVALID_DATA;
+
+        BlockTable table;
+        Result result = ReadBlockHeader(data, resource_size, data_size, &table);
+        if (RESULT_OK == result)
+            result = ReadBlockEnds(data, data_size, &table);
+        if (RESULT_OK != result)
+            return result;
+
+        const uint8_t* block_data = data + table.m_TableSize;
+
+        uint32_t worker_count = job_thread ? dmJobThread::GetWorkerCount(job_thread) : 0;
+        if (worker_count == 0 || table.m_BlockCount < MIN_PARALLEL_BLOCK_COUNT)
+        {
+            for (uint32_t i = 0; i < table.m_BlockCount && RESULT_OK == result; ++i)
+            {
+                result = DecompressBlock(&table, i, block_data, 0, (uint8_t*)buffer + i * table.m_BlockSize);
+            }
+            return result;
+        }
+
+        worker_count = dmMath::Min(worker_count, table.m_BlockCount - 1);
+
+        BlockBatch* batch = new BlockBatch;
+        batch->m_Table = table;
+        batch->m_Data = block_data;
+        batch->m_Buffer = (uint8_t*)buffer;
+        batch->m_Mutex = dmMutex::New();
+        batch->m_Done = dmConditionVariable::New();
+        batch->m_Active = 0;
+        batch->m_Next = 0;
+        batch->m_Failed = 0;
+        batch->m_RefCount = 1 + worker_count;
+
+        for (uint32_t i = 0; i < worker_count; ++i)
+        {
+            dmJobThread::PushJob(job_thread, ProcessBlockBatchJob, 0x0, 0x0, batch);
+        }
+
+        ProcessBlockBatch(batch);
+
+        // All blocks are taken at this point, wait for the workers still decompressing theirs.
+        // Workers that haven't started yet find no blocks left, and only release their reference.
+        {
+            DM_MUTEX_SCOPED_LOCK(batch->m_Mutex);
+            while (batch->m_Active != 0)
+            {
+                dmConditionVariable::Wait(batch->m_Done, batch->m_Mutex);
+            }
+        }
+
+        result = dmAtomicGet32(&batch->m_Failed) ? RESULT_OUTBUFFER_TOO_SMALL : RESULT_OK;
+        ReleaseBlockBatch(batch);
+        return result;
+    }
+
+    void SetJobThread(HArchiveIndexContainer archive, dmJobThread::HContext job_thread)
+    {
+        archive->m_JobThread = job_thread;
+    }
+
+    // Gets a range of the archive data, either directly from the memory mapped data, or read from file into the scratch buffer
+    static Result GetArchiveData(const ArchiveFileIndex* afi, uint32_t offset, uint32_t size, dmArray<uint8_t>& scratch, const uint8_t** data)
+    {
+        if (afi->m_IsMemMapped)
+        {
+            *data = afi->m_ResourceData + offset;
+            return RESULT_OK;
+        }
+
+        if (scratch.Capacity() < size)
+            scratch.SetCapacity(size);
+        scratch.SetSize(size);
+
+        FILE* resource_file = afi->m_FileResourceData;
+        fseek(resource_file, offset, SEEK_SET);
+        if (fread(scratch.Begin(), 1, size, resource_file) != size)
+            return RESULT_IO_ERROR;
+        *data = scratch.Begin();
+        return RESULT_OK;
+    }
+
+    // Decompresses only the blocks covering the range [offset, offset+size). The compressed blocks are
+    // fetched one at a time, so reading from file only needs a scratch buffer the size of one block.
+    static Result ReadBlocksPartial(const ArchiveFileIndex* afi, uint32_t resource_offset, uint32_t compressed_size, uint32_t resource_size,
+                                    uint32_t offset, uint32_t size, uint8_t* buffer)
+    {
+        if (compressed_size < BLOCK_HEADER_SIZE)
+            return RESULT_INVALID_DATA;
+
+        dmArray<uint8_t> table_scratch;
+        const uint8_t* table_data;
+        Result result = GetArchiveData(afi, resource_offset, BLOCK_HEADER_SIZE, table_scratch, &table_data);
+        if (RESULT_OK != result)
+            return result;
+
+        BlockTable table;
+        result = ReadBlockHeader(table_data, resource_size, compressed_size, &table);
+        if (RESULT_OK == result)
+            result = GetArchiveData(afi, resource_offset, table.m_TableSize, table_scratch, &table_data);
+        if (RESULT_OK == result)
+            result = ReadBlockEnds(table_data, compressed_size, &table);
+        if (RESULT_OK != result)
+            return result;
+
+        uint32_t first = offset / table.m_BlockSize;
+        uint32_t last = (offset + size - 1) / table.m_BlockSize;
+        uint32_t data_offset = resource_offset + table.m_TableSize;
+
+        dmArray<uint8_t> data_scratch;
+        uint8_t* temp_block = 0;
+        for (uint32_t i = first; i <= last && RESULT_OK == result; ++i)
+        {
+            uint32_t block_start = GetBlockStart(&table, i);
+            const uint8_t* data;
+            result = GetArchiveData(afi, data_offset + block_start, GetBlockEnd(&table, i) - block_start, data_scratch, &data);
+            if (RESULT_OK != result)
+                break;
+
+            uint32_t block_offset = i * table.m_BlockSize;
+            uint32_t block_end = block_offset + GetBlockUncompressedSize(&table, i);
+            uint32_t copy_start = dmMath::Max(offset, block_offset);
+            uint32_t copy_end = dmMath::Min(offset + size, block_end);
+
+            if (copy_start == block_offset && copy_end == block_end)
+            {
+                result = DecompressBlock(&table, i, data, block_start, buffer + (block_offset - offset));
+                continue;
+            }
+
+            // Only part of the block is requested
+            if (!temp_block)
+                temp_block = new uint8_t[table.m_BlockSize];
+            result = DecompressBlock(&table, i, data, block_start, temp_block);
+            if (RESULT_OK == result)
+                memcpy(buffer + (copy_start - offset), temp_block + (copy_start - block_offset), copy_end - copy_start);
+        }
+
+        delete[] temp_block;
+        return result;
+    }
+
     Result ReadEntry(HArchiveIndexContainer archive, const EntryData* entry, void* buffer)
     {
         // We always assume it's in Host format, since it may arrive from memory mapped data
@@ -509,6 +868,7 @@ namespace dmResourceArchive
 
         bool encrypted = (flags & dmResourceArchive::ENTRY_FLAG_ENCRYPTED);
         bool compressed = (flags & dmResourceArchive::ENTRY_FLAG_COMPRESSED);
+        bool compressed_blocks = (flags & dmResourceArchive::ENTRY_FLAG_COMPRESSED_BLOCKS);
 
         const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
         bool resource_memmapped = afi->m_IsMemMapped;
@@ -517,6 +877,12 @@ namespace dmResourceArchive
         uint8_t* source_data = 0;
         uint32_t source_data_size = 0;
 
+        if (!resource_memmapped && compressed && compressed_blocks && !encrypted && size > 0)
+        {
+            // Read and decompress a block at a time, instead of reading all the compressed data into a temporary buffer
+            return ReadBlocksPartial(afi, resource_offset, compressed_size, size, 0, size, (uint8_t*)buffer);
+        }
+
         if (!resource_memmapped)
         {
             // we need to read from the file on disc
@@ -599,7 +965,16 @@ namespace dmResourceArchive
             }
         }
 
-        if (compressed)
+        if (compressed && compressed_blocks)
+        {
+            Result r = DecompressBlocks(archive->m_JobThread, source_data, source_data_size, size, buffer);
+            if (dmResourceArchive::RESULT_OK != r)
+            {
+                delete[] temp_data;
+                return r;
+            }
+        }
+        else if (compressed)
         {
             int decompressed_size;
             dmLZ4::Result r = dmLZ4::DecompressBuffer(source_data, source_data_size, buffer, size, &decompressed_size);
@@ -614,6 +989,77 @@ namespace dmResourceArchive
         return dmResourceArchive::RESULT_OK;
     }
 
+    Result GetEntryDataView(HArchiveIndexContainer archive, const EntryData* entry, const uint8_t** data)
+    {
+        const uint32_t flags            = dmEndian::ToNetwork(entry->m_Flags);
+        const uint32_t resource_offset  = dmEndian::ToNetwork(entry->m_ResourceDataOffset);
+
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+        if (!afi->m_IsMemMapped || (flags & (ENTRY_FLAG_ENCRYPTED | ENTRY_FLAG_COMPRESSED)))
+        {
+            return RESULT_NOT_FOUND;
+        }
+
+        *data = afi->m_ResourceData + resource_offset;
+        return RESULT_OK;
+    }
+
+    Result ReadEntryPartial(HArchiveIndexContainer archive, const EntryData* entry, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+    {
+        const uint32_t flags            = dmEndian::ToNetwork(entry->m_Flags);
+        const uint32_t resource_size    = dmEndian::ToNetwork(entry->m_ResourceSize);
+        const uint32_t resource_offset  = dmEndian::ToNetwork(entry->m_ResourceDataOffset);
+        const uint32_t compressed_size  = dmEndian::ToNetwork(entry->m_ResourceCompressedSize);
+
+        *nread = 0;
+        if (offset >= resource_size)
+            return dmResourceArchive::RESULT_OK;
+        size = dmMath::Min(size, resource_size - offset);
+        if (size == 0)
+            return dmResourceArchive::RESULT_OK;
+
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+
+        // Block compressed entries can be decompressed piecewise, unless they need to be decrypted as a whole first
+        const uint32_t block_flags = dmResourceArchive::ENTRY_FLAG_COMPRESSED | dmResourceArchive::ENTRY_FLAG_COMPRESSED_BLOCKS;
+        if ((flags & block_flags) == block_flags && !(flags & dmResourceArchive::ENTRY_FLAG_ENCRYPTED))
+        {
+            Result result = ReadBlocksPartial(afi, resource_offset, compressed_size, resource_size, offset, size, (uint8_t*)buffer);
+            if (result == dmResourceArchive::RESULT_OK)
+                *nread = size;
+            return result;
+        }
+
+        if (flags & (dmResourceArchive::ENTRY_FLAG_ENCRYPTED | dmResourceArchive::ENTRY_FLAG_COMPRESSED))
+        {
+            // The data can only be decoded as a whole
+            uint8_t* temp_data = new uint8_t[resource_size];
+            Result result = ReadEntry(archive, entry, temp_data);
+            if (result == dmResourceArchive::RESULT_OK)
+            {
+                memcpy(buffer, temp_data + offset, size);
+                *nread = size;
+            }
+            delete[] temp_data;
+            return result;
+        }
+
+        if (afi->m_IsMemMapped)
+        {
+            memcpy(buffer, afi->m_ResourceData + resource_offset + offset, size);
+        }
+        else
+        {
+            FILE* resource_file = afi->m_FileResourceData;
+            fseek(resource_file, resource_offset + offset, SEEK_SET);
+            if (fread(buffer, 1, size, resource_file) != size)
+                return dmResourceArchive::RESULT_IO_ERROR;
+        }
+
+        *nread = size;
+        return dmResourceArchive::RESULT_OK;
+    }
+
     Result WriteArchiveIndex(const char* path, ArchiveIndex* ai)
     {
         // Write to temporary index file, filename liveupdate.arci.tmp
@@ -685,6 +1131,11 @@ namespace dmResourceArchive
         archive_container->m_ArchiveIndex = new_index;
         // Since we store data sequentially when doing the deep-copy we want to access it in that fashion
         archive_container->m_IsMemMapped = mem_mapped;
+
+        if (archive_container->m_LookupTable)
+        {
+            BuildLookupTable(archive_container);
+        }
     }
 
     uint32_t GetEntryCount(HArchiveIndexContainer archive)
@@ -23,6 +23,7 @@
 #include <dlib/uri.h>
 #include <dlib/align.h>
 #include <dlib/array.h>
+#include <dlib/job_thread.h>
 #include <dlib/path.h> // DMPATH_MAX_PATH
 
 
@@ -55,9 +56,10 @@ namespace dmResourceArchive
 
     enum EntryFlag
     {
-        ENTRY_FLAG_ENCRYPTED        = 1 << 0,
-        ENTRY_FLAG_COMPRESSED       = 1 << 1,
-        ENTRY_FLAG_LIVEUPDATE_DATA  = 1 << 2,
+        ENTRY_FLAG_ENCRYPTED            = 1 << 0,
+        ENTRY_FLAG_COMPRESSED           = 1 << 1,
+        ENTRY_FLAG_LIVEUPDATE_DATA      = 1 << 2,
+        ENTRY_FLAG_COMPRESSED_BLOCKS    = 1 << 3, // Set together with ENTRY_FLAG_COMPRESSED. See DecompressBlocks()
     };
 
     // part of the .arci file format
@@ -121,6 +123,11 @@ namespace dmResourceArchive
         //ArchiveLoader       m_Loader;
         void*               m_UserData;         // private to the loader
 
+        uint32_t* m_LookupTable;                // Optional hash table from digest to entry index. See CreateLookupTable()
+        uint32_t  m_LookupTableMask;
+
+        dmJobThread::HContext m_JobThread;      // Optional, used to decompress block compressed entries in parallel. See SetJobThread()
+
         uint32_t m_ArchiveIndexSize;            // kept for unmapping
         uint8_t  m_IsMemMapped:1; // if the m_ArchiveIndex is memory mapped
         uint8_t  :7;
@@ -203,6 +210,14 @@ namespace dmResourceArchive
      */
     Result FindEntry(HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, EntryData** entry);
 
+    /**
+     * Create a hash table from digest to entry, making FindEntry() constant time instead of a binary search.
+     * The table is updated by SetNewArchiveIndex(), and freed by Delete()
+     * @param archive archive index handle
+     * @return RESULT_OK on success
+     */
+    Result CreateLookupTable(HArchiveIndexContainer archive);
+
     /**
      * Read resource from the given archive
      * @param archive archive index handle
@@ -212,6 +227,55 @@ namespace dmResourceArchive
      */
     Result ReadEntry(HArchiveIndexContainer archive, const EntryData* entry, void* buffer);
 
+    /**
+     * Read part of a resource from the given archive
+     * @note For block compressed entries, only the blocks covering the range are decompressed.
+     *       Other compressed or encrypted entries are read in full into a temporary buffer
+     * @param archive archive index handle
+     * @param entry_data entry data
+     * @param offset offset in bytes into the uncompressed resource
+     * @param size number of bytes to read
+     * @param buffer buffer to load to. Must be at least size bytes
+     * @param nread number of bytes actually read. Less than size at the end of the resource
+     * @return RESULT_OK on success
+     */
+    Result ReadEntryPartial(HArchiveIndexContainer archive, const EntryData* entry, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread);
+
+    /**
+     * Decompress a block compressed entry (ENTRY_FLAG_COMPRESSED_BLOCKS), using the job thread workers if set.
+     * The data is a header followed by separately LZ4 compressed blocks:
+     *   uint32_t block_size                 uncompressed size of each block (the last one may be smaller)
+     *   uint32_t block_count
+     *   uint32_t block_ends[block_count]    end offset of each compressed block, relative to the first block
+     * All header values are big endian. The data is written by ArchiveBuilder.java
+     * @param job_thread job thread used to decompress the blocks in parallel with the calling thread. May be 0
+     * @param data compressed (and decrypted) entry data
+     * @param data_size size of the compressed data
+     * @param resource_size uncompressed size of the resource
+     * @param buffer buffer to decompress to. Must be at least resource_size bytes
+     * @return RESULT_OK on success
+     */
+    Result DecompressBlocks(dmJobThread::HContext job_thread, const uint8_t* data, uint32_t data_size, uint32_t resource_size, void* buffer);
+
+    /**
+     * Set the job thread used to decompress the block compressed entries of an archive in parallel.
+     * The reading thread always takes part in the work as well.
+     * @param archive archive index container
+     * @param job_thread job thread context. 0 to only decompress on the reading thread
+     */
+    void SetJobThread(HArchiveIndexContainer archive, dmJobThread::HContext job_thread);
+
+    /**
+     * Get a read-only pointer to the resource data inside the archive, without copying it.
+     * Only possible when the archive data is memory mapped, and the entry is neither compressed nor encrypted.
+     * The data is valid until the archive is unloaded
+     * @param archive archive index handle
+     * @param entry_data entry data
+     * @param data pointer to the resource data
+     * @return RESULT_OK on success, RESULT_NOT_FOUND if the data cannot be accessed directly
+     */
+    Result GetEntryDataView(HArchiveIndexContainer archive, const EntryData* entry, const uint8_t** data);
+
     /**
      * Delete archive index. Only required for archives created with LoadArchive function
      * @param archive archive index handle
@@ -230,6 +230,20 @@ dmResource::Result GetDependencies(dmResource::HManifest manifest, const dmhash_
     return dmResource::RESULT_OK;
 }
 
+dmResource::Result GetChildren(dmResource::HManifest manifest, const dmhash_t url_hash, dmArray<dmhash_t>& children)
+{
+    dmLiveUpdateDDF::ResourceEntry* entry = FindEntry(manifest, url_hash);
+    if (!entry)
+        return dmResource::RESULT_RESOURCE_NOT_FOUND;
+
+    uint32_t count = entry->m_Children.m_Count;
+    if (children.Remaining() < count)
+        children.OffsetCapacity(count - children.Remaining());
+
+    children.PushArray(entry->m_Children.m_Data, count);
+    return dmResource::RESULT_OK;
+}
+
 static void BuildDigestToUrlMapping(dmResource::HManifest manifest, bool liveupdate_only)
 {
     uint32_t hash_length = GetEntryHashLength(manifest);
@@ -61,6 +61,10 @@ namespace dmResource
     // Note: Only returns the dependency path urls. It doesn't recurse.
     dmResource::Result  GetDependencies(dmResource::HManifest manifest, const dmhash_t url_hash, dmArray<dmhash_t>& dependencies);
 
+    // Gets the resources directly referenced by a resource.
+    // Note: Only available in manifests built with the children list, otherwise the list is empty.
+    dmResource::Result  GetChildren(dmResource::HManifest manifest, const dmhash_t url_hash, dmArray<dmhash_t>& children);
+
     /*#
      * Get the url hash given a hex digest (the actual filename)
      * @name GetUrlHashFromHexDigest
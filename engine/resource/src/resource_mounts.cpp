@@ -22,9 +22,11 @@
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/mutex.h>
 #include <dlib/sys.h>
 #include <algorithm> // std::sort
+#include <assert.h>
 
 namespace dmResourceMounts
 {
@@ -38,6 +40,7 @@ struct ArchiveMount
     const char*                     m_Name;
     dmResourceProvider::HArchive    m_Archive;
     int                             m_Priority;
+    uint32_t                        m_ViewCount;    // Number of resource views pinning the archive
     bool                            m_Persist;
 };
 
@@ -51,8 +54,11 @@ struct ResourceMountsContext
 {
     // The currently mounted archives, in sorted order
     dmArray<ArchiveMount>           m_Mounts;
+    // Removed archives waiting for their resource views to be released before they are unmounted
+    dmArray<ArchiveMount>           m_PendingUnmounts;
     dmHashTable64<CustomFile>       m_CustomFiles;
     dmResourceProvider::HArchive    m_ResourceBaseArchive;
+    dmJobThread::HContext           m_JobThread;    // Passed on to each mounted archive
     dmMutex::HMutex                 m_Mutex;
 
 };
@@ -65,6 +71,7 @@ static dmResource::Result ProviderResultToResult(dmResourceProvider::Result resu
     case dmResourceProvider::RESULT_OK:         return dmResource::RESULT_OK;
     case dmResourceProvider::RESULT_IO_ERROR:   return dmResource::RESULT_IO_ERROR;
     case dmResourceProvider::RESULT_NOT_FOUND:  return dmResource::RESULT_RESOURCE_NOT_FOUND;
+    case dmResourceProvider::RESULT_NOT_SUPPORTED: return dmResource::RESULT_NOT_SUPPORTED;
     default:                                    return dmResource::RESULT_UNKNOWN_ERROR;
     }
 }
@@ -77,6 +84,7 @@ HContext Create(dmResourceProvider::HArchive base_archive)
     ctx->m_Mounts.SetCapacity(2);
     ctx->m_Mutex = dmMutex::New();
     ctx->m_ResourceBaseArchive = base_archive;
+    ctx->m_JobThread = 0;
     return ctx;
 }
 
@@ -105,10 +113,22 @@ static void SortMounts(dmArray<ArchiveMount>& mounts)
     std::sort(mounts.Begin(), mounts.End(), MountSortPred());
 }
 
+void SetJobThread(HContext ctx, dmJobThread::HContext job_thread)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+    ctx->m_JobThread = job_thread;
+    for (uint32_t i = 0; i < ctx->m_Mounts.Size(); ++i)
+    {
+        dmResourceProvider::SetJobThread(ctx->m_Mounts[i].m_Archive, job_thread);
+    }
+}
+
 static void AddMountInternal(HContext ctx, const ArchiveMount& mount)
 {
     DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
 
+    dmResourceProvider::SetJobThread(mount.m_Archive, ctx->m_JobThread);
+
     if (ctx->m_Mounts.Full())
         ctx->m_Mounts.OffsetCapacity(2);
 
@@ -159,11 +179,20 @@ dmResource::Result AddMount(HContext ctx, const char* name, dmResourceProvider::
     mount.m_Name = strdup(name);
     mount.m_Priority = priority;
     mount.m_Archive = archive;
+    mount.m_ViewCount = 0;
     mount.m_Persist = persist;
     AddMountInternal(ctx, mount);
     return dmResource::RESULT_OK;
 }
 
+// Assumes mutex lock is held
+static void AddPendingUnmount(HContext ctx, const ArchiveMount& mount)
+{
+    if (ctx->m_PendingUnmounts.Full())
+        ctx->m_PendingUnmounts.OffsetCapacity(2);
+    ctx->m_PendingUnmounts.Push(mount);
+}
+
 // Assumes mutex lock is held
 static dmResource::Result RemoveMountByIndexInternal(HContext ctx, uint32_t index)
 {
@@ -187,6 +216,13 @@ dmResource::Result RemoveMount(HContext ctx, dmResourceProvider::HArchive archiv
         ArchiveMount& mount = ctx->m_Mounts[i];
         if (mount.m_Archive == archive)
         {
+            if (mount.m_ViewCount > 0)
+            {
+                // Resources are still being created from the archive data. The archive is unmounted when the last view is released
+                AddPendingUnmount(ctx, mount);
+                RemoveMountByIndexInternal(ctx, i);
+                return dmResource::RESULT_PENDING;
+            }
             return RemoveMountByIndexInternal(ctx, i);
         }
     }
@@ -203,7 +239,15 @@ dmResource::Result RemoveAndUnmountByName(HContext ctx, const char* name)
         ArchiveMount& mount = ctx->m_Mounts[i];
         if (strcmp(mount.m_Name, name) == 0)
         {
-            dmResourceProvider::Unmount(mount.m_Archive);
+            if (mount.m_ViewCount > 0)
+            {
+                // Resources are still being created from the archive data
+                AddPendingUnmount(ctx, mount);
+            }
+            else
+            {
+                dmResourceProvider::Unmount(mount.m_Archive);
+            }
             return RemoveMountByIndexInternal(ctx, i);
         }
     }
@@ -363,6 +407,15 @@ static dmResource::Result DestroyMounts(HContext ctx)
         dmResourceProvider::Unmount(mount.m_Archive);
     }
     ctx->m_Mounts.SetSize(0);
+
+    size = ctx->m_PendingUnmounts.Size();
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        ArchiveMount& mount = ctx->m_PendingUnmounts[i];
+        dmLogWarning("Unmounting archive '%s' with %u resource views still in use", mount.m_Name, mount.m_ViewCount);
+        dmResourceProvider::Unmount(mount.m_Archive);
+    }
+    ctx->m_PendingUnmounts.SetSize(0);
     return dmResource::RESULT_OK;
 }
 
@@ -455,6 +508,111 @@ dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* pa
     return dmResource::RESULT_RESOURCE_NOT_FOUND;
 }
 
+dmResource::Result ReadResourcePartial(HContext ctx, dmhash_t path_hash, const char* path, uint32_t offset, uint32_t size, uint8_t* buffer, uint32_t* nread)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+
+    uint32_t count = ctx->m_Mounts.Size();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ArchiveMount& mount = ctx->m_Mounts[i];
+        dmResourceProvider::Result result = dmResourceProvider::ReadFilePartial(mount.m_Archive, path_hash, path, offset, size, buffer, nread);
+        if (dmResourceProvider::RESULT_NOT_FOUND == result)
+            continue;
+        if (dmResourceProvider::RESULT_OK == result)
+        {
+            DM_RESOURCE_DBG_LOG(3, "ReadResourcePartial: %s (%u bytes at %u)\n", path, *nread, offset);
+            DebugPrintMount(3, mount);
+            return dmResource::RESULT_OK;
+        }
+        return ProviderResultToResult(result);
+    }
+
+    if (!ctx->m_CustomFiles.Empty())
+    {
+        CustomFile* file = ctx->m_CustomFiles.Get(path_hash);
+        if (file)
+        {
+            *nread = offset < file->m_Size ? dmMath::Min(size, file->m_Size - offset) : 0;
+            memcpy(buffer, (const uint8_t*)file->m_Resource + offset, *nread);
+            return dmResource::RESULT_OK;
+        }
+    }
+
+    return dmResource::RESULT_RESOURCE_NOT_FOUND;
+}
+
+dmResource::Result GetResourceView(HContext ctx, dmhash_t path_hash, const char* path, ResourceView* view)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+
+    uint32_t count = ctx->m_Mounts.Size();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ArchiveMount& mount = ctx->m_Mounts[i];
+        dmResourceProvider::Result result = dmResourceProvider::GetFileView(mount.m_Archive, path_hash, path, &view->m_Data, &view->m_Size);
+        if (dmResourceProvider::RESULT_NOT_FOUND == result)
+            continue;
+        if (dmResourceProvider::RESULT_OK == result)
+        {
+            // The resource types may read the data with aligned loads, so an unaligned view is read into a buffer instead
+            if (((uintptr_t)view->m_Data & (RESOURCE_VIEW_ALIGNMENT - 1)) != 0)
+            {
+                DM_RESOURCE_DBG_LOG(3, "GetResourceView: %s is not aligned\n", path);
+                return dmResource::RESULT_NOT_SUPPORTED;
+            }
+
+            DM_RESOURCE_DBG_LOG(3, "GetResourceView: %s (%u bytes)\n", path, view->m_Size);
+            DebugPrintMount(3, mount);
+            view->m_Archive = mount.m_Archive;
+            mount.m_ViewCount++;
+            return dmResource::RESULT_OK;
+        }
+        return ProviderResultToResult(result);
+    }
+
+    if (!ctx->m_CustomFiles.Empty() && ctx->m_CustomFiles.Get(path_hash))
+        return dmResource::RESULT_NOT_SUPPORTED;
+
+    return dmResource::RESULT_RESOURCE_NOT_FOUND;
+}
+
+void ReleaseResourceView(HContext ctx, ResourceView* view)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+
+    uint32_t count = ctx->m_Mounts.Size();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ArchiveMount& mount = ctx->m_Mounts[i];
+        if (mount.m_Archive == view->m_Archive)
+        {
+            assert(mount.m_ViewCount > 0);
+            mount.m_ViewCount--;
+            view->m_Archive = 0;
+            return;
+        }
+    }
+
+    count = ctx->m_PendingUnmounts.Size();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ArchiveMount& mount = ctx->m_PendingUnmounts[i];
+        if (mount.m_Archive == view->m_Archive)
+        {
+            assert(mount.m_ViewCount > 0);
+            if (--mount.m_ViewCount == 0)
+            {
+                DM_RESOURCE_DBG_LOG(1, "Unmounting removed archive %s\n", mount.m_Name);
+                dmResourceProvider::Unmount(mount.m_Archive);
+                ctx->m_PendingUnmounts.EraseSwap(i);
+            }
+            view->m_Archive = 0;
+            return;
+        }
+    }
+}
+
 dmResource::Result ReadResource(HContext ctx, const char* path, dmhash_t path_hash, dmArray<char>* buffer)
 {
     DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
@@ -649,4 +807,41 @@ dmResource::Result GetDependencies(HContext ctx, const SGetDependenciesParams* r
     return GetDependenciesInternal(&iter_ctx, request->m_UrlHash);
 }
 
+dmResource::Result GetChildren(HContext ctx, dmhash_t url_hash, FGetChild callback, void* callback_context)
+{
+    DM_MUTEX_SCOPED_LOCK(ctx->m_Mutex);
+
+    dmArray<dmhash_t> children;
+
+    uint32_t num_mounts = ctx->m_Mounts.Size();
+    for (uint32_t i = 0; i < num_mounts; ++i)
+    {
+        ArchiveMount& mount = ctx->m_Mounts[i];
+
+        dmResource::Manifest* manifest;
+        dmResourceProvider::Result presult = dmResourceProvider::GetManifest(mount.m_Archive, &manifest);
+        if (presult != dmResourceProvider::RESULT_OK)
+            continue;
+
+        dmResource::Result result = dmResource::GetChildren(manifest, url_hash, children);
+        if (dmResource::RESULT_RESOURCE_NOT_FOUND == result)
+            continue;
+
+        for (uint32_t c = 0; c < children.Size(); ++c)
+        {
+            dmLiveUpdateDDF::ResourceEntry* entry = dmResource::FindEntry(manifest, children[c]);
+            if (!entry)
+                continue;
+
+            SGetChildrenResult child;
+            child.m_UrlHash = entry->m_UrlHash;
+            child.m_Url     = entry->m_Url;
+            child.m_Size    = entry->m_Size;
+            callback(callback_context, &child);
+        }
+        return dmResource::RESULT_OK;
+    }
+    return dmResource::RESULT_RESOURCE_NOT_FOUND;
+}
+
 }
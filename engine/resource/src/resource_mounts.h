@@ -18,6 +18,7 @@
 #include "resource.h"
 #include <dlib/array.h>
 #include <dlib/hash.h>
+#include <dlib/job_thread.h>
 #include <dlib/mutex.h>
 
 namespace dmResourceProvider
@@ -36,8 +37,13 @@ namespace dmResourceMounts
 
     dmMutex::HMutex GetMutex(HContext ctx);
 
+    // Sets the job thread of the mounted archives, and of the archives mounted later
+    void        SetJobThread(HContext ctx, dmJobThread::HContext job_thread);
+
     // Does not call Unmount on the archives
     dmResource::Result AddMount(HContext ctx, const char* name, dmResourceProvider::HArchive archive, int priority, bool persist);
+    // If resource views of the archive are still in use, the archive is unmounted when the last view is released.
+    // RESULT_PENDING is returned then, and the caller must not unmount it.
     dmResource::Result RemoveMount(HContext ctx, dmResourceProvider::HArchive archive);
 
     // Also calls Unmount on the archive
@@ -51,6 +57,25 @@ namespace dmResourceMounts
     dmResource::Result GetResourceSize(HContext ctx, dmhash_t path_hash, const char* path, uint32_t* resource_size);
     dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_size);
     dmResource::Result ReadResource(HContext ctx, dmhash_t path_hash, const char* path, dmArray<char>* buffer);
+    dmResource::Result ReadResourcePartial(HContext ctx, dmhash_t path_hash, const char* path, uint32_t offset, uint32_t size, uint8_t* buffer, uint32_t* nread);
+
+    // Views are only given for data at this alignment
+    const uint32_t RESOURCE_VIEW_ALIGNMENT = 16;
+
+    // A read-only view directly into the data of a mounted archive
+    struct ResourceView
+    {
+        const uint8_t*                  m_Data;
+        uint32_t                        m_Size;
+        dmResourceProvider::HArchive    m_Archive;
+    };
+
+    // Gets a view of the resource data without copying it. The archive is pinned until the view is released,
+    // and removing the mount with RemoveMount or RemoveAndUnmountByName defers the unmount until then.
+    // Returns RESULT_NOT_SUPPORTED if the resource exists, but has to be read with ReadResource (e.g. it is compressed,
+    // or not aligned to RESOURCE_VIEW_ALIGNMENT)
+    dmResource::Result GetResourceView(HContext ctx, dmhash_t path_hash, const char* path, ResourceView* view);
+    void ReleaseResourceView(HContext ctx, ResourceView* view);
 
     struct SGetMountResult
     {
@@ -86,6 +111,18 @@ namespace dmResourceMounts
 
     typedef void (*FGetDependency)(void* context, const SGetDependenciesResult* result);
     dmResource::Result GetDependencies(HContext ctx, const SGetDependenciesParams* request, FGetDependency callback, void* callback_context);
+
+    struct SGetChildrenResult
+    {
+        dmhash_t    m_UrlHash;
+        const char* m_Url;      // Only valid during the callback
+        uint32_t    m_Size;     // The uncompressed size
+    };
+
+    // Reports the direct children of a resource, from the manifest of the first mount that knows the resource
+    // Returns RESULT_RESOURCE_NOT_FOUND if no mounted manifest has the resource
+    typedef void (*FGetChild)(void* context, const SGetChildrenResult* result);
+    dmResource::Result GetChildren(HContext ctx, dmhash_t url_hash, FGetChild callback, void* callback_context);
 }
 
 #endif // DM_RESOURCE_MOUNTS_H
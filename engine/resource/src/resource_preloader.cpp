@@ -16,6 +16,7 @@
 #include <assert.h>
 #include <string.h>
 #include <time.h>
+#include <algorithm> // std::sort
 
 #include <dlib/profile.h>
 #include <dlib/dstrings.h>
@@ -28,6 +29,7 @@
 
 #include "block_allocator.h"
 #include "resource.h"
+#include "resource_mounts.h"
 #include "resource_private.h"
 #include "resource_util.h"
 #include "async/load_queue.h"
@@ -53,15 +55,21 @@ namespace dmResource
     // => Waiting for load through load queue, (RESULT_PENDING, m_LoadRequest=<handle>)
     //    (Once the load completes, the resource preload will have run and populated the node with children)
     // => Preloaded, waiting on children (RESULT_PENDING, m_Buffer=<data>, m_PreloadData=<data>, m_FirstChild != -1)
+    // => Failed to load, waiting on children that are already loading (RESULT_PENDING, m_LoadError=<error>)
     // => Created successfully, (RESULT_OK, m_Resource=<resource>, m_FirstChild == -1)
     // => Created with error, (neither RESULT_PENDING nor RESULT_OK)
     //
     // Nodes are scheduled for load in depth first order. Once they are loaded they might add new child items to the
     // tree. Child items to a node will then be loaded and created before the parent node is created.
     //
-    // Once a node with children finds none of them are in PENDING state any longer, resource create will happen,
-    // child nodes (which are done) are then erased and the tree is traversed upwards to see if the parent can be
-    // completed in the same manner. (PreloaderTryPruneParent)
+    // If the mounted archives have a manifest, the children listed for each resource in the manifest are inserted
+    // into the tree as soon as the node is inserted (PreloadManifestChildren), largest first. The children of a node
+    // are scheduled for load while the node itself is still loading, so most of the tree is loading at the same
+    // time instead of one level at a time. The hints from the preload functions still add any child that is missing.
+    //
+    // Once a node with children finds none of them are in PENDING state any longer, and the node itself has been
+    // loaded, resource create will happen, child nodes (which are done) are then erased and the tree is traversed
+    // upwards to see if the parent can be completed in the same manner. (PreloaderTryPruneParent)
     //
     // New items added in PreloadHint are added to a guarded dmArray and the preloader pops this array after it
     // has detected a completion of an item in the preloader queue. This keeps the syncronized state small and
@@ -104,6 +112,9 @@ namespace dmResource
         // Set once preload function has run
         void* m_PreloadData;
 
+        // Set if the load failed while children were loading, the error is set once they have completed
+        Result m_LoadError;
+
         // Set once load has completed
         Result m_LoadResult;
         void* m_Resource;
@@ -136,6 +147,8 @@ namespace dmResource
     static const uint32_t PATH_BUFFER_TABLE_SIZE         = 509;
     static const uint32_t PATH_BUFFER_TABLE_CAPACITY     = MAX_PRELOADER_PATHS;
     static const uint32_t PATH_BUFFER_HASHDATA_SIZE      = (PATH_BUFFER_TABLE_SIZE * sizeof(uint32_t)) + (PATH_BUFFER_TABLE_CAPACITY * sizeof(TPathHashTable::Entry));
+    // The manifest children are only inserted while this many requests are left for the preload hints
+    static const uint32_t MANIFEST_CHILDREN_RESERVE      = MAX_PRELOADER_REQUESTS / 4;
 
     struct PendingHint
     {
@@ -175,12 +188,19 @@ namespace dmResource
         TPathInProgressTable m_InProgress;
         uint8_t m_PathInProgressData[PATH_IN_PROGRESS_HASHDATA_SIZE];
 
+        // Paths that have had their manifest children inserted
+        dmHashTable64<bool> m_ExpandedPaths;
+
         // used instead of dynamic allocs as far as it lasts.
         dmBlockAllocator::HContext m_BlockAllocator;
 
         // post create state
         bool m_LoadQueueFull;
         bool m_CreateComplete;
+        // Set when the preloader must complete regardless of the factory create budget
+        bool m_IgnoreCreateBudget;
+        // Set when a create was held back by the create budget during the current update
+        bool m_CreateDeferred;
         uint32_t m_PostCreateCallbackIndex;
         dmArray<ResourcePostCreateParamsInternal> m_PostCreateCallbacks;
 
@@ -366,6 +386,131 @@ namespace dmResource
         return RESULT_OK;
     }
 
+    struct ManifestChild
+    {
+        PathDescriptor m_PathDescriptor;
+        uint32_t m_Size;
+    };
+
+    struct ManifestChildSizePred
+    {
+        bool operator ()(const ManifestChild& a, const ManifestChild& b) const
+        {
+            return a.m_Size < b.m_Size;
+        }
+    };
+
+    struct ManifestChildrenContext
+    {
+        HPreloader m_Preloader;
+        dmArray<ManifestChild> m_Children;
+    };
+
+    static void GetManifestChildCallback(void* _ctx, const dmResourceMounts::SGetChildrenResult* result)
+    {
+        ManifestChildrenContext* ctx = (ManifestChildrenContext*)_ctx;
+
+        // Resources of unknown types are left to the preload hints, which reports the error
+        const char* ext = strrchr(result->m_Url, '.');
+        if (!ext || !FindResourceType(ctx->m_Preloader->m_Factory, ext + 1))
+        {
+            return;
+        }
+
+        ManifestChild child;
+        if (MakePathDescriptor(ctx->m_Preloader, result->m_Url, child.m_PathDescriptor) != RESULT_OK)
+        {
+            return;
+        }
+        child.m_Size = result->m_Size;
+
+        if (ctx->m_Children.Full())
+        {
+            ctx->m_Children.OffsetCapacity(16);
+        }
+        ctx->m_Children.Push(child);
+    }
+
+    static bool IsPathInParentChain(HPreloader preloader, TRequestIndex index, dmhash_t canonical_path_hash)
+    {
+        while (index != -1)
+        {
+            if (preloader->m_Request[index].m_PathDescriptor.m_CanonicalPathHash == canonical_path_hash)
+            {
+                return true;
+            }
+            index = preloader->m_Request[index].m_Parent;
+        }
+        return false;
+    }
+
+    // Inserts the children listed in the manifest for the item, and their children in turn.
+    // Each path is only expanded once, other instances of it will wait for the first one to be created
+    // (or get their children from the preload hints if they start loading first).
+    static void PreloadManifestChildren(HPreloader preloader, TRequestIndex index)
+    {
+        if (index == -1 || preloader->m_FreelistSize <= MANIFEST_CHILDREN_RESERVE)
+        {
+            return;
+        }
+
+        PreloadRequest* req = &preloader->m_Request[index];
+        if (req->m_LoadResult != RESULT_PENDING || req->m_PathDescriptor.m_ResourceType == 0)
+        {
+            return;
+        }
+
+        dmhash_t path_hash = req->m_PathDescriptor.m_CanonicalPathHash;
+        if (preloader->m_ExpandedPaths.Get(path_hash))
+        {
+            return;
+        }
+        if (preloader->m_ExpandedPaths.Full())
+        {
+            uint32_t capacity = preloader->m_ExpandedPaths.Capacity() + 64;
+            preloader->m_ExpandedPaths.SetCapacity((capacity * 2) / 3, capacity);
+        }
+        preloader->m_ExpandedPaths.Put(path_hash, true);
+
+        dmResourceMounts::HContext mounts = GetMountsContext(preloader->m_Factory);
+        if (!mounts)
+        {
+            return;
+        }
+
+        ManifestChildrenContext ctx;
+        ctx.m_Preloader = preloader;
+        if (dmResourceMounts::GetChildren(mounts, path_hash, GetManifestChildCallback, &ctx) != RESULT_OK)
+        {
+            return;
+        }
+
+        // Children are inserted first in the list, so the largest ones end up first and are loaded first
+        std::sort(ctx.m_Children.Begin(), ctx.m_Children.End(), ManifestChildSizePred());
+
+        for (uint32_t i = 0; i < ctx.m_Children.Size(); ++i)
+        {
+            if (preloader->m_FreelistSize <= MANIFEST_CHILDREN_RESERVE)
+            {
+                break;
+            }
+            const PathDescriptor& path_descriptor = ctx.m_Children[i].m_PathDescriptor;
+            // Leave any loop to the preload hints, which reports it
+            if (IsPathInParentChain(preloader, index, path_descriptor.m_CanonicalPathHash))
+            {
+                continue;
+            }
+            PreloadPathDescriptor(preloader, index, path_descriptor);
+        }
+
+        TRequestIndex child = preloader->m_Request[index].m_FirstChild;
+        while (child != -1)
+        {
+            PreloadManifestChildren(preloader, child);
+            child = preloader->m_Request[child].m_NextSibling;
+        }
+    }
+
     static bool PopHints(HPreloader preloader)
     {
         dmArray<PendingHint> new_hints;
@@ -383,6 +528,7 @@ namespace dmResource
             const PendingHint* hint = &hints[i];
             if (PreloadPathDescriptor(preloader, hint->m_Parent, hint->m_PathDescriptor) == RESULT_OK)
             {
+                PreloadManifestChildren(preloader, preloader->m_Request[hint->m_Parent].m_FirstChild);
                 ++new_hint_count;
             }
         }
@@ -434,10 +580,12 @@ namespace dmResource
         preloader->m_Freelist[preloader->m_FreelistSize++] = index;
     }
 
+    // Children inserted from the manifest may have children of their own, that have not started loading
     static void RemoveChildren(ResourcePreloader* preloader, PreloadRequest* req)
     {
         while (req->m_FirstChild != -1)
         {
+            RemoveChildren(preloader, &preloader->m_Request[req->m_FirstChild]);
             PreloaderRemoveLeaf(preloader, req->m_FirstChild);
         }
         assert(req->m_PendingChildCount == 0);
@@ -475,6 +623,8 @@ namespace dmResource
         preloader->m_PostCreateCallbacks.SetCapacity(MAX_PRELOADER_REQUESTS / 8);
         preloader->m_LoadQueueFull           = false;
         preloader->m_CreateComplete          = false;
+        preloader->m_IgnoreCreateBudget      = false;
+        preloader->m_CreateDeferred          = false;
         preloader->m_PostCreateCallbackIndex = 0;
 
         preloader->m_BlockAllocator = dmBlockAllocator::CreateContext();
@@ -496,6 +646,15 @@ namespace dmResource
             }
         }
 
+        // The requested items are expanded after they are all inserted, to keep them at the first indices
+        if (root->m_LoadResult == RESULT_PENDING)
+        {
+            for (TRequestIndex i = 0; i < preloader->m_PersistResourceCount; ++i)
+            {
+                PreloadManifestChildren(preloader, i);
+            }
+        }
+
         return preloader;
     }
 
@@ -506,6 +665,17 @@ namespace dmResource
         return NewPreloader(factory, names);
     }
 
+    // The creation of resources is spread over several frames if the factory has a create budget
+    static bool HasCreateBudget(HPreloader preloader, uint32_t cost)
+    {
+        if (preloader->m_IgnoreCreateBudget || HasCreateBudget(preloader->m_Factory, cost))
+        {
+            return true;
+        }
+        preloader->m_CreateDeferred = true;
+        return false;
+    }
+
     // CreateResource operation ends either with
     //   1) Having created the resource and free:d all buffers => RESULT_OK + m_Resource
     //   2) Having failed, (or created and destroyed), leaving => RESULT_SOME_ERROR + everything free:d
@@ -535,6 +705,8 @@ namespace dmResource
         params.m_Resource    = &tmp_resource;
         params.m_Filename    = req->m_PathDescriptor.m_InternalizedName;
 
+        uint64_t create_start = dmTime::GetTime();
+        SetPreloaderCreate(preloader->m_Factory, !preloader->m_IgnoreCreateBudget);
         if (!buffer)
         {
             assert(req->m_Buffer);
@@ -554,6 +726,8 @@ namespace dmResource
             params.m_BufferSize               = buffer_size;
             req->m_LoadResult                 = resource_type->m_CreateFunction(params);
         }
+        SetPreloaderCreate(preloader->m_Factory, false);
+        AddCreateTime(preloader->m_Factory, &resource_type->m_CreateCost, (uint32_t)(dmTime::GetTime() - create_start));
 
         if (req->m_LoadResult == RESULT_OK)
         {
@@ -600,7 +774,7 @@ namespace dmResource
         if (rd)
         {
             // Use already loaded resource
-            rd->m_ReferenceCount++;
+            IncRef(preloader->m_Factory, rd);
             req->m_Resource = rd->m_Resource;
             destroy         = true;
         }
@@ -664,6 +838,20 @@ namespace dmResource
         }
     }
 
+    // The item has been loaded and is only waiting for its children to complete
+    static bool IsWaitingForChildren(const PreloadRequest* req)
+    {
+        return req->m_LoadRequest == 0 && (req->m_Buffer != 0 || req->m_LoadError != RESULT_OK);
+    }
+
+    static void FailLoad(HPreloader preloader, PreloadRequest* req, Result result)
+    {
+        req->m_LoadResult = result;
+        req->m_LoadError  = RESULT_OK;
+        RemoveChildren(preloader, req);
+        RemoveFromParentPendingCount(preloader, req);
+    }
+
     // Try to create the resource of the parent if all the child requests has been
     // resolved. We continue up the parent chain until we find a parent where all
     // children are not resolved and we break
@@ -680,14 +868,31 @@ namespace dmResource
         {
             return false;
         }
-        CreateResource(preloader, parent_req, 0, 0);
+        // The children may complete before the parent has been loaded, it's created once its load finishes
+        if (!IsWaitingForChildren(parent_req))
+        {
+            return false;
+        }
+        // Out of budget this frame, the parent is created later by DoPreloaderUpdateOneReq
+        if (parent_req->m_LoadError == RESULT_OK && !HasCreateBudget(preloader, parent_req->m_PathDescriptor.m_ResourceType->m_CreateCost))
+        {
+            return false;
+        }
+        if (parent_req->m_LoadError != RESULT_OK)
+        {
+            FailLoad(preloader, parent_req, parent_req->m_LoadError);
+        }
+        else
+        {
+            CreateResource(preloader, parent_req, 0, 0);
+        }
         UnmarkPathInProgress(preloader, &parent_req->m_PathDescriptor);
         PreloaderTryPruneParent(preloader, parent_req);
         return true;
     }
 
     // Ends the Load part of the resource and handles the result of the load
-    // It will create the resource if it has no children, otherwise it will
+    // It will create the resource if all its children are done (and the create budget allows it), otherwise it will
     // copy the loaded buffer for later use when all the children has been created.
     //
     // Returns true if the resource was created
@@ -697,44 +902,49 @@ namespace dmResource
         PopHints(preloader);
 
         // Propagate errors
+        Result result = RESULT_OK;
         if (load_result.m_LoadResult != RESULT_OK)
         {
-            req->m_LoadResult = load_result.m_LoadResult;
+            result = load_result.m_LoadResult;
         }
         else if (load_result.m_PreloadResult != RESULT_OK)
         {
-            req->m_LoadResult = load_result.m_PreloadResult;
-        }
-
-        // On error remove all children
-        if (req->m_LoadResult != RESULT_PENDING)
-        {
-            RemoveChildren(preloader, req);
-            RemoveFromParentPendingCount(preloader, req);
+            result = load_result.m_PreloadResult;
         }
 
         req->m_PreloadData = load_result.m_PreloadData;
 
         bool created_resource = false;
 
-        // If no children, do the create step immediately with the buffer in place
-        if (req->m_FirstChild == -1)
+        // If no children are pending, do the create step immediately with the buffer in place
+        if (req->m_PendingChildCount == 0 && (result != RESULT_OK || HasCreateBudget(preloader, req->m_PathDescriptor.m_ResourceType->m_CreateCost)))
         {
-            if (req->m_LoadResult == RESULT_PENDING)
+            if (result == RESULT_OK)
             {
                 // Create the resource using the loading buffer directly.
                 CreateResource(preloader, req, buffer, buffer_size);
                 created_resource = true;
             }
+            else
+            {
+                FailLoad(preloader, req, result);
+            }
             UnmarkPathInProgress(preloader, &req->m_PathDescriptor);
             dmLoadQueue::FreeLoad(preloader->m_LoadQueue, req->m_LoadRequest);
             req->m_LoadRequest = 0;
 
             PreloaderTryPruneParent(preloader, req);
         }
+        else if (result != RESULT_OK)
+        {
+            // The children might be loading already, so they have to complete before they can be removed
+            req->m_LoadError = result;
+            dmLoadQueue::FreeLoad(preloader->m_LoadQueue, req->m_LoadRequest);
+            req->m_LoadRequest = 0;
+        }
         else
         {
-            // Keep the loaded bytes until we have loaded all children
+            // Keep the loaded bytes until we have loaded all children (or there is budget to create it)
             req->m_Buffer = dmBlockAllocator::Allocate(preloader->m_BlockAllocator, buffer_size);
             memcpy(req->m_Buffer, buffer, buffer_size);
             req->m_BufferSize = buffer_size;
@@ -794,7 +1004,7 @@ namespace dmResource
             return false;
         }
 
-        // If loading it must finish first before trying to go down to children
+        // If loading, the children already known can start loading too
         if (req->m_LoadRequest)
         {
             void* buffer;
@@ -805,7 +1015,7 @@ namespace dmResource
             dmLoadQueue::Result e = dmLoadQueue::EndLoad(preloader->m_LoadQueue, req->m_LoadRequest, &buffer, &buffer_size, &res);
             if (e == dmLoadQueue::RESULT_PENDING)
             {
-                return false;
+                return PreloaderUpdateOneItem(preloader, req->m_FirstChild);
             }
             preloader->m_LoadQueueFull = false;
 
@@ -816,9 +1026,29 @@ namespace dmResource
             return false;
         }
 
-        // It has a buffer if is waiting for children to complete first
-        if (req->m_Buffer)
+        // It has a buffer (or an error) if is waiting for children to complete first
+        if (IsWaitingForChildren(req))
         {
+            // The children are done, but the create was held back by the create budget
+            if (req->m_PendingChildCount == 0)
+            {
+                if (req->m_LoadError == RESULT_OK && !HasCreateBudget(preloader, req->m_PathDescriptor.m_ResourceType->m_CreateCost))
+                {
+                    return false;
+                }
+                if (req->m_LoadError != RESULT_OK)
+                {
+                    FailLoad(preloader, req, req->m_LoadError);
+                }
+                else
+                {
+                    CreateResource(preloader, req, 0, 0);
+                }
+                UnmarkPathInProgress(preloader, &req->m_PathDescriptor);
+                PreloaderTryPruneParent(preloader, req);
+                return true;
+            }
+
             // traverse depth first
             if (PreloaderUpdateOneItem(preloader, req->m_FirstChild))
             {
@@ -831,7 +1061,7 @@ namespace dmResource
         SResourceDescriptor* rd = FindByHash(preloader->m_Factory, req->m_PathDescriptor.m_CanonicalPathHash);
         if (rd)
         {
-            rd->m_ReferenceCount++;
+            IncRef(preloader->m_Factory, rd);
             req->m_Resource   = rd->m_Resource;
             req->m_LoadResult = RESULT_OK;
             RemoveChildren(preloader, req);
@@ -881,7 +1111,11 @@ namespace dmResource
         ResourcePostCreateParams& params     = ip.m_Params;
         params.m_Resource                    = &ip.m_ResourceDesc;
         SResourceType* resource_type         = (SResourceType*)params.m_Resource->m_ResourceType;
+        uint64_t post_create_start           = dmTime::GetTime();
+        SetPreloaderCreate(preloader->m_Factory, !preloader->m_IgnoreCreateBudget);
         Result ret                           = resource_type->m_PostCreateFunction(params);
+        SetPreloaderCreate(preloader->m_Factory, false);
+        AddCreateTime(preloader->m_Factory, &resource_type->m_PostCreateCost, (uint32_t)(dmTime::GetTime() - post_create_start));
 
         if (ret == RESULT_PENDING)
         {
@@ -924,6 +1158,7 @@ namespace dmResource
         uint64_t start           = dmTime::GetTime();
         uint32_t empty_runs      = 0;
         bool close_to_time_limit = soft_time_limit < 1000;
+        preloader->m_CreateDeferred = false;
 
         do
         {
@@ -931,7 +1166,12 @@ namespace dmResource
             Result post_create_result = RESULT_OK;
             if (preloader->m_PostCreateCallbackIndex < preloader->m_PostCreateCallbacks.Size())
             {
-                post_create_result = PostCreateUpdateOneItem(preloader);
+                ResourcePostCreateParamsInternal& ip = preloader->m_PostCreateCallbacks[preloader->m_PostCreateCallbackIndex];
+                SResourceType* resource_type         = (SResourceType*)ip.m_ResourceDesc.m_ResourceType;
+                if (HasCreateBudget(preloader, resource_type->m_PostCreateCost))
+                    post_create_result = PostCreateUpdateOneItem(preloader);
+                else
+                    post_create_result = RESULT_PENDING;
                 if (post_create_result != RESULT_PENDING)
                 {
                     empty_runs = 0;
@@ -987,6 +1227,12 @@ namespace dmResource
                 continue;
             }
 
+            // Nothing more can be created this frame, leave the rest of the time to the game
+            if (preloader->m_CreateDeferred)
+            {
+                break;
+            }
+
             if (close_to_time_limit)
             {
                 ++empty_runs;
@@ -1024,6 +1270,7 @@ namespace dmResource
         // This is not a super-important use-case, the only way to trigger this is to start a load and
         // then do unload before it completes or if you destroy the collection while loading.
         // The normal operation is to issue a load and progress once complete.
+        preloader->m_IgnoreCreateBudget = true;
         while (UpdatePreloader(preloader, 0, 0, 1000000) == RESULT_PENDING)
         {
             dmLogWarning("Waiting for preloader to complete.");
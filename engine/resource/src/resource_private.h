@@ -52,10 +52,38 @@ namespace dmResource
         FResourcePostCreate m_PostCreateFunction;
         FResourceDestroy    m_DestroyFunction;
         FResourceRecreate   m_RecreateFunction;
+        // Measured (smoothed) time in microseconds of the create and post create calls
+        uint32_t            m_CreateCost;
+        uint32_t            m_PostCreateCost;
+        // Bytes of cached resources of this type, and the max allowed
+        uint32_t            m_CacheSize;
+        uint32_t            m_CacheBudget;
     };
 
     struct SResourceDescriptor;
 
+    // Settings for the background load queues (see NewFactoryParams)
+    struct LoadQueueParams
+    {
+        uint32_t m_ThreadCount;
+        uint32_t m_QueueSlots;
+        uint32_t m_MaxPendingData;
+    };
+
+    const LoadQueueParams* GetLoadQueueParams(HFactory factory);
+
+    // Returns true if work expected to take 'cost' microseconds fits in the create budget of this frame.
+    // The first item each frame is always allowed, so that large items still complete.
+    bool HasCreateBudget(HFactory factory, uint32_t cost);
+
+    // Set around the create and post create calls of a preloader, so that GetCreateBudgetLeft only limits those
+    void SetPreloaderCreate(HFactory factory, bool preloader_create);
+
+    // Increase the reference count, a resource with no references is taken out of the resource cache
+    void IncRef(HFactory factory, SResourceDescriptor* rd);
+    // Adds the time spent in a create or post create call to this frame, and to the measured cost of the type
+    void AddCreateTime(HFactory factory, uint32_t* cost, uint32_t time);
+
     Result CheckSuppliedResourcePath(const char* name);
 
     // load with default internal buffer and its management, returns buffer ptr in 'buffer'
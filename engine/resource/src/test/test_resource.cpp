@@ -40,9 +40,11 @@
 #include "../resource_archive_private.h"
 #include "../resource_manifest.h"
 #include "../resource_manifest_private.h"
+#include "../resource_mounts.h"
 #include "../resource_private.h"
 #include "../resource_util.h"
 #include "../resource_verify.h"
+#include "../providers/provider_private.h"
 #include "test/test_resource_ddf.h"
 
 #if defined(DM_TEST_HTTP_SUPPORTED)
@@ -60,6 +62,7 @@ char g_HttpAddress[128] = "localhost";
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 
+#include <algorithm> // std::sort
 #include <vector>
 
 extern unsigned char RESOURCES_ARCI[];
@@ -226,10 +229,15 @@ protected:
         m_FooResourceCreateCallCount = 0;
         m_FooResourcePostCreateCallCount = 0;
         m_FooResourceDestroyCallCount = 0;
+        m_FooResourceCreateBudgetLeft = 0;
 
         dmResource::NewFactoryParams params;
         params.m_MaxResources = 16;
+        CreateFactory(&params);
+    }
 
+    void CreateFactory(dmResource::NewFactoryParams* params)
+    {
         const char* original_mount_path = GetParam();
 #if defined(DM_TEST_HTTP_SUPPORTED)
         char mountpath[512];
@@ -240,7 +248,7 @@ protected:
         }
 #endif
 
-        m_Factory = dmResource::NewFactory(&params, original_mount_path);
+        m_Factory = dmResource::NewFactory(params, original_mount_path);
 
         ASSERT_NE((void*) 0, m_Factory);
         m_ResourceName = "/test.cont";
@@ -294,6 +302,7 @@ public:
     uint32_t           m_FooResourceCreateCallCount;
     uint32_t           m_FooResourcePostCreateCallCount;
     uint32_t           m_FooResourceDestroyCallCount;
+    uint32_t           m_FooResourceCreateBudgetLeft;
 
     dmResource::HFactory m_Factory;
     const char*        m_ResourceName;
@@ -379,6 +388,7 @@ dmResource::Result FooResourceCreate(const dmResource::ResourceCreateParams& par
 {
     GetResourceTest* self = (GetResourceTest*) params.m_Context;
     self->m_FooResourceCreateCallCount++;
+    self->m_FooResourceCreateBudgetLeft = dmResource::GetCreateBudgetLeft(params.m_Factory);
 
     TestResource::ResourceFoo* resource_foo;
 
@@ -842,6 +852,215 @@ TEST_P(GetResourceTest, PreloadGetParallell)
     }
 }
 
+TEST_P(GetResourceTest, PreloadGetLoaderThreads)
+{
+    // Many loader threads working on a small queue, which is throttled after each load
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_LoaderThreadCount = 4;
+    params.m_LoaderQueueSlots = 3;
+    params.m_LoaderMaxPendingData = 1;
+    CreateFactory(&params);
+
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        TestResourceContainer* resource = 0;
+        dmResource::Result e = PreloaderGet(m_Factory, m_ResourceName, (void**) &resource);
+        ASSERT_EQ(dmResource::RESULT_OK, e);
+        ASSERT_NE((void*) 0, resource);
+        ASSERT_EQ((uint32_t) 123, resource->m_Resources[0]->m_X);
+        ASSERT_EQ((uint32_t) 456, resource->m_Resources[1]->m_X);
+
+        dmResource::Release(m_Factory, resource);
+    }
+}
+
+TEST_P(GetResourceTest, PreloadGetCreateBudget)
+{
+    // A tiny budget allows (at most) one create per frame, so the resources are created over several updates
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_CreateBudget = 1;
+    CreateFactory(&params);
+
+    // The budget only applies to the creates of the preloaders
+    ASSERT_EQ(0xFFFFFFFF, dmResource::GetCreateBudgetLeft(m_Factory));
+
+    dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, m_ResourceName);
+    dmResource::Result r = dmResource::RESULT_PENDING;
+    uint32_t frames = 0;
+    while (r == dmResource::RESULT_PENDING && frames < 1000)
+    {
+        dmResource::UpdateFactory(m_Factory);
+        r = dmResource::UpdatePreloader(pr, 0, 0, 30*1000);
+        ++frames;
+    }
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+
+    TestResourceContainer* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_EQ((uint32_t) 123, resource->m_Resources[0]->m_X);
+    ASSERT_EQ((uint32_t) 456, resource->m_Resources[1]->m_X);
+    ASSERT_GE(1U, m_FooResourceCreateBudgetLeft);
+    dmResource::Release(m_Factory, resource);
+
+    dmResource::DeletePreloader(pr);
+}
+
+TEST_P(GetResourceTest, GetCreateBudget)
+{
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_CreateBudget = 1;
+    CreateFactory(&params);
+
+    // Resources created with Get are created in one go
+    TestResourceContainer* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_EQ(0xFFFFFFFF, m_FooResourceCreateBudgetLeft);
+    dmResource::Release(m_Factory, resource);
+}
+
+TEST_P(GetResourceTest, ResourceCache)
+{
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_CacheSize = 1024 * 1024;
+    CreateFactory(&params);
+
+    TestResourceContainer* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    uint32_t sub_resource_count = resource->m_Resources.size();
+    dmResource::Release(m_Factory, resource);
+
+    // Kept in the cache without references
+    ASSERT_EQ((uint32_t) 0, m_ResourceContainerDestroyCallCount);
+    ASSERT_EQ((uint32_t) 0, m_FooResourceDestroyCallCount);
+    dmResource::SResourceDescriptor descriptor;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor));
+    ASSERT_EQ((uint32_t) 0, descriptor.m_ReferenceCount);
+
+    // A cache hit
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerCreateCallCount);
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor));
+    ASSERT_EQ((uint32_t) 1, descriptor.m_ReferenceCount);
+    dmResource::Release(m_Factory, resource);
+
+    // Type budgets only apply to cached resources, the foo resources are still referenced by the container
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetCacheBudget(m_Factory, "foo", 0));
+    ASSERT_EQ((uint32_t) 0, m_FooResourceDestroyCallCount);
+    ASSERT_EQ(dmResource::RESULT_UNKNOWN_RESOURCE_TYPE, dmResource::SetCacheBudget(m_Factory, "does_not_exist", 0));
+
+    // Disabling the cache destroys the container, which releases the foo resources
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetCacheBudget(m_Factory, 0, 0));
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerDestroyCallCount);
+    ASSERT_EQ(sub_resource_count, m_FooResourceDestroyCallCount);
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor));
+}
+
+TEST_P(GetResourceTest, ResourceCacheChanged)
+{
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_CacheSize = 1024 * 1024;
+    CreateFactory(&params);
+
+    dmhash_t name_hash = dmHashString64(m_ResourceName);
+    TestResourceContainer* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_TRUE(dmResource::IsCacheable(m_Factory, name_hash));
+
+    // A changed resource is destroyed when it's released
+    dmResource::SetUncacheable(m_Factory, name_hash);
+    ASSERT_FALSE(dmResource::IsCacheable(m_Factory, name_hash));
+    dmResource::Release(m_Factory, resource);
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerDestroyCallCount);
+    dmResource::SResourceDescriptor descriptor;
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor));
+
+    // Loaded from file again, it can be cached
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_TRUE(dmResource::IsCacheable(m_Factory, name_hash));
+    dmResource::Release(m_Factory, resource);
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerDestroyCallCount);
+
+    // Changing a cached resource evicts it instead
+    char data[] = "changed";
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResource::SetResource(m_Factory, name_hash, data, sizeof(data)));
+    ASSERT_EQ((uint32_t) 2, m_ResourceContainerDestroyCallCount);
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor));
+}
+
+TEST_P(GetResourceTest, ResourceCacheCreate)
+{
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_CacheSize = 1024 * 1024;
+    CreateFactory(&params);
+
+    TestResource::ResourceFoo* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/test01.foo", (void**) &resource));
+    ASSERT_EQ((uint32_t) 123, resource->m_X);
+    dmResource::Release(m_Factory, resource);
+    ASSERT_EQ((uint32_t) 0, m_FooResourceDestroyCallCount);
+
+    // Creating a resource at the path of a cached resource replaces it
+    void* data = 0;
+    uint32_t data_size = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::GetRaw(m_Factory, "/test02.foo", &data, &data_size));
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::CreateResource(m_Factory, "/test01.foo", data, data_size, (void**) &resource));
+    free(data);
+    ASSERT_EQ((uint32_t) 1, m_FooResourceDestroyCallCount);
+    ASSERT_EQ((uint32_t) 456, resource->m_X);
+
+    dmResource::SResourceDescriptor descriptor;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::GetDescriptor(m_Factory, "/test01.foo", &descriptor));
+    ASSERT_EQ((uint32_t) 1, descriptor.m_ReferenceCount);
+    dmResource::Release(m_Factory, resource);
+}
+
+TEST_P(GetResourceTest, ResourcePrefetch)
+{
+    const char* names_array[1] = { m_ResourceName };
+    dmArray<const char*> names(names_array, 1, 1);
+    ASSERT_EQ(dmResource::RESULT_NOT_SUPPORTED, dmResource::Prefetch(m_Factory, names));
+
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_CacheSize = 1024 * 1024;
+    CreateFactory(&params);
+
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Prefetch(m_Factory, names));
+
+    dmResource::SResourceDescriptor descriptor;
+    dmResource::Result r = dmResource::RESULT_RESOURCE_NOT_FOUND;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        dmResource::UpdateFactory(m_Factory);
+        r = dmResource::GetDescriptor(m_Factory, m_ResourceName, &descriptor);
+        if (r == dmResource::RESULT_OK && descriptor.m_ReferenceCount == 0)
+            break;
+        dmTime::Sleep(30000);
+    }
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+    ASSERT_EQ((uint32_t) 0, descriptor.m_ReferenceCount);
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerCreateCallCount);
+
+    TestResourceContainer* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, PreloaderGet(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_EQ((uint32_t) 1, m_ResourceContainerCreateCallCount);
+    ASSERT_EQ((uint32_t) 123, resource->m_Resources[0]->m_X);
+    dmResource::Release(m_Factory, resource);
+}
+
 TEST_P(GetResourceTest, PreloadGetManyRefs)
 {
     // this has more references than the preloader can fit into its tree
@@ -863,6 +1082,146 @@ TEST_P(GetResourceTest, PreloadGetManyRefs)
 }
 
 
+// An archive without any files, whose manifest lists the children of resources in the other mounts
+struct ChildrenArchive
+{
+    static const uint32_t MAX_ENTRIES = 4;
+
+    dmResource::Manifest            m_Manifest;
+    dmLiveUpdateDDF::ManifestData   m_Data;
+    dmLiveUpdateDDF::ResourceEntry  m_Entries[MAX_ENTRIES];
+    dmhash_t                        m_Children[MAX_ENTRIES][MAX_ENTRIES];
+    uint32_t                        m_EntryCount;
+};
+
+static bool ResourceEntryUrlHashPred(const dmLiveUpdateDDF::ResourceEntry& a, const dmLiveUpdateDDF::ResourceEntry& b)
+{
+    return a.m_UrlHash < b.m_UrlHash;
+}
+
+static void AddChildrenArchiveEntry(ChildrenArchive* archive, const char* url, const char** children, uint32_t child_count)
+{
+    dmLiveUpdateDDF::ResourceEntry* entry = &archive->m_Entries[archive->m_EntryCount];
+    dmhash_t* child_hashes = archive->m_Children[archive->m_EntryCount];
+    archive->m_EntryCount++;
+
+    memset(entry, 0, sizeof(*entry));
+    entry->m_Url = url;
+    entry->m_UrlHash = dmHashString64(url);
+    for (uint32_t i = 0; i < child_count; ++i)
+    {
+        child_hashes[i] = dmHashString64(children[i]);
+    }
+    entry->m_Children.m_Data = child_hashes;
+    entry->m_Children.m_Count = child_count;
+
+    // The manifest lookup is a binary search on the url hash
+    std::sort(archive->m_Entries, archive->m_Entries + archive->m_EntryCount, ResourceEntryUrlHashPred);
+    archive->m_Data.m_Resources.m_Data = archive->m_Entries;
+    archive->m_Data.m_Resources.m_Count = archive->m_EntryCount;
+    archive->m_Manifest.m_DDFData = &archive->m_Data;
+}
+
+static dmResourceProvider::Result ChildrenArchiveUnmount(dmResourceProvider::HArchiveInternal archive)
+{
+    return dmResourceProvider::RESULT_OK;
+}
+
+static dmResourceProvider::Result ChildrenArchiveGetManifest(dmResourceProvider::HArchiveInternal archive, dmResource::HManifest* out_manifest)
+{
+    *out_manifest = &((ChildrenArchive*) archive)->m_Manifest;
+    return dmResourceProvider::RESULT_OK;
+}
+
+static dmResourceProvider::Result ChildrenArchiveGetFileSize(dmResourceProvider::HArchiveInternal archive, dmhash_t path_hash, const char* path, uint32_t* file_size)
+{
+    return dmResourceProvider::RESULT_NOT_FOUND;
+}
+
+static dmResourceProvider::Result ChildrenArchiveReadFile(dmResourceProvider::HArchiveInternal archive, dmhash_t path_hash, const char* path, uint8_t* buffer, uint32_t buffer_len)
+{
+    return dmResourceProvider::RESULT_NOT_FOUND;
+}
+
+class PreloadManifestChildrenTest : public GetResourceTest
+{
+protected:
+    virtual void SetUp()
+    {
+        GetResourceTest::SetUp();
+
+        memset(&m_Loader, 0, sizeof(m_Loader));
+        m_Loader.m_NameHash = dmHashString64("children");
+        m_Loader.m_Unmount = ChildrenArchiveUnmount;
+        m_Loader.m_GetManifest = ChildrenArchiveGetManifest;
+        m_Loader.m_GetFileSize = ChildrenArchiveGetFileSize;
+        m_Loader.m_ReadFile = ChildrenArchiveReadFile;
+
+        m_Archive.m_EntryCount = 0;
+
+        // test01.foo doesn't hint anything, so test02.foo is only loaded as a child from the manifest
+        const char* foo_children[] = { "/test02.foo" };
+        AddChildrenArchiveEntry(&m_Archive, "/test01.foo", foo_children, 1);
+        const char* missing_children[] = { "/test01.foo", "/test02.foo" };
+        AddChildrenArchiveEntry(&m_Archive, "/missing.cont", missing_children, 2);
+
+        dmResourceProvider::HArchive archive;
+        ASSERT_EQ(dmResourceProvider::RESULT_OK, dmResourceProvider::CreateMount(&m_Loader, &m_Archive, &archive));
+        // Before the other mounts, since the first manifest that has the resource is used
+        ASSERT_EQ(dmResource::RESULT_OK, dmResourceMounts::AddMount(dmResource::GetMountsContext(m_Factory), "children", archive, 100, false));
+    }
+
+    dmResource::Result UpdatePreloaderUntilDone(dmResource::HPreloader preloader)
+    {
+        dmResource::Result r = dmResource::RESULT_PENDING;
+        for (uint32_t i = 0; i < 1000 && r == dmResource::RESULT_PENDING; ++i)
+        {
+            r = dmResource::UpdatePreloader(preloader, 0, 0, 30*1000);
+            if (r == dmResource::RESULT_PENDING)
+                dmTime::Sleep(1000);
+        }
+        return r;
+    }
+
+    dmResourceProvider::ArchiveLoader m_Loader;
+    ChildrenArchive m_Archive;
+};
+
+TEST_P(PreloadManifestChildrenTest, LoadChildren)
+{
+    dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, "/test01.foo");
+    ASSERT_EQ(dmResource::RESULT_OK, UpdatePreloaderUntilDone(pr));
+
+    // The child was created by the preloader, and released when the parent was created
+    ASSERT_EQ(2U, m_FooResourceCreateCallCount);
+    ASSERT_EQ(1U, m_FooResourceDestroyCallCount);
+
+    TestResource::ResourceFoo* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/test01.foo", (void**) &resource));
+    ASSERT_EQ(2U, m_FooResourceCreateCallCount);
+    dmResource::DeletePreloader(pr);
+    dmResource::Release(m_Factory, resource);
+    ASSERT_EQ(2U, m_FooResourceDestroyCallCount);
+}
+
+TEST_P(PreloadManifestChildrenTest, LoadErrorWhileChildrenLoad)
+{
+    // The parent fails to load while the children from the manifest are in flight. The error is reported
+    // once they have completed, and nothing they created is kept.
+    dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, "/missing.cont");
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, UpdatePreloaderUntilDone(pr));
+    dmResource::DeletePreloader(pr);
+
+    ASSERT_EQ(0U, m_ResourceContainerCreateCallCount);
+    ASSERT_EQ(m_FooResourceCreateCallCount, m_FooResourceDestroyCallCount);
+
+    dmResource::SResourceDescriptor descriptor;
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResource::GetDescriptor(m_Factory, "/test01.foo", &descriptor));
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, dmResource::GetDescriptor(m_Factory, "/test02.foo", &descriptor));
+}
+
+INSTANTIATE_TEST_CASE_P(PreloadManifestChildrenTestURI, PreloadManifestChildrenTest, jc_test_values_in(params_resource_paths));
+
 TEST_P(GetResourceTest, PreloadGetAbort)
 {
     // Must not leak or crash
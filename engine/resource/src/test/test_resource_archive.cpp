@@ -22,6 +22,9 @@
 #include "../providers/provider_archive_private.h"
 #include <dlib/dstrings.h>
 #include <dlib/endian.h>
+#include <dlib/job_thread.h>
+#include <dlib/lz4.h>
+#include <dlib/math.h>
 #include <dlib/sys.h>
 #include <dlib/testutil.h>
 #include <testmain/testmain.h>
@@ -350,6 +353,42 @@ TEST(dmResourceArchive, GetInsertionIndex)
     dmResourceArchive::Delete(archive);
 }
 
+TEST(dmResourceArchive, LookupTable)
+{
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_ARCI, RESOURCES_ARCI_SIZE, true, RESOURCES_ARCD, RESOURCES_ARCD_SIZE, true, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+    dmResourceArchive::EntryData* expected_entries[DM_ARRAY_SIZE(content_hash)];
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(content_hash); ++i)
+    {
+        expected_entries[i] = 0;
+        dmResourceArchive::FindEntry(archive, content_hash[i], sizeof(content_hash[i]), &expected_entries[i]);
+    }
+
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, dmResourceArchive::CreateLookupTable(archive));
+    ASSERT_NE((uint32_t*)0, archive->m_LookupTable);
+
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(content_hash); ++i)
+    {
+        dmResourceArchive::EntryData* entry = 0;
+        result = dmResourceArchive::FindEntry(archive, content_hash[i], sizeof(content_hash[i]), &entry);
+        if (IsLiveUpdateResource(path_hash[i]))
+        {
+            ASSERT_EQ(dmResourceArchive::RESULT_NOT_FOUND, result);
+            continue;
+        }
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+        ASSERT_EQ(expected_entries[i], entry);
+    }
+
+    uint8_t invalid_hash[] = { 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U };
+    result = dmResourceArchive::FindEntry(archive, invalid_hash, sizeof(invalid_hash), 0);
+    ASSERT_EQ(dmResourceArchive::RESULT_NOT_FOUND, result);
+
+    dmResourceArchive::Delete(archive);
+}
+
 TEST(dmResourceArchive, ManifestHeader)
 {
     dmResource::HManifest manifest = new dmResource::Manifest();
@@ -758,6 +797,140 @@ TEST(dmResourceArchive, LoadFromDisk_Compressed)
     dmResourceArchive::Delete(archive);
 }
 
+static const uint32_t BLOCKS_RESOURCE_SIZE = 100000;
+static const uint32_t BLOCKS_BLOCK_SIZE = 4096;
+
+// Same format as written by ArchiveBuilder.java
+static uint32_t CompressBlocks(const uint8_t* data, uint32_t size, uint32_t block_size, uint8_t* out)
+{
+    uint32_t block_count = (size + block_size - 1) / block_size;
+    uint32_t table_size = 8 + 4 * block_count;
+    uint32_t* table = (uint32_t*)out;
+    table[0] = dmEndian::ToNetwork(block_size);
+    table[1] = dmEndian::ToNetwork(block_count);
+
+    uint32_t offset = table_size;
+    for (uint32_t i = 0; i < block_count; ++i)
+    {
+        uint32_t start = i * block_size;
+        int compressed_size = 0;
+        dmLZ4::CompressBuffer(data + start, dmMath::Min(block_size, size - start), out + offset, &compressed_size);
+        offset += compressed_size;
+        table[2 + i] = dmEndian::ToNetwork(offset - table_size);
+    }
+    return offset;
+}
+
+// Either from the memory mapped data, or read from file
+static void TestReadEntryBlocks(dmJobThread::HContext job_thread, bool from_file)
+{
+    uint8_t* resource = new uint8_t[BLOCKS_RESOURCE_SIZE];
+    for (uint32_t i = 0; i < BLOCKS_RESOURCE_SIZE; ++i)
+    {
+        resource[i] = (uint8_t)((i / 7) ^ (i >> 10));
+    }
+
+    int max_block_size = 0;
+    dmLZ4::MaxCompressedSize(BLOCKS_BLOCK_SIZE, &max_block_size);
+    uint32_t block_count = (BLOCKS_RESOURCE_SIZE + BLOCKS_BLOCK_SIZE - 1) / BLOCKS_BLOCK_SIZE;
+    uint8_t* data = new uint8_t[8 + block_count * (4 + max_block_size)];
+    uint32_t compressed_size = CompressBlocks(resource, BLOCKS_RESOURCE_SIZE, BLOCKS_BLOCK_SIZE, data);
+    ASSERT_LT(compressed_size, BLOCKS_RESOURCE_SIZE);
+
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_ARCI, RESOURCES_ARCI_SIZE, true, data, compressed_size, true, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+    char path[512];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "test_resource_blocks.arcd");
+    FILE* resource_file = 0;
+    if (from_file)
+    {
+        resource_file = fopen(path, "w+b");
+        ASSERT_NE((FILE*)0, resource_file);
+        ASSERT_EQ(compressed_size, (uint32_t)fwrite(data, 1, compressed_size, resource_file));
+        fflush(resource_file);
+        archive->m_ArchiveFileIndex->m_FileResourceData = resource_file;
+        archive->m_ArchiveFileIndex->m_IsMemMapped = false;
+    }
+
+    dmResourceArchive::EntryData entry;
+    entry.m_ResourceDataOffset = 0;
+    entry.m_ResourceSize = dmEndian::ToNetwork(BLOCKS_RESOURCE_SIZE);
+    entry.m_ResourceCompressedSize = dmEndian::ToNetwork(compressed_size);
+    entry.m_Flags = dmEndian::ToNetwork((uint32_t)(dmResourceArchive::ENTRY_FLAG_COMPRESSED | dmResourceArchive::ENTRY_FLAG_COMPRESSED_BLOCKS));
+
+    dmResourceArchive::SetJobThread(archive, job_thread);
+
+    uint8_t* buffer = new uint8_t[BLOCKS_RESOURCE_SIZE];
+    result = dmResourceArchive::ReadEntry(archive, &entry, buffer);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    ASSERT_ARRAY_EQ_LEN(resource, buffer, BLOCKS_RESOURCE_SIZE);
+
+    // Within a block, across blocks, whole blocks and past the end
+    const uint32_t ranges[][2] = {
+        { 0, 10 },
+        { 100, BLOCKS_BLOCK_SIZE * 2 },
+        { BLOCKS_BLOCK_SIZE * 3, BLOCKS_BLOCK_SIZE * 4 },
+        { BLOCKS_RESOURCE_SIZE - 50, 100 },
+    };
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(ranges); ++i)
+    {
+        uint32_t offset = ranges[i][0];
+        uint32_t size = ranges[i][1];
+        uint32_t expected_size = dmMath::Min(size, BLOCKS_RESOURCE_SIZE - offset);
+
+        memset(buffer, 0, BLOCKS_RESOURCE_SIZE);
+        uint32_t nread = 0;
+        result = dmResourceArchive::ReadEntryPartial(archive, &entry, offset, size, buffer, &nread);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+        ASSERT_EQ(expected_size, nread);
+        ASSERT_ARRAY_EQ_LEN(resource + offset, buffer, nread);
+    }
+
+    // A block ending outside of the entry is rejected
+    ((uint32_t*)data)[2] = dmEndian::ToNetwork(compressed_size);
+    if (from_file)
+    {
+        fseek(resource_file, 0, SEEK_SET);
+        ASSERT_EQ(12U, (uint32_t)fwrite(data, 1, 12, resource_file));
+        fflush(resource_file);
+    }
+    result = dmResourceArchive::ReadEntry(archive, &entry, buffer);
+    ASSERT_EQ(dmResourceArchive::RESULT_INVALID_DATA, result);
+
+    dmResourceArchive::Delete(archive); // fclose on the FILE*
+    if (from_file)
+    {
+        dmSys::Unlink(path);
+    }
+    delete[] buffer;
+    delete[] data;
+    delete[] resource;
+}
+
+TEST(dmResourceArchive, ReadEntryBlocks)
+{
+    TestReadEntryBlocks(0, false);
+}
+
+TEST(dmResourceArchive, ReadEntryBlocks_File)
+{
+    TestReadEntryBlocks(0, true);
+}
+
+TEST(dmResourceArchive, ReadEntryBlocks_JobThread)
+{
+    dmJobThread::JobThreadCreationParams job_thread_create_param;
+    job_thread_create_param.m_ThreadNames[0] = "test_jobs";
+    job_thread_create_param.m_ThreadNames[1] = "test_jobs";
+    job_thread_create_param.m_ThreadCount = 2;
+    dmJobThread::HContext job_thread = dmJobThread::Create(job_thread_create_param);
+
+    TestReadEntryBlocks(job_thread, false);
+
+    dmJobThread::Destroy(job_thread);
+}
 
 static dmResource::Result TestDecryption(void* buffer, uint32_t buffer_len)
 {
@@ -0,0 +1,96 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include <dlib/endian.h>
+#include <dlib/time.h>
+#include <testmain/testmain.h>
+#include "../resource_archive.h"
+
+static int CompareHashes(const void* a, const void* b)
+{
+    return memcmp(a, b, dmResourceArchive::MAX_HASH);
+}
+
+// Compares the lookup table to the binary search, for a large archive index
+TEST(dmResourceArchive, MeasureLookupTable)
+{
+    const uint32_t entry_count = 128 * 1024;
+    const uint32_t hash_len = 20;
+    const uint32_t iter_count = 1024 * 1024;
+
+    uint32_t hash_offset = sizeof(dmResourceArchive::ArchiveIndex);
+    uint32_t entry_offset = hash_offset + entry_count * dmResourceArchive::MAX_HASH;
+    uint32_t index_size = entry_offset + entry_count * sizeof(dmResourceArchive::EntryData);
+    uint8_t* index_data = new uint8_t[index_size];
+    memset(index_data, 0, index_size);
+
+    dmResourceArchive::ArchiveIndex* index = (dmResourceArchive::ArchiveIndex*)index_data;
+    index->m_Version = dmEndian::ToNetwork(dmResourceArchive::VERSION);
+    index->m_EntryDataCount = dmEndian::ToNetwork(entry_count);
+    index->m_EntryDataOffset = dmEndian::ToNetwork(entry_offset);
+    index->m_HashOffset = dmEndian::ToNetwork(hash_offset);
+    index->m_HashLength = dmEndian::ToNetwork(hash_len);
+
+    uint8_t* hashes = index_data + hash_offset;
+    uint32_t seed = 0x1234567;
+    for (uint32_t i = 0; i < entry_count * hash_len; ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        hashes[(i / hash_len) * dmResourceArchive::MAX_HASH + (i % hash_len)] = (uint8_t)(seed >> 24);
+    }
+    qsort(hashes, entry_count, dmResourceArchive::MAX_HASH, CompareHashes);
+
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer(index_data, index_size, true, 0, 0, true, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+    uint64_t times[2];
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        uint64_t start = dmTime::GetTime();
+        if (pass == 1)
+        {
+            ASSERT_EQ(dmResourceArchive::RESULT_OK, dmResourceArchive::CreateLookupTable(archive));
+        }
+
+        for (uint32_t iter = 0; iter < iter_count; ++iter)
+        {
+            uint32_t i = (iter * 7919) % entry_count;
+            dmResourceArchive::EntryData* entry = 0;
+            result = dmResourceArchive::FindEntry(archive, hashes + i * dmResourceArchive::MAX_HASH, hash_len, &entry);
+            ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+            ASSERT_EQ((dmResourceArchive::EntryData*)(index_data + entry_offset) + i, entry);
+        }
+        times[pass] = dmTime::GetTime() - start;
+    }
+
+    printf("%u entries, %u lookups: binary search %.3f ms, lookup table %.3f ms (including creation)\n",
+            entry_count, iter_count, times[0] / 1000.0, times[1] / 1000.0);
+
+    dmResourceArchive::Delete(archive);
+    delete[] index_data;
+}
+
+int main(int argc, char **argv)
+{
+    TestMainPlatformInit();
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
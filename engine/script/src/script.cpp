@@ -19,6 +19,7 @@
 #include <dlib/math.h>
 #include <dlib/pprint.h>
 #include <dlib/profile.h>
+#include <dlib/time.h>
 
 #include "script_private.h"
 #include "script_hash.h"
@@ -40,6 +41,9 @@ extern "C"
 }
 
 DM_PROPERTY_GROUP(rmtp_Script, "");
+DM_PROPERTY_U32(rmtp_LuaGCTime, 0, FrameReset, "us spent in budgeted gc steps", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaGCSteps, 0, FrameReset, "# budgeted gc steps / frame", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_LuaHeap, 0, FrameReset, "kb", &rmtp_Script);
 
 namespace dmScript
 {
@@ -64,6 +68,7 @@ namespace dmScript
     const char META_TABLE_IS_VALID[]                 = "__is_valid";
     const char META_GET_INSTANCE_CONTEXT_TABLE_REF[] = "__get_instance_context_table_ref";
     const char META_GET_INSTANCE_DATA_TABLE_REF[]    = "__get_instance_data_table_ref";
+    const char META_TABLE_IS_SCRIPT_RECEIVER[]       = "__is_script_receiver";
 
     const char SCRIPT_METATABLE_TYPE_HASH_KEY_NAME[] = "__dmengine_type";
     static const uint32_t SCRIPT_METATABLE_TYPE_HASH_KEY = dmHashBufferNoReverse32(SCRIPT_METATABLE_TYPE_HASH_KEY_NAME, sizeof(SCRIPT_METATABLE_TYPE_HASH_KEY_NAME) - 1);
@@ -71,6 +76,13 @@ namespace dmScript
     // A debug value for profiling lua references
     int g_LuaReferenceCount = 0;
 
+    // Same as the panic function set by luaL_newstate
+    static int LuaPanic(lua_State* L)
+    {
+        dmLogFatal("PANIC: unprotected error in call to Lua API (%s)", lua_tostring(L, -1));
+        return 0;
+    }
+
     HContext NewContext(dmConfigFile::HConfig config_file, dmResource::HFactory factory, bool enable_extensions)
     {
         Context* context = new Context();
@@ -80,9 +92,25 @@ namespace dmScript
         context->m_ScriptExtensions.SetCapacity(8);
         context->m_ConfigFile = config_file;
         context->m_ResourceFactory = factory;
-        context->m_LuaState = lua_open();
+        context->m_LuaAllocator = NewLuaAllocator();
+        context->m_LuaState = lua_newstate(LuaAlloc, context->m_LuaAllocator);
+        if (!context->m_LuaState)
+        {
+            // LuaJIT builds that keep their objects in the low 2GB (64 bit without GC64) can't take a custom allocator
+            DeleteLuaAllocator(context->m_LuaAllocator);
+            context->m_LuaAllocator = 0;
+            context->m_LuaState = lua_open();
+        }
+        if (context->m_LuaState)
+        {
+            lua_atpanic(context->m_LuaState, LuaPanic);
+        }
         context->m_ContextTableRef = LUA_NOREF;
+        context->m_GCBudget = 0;
+        context->m_GCPause = 0;
         context->m_EnableExtensions = enable_extensions;
+        context->m_LazyModules = false;
+        context->m_BytecodeCache = 0;
         return context;
     }
 
@@ -90,6 +118,10 @@ namespace dmScript
     {
         ClearModules(context);
         lua_close(context->m_LuaState);
+        if (context->m_LuaAllocator)
+        {
+            DeleteLuaAllocator(context->m_LuaAllocator);
+        }
         delete context;
     }
 
@@ -228,8 +260,70 @@ namespace dmScript
         context->m_ScriptExtensions.Push(script_extension);
     }
 
+    bool GetLuaAllocatorStats(HContext context, LuaAllocatorStats* out_stats)
+    {
+        if (!context->m_LuaAllocator)
+            return false;
+        GetLuaAllocatorStats(context->m_LuaAllocator, out_stats);
+        return true;
+    }
+
+    void ResetLuaAllocatorCounters(HContext context)
+    {
+        if (context->m_LuaAllocator)
+            ResetLuaAllocatorCounters(context->m_LuaAllocator);
+    }
+
+    // The heap may grow to this percentage of the live size after a cycle before the collector starts a new cycle
+    // by itself, which leaves the cycles to the budgeted steps as long as they keep up
+    static const int GC_BUDGET_PAUSE = 400;
+
+    void SetGCBudget(HContext context, uint32_t budget_us)
+    {
+        lua_State* L = context->m_LuaState;
+        if (budget_us > 0 && context->m_GCBudget == 0)
+        {
+            context->m_GCPause = lua_gc(L, LUA_GCSETPAUSE, GC_BUDGET_PAUSE);
+        }
+        else if (budget_us == 0 && context->m_GCBudget > 0)
+        {
+            lua_gc(L, LUA_GCSETPAUSE, context->m_GCPause);
+        }
+        context->m_GCBudget = budget_us;
+    }
+
+    // Runs single collector steps until the budget is spent or a cycle completes
+    static void StepGC(HContext context)
+    {
+        DM_PROFILE("Lua GC");
+        lua_State* L = context->m_LuaState;
+        uint64_t start = dmTime::GetTime();
+        uint64_t end = start + context->m_GCBudget;
+        uint64_t now = start;
+        uint32_t steps = 0;
+        do
+        {
+            ++steps;
+            if (lua_gc(L, LUA_GCSTEP, 0))
+            {
+                now = dmTime::GetTime();
+                break;
+            }
+            now = dmTime::GetTime();
+        } while (now < end);
+
+        DM_PROPERTY_ADD_U32(rmtp_LuaGCTime, (uint32_t)(now - start));
+        DM_PROPERTY_ADD_U32(rmtp_LuaGCSteps, steps);
+    }
+
     void Update(HContext context)
     {
+        if (context->m_GCBudget > 0)
+        {
+            StepGC(context);
+        }
+        DM_PROPERTY_ADD_U32(rmtp_LuaHeap, (uint32_t)lua_gc(context->m_LuaState, LUA_GCCOUNT, 0));
+
         for (HScriptExtension* l = context->m_ScriptExtensions.Begin(); l != context->m_ScriptExtensions.End(); ++l)
         {
             if ((*l)->Update != 0x0)
@@ -938,6 +1032,21 @@ namespace dmScript
         return false;
     }
 
+    bool IsScriptReceiver(lua_State* L, const dmMessage::URL& receiver) {
+        DM_LUA_STACK_CHECK(L, 0);
+        GetInstance(L);
+        if (GetMetaFunction(L, -1, META_TABLE_IS_SCRIPT_RECEIVER, sizeof(META_TABLE_IS_SCRIPT_RECEIVER) - 1)) {
+            lua_pushvalue(L, -2);
+            PushURL(L, receiver);
+            lua_call(L, 2, 1);
+            bool result = lua_toboolean(L, -1);
+            lua_pop(L, 2);
+            return result;
+        }
+        lua_pop(L, 1);
+        return false;
+    }
+
     void SetContextValue(HContext context)
     {
         assert(context != 0x0);
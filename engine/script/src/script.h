@@ -57,6 +57,21 @@ namespace dmScript
     extern const char META_TABLE_IS_VALID[];
     extern const char META_GET_INSTANCE_DATA_TABLE_REF[];
 
+    /**
+     * Optional. Implementor should return true if the URL addresses a script
+     * component running in the same Lua state as the instance. Tables posted
+     * with msg.post to such a receiver are passed by reference.
+     *
+     * Lua stack on entry
+     *  [-2] instance
+     *  [-1] url
+     *
+     * Lua stack on exit
+     *  [-1] boolean
+     *
+     */
+    extern const char META_TABLE_IS_SCRIPT_RECEIVER[];
+
     /**
      * Implementor should return a Ref to the instance context table.
      *
@@ -205,6 +220,50 @@ namespace dmScript
      */
     void Update(HContext context);
 
+    /**
+     * Set the time spent running the Lua garbage collector in incremental steps each Update().
+     * While a budget is set, the collector keeps running inside script callbacks, but waits for
+     * the heap to grow to four times its size after the last completed cycle before it starts a
+     * new cycle by itself. The budgeted steps start the cycles earlier, so most of the work is
+     * done in Update().
+     * @param context script context
+     * @param budget_us microseconds per frame, 0 means the collector runs automatically (default)
+     */
+    void SetGCBudget(HContext context, uint32_t budget_us);
+
+    // game.project settings of the GC budget of each script context, see SetGCBudget. A shared state uses the game object budget
+    static const char* const GC_BUDGET_GO_KEY       = "script.gc_budget_go";
+    static const char* const GC_BUDGET_RENDER_KEY   = "script.gc_budget_render";
+    static const char* const GC_BUDGET_GUI_KEY      = "script.gc_budget_gui";
+
+    // Size classes of the Lua allocator are multiples of 16 bytes, up to LUA_ALLOCATOR_MAX_SMALL_SIZE
+    const uint32_t LUA_ALLOCATOR_SIZE_CLASS_COUNT = 16;
+    const uint32_t LUA_ALLOCATOR_MAX_SMALL_SIZE = LUA_ALLOCATOR_SIZE_CLASS_COUNT * 16;
+
+    struct LuaAllocatorStats
+    {
+        uint64_t m_Bytes;           // Bytes currently allocated by Lua
+        uint64_t m_PeakBytes;       // Highest m_Bytes since the allocator was created
+        uint64_t m_PageBytes;       // Bytes reserved for the size class pages
+        uint32_t m_AllocationCount; // Number of allocations since the last call to ResetLuaAllocatorCounters
+        uint32_t m_FreeCount;       // Number of frees since the last call to ResetLuaAllocatorCounters
+        uint64_t m_SizeClassBytes[LUA_ALLOCATOR_SIZE_CLASS_COUNT + 1]; // Bytes in use per size class, the last one is the large blocks
+    };
+
+    /**
+     * Get the memory statistics of the Lua state of a context. Each context has its own allocator.
+     * @param context script context
+     * @param out_stats receives the statistics
+     * @return false if the context uses the default Lua allocator (64 bit LuaJIT builds without GC64)
+     */
+    bool GetLuaAllocatorStats(HContext context, LuaAllocatorStats* out_stats);
+
+    /**
+     * Reset the allocation and free counters of the Lua state of a context
+     * @param context script context
+     */
+    void ResetLuaAllocatorCounters(HContext context);
+
     /**
      * Finalize script libraries
      * @param context script context
@@ -262,6 +321,57 @@ namespace dmScript
 
     void RegisterDDFDecoder(void* descriptor, MessageDecoder decoder);
 
+    /**
+     * Push the table of a message without a DDF descriptor (e.g. posted with msg.post) to the Lua stack.
+     * Tables posted to a script in the same Lua state (see META_TABLE_IS_SCRIPT_RECEIVER) are passed as a
+     * reference to a copy of the table. Other messages carry the table encoded, as read by PushTable.
+     * Pushes an empty table if the message has no data.
+     * @param L Lua state
+     * @param message the message
+     */
+    void PushMessageTable(lua_State* L, const dmMessage::Message* message);
+
+    /**
+     * Push a deep copy of a table, checked as by CheckTable with a buffer of buffer_size bytes, without encoding it.
+     * The same errors as CheckTable are raised. Vector, quat, matrix and url values are copied, the rest are shared.
+     * @param L Lua state
+     * @param index Index of the table
+     * @param buffer_size Largest allowed size of the serialized table
+     * @return Number of bytes required for the serialized table
+     */
+    uint32_t PushTableCopy(lua_State* L, int index, uint32_t buffer_size);
+
+    /**
+     * Serialize a table in a single pass, to a buffer owned by the module that grows as needed. The format is the same as for CheckTable.
+     * The buffer is reused, so the data is only valid until the next table is serialized.
+     * @param L Lua state
+     * @param index Index of the table
+     * @param out_buffer Receives the buffer
+     * @return Number of bytes used in the buffer
+     */
+    uint32_t SerializeTableTemp(lua_State* L, int index, const char** out_buffer);
+
+    /**
+     * Serialize a table to a buffer of the exact size. The format is the same as for CheckTable.
+     * @param L Lua state
+     * @param index Index of the table
+     * @param out_buffer Receives the buffer, which is owned by the caller and must be freed with dmMemory::AlignedFree
+     * @return Number of bytes used in the buffer
+     */
+    uint32_t SerializeTable(lua_State* L, int index, char** out_buffer);
+
+    /**
+     * Write a serialized table to a file, the way sys.save does. The data is written to a temporary
+     * file that replaces the target file on success. Safe to call from any thread.
+     * @param filename Path of the file to write
+     * @param data Serialized table
+     * @param data_size Size of the data in bytes
+     * @param error Receives a description of the error on failure
+     * @param error_size Size of the error buffer
+     * @return true if the file was written
+     */
+    bool WriteSaveFile(const char* filename, const char* data, uint32_t data_size, char* error, uint32_t error_size);
+
     /**
      * Removes a hash value from the currently known hashes.
      * @param L Lua state
@@ -524,6 +634,45 @@ namespace dmScript
      */
     Result AddModule(HContext context, dmLuaDDF::LuaSource *source, const char *script_name, void* resource, dmhash_t path_hash);
 
+    /**
+     * Loads the resource of a module added with AddLazyModule, when the module is first required
+     * @param context script context
+     * @param resource_path path of the module resource
+     * @param user_context user context passed to AddLazyModule
+     * @param resource [out] the module resource, released throught the resource system at finalization
+     * @param source [out] lua source of the module. Must stay valid until the function returns
+     * @return true on success
+     */
+    typedef bool (*FLoadModule)(HContext context, const char* resource_path, void* user_context, void** resource, dmLuaDDF::LuaSource** source);
+
+    /**
+     * Add a module without loading it. The module resource is loaded with the load_module callback
+     * on the first require of the module.
+     * @param context script context
+     * @param script_name script-name, see AddModule
+     * @param resource_path path of the module resource
+     * @param path_hash hashed canonical path of the module resource
+     * @param load_module callback that loads the module resource
+     * @param user_context user context passed to load_module
+     * @return RESULT_OK on success
+     */
+    Result AddLazyModule(HContext context, const char* script_name, const char* resource_path, dmhash_t path_hash, FLoadModule load_module, void* user_context);
+
+    /**
+     * Set if modules required by scripts in this context should be loaded on their first require,
+     * instead of with the scripts. See AddLazyModule.
+     * @param context script context
+     * @param lazy_modules true to load modules on their first require. Default is false
+     */
+    void SetLazyModules(HContext context, bool lazy_modules);
+
+    /**
+     * Check if modules are loaded on their first require, see SetLazyModules
+     * @param context script context
+     * @return true if modules are loaded on their first require
+     */
+    bool GetLazyModules(HContext context);
+
     /**
      * Reload loaded module
      * @param context script context
@@ -608,9 +757,50 @@ namespace dmScript
 
     /**
      * Wraps luaL_loadbuffer but takes dmLuaDDF::LuaSource instead of buffer directly.
+     * Source chunks are loaded through the bytecode cache of the script context, if it has one.
      */
     int LuaLoad(lua_State *L, dmLuaDDF::LuaSource* source);
 
+    typedef struct BytecodeCache* HBytecodeCache;
+
+    /**
+     * Create a cache of compiled Lua chunks, stored in a file on the device. Chunks loaded from source
+     * are compiled once and then loaded as bytecode on later launches, which skips the parser.
+     * The file is discarded if it was written by another engine version.
+     * @param path path of the cache file
+     * @param version engine version, e.g. the engine sha1
+     * @return cache handle
+     */
+    HBytecodeCache NewBytecodeCache(const char* path, const char* version);
+
+    /**
+     * Delete a bytecode cache. The cache isn't saved, see SaveBytecodeCache.
+     * @param cache cache handle
+     */
+    void DeleteBytecodeCache(HBytecodeCache cache);
+
+    /**
+     * Write the bytecode cache to its file, if chunks were added since it was loaded or last saved
+     * @param cache cache handle
+     * @return true on success
+     */
+    bool SaveBytecodeCache(HBytecodeCache cache);
+
+    /**
+     * Get the number of compiled chunks in the bytecode cache
+     * @param cache cache handle
+     * @return number of chunks
+     */
+    uint32_t GetBytecodeCacheEntryCount(HBytecodeCache cache);
+
+    /**
+     * Set the bytecode cache used when loading scripts and modules in the context. The cache can be
+     * shared between contexts, and must outlive them.
+     * @param context script context
+     * @param cache cache handle, 0 to load without a cache (default)
+     */
+    void SetBytecodeCache(HContext context, HBytecodeCache cache);
+
     /** Gets the number of references currently kept
      * @return the total number of references in the game
     */
@@ -0,0 +1,282 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "script_alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <dlib/math.h>
+#include <dlib/memory.h>
+
+namespace dmScript
+{
+    // Each size class allocates its blocks from pages of this size. The pages are aligned to their size,
+    // so that the page of a block is found from its address.
+    static const uint32_t PAGE_SIZE = 32 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* m_Next;
+    };
+
+    // Stored at the start of each page, followed by the blocks
+    struct Page
+    {
+        Page*       m_Prev;         // Links the pages of the size class that have free blocks
+        Page*       m_Next;
+        FreeBlock*  m_FreeList;
+        uint16_t    m_UsedCount;    // Number of blocks in use
+        uint16_t    m_SizeClass;
+    };
+
+    // Keeps the blocks 16 byte aligned
+    static const uint32_t PAGE_HEADER_SIZE = (sizeof(Page) + 15) & ~15;
+
+    struct LuaAllocator
+    {
+        Page*               m_Pages[LUA_ALLOCATOR_SIZE_CLASS_COUNT];            // Pages with free blocks
+        uint32_t            m_EmptyPageCount[LUA_ALLOCATOR_SIZE_CLASS_COUNT];   // Pages with no blocks in use, at most one is kept
+        LuaAllocatorStats   m_Stats;
+    };
+
+    static inline uint32_t GetSizeClass(size_t size)
+    {
+        return (uint32_t)((size + 15) / 16) - 1;
+    }
+
+    static inline bool IsSmall(size_t size)
+    {
+        return size <= LUA_ALLOCATOR_MAX_SMALL_SIZE;
+    }
+
+    static inline Page* GetPage(void* ptr)
+    {
+        return (Page*)((uintptr_t)ptr & ~(uintptr_t)(PAGE_SIZE - 1));
+    }
+
+    static void LinkPage(LuaAllocator* allocator, Page* page)
+    {
+        Page*& head = allocator->m_Pages[page->m_SizeClass];
+        page->m_Prev = 0;
+        page->m_Next = head;
+        if (head)
+            head->m_Prev = page;
+        head = page;
+    }
+
+    static void UnlinkPage(LuaAllocator* allocator, Page* page)
+    {
+        if (page->m_Prev)
+            page->m_Prev->m_Next = page->m_Next;
+        else
+            allocator->m_Pages[page->m_SizeClass] = page->m_Next;
+        if (page->m_Next)
+            page->m_Next->m_Prev = page->m_Prev;
+    }
+
+    static Page* NewPage(LuaAllocator* allocator, uint32_t size_class)
+    {
+        uint8_t* memory = 0;
+        if (dmMemory::AlignedMalloc((void**)&memory, PAGE_SIZE, PAGE_SIZE) != dmMemory::RESULT_OK)
+            return 0;
+
+        Page* page = (Page*)memory;
+        page->m_UsedCount = 0;
+        page->m_SizeClass = (uint16_t)size_class;
+
+        uint32_t block_size = (size_class + 1) * 16;
+        uint32_t block_count = (PAGE_SIZE - PAGE_HEADER_SIZE) / block_size;
+        FreeBlock* head = 0;
+        for (uint32_t i = block_count; i > 0; --i)
+        {
+            FreeBlock* block = (FreeBlock*)(memory + PAGE_HEADER_SIZE + (i - 1) * block_size);
+            block->m_Next = head;
+            head = block;
+        }
+        page->m_FreeList = head;
+
+        LinkPage(allocator, page);
+        allocator->m_EmptyPageCount[size_class]++;
+        allocator->m_Stats.m_PageBytes += PAGE_SIZE;
+        return page;
+    }
+
+    static void DeletePage(LuaAllocator* allocator, Page* page)
+    {
+        UnlinkPage(allocator, page);
+        allocator->m_Stats.m_PageBytes -= PAGE_SIZE;
+        dmMemory::AlignedFree(page);
+    }
+
+    HLuaAllocator NewLuaAllocator()
+    {
+        LuaAllocator* allocator = new LuaAllocator;
+        memset(allocator->m_Pages, 0, sizeof(allocator->m_Pages));
+        memset(allocator->m_EmptyPageCount, 0, sizeof(allocator->m_EmptyPageCount));
+        memset(&allocator->m_Stats, 0, sizeof(allocator->m_Stats));
+        return allocator;
+    }
+
+    void DeleteLuaAllocator(HLuaAllocator allocator)
+    {
+        // The Lua state is closed at this point, so the pages have no blocks in use and all of them have free blocks
+        for (uint32_t i = 0; i < LUA_ALLOCATOR_SIZE_CLASS_COUNT; ++i)
+        {
+            while (allocator->m_Pages[i])
+            {
+                DeletePage(allocator, allocator->m_Pages[i]);
+            }
+        }
+        delete allocator;
+    }
+
+    static void* Allocate(LuaAllocator* allocator, size_t size)
+    {
+        void* ptr;
+        uint32_t size_class;
+        if (IsSmall(size))
+        {
+            size_class = GetSizeClass(size);
+            Page* page = allocator->m_Pages[size_class];
+            if (!page)
+            {
+                page = NewPage(allocator, size_class);
+                if (!page)
+                    return 0;
+            }
+            FreeBlock* block = page->m_FreeList;
+            page->m_FreeList = block->m_Next;
+            if (page->m_UsedCount++ == 0)
+                allocator->m_EmptyPageCount[size_class]--;
+            if (!page->m_FreeList)
+                UnlinkPage(allocator, page);
+            ptr = block;
+        }
+        else
+        {
+            size_class = LUA_ALLOCATOR_SIZE_CLASS_COUNT;
+            ptr = malloc(size);
+            if (!ptr)
+                return 0;
+        }
+
+        LuaAllocatorStats& stats = allocator->m_Stats;
+        stats.m_AllocationCount++;
+        stats.m_Bytes += size;
+        stats.m_SizeClassBytes[size_class] += size;
+        if (stats.m_Bytes > stats.m_PeakBytes)
+            stats.m_PeakBytes = stats.m_Bytes;
+        return ptr;
+    }
+
+    static void Free(LuaAllocator* allocator, void* ptr, size_t size)
+    {
+        uint32_t size_class;
+        if (IsSmall(size))
+        {
+            size_class = GetSizeClass(size);
+            Page* page = GetPage(ptr);
+            FreeBlock* block = (FreeBlock*)ptr;
+            if (!page->m_FreeList)
+                LinkPage(allocator, page);
+            block->m_Next = page->m_FreeList;
+            page->m_FreeList = block;
+
+            // One empty page is kept per size class, so that a block freed and allocated again doesn't release and allocate a page
+            if (--page->m_UsedCount == 0)
+            {
+                if (allocator->m_EmptyPageCount[size_class] > 0)
+                    DeletePage(allocator, page);
+                else
+                    allocator->m_EmptyPageCount[size_class]++;
+            }
+        }
+        else
+        {
+            size_class = LUA_ALLOCATOR_SIZE_CLASS_COUNT;
+            free(ptr);
+        }
+
+        LuaAllocatorStats& stats = allocator->m_Stats;
+        stats.m_FreeCount++;
+        stats.m_Bytes -= size;
+        stats.m_SizeClassBytes[size_class] -= size;
+    }
+
+    void* LuaAlloc(void* user_data, void* ptr, size_t old_size, size_t new_size)
+    {
+        LuaAllocator* allocator = (LuaAllocator*)user_data;
+
+        if (new_size == 0)
+        {
+            if (ptr)
+                Free(allocator, ptr, old_size);
+            return 0;
+        }
+
+        if (ptr == 0)
+        {
+            return Allocate(allocator, new_size);
+        }
+
+        LuaAllocatorStats& stats = allocator->m_Stats;
+        if (IsSmall(old_size) && IsSmall(new_size))
+        {
+            uint32_t old_class = GetSizeClass(old_size);
+            uint32_t new_class = GetSizeClass(new_size);
+            if (old_class == new_class)
+            {
+                int64_t delta = (int64_t)new_size - (int64_t)old_size;
+                stats.m_Bytes += delta;
+                stats.m_SizeClassBytes[new_class] += delta;
+                if (stats.m_Bytes > stats.m_PeakBytes)
+                    stats.m_PeakBytes = stats.m_Bytes;
+                return ptr;
+            }
+        }
+        else if (!IsSmall(old_size) && !IsSmall(new_size))
+        {
+            void* new_ptr = realloc(ptr, new_size);
+            if (!new_ptr)
+                return 0;
+            stats.m_AllocationCount++;
+            int64_t delta = (int64_t)new_size - (int64_t)old_size;
+            stats.m_Bytes += delta;
+            stats.m_SizeClassBytes[LUA_ALLOCATOR_SIZE_CLASS_COUNT] += delta;
+            if (stats.m_Bytes > stats.m_PeakBytes)
+                stats.m_PeakBytes = stats.m_Bytes;
+            return new_ptr;
+        }
+
+        // Moving between size classes, or between the pages and the system allocator
+        void* new_ptr = Allocate(allocator, new_size);
+        if (!new_ptr)
+            return 0;
+        memcpy(new_ptr, ptr, dmMath::Min(old_size, new_size));
+        Free(allocator, ptr, old_size);
+        return new_ptr;
+    }
+
+    void GetLuaAllocatorStats(HLuaAllocator allocator, LuaAllocatorStats* out_stats)
+    {
+        *out_stats = allocator->m_Stats;
+    }
+
+    void ResetLuaAllocatorCounters(HLuaAllocator allocator)
+    {
+        allocator->m_Stats.m_AllocationCount = 0;
+        allocator->m_Stats.m_FreeCount = 0;
+    }
+}
@@ -0,0 +1,40 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SCRIPT_ALLOC_H
+#define DM_SCRIPT_ALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "script.h"
+
+namespace dmScript
+{
+    // Lua allocator (lua_Alloc) with free lists per size class for the small blocks Lua churns (strings, tables, closures, userdata).
+    // Blocks are carved from pages, and a page is released when its blocks are freed (one empty page per size class is kept).
+    // Larger blocks use the system allocator. Each script context has its own allocator.
+    typedef struct LuaAllocator* HLuaAllocator;
+
+    HLuaAllocator NewLuaAllocator();
+    void DeleteLuaAllocator(HLuaAllocator allocator);
+
+    // The lua_Alloc function, with the allocator as user data
+    void* LuaAlloc(void* user_data, void* ptr, size_t old_size, size_t new_size);
+
+    void GetLuaAllocatorStats(HLuaAllocator allocator, LuaAllocatorStats* out_stats);
+    void ResetLuaAllocatorCounters(HLuaAllocator allocator);
+}
+
+#endif // DM_SCRIPT_ALLOC_H
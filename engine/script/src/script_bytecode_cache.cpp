@@ -0,0 +1,305 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "script.h"
+#include "script_private.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dlib/array.h>
+#include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/hashtable.h>
+#include <dlib/log.h>
+#include <dlib/math.h>
+#include <dlib/mutex.h>
+#include <dlib/path.h>
+#include <dlib/sys.h>
+
+extern "C"
+{
+#include <lua/lua.h>
+#include <lua/lauxlib.h>
+}
+
+namespace dmScript
+{
+    // File layout: a BytecodeCacheHeader followed by m_EntryCount entries. Each entry is a
+    // BytecodeCacheEntryHeader followed by m_Size bytes of bytecode. All values are native endian,
+    // since the file never leaves the device.
+    static const uint32_t BYTECODE_CACHE_MAGIC = 0x43424d44; // "DMBC"
+    static const uint32_t BYTECODE_CACHE_FORMAT_VERSION = 1;
+    // Chunks are no longer added once the cache holds this many bytes of bytecode
+    static const uint32_t BYTECODE_CACHE_MAX_SIZE = 16 * 1024 * 1024;
+
+    struct BytecodeCacheHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_FormatVersion;
+        uint64_t m_VersionHash;
+        uint32_t m_PointerSize;
+        uint32_t m_EntryCount;
+    };
+
+    struct BytecodeCacheEntryHeader
+    {
+        uint64_t m_Key;
+        uint32_t m_Size;
+        uint32_t m_Checksum;
+    };
+
+    struct BytecodeCacheEntry
+    {
+        char*    m_Data;
+        uint32_t m_Size;
+    };
+
+    struct BytecodeCache
+    {
+        dmMutex::HMutex                         m_Mutex;
+        dmHashTable64<BytecodeCacheEntry>       m_Entries;
+        char*                                   m_Path;
+        uint64_t                                m_VersionHash;
+        uint32_t                                m_Size;
+        bool                                    m_Dirty;
+    };
+
+    static void PutEntry(BytecodeCache* cache, uint64_t key, char* data, uint32_t size)
+    {
+        if (cache->m_Entries.Full())
+        {
+            cache->m_Entries.SetCapacity(dmMath::Max(127U, cache->m_Entries.Capacity() / 2), cache->m_Entries.Capacity() + 128);
+        }
+        BytecodeCacheEntry entry;
+        entry.m_Data = data;
+        entry.m_Size = size;
+        cache->m_Entries.Put(key, entry);
+        cache->m_Size += size;
+    }
+
+    static void ReadCacheFile(BytecodeCache* cache)
+    {
+        FILE* file = fopen(cache->m_Path, "rb");
+        if (!file)
+        {
+            return;
+        }
+
+        BytecodeCacheHeader header;
+        bool valid = fread(&header, 1, sizeof(header), file) == sizeof(header)
+                  && header.m_Magic == BYTECODE_CACHE_MAGIC
+                  && header.m_FormatVersion == BYTECODE_CACHE_FORMAT_VERSION
+                  && header.m_VersionHash == cache->m_VersionHash
+                  && header.m_PointerSize == sizeof(void*);
+
+        for (uint32_t i = 0; valid && i < header.m_EntryCount; ++i)
+        {
+            BytecodeCacheEntryHeader entry;
+            if (fread(&entry, 1, sizeof(entry), file) != sizeof(entry) ||
+                entry.m_Size == 0 || cache->m_Size + entry.m_Size > BYTECODE_CACHE_MAX_SIZE)
+            {
+                valid = false;
+                break;
+            }
+
+            char* data = (char*) malloc(entry.m_Size);
+            if (fread(data, 1, entry.m_Size, file) != entry.m_Size ||
+                dmHashBuffer32(data, entry.m_Size) != entry.m_Checksum)
+            {
+                free(data);
+                valid = false;
+                break;
+            }
+            PutEntry(cache, entry.m_Key, data, entry.m_Size);
+        }
+        fclose(file);
+
+        if (!valid)
+        {
+            // Written by another engine version, or truncated. Keep the entries read so far,
+            // and rewrite the file with the entries added this session.
+            cache->m_Dirty = true;
+        }
+    }
+
+    HBytecodeCache NewBytecodeCache(const char* path, const char* version)
+    {
+        BytecodeCache* cache = new BytecodeCache();
+        cache->m_Mutex = dmMutex::New();
+        cache->m_Entries.SetCapacity(127, 256);
+        cache->m_Path = strdup(path);
+        cache->m_VersionHash = dmHashString64(version);
+        cache->m_Size = 0;
+        cache->m_Dirty = false;
+        ReadCacheFile(cache);
+        return cache;
+    }
+
+    static void FreeEntryCallback(void* context, const uint64_t* key, BytecodeCacheEntry* value)
+    {
+        free(value->m_Data);
+    }
+
+    void DeleteBytecodeCache(HBytecodeCache cache)
+    {
+        cache->m_Entries.Iterate(&FreeEntryCallback, (void*) 0);
+        free(cache->m_Path);
+        dmMutex::Delete(cache->m_Mutex);
+        delete cache;
+    }
+
+    struct WriteEntryContext
+    {
+        FILE* m_File;
+        bool  m_Result;
+    };
+
+    static void WriteEntryCallback(WriteEntryContext* context, const uint64_t* key, BytecodeCacheEntry* value)
+    {
+        BytecodeCacheEntryHeader entry;
+        entry.m_Key = *key;
+        entry.m_Size = value->m_Size;
+        entry.m_Checksum = dmHashBuffer32(value->m_Data, value->m_Size);
+        context->m_Result = context->m_Result
+                         && fwrite(&entry, 1, sizeof(entry), context->m_File) == sizeof(entry)
+                         && fwrite(value->m_Data, 1, value->m_Size, context->m_File) == value->m_Size;
+    }
+
+    bool SaveBytecodeCache(HBytecodeCache cache)
+    {
+        DM_MUTEX_SCOPED_LOCK(cache->m_Mutex);
+        if (!cache->m_Dirty)
+        {
+            return true;
+        }
+
+        // Write to a temporary file first, so that a crash mid-write never leaves a truncated cache behind
+        char tmp_path[DMPATH_MAX_PATH];
+        dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache->m_Path);
+        FILE* file = fopen(tmp_path, "wb");
+        if (!file)
+        {
+            dmLogWarning("Unable to write the bytecode cache to '%s'", tmp_path);
+            return false;
+        }
+
+        BytecodeCacheHeader header;
+        header.m_Magic = BYTECODE_CACHE_MAGIC;
+        header.m_FormatVersion = BYTECODE_CACHE_FORMAT_VERSION;
+        header.m_VersionHash = cache->m_VersionHash;
+        header.m_PointerSize = sizeof(void*);
+        header.m_EntryCount = cache->m_Entries.Size();
+
+        WriteEntryContext context;
+        context.m_File = file;
+        context.m_Result = fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+        cache->m_Entries.Iterate(&WriteEntryCallback, &context);
+        bool result = (fclose(file) == 0) && context.m_Result;
+
+        if (!result || dmSys::Rename(cache->m_Path, tmp_path) != dmSys::RESULT_OK)
+        {
+            dmSys::Unlink(tmp_path);
+            dmLogWarning("Unable to write the bytecode cache to '%s'", cache->m_Path);
+            return false;
+        }
+        cache->m_Dirty = false;
+        return true;
+    }
+
+    uint32_t GetBytecodeCacheEntryCount(HBytecodeCache cache)
+    {
+        DM_MUTEX_SCOPED_LOCK(cache->m_Mutex);
+        return cache->m_Entries.Size();
+    }
+
+    void SetBytecodeCache(HContext context, HBytecodeCache cache)
+    {
+        context->m_BytecodeCache = cache;
+    }
+
+    static int WriteChunk(lua_State* L, const void* p, size_t size, void* user_data)
+    {
+        dmArray<char>* buffer = (dmArray<char>*) user_data;
+        if (buffer->Remaining() < size)
+        {
+            buffer->OffsetCapacity(dmMath::Max((uint32_t) size, buffer->Capacity()));
+        }
+        buffer->PushArray((const char*) p, (uint32_t) size);
+        return 0;
+    }
+
+    int LoadBuffer(lua_State* L, HBytecodeCache cache, const char* buf, uint32_t size, const char* chunkname)
+    {
+        // Chunks that are already bytecode (they start with an escape character) are loaded as they are
+        if (cache == 0 || size == 0 || buf[0] == '\033')
+        {
+            return luaL_loadbuffer(L, buf, size, chunkname);
+        }
+
+        HashState64 hash_state;
+        dmHashInit64(&hash_state, false);
+        dmHashUpdateBuffer64(&hash_state, chunkname, strlen(chunkname));
+        dmHashUpdateBuffer64(&hash_state, buf, size);
+        uint64_t key = dmHashFinal64(&hash_state);
+
+        BytecodeCacheEntry entry;
+        entry.m_Data = 0;
+        {
+            DM_MUTEX_SCOPED_LOCK(cache->m_Mutex);
+            BytecodeCacheEntry* cached = cache->m_Entries.Get(key);
+            if (cached)
+            {
+                entry = *cached;
+            }
+        }
+
+        // Entries are only freed with the cache, so the data stays valid after unlocking
+        if (entry.m_Data)
+        {
+            if (luaL_loadbuffer(L, entry.m_Data, entry.m_Size, chunkname) == 0)
+            {
+                return 0;
+            }
+            dmLogWarning("Unable to load cached bytecode for '%s': %s", chunkname, lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return luaL_loadbuffer(L, buf, size, chunkname);
+        }
+
+        int ret = luaL_loadbuffer(L, buf, size, chunkname);
+        if (ret != 0)
+        {
+            return ret;
+        }
+
+        // The compiled chunk is on top of the stack. lua_dump keeps the debug info, so line numbers
+        // in tracebacks are the same as when loading from source.
+        dmArray<char> bytecode;
+        if (lua_dump(L, WriteChunk, &bytecode) != 0 || bytecode.Empty())
+        {
+            return 0;
+        }
+
+        DM_MUTEX_SCOPED_LOCK(cache->m_Mutex);
+        if (cache->m_Entries.Get(key) == 0 && cache->m_Size + bytecode.Size() <= BYTECODE_CACHE_MAX_SIZE)
+        {
+            char* data = (char*) malloc(bytecode.Size());
+            memcpy(data, bytecode.Begin(), bytecode.Size());
+            PutEntry(cache, key, data, bytecode.Size());
+            cache->m_Dirty = true;
+        }
+        return 0;
+    }
+}
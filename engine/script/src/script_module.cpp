@@ -60,7 +60,8 @@ namespace dmScript
         const char *buf;
         uint32_t size;
         GetLuaSource(source, &buf, &size);
-        return luaL_loadbuffer(L, buf, size, source->m_Filename);
+        HContext context = GetScriptContext(L);
+        return LoadBuffer(L, context ? context->m_BytecodeCache : 0, buf, size, source->m_Filename);
     }
 
     static bool LuaLoadModule(lua_State *L, const char *buf, uint32_t size, const char *filename)
@@ -68,7 +69,8 @@ namespace dmScript
         int top = lua_gettop(L);
         (void) top;
 
-        int ret = luaL_loadbuffer(L, buf, size, filename);
+        HContext context = GetScriptContext(L);
+        int ret = LoadBuffer(L, context ? context->m_BytecodeCache : 0, buf, size, filename);
         if (ret == 0)
         {
             assert(top + 1 == lua_gettop(L));
@@ -85,6 +87,44 @@ namespace dmScript
         return true;
     }
 
+    static void SetModuleSource(Module* module, dmLuaDDF::LuaSource* source, void* resource)
+    {
+        const char *buf;
+        uint32_t size;
+        GetLuaSource(source, &buf, &size);
+
+        module->m_Script = (char*) malloc(size);
+        module->m_ScriptSize = size;
+        memcpy(module->m_Script, buf, size);
+
+        module->m_Resource = resource;
+        module->m_Filename = strdup(source->m_Filename);
+    }
+
+    // Loads the resource of a module added with AddLazyModule
+    static Module* LoadLazyModule(HContext context, dmhash_t name_hash)
+    {
+        Module* module = context->m_Modules.Get(name_hash);
+        char* resource_path = module->m_ResourcePath;
+        FLoadModule load_module = module->m_LoadModule;
+        void* load_module_context = module->m_LoadModuleContext;
+
+        void* resource = 0;
+        dmLuaDDF::LuaSource* source = 0;
+        // The callback adds the sub modules of the module, which may grow the module table
+        if (!load_module(context, resource_path, load_module_context, &resource, &source))
+        {
+            dmLogError("Unable to load module resource '%s'", resource_path);
+            return 0;
+        }
+
+        module = context->m_Modules.Get(name_hash);
+        SetModuleSource(module, source, resource);
+        free(module->m_ResourcePath);
+        module->m_ResourcePath = 0;
+        return module;
+    }
+
     static int LoadModule(lua_State *L) {
         int top = lua_gettop(L);
         (void) top;
@@ -102,6 +142,15 @@ namespace dmScript
             return 1;
         }
 
+        if (module->m_Script == 0)
+        {
+            module = LoadLazyModule(context, name_hash);
+            if (module == 0)
+            {
+                return luaL_error(L, "error loading module '%s'", name);
+            }
+        }
+
         if (!LuaLoadModule(L, module->m_Script, module->m_ScriptSize, module->m_Filename))
         {
             luaL_error(L, "error loading module '%s'from file '%s':\n\t%s",
@@ -111,36 +160,54 @@ namespace dmScript
         return 1;
     }
 
+    static Result PutModule(HContext context, dmhash_t module_hash, dmhash_t path_hash, const Module& module)
+    {
+        if (context->m_Modules.Full())
+        {
+            context->m_Modules.SetCapacity(127, context->m_Modules.Capacity() + 128);
+            context->m_PathToModule.SetCapacity(127, context->m_PathToModule.Capacity() + 128);
+        }
+
+        context->m_Modules.Put(module_hash, module);
+        context->m_PathToModule.Put(path_hash, module_hash);
+
+        return RESULT_OK;
+    }
+
     Result AddModule(HContext context, dmLuaDDF::LuaSource *source, const char *script_name, void* resource, dmhash_t path_hash)
     {
         dmhash_t module_hash = dmHashString64(script_name);
 
-
         Module module;
+        memset(&module, 0, sizeof(module));
         module.m_Name = strdup(script_name);
+        SetModuleSource(&module, source, resource);
 
-        const char *buf;
-        uint32_t size;
-        GetLuaSource(source, &buf, &size);
+        return PutModule(context, module_hash, path_hash, module);
+    }
 
-        module.m_Script = (char*) malloc(size);
-        module.m_ScriptSize = size;
-        memcpy(module.m_Script, buf, size);
+    Result AddLazyModule(HContext context, const char* script_name, const char* resource_path, dmhash_t path_hash, FLoadModule load_module, void* user_context)
+    {
+        dmhash_t module_hash = dmHashString64(script_name);
 
-        module.m_Resource = resource;
-        module.m_Filename = strdup(source->m_Filename);
+        Module module;
+        memset(&module, 0, sizeof(module));
+        module.m_Name = strdup(script_name);
+        module.m_ResourcePath = strdup(resource_path);
+        module.m_LoadModule = load_module;
+        module.m_LoadModuleContext = user_context;
 
-        if (context->m_Modules.Full())
-        {
-            context->m_Modules.SetCapacity(127, context->m_Modules.Capacity() + 128);
-            context->m_PathToModule.SetCapacity(127, context->m_PathToModule.Capacity() + 128);
-        }
+        return PutModule(context, module_hash, path_hash, module);
+    }
 
-        context->m_Modules.Put(module_hash, module);
-        Module* module_handle = context->m_Modules.Get(module_hash);
-        context->m_PathToModule.Put(path_hash, module_handle);
+    void SetLazyModules(HContext context, bool lazy_modules)
+    {
+        context->m_LazyModules = lazy_modules;
+    }
 
-        return RESULT_OK;
+    bool GetLazyModules(HContext context)
+    {
+        return context->m_LazyModules;
     }
 
     Result ReloadModule(HContext context, dmLuaDDF::LuaSource *source, dmhash_t path_hash)
@@ -149,12 +216,17 @@ namespace dmScript
         int top = lua_gettop(L);
         (void) top;
 
-        Module** module_handle = context->m_PathToModule.Get(path_hash);
-        if (module_handle == 0)
+        dmhash_t* module_hash = context->m_PathToModule.Get(path_hash);
+        if (module_hash == 0)
         {
             return RESULT_MODULE_NOT_LOADED;
         }
-        Module* module = *module_handle;
+        Module* module = context->m_Modules.Get(*module_hash);
+        if (module->m_Script == 0)
+        {
+            // A lazy module that hasn't been required yet, it loads the new version on the first require
+            return RESULT_OK;
+        }
 
         const char *buf;
         uint32_t size;
@@ -193,12 +265,14 @@ namespace dmScript
         free(value->m_Script);
         free(value->m_Name);
         free(value->m_Filename);
+        free(value->m_ResourcePath);
     }
 
     void ClearModules(HContext context)
     {
         context->m_Modules.Iterate(&FreeModuleCallback, (void*) context->m_ResourceFactory);
         context->m_Modules.Clear();
+        context->m_PathToModule.Clear();
     }
 
     bool ModuleLoaded(HContext context, const char* script_name)
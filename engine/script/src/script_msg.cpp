@@ -445,6 +445,49 @@ namespace dmScript
         return 1;
     }
 
+    // Payload of the messages that pass a table by reference within a Lua state
+    struct MessageTable
+    {
+        HContext    m_Context;
+        int         m_Ref;
+    };
+
+    static void DestroyMessageTable(dmMessage::Message* message)
+    {
+        MessageTable* table = (MessageTable*)message->m_Data;
+        Unref(table->m_Context->m_LuaState, LUA_REGISTRYINDEX, table->m_Ref);
+    }
+
+    void PushMessageTable(lua_State* L, const dmMessage::Message* message)
+    {
+        if (message->m_DestroyCallback == DestroyMessageTable)
+        {
+            const MessageTable* table = (const MessageTable*)message->m_Data;
+            if (GetScriptContext(L) == table->m_Context)
+            {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, table->m_Ref);
+                return;
+            }
+
+            // The receiver runs in another Lua state (e.g. a gui script), encode the table from the sending state.
+            // The size was checked when the message was posted.
+            lua_State* sender_L = table->m_Context->m_LuaState;
+            char DM_ALIGNED(16) data[MAX_MESSAGE_DATA_SIZE];
+            lua_rawgeti(sender_L, LUA_REGISTRYINDEX, table->m_Ref);
+            uint32_t data_size = CheckTable(sender_L, data, MAX_MESSAGE_DATA_SIZE, -1);
+            lua_pop(sender_L, 1);
+            PushTable(L, data, data_size);
+        }
+        else if (message->m_DataSize > 0)
+        {
+            PushTable(L, (const char*)message->m_Data, message->m_DataSize);
+        }
+        else
+        {
+            lua_newtable(L);
+        }
+    }
+
     /*# posts a message to a receiving URL
      *
      * Post a message to a receiving URL. The most common case is to send messages
@@ -501,7 +544,7 @@ namespace dmScript
 
         char DM_ALIGNED(16) data[MAX_MESSAGE_DATA_SIZE];
         uint32_t data_size = 0;
-
+        dmMessage::MessageDestroyCallback destroy_callback = 0;
 
         const dmDDF::Descriptor* desc = dmDDF::GetDescriptorFromHash(message_id);
         if (desc != 0)
@@ -526,13 +569,31 @@ namespace dmScript
         {
             if (!lua_isnil(L, 3))
             {
-                data_size = dmScript::CheckTable(L, data, MAX_MESSAGE_DATA_SIZE, 3);
+                // A script in the same Lua state gets a reference to a copy of the table, instead of it being encoded
+                // and decoded. Other receivers (e.g. native components) read the binary table with dmScript::PushTable
+                if (receiver.m_Socket == sender.m_Socket && receiver.m_Fragment != 0 && lua_istable(L, 3) && IsScriptReceiver(L, receiver))
+                {
+                    dmScript::PushTableCopy(L, 3, MAX_MESSAGE_DATA_SIZE);
+                    MessageTable* table = (MessageTable*)data;
+                    table->m_Context = GetScriptContext(L);
+                    table->m_Ref = Ref(L, LUA_REGISTRYINDEX);
+                    data_size = sizeof(MessageTable);
+                    destroy_callback = DestroyMessageTable;
+                }
+                else
+                {
+                    data_size = dmScript::CheckTable(L, data, MAX_MESSAGE_DATA_SIZE, 3);
+                }
             }
         }
 
         assert(top == lua_gettop(L));
 
-        dmMessage::Result result = dmMessage::Post(&sender, &receiver, message_id, 0, (uintptr_t) desc, data, data_size, 0);
+        dmMessage::Result result = dmMessage::Post(&sender, &receiver, message_id, 0, (uintptr_t) desc, data, data_size, destroy_callback);
+        if (result != dmMessage::RESULT_OK && destroy_callback)
+        {
+            Unref(L, LUA_REGISTRYINDEX, ((MessageTable*)data)->m_Ref);
+        }
         if (result == dmMessage::RESULT_SOCKET_NOT_FOUND)
         {
             char receiver_buffer[512];
@@ -16,6 +16,7 @@
 #define SCRIPT_PRIVATE_H
 
 #include <dlib/hashtable.h>
+#include "script_alloc.h"
 
 #define SCRIPT_MAIN_THREAD "__script_main_thread"
 #define SCRIPT_ERROR_HANDLER_VAR "__error_handler"
@@ -58,11 +59,14 @@ namespace dmScript
 
     struct Module
     {
-        char*       m_Script;
+        char*       m_Script;       // 0 until a lazy module is first required
         uint32_t    m_ScriptSize;
         char*       m_Name;
         void*       m_Resource;
         char*       m_Filename;
+        char*       m_ResourcePath; // Set while a lazy module isn't loaded yet
+        FLoadModule m_LoadModule;
+        void*       m_LoadModuleContext;
     };
 
     typedef struct ScriptExtension* HScriptExtension;
@@ -72,22 +76,33 @@ namespace dmScript
         dmConfigFile::HConfig       m_ConfigFile;
         dmResource::HFactory        m_ResourceFactory;
         dmHashTable64<Module>       m_Modules;
-        dmHashTable64<Module*>      m_PathToModule;
+        dmHashTable64<dmhash_t>     m_PathToModule; // Path hash to module name hash
         dmHashTable64<int>          m_HashInstances;
         dmArray<HScriptExtension>   m_ScriptExtensions;
         lua_State*                  m_LuaState;
+        HLuaAllocator               m_LuaAllocator; // 0 if the state uses the default allocator
+        HBytecodeCache              m_BytecodeCache;
         int                         m_ContextTableRef;
+        uint32_t                    m_GCBudget;     // Microseconds of incremental collection per frame, 0 if automatic
+        int                         m_GCPause;      // The collector pause to restore when the budget is removed
         bool                        m_EnableExtensions;
+        bool                        m_LazyModules;
     };
 
     HContext GetScriptContext(lua_State* L);
 
+    // Wraps luaL_loadbuffer. Source chunks are loaded from the bytecode cache if it has them, and added to it otherwise.
+    int LoadBuffer(lua_State* L, HBytecodeCache cache, const char* buf, uint32_t size, const char* chunkname);
+
     bool ResolvePath(lua_State* L, const char* path, uint32_t path_size, dmhash_t& out_hash);
 
     bool GetURL(lua_State* L, dmMessage::URL& out_url);
 
     bool IsValidInstance(lua_State* L);
 
+    // True if the receiver is a script in the same Lua state as the current instance (see META_TABLE_IS_SCRIPT_RECEIVER)
+    bool IsScriptReceiver(lua_State* L, const dmMessage::URL& receiver);
+
     /**
      * Remove all modules.
      * @param context script context
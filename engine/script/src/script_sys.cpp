@@ -39,6 +39,7 @@
 #include <dlib/socket.h>
 #include <dlib/path.h>
 #include <dlib/align.h>
+#include <dlib/atomic.h>
 #include <dlib/memory.h>
 #include <resource/resource.h>
 #include "script.h"
@@ -100,116 +101,118 @@ union SaveLoadBuffer
         }
     }
 
-    /*# saves a lua table to a file stored on disk
-     * The table can later be loaded by <code>sys.load</code>.
-     * Use <code>sys.get_save_file</code> to obtain a valid location for the file.
-     * Internally, this function uses a workspace buffer sized output file sized 512kb.
-     * This size reflects the output file size which must not exceed this limit.
-     * Additionally, the total number of rows that any one table may contain is limited to 65536
-     * (i.e. a 16 bit range). When tables are used to represent arrays, the values of
-     * keys are permitted to fall within a 32 bit range, supporting sparse arrays, however
-     * the limit on the total number of rows remains in effect.
-     *
-     * @name sys.save
-     * @param filename [type:string] file to write to
-     * @param table [type:table] lua table to save
-     * @return success [type:boolean] a boolean indicating if the table could be saved or not
-     * @examples
-     *
-     * Save data:
-     *
-     * ```lua
-     * local my_table = {}
-     * table.insert(my_table, "my_value")
-     * local my_file_path = sys.get_save_file("my_game", "my_file")
-     * if not sys.save(my_file_path, my_table) then
-     *   -- Alert user that the data could not be saved
-     * end
-     * ```
-     */
-
-    static int Sys_Save(lua_State* L)
+    bool WriteSaveFile(const char* filename, const char* data, uint32_t data_size, char* error, uint32_t error_size)
     {
-        const char* filename = luaL_checkstring(L, 1);
-
-        luaL_checktype(L, 2, LUA_TTABLE);
-
-        uint32_t table_size = CheckTableSize(L, 2);
-
-        char* buffer = Sys_SetupTableSerializationBuffer(table_size);
-        if (!buffer)
-        {
-            return luaL_error(L, "Could not allocate %d bytes for table serialization.", table_size);
-        }
-        uint32_t n_used = CheckTable(L, buffer, table_size, 2);
-
 #if !defined(__EMSCRIPTEN__)
 
         char tmp_filename[DMPATH_MAX_PATH];
         // The counter and hash are there to make the files unique enough to avoid that the user
         // accidentally writes to it.
-        static int save_counter = 0;
+        static int32_atomic_t save_counter = 0;
         uint32_t hash = dmHashString32(filename);
-        int res = dmSnPrintf(tmp_filename, sizeof(tmp_filename), "%s.defoldtmp_%x_%d", filename, hash, save_counter++);
+        int res = dmSnPrintf(tmp_filename, sizeof(tmp_filename), "%s.defoldtmp_%x_%d", filename, hash, dmAtomicIncrement32(&save_counter));
         if (res == -1)
         {
-            Sys_FreeTableSerializationBuffer(buffer);
-            return luaL_error(L, "Could not write to the file %s. Path too long.", filename);
+            dmSnPrintf(error, error_size, "Could not write to the file %s. Path too long.", filename);
+            return false;
         }
 
         FILE* file = fopen(tmp_filename, "wb");
         if (!file)
         {
-            Sys_FreeTableSerializationBuffer(buffer);
             #if !defined(DM_NO_ERRNO)
                 char errmsg[128] = {};
                 dmStrError(errmsg, sizeof(errmsg), errno);
-                return luaL_error(L, "Could not open the file %s, reason: %s.", tmp_filename, errmsg);
+                dmSnPrintf(error, error_size, "Could not open the file %s, reason: %s.", tmp_filename, errmsg);
             #else
-                return luaL_error(L, "Could not open the file %s", tmp_filename);
+                dmSnPrintf(error, error_size, "Could not open the file %s", tmp_filename);
             #endif
+            return false;
         }
 
-        bool result = fwrite(buffer, 1, n_used, file) == n_used;
+        bool result = fwrite(data, 1, data_size, file) == data_size;
         result = (fclose(file) == 0) && result;
-        Sys_FreeTableSerializationBuffer(buffer);
 
         if (!result)
         {
             dmSys::Unlink(tmp_filename);
-            return luaL_error(L, "Could not write to the file %s.", filename);
+            dmSnPrintf(error, error_size, "Could not write to the file %s.", filename);
+            return false;
         }
 
         if (dmSys::Rename(filename, tmp_filename) != dmSys::RESULT_OK)
         {
-            return luaL_error(L, "Could not rename %s to the file %s.", tmp_filename, filename);
+            dmSnPrintf(error, error_size, "Could not rename %s to the file %s.", tmp_filename, filename);
+            return false;
         }
-
-        lua_pushboolean(L, result);
-        return 1;
+        return true;
 
 #else // __EMSCRIPTEN__
 
         FILE* file = fopen(filename, "wb");
         if (!file)
         {
-            Sys_FreeTableSerializationBuffer(buffer);
-            return luaL_error(L, "Could not write to the file %s.", filename);
+            dmSnPrintf(error, error_size, "Could not write to the file %s.", filename);
+            return false;
         }
 
-        bool result = fwrite(buffer, 1, n_used, file) == n_used;
+        bool result = fwrite(data, 1, data_size, file) == data_size;
         result = (fclose(file) == 0) && result;
-        Sys_FreeTableSerializationBuffer(buffer);
 
         if (!result)
         {
             dmSys::Unlink(filename);
-            return luaL_error(L, "Could not write to the file %s.", filename);
+            dmSnPrintf(error, error_size, "Could not write to the file %s.", filename);
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    /*# saves a lua table to a file stored on disk
+     * The table can later be loaded by <code>sys.load</code>.
+     * Use <code>sys.get_save_file</code> to obtain a valid location for the file.
+     * The file is written before the function returns, use <code>sys.save_async</code>
+     * to write large tables without stalling the game.
+     * When tables are used to represent arrays, the values of keys are permitted to fall
+     * within a 32 bit range, supporting sparse arrays.
+     *
+     * @name sys.save
+     * @param filename [type:string] file to write to
+     * @param table [type:table] lua table to save
+     * @return success [type:boolean] a boolean indicating if the table could be saved or not
+     * @examples
+     *
+     * Save data:
+     *
+     * ```lua
+     * local my_table = {}
+     * table.insert(my_table, "my_value")
+     * local my_file_path = sys.get_save_file("my_game", "my_file")
+     * if not sys.save(my_file_path, my_table) then
+     *   -- Alert user that the data could not be saved
+     * end
+     * ```
+     */
+
+    static int Sys_Save(lua_State* L)
+    {
+        const char* filename = luaL_checkstring(L, 1);
+
+        luaL_checktype(L, 2, LUA_TTABLE);
+
+        const char* buffer = 0;
+        uint32_t n_used = SerializeTableTemp(L, 2, &buffer);
+
+        char error[512];
+        bool result = WriteSaveFile(filename, buffer, n_used, error, sizeof(error));
+        if (!result)
+        {
+            return luaL_error(L, "%s", error);
         }
 
         lua_pushboolean(L, result);
         return 1;
-#endif
     }
 
 
@@ -1339,16 +1342,9 @@ union SaveLoadBuffer
         DM_LUA_STACK_CHECK(L, 1);
         luaL_checktype(L, 1, LUA_TTABLE);
 
-        uint32_t table_size = CheckTableSize(L, 1);
-        char* buffer = Sys_SetupTableSerializationBuffer(table_size);
-        if (!buffer)
-        {
-            return luaL_error(L, "Could not allocate %d bytes for table serialization.", table_size);
-        }
-
-        uint32_t n_used = CheckTable(L, buffer, table_size, 1);
-        lua_pushlstring(L, (const char*)buffer, n_used);
-        Sys_FreeTableSerializationBuffer(buffer);
+        const char* buffer = 0;
+        uint32_t n_used = SerializeTableTemp(L, 1, &buffer);
+        lua_pushlstring(L, buffer, n_used);
         return 1;
 
     }
@@ -15,8 +15,11 @@
 #include <stdint.h>
 #include <string.h>
 #include <dlib/array.h>
+#include <dlib/hashtable.h>
 #include <dlib/log.h>
 #include <dlib/dstrings.h>
+#include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/static_assert.h>
 #include "script.h"
 #include "script_private.h"
@@ -31,11 +34,13 @@ extern "C"
 // the rest of the types used when serializing a table come from lua.h
 // make sure this type has a value quite a bit higher than the types in lua.h
 #define LUA_TNEGATIVENUMBER 64
+// custom type when writing a string that has already been written in the same payload
+#define LUA_TSTRINGREF 65
 
 namespace dmScript
 {
     const int TABLE_MAGIC = 0x42544448;
-    const uint32_t TABLE_VERSION_CURRENT = 4;
+    const uint32_t TABLE_VERSION_CURRENT = 5;
 
     /*
      * Original table serialization format:
@@ -85,6 +90,11 @@ namespace dmScript
      *
      *    Version 4:
      *    Adds support for more than 65535 keys in a table.
+     *
+     *    Version 5:
+     *    Each string (key or value) is written once per payload. The strings are numbered in the order they are
+     *    written, and later occurrences of a string are written with the type LUA_TSTRINGREF followed by the MSB
+     *    encoded number of the string.
      */
 
     struct TableHeader
@@ -183,6 +193,7 @@ namespace dmScript
         case 2:
         case 3:
         case 4:
+        case 5:
             supported = true;
             break;
         default:
@@ -215,7 +226,7 @@ namespace dmScript
                 luaL_error(L, "table too large");
             }
         }
-        else if ((3 == header.m_Version) || (4 == header.m_Version))
+        else if ((3 == header.m_Version) || (4 == header.m_Version) || (5 == header.m_Version))
         {
             if (buffer_end - buffer < 4)
                 luaL_error(L, "table too large");
@@ -236,22 +247,117 @@ namespace dmScript
         return buffer;
     }
 
-    // When storing/packing lua data to a byte array, we now use the binary lua string interface
-    static uint32_t SaveTSTRING(lua_State* L, int index, char* buffer, uint32_t buffer_size, const char* buffer_end, uint32_t count)
+    // Destination of a serialized table. The buffer either has a fixed size (CheckTable) or grows as needed (SerializeTable).
+    // A writer without a buffer only measures the payload (CheckTableSize, PushTableCopy).
+    struct TableWriter
+    {
+        char*       m_Buffer;
+        uint32_t    m_Size;         // Bytes written
+        uint32_t    m_Capacity;
+        bool        m_Growable;
+    };
+
+    // Size of the module buffer when first allocated, and the largest size it's kept at between calls
+    static const uint32_t TABLE_BUFFER_MIN_SIZE = 16 * 1024;
+    static const uint32_t TABLE_BUFFER_MAX_KEPT_SIZE = 1024 * 1024;
+
+    // The module buffer that tables are serialized into. It's reused between calls, and it's kept here while it's written to
+    // so that it isn't leaked when a Lua error is raised.
+    static char*    g_TableBuffer = 0;
+    static uint32_t g_TableBufferCapacity = 0;
+
+    // The strings written to the current payload, and their number. Lua strings are interned, so the key is the string pointer.
+    static dmHashTable<uintptr_t, uint32_t> g_TableStrings;
+
+    static char* Reserve(lua_State* L, TableWriter& writer, uint32_t size, const char* what, uint32_t count)
+    {
+        if (writer.m_Capacity - writer.m_Size < size)
+        {
+            if (!writer.m_Growable)
+            {
+                luaL_error(L, "buffer (%d bytes) too small for table, exceeded at %s for element #%d", writer.m_Capacity, what, count);
+            }
+
+            uint32_t capacity = dmMath::Max(writer.m_Capacity * 2, writer.m_Size + size);
+            char* buffer = 0;
+            if (dmMemory::AlignedMalloc((void**)&buffer, 16, capacity) != dmMemory::RESULT_OK)
+            {
+                luaL_error(L, "Could not allocate %d bytes for table serialization.", capacity);
+            }
+            memcpy(buffer, writer.m_Buffer, writer.m_Size);
+            dmMemory::AlignedFree(g_TableBuffer);
+            g_TableBuffer = buffer;
+            g_TableBufferCapacity = capacity;
+            writer.m_Buffer = buffer;
+            writer.m_Capacity = capacity;
+        }
+        if (writer.m_Buffer == 0)
+        {
+            // Measuring only. The callers write at most a few bytes to the reserved space, the rest goes through Write.
+            static char scratch[sizeof(uint32_t)];
+            return scratch;
+        }
+        return writer.m_Buffer + writer.m_Size;
+    }
+
+    static void WriteType(TableWriter& writer, uint32_t offset, char type)
+    {
+        if (writer.m_Buffer)
+        {
+            writer.m_Buffer[offset] = type;
+        }
+    }
+
+    // NOTE: We align lua_Number to sizeof(float) even if lua_Number probably is of double type
+    static void WriteAlignment(lua_State* L, TableWriter& writer, const char* what, uint32_t count)
+    {
+        uint32_t align_size = ((writer.m_Size + sizeof(float)-1) & ~(sizeof(float)-1)) - writer.m_Size;
+        char* buffer = Reserve(L, writer, align_size, what, count);
+#ifndef NDEBUG
+        memset(buffer, 0, align_size);
+#endif
+        (void)buffer;
+        writer.m_Size += align_size;
+    }
+
+    static void Write(lua_State* L, TableWriter& writer, const void* data, uint32_t size, const char* what, uint32_t count)
+    {
+        char* buffer = Reserve(L, writer, size, what, count);
+        if (writer.m_Buffer)
+        {
+            memcpy(buffer, data, size);
+        }
+        writer.m_Size += size;
+    }
+
+    // When storing/packing lua data to a byte array, we now use the binary lua string interface.
+    // A string that has already been written is replaced with a reference, and the type at type_offset is changed accordingly.
+    static void WriteString(lua_State* L, TableWriter& writer, int index, uint32_t type_offset, const char* what, uint32_t count)
     {
         size_t value_len = 0;
         const char* value = lua_tolstring(L, index, &value_len);
-        uint32_t total_size = value_len + sizeof(uint32_t);
-        if (buffer_end - buffer < (intptr_t)total_size)
+
+        uint32_t* string_number = g_TableStrings.Get((uintptr_t)value);
+        if (string_number)
         {
-            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at '%s' for element #%d", buffer_size, value, count);
+            char encoded[5];
+            char* end = encoded;
+            EncodeMSB(*string_number, end, encoded + sizeof(encoded));
+            Write(L, writer, encoded, end - encoded, what, count);
+            WriteType(writer, type_offset, (char) LUA_TSTRINGREF);
+            return;
         }
 
+        if (g_TableStrings.Full())
+        {
+            uint32_t capacity = g_TableStrings.Capacity() * 2;
+            g_TableStrings.SetCapacity((capacity * 2 / 3) | 1, capacity);
+        }
+        g_TableStrings.Put((uintptr_t)value, g_TableStrings.Size());
+
         uint32_t len = (uint32_t)value_len;
-        memcpy(buffer, &len, sizeof(uint32_t));
-        buffer += sizeof(uint32_t);
-        memcpy(buffer, value, value_len);
-        return total_size;
+        Write(L, writer, &len, sizeof(uint32_t), what, count);
+        Write(L, writer, value, len, what, count);
     }
 
     // When loading older save games, we will use the old unpack method (with truncated c strings)
@@ -314,7 +420,8 @@ namespace dmScript
         return false;
     }
 
-    uint32_t DoCheckTableSize(lua_State* L, int index, int parent_offset, dmArray<const void*>& table_stack)
+    // Writes the table at 'index'. If 'copy' is the stack index of a table, a copy of each key and value is also added to it.
+    static void DoCheckTable(lua_State* L, const TableHeader& header, TableWriter& writer, int index, dmArray<const void*>& table_stack, int copy)
     {
         int top = lua_gettop(L);
         (void)top;
@@ -324,155 +431,17 @@ namespace dmScript
         const void* table_data = (const void*)lua_topointer(L, index);
         if (StackContains(table_stack, table_data))
         {
-            return luaL_error(L, "Save table is recursive!");
+            luaL_error(L, "Save table is recursive!");
         }
         StackPush(table_stack, table_data);
 
         lua_pushvalue(L, index);
         lua_pushnil(L);
 
-        uint32_t size = 0;
-
-        // count
-        size += 4;
-        while (lua_next(L, -2) != 0)
-        {
-            int key_type = lua_type(L, -2);
-            int value_type = lua_type(L, -1);
-            if (key_type != LUA_TSTRING && key_type != LUA_TNUMBER)
-            {
-                luaL_error(L, "keys in table must be of type number or string (found %s)", lua_typename(L, key_type));
-            }
-
-            // key + value type
-            size += 2;
-            if (key_type == LUA_TSTRING)
-            {
-                size += sizeof(uint32_t) + lua_objlen(L, -2);
-            }
-            else if (key_type == LUA_TNUMBER)
-            {
-                size += 4;
-            }
-
-            switch (value_type)
-            {
-                case LUA_TBOOLEAN:
-                {
-                    size += 1;
-                }
-                break;
-
-                case LUA_TNUMBER:
-                {
-                    int offset = parent_offset + size;
-                    int aligned_offset = (offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    int align_size = aligned_offset - offset;
-                    size += align_size;
-                    size += sizeof(lua_Number);
-                }
-                break;
-
-                case LUA_TSTRING:
-                {
-                    size += sizeof(uint32_t) + lua_objlen(L, -1);
-                }
-                break;
-
-                case LUA_TUSERDATA:
-                {
-                    // subtype
-                    size += 1;
-
-                    int offset = parent_offset + size;
-                    int aligned_offset = (offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    int align_size = aligned_offset - offset;
-                    size += align_size;
-
-
-                    if (IsVector3(L, -1))
-                    {
-                        size += sizeof(float) * 3;
-                    }
-                    else if (IsVector4(L, -1))
-                    {
-                        size += sizeof(float) * 4;
-                    }
-                    else if (IsQuat(L, -1))
-                    {
-                        size += sizeof(float) * 4;
-                    }
-                    else if (IsMatrix4(L, -1))
-                    {
-                        size += sizeof(float) * 16;
-                    }
-                    else if (IsHash(L, -1))
-                    {
-                        size += sizeof(dmhash_t);
-                    }
-                    else if (IsURL(L, -1))
-                    {
-                        size += sizeof(dmMessage::URL);
-                    }
-                    else
-                    {
-                        luaL_error(L, "unsupported value type in table: %s", lua_typename(L, value_type));
-                    }
-                }
-                break;
-
-                case LUA_TTABLE:
-                {
-                    size += DoCheckTableSize(L, -1, parent_offset + size, table_stack);
-                }
-                break;
-
-                default:
-                    luaL_error(L, "unsupported value type in table: %s", lua_typename(L, value_type));
-                    break;
-            }
-
-            lua_pop(L, 1);
-        }
-        lua_pop(L, 1);
-
-        const void* p = StackPop(table_stack);
-        assert(p == table_data);
-        return size;
-    }
-
-    uint32_t CheckTableSize(lua_State* L, int index)
-    {
-        dmArray<const void*> table_stack;
-        uint32_t size = sizeof(TableHeader) + DoCheckTableSize(L, index, 0, table_stack);
-        return size;
-    }
-
-    uint32_t DoCheckTable(lua_State* L, const TableHeader& header, const char* original_buffer, char* buffer, uint32_t buffer_size, int index, dmArray<const void*>& table_stack)
-    {
-        int top = lua_gettop(L);
-        (void)top;
-
-        char* buffer_start = buffer;
-        char* buffer_end = buffer + buffer_size;
-        luaL_checktype(L, index, LUA_TTABLE);
-
-        const void* table_data = (const void*)lua_topointer(L, index);
-        if (StackContains(table_stack, table_data))
-        {
-            return luaL_error(L, "Save table is recursive!");
-        }
-        StackPush(table_stack, table_data);
-
-        lua_pushvalue(L, index);
-        lua_pushnil(L);
-
-        if (buffer_size < 4)
-        {
-            luaL_error(L, "table too large");
-        }
         // Make room for count (4 bytes)
-        buffer += 4;
+        uint32_t count_offset = writer.m_Size;
+        Reserve(L, writer, sizeof(uint32_t), "count", 0);
+        writer.m_Size += sizeof(uint32_t);
 
         uint32_t count = 0;
         while (lua_next(L, -2) != 0)
@@ -492,193 +461,111 @@ namespace dmScript
                 luaL_error(L, "keys in table must be of type number or string (found %s)", lua_typename(L, key_type));
             }
 
-            if (buffer_end - buffer < 2)
-            {
-                luaL_error(L, "buffer (%d bytes) too small for table, exceeded at key for element #%d", buffer_size, count);
-            }
+            uint32_t type_offset = writer.m_Size;
+            int sub_type = -1;
+            char* types = Reserve(L, writer, 2, "key", count);
+            types[1] = (char) value_type;
+            writer.m_Size += 2;
 
             if (key_type == LUA_TSTRING)
             {
-                (*buffer++) = (char) LUA_TSTRING;
-                (*buffer++) = (char) value_type;
-                buffer += SaveTSTRING(L, -2, buffer, buffer_size, buffer_end, count);
+                WriteType(writer, type_offset, (char) LUA_TSTRING);
+                WriteString(L, writer, -2, type_offset, "key", count);
             }
             else if (key_type == LUA_TNUMBER)
             {
                 lua_Number key = lua_tonumber(L, -2);
-                (*buffer++) = (char) (key >= 0 ? LUA_TNUMBER : LUA_TNEGATIVENUMBER);
-                (*buffer++) = (char) value_type;
-                buffer = WriteEncodedIndex(L, key, header, buffer, buffer_end);
+                WriteType(writer, type_offset, (char) (key >= 0 ? LUA_TNUMBER : LUA_TNEGATIVENUMBER));
+                char* buffer = Reserve(L, writer, sizeof(uint32_t), "key", count);
+                char* buffer_end = WriteEncodedIndex(L, key, header, buffer, buffer + sizeof(uint32_t));
+                writer.m_Size += buffer_end - buffer;
             }
 
             switch (value_type)
             {
                 case LUA_TBOOLEAN:
                 {
-                    if (buffer_end - buffer < 1)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-                    (*buffer++) = (char) lua_toboolean(L, -1);
+                    char value = (char) lua_toboolean(L, -1);
+                    Write(L, writer, &value, 1, "value", count);
                 }
                 break;
 
                 case LUA_TNUMBER:
                 {
-                    // NOTE: We align lua_Number to sizeof(float) even if lua_Number probably is of double type
-                    intptr_t offset = buffer - original_buffer;
-                    intptr_t aligned_buffer = ((intptr_t) offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    intptr_t align_size = aligned_buffer - (intptr_t) offset;
-
-                    if (buffer_end - buffer < align_size)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-#ifndef NDEBUG
-                    memset(buffer, 0, align_size);
-#endif
-                    buffer += align_size;
-
-                    if (buffer_end - buffer < int32_t(sizeof(lua_Number)) || buffer_end - buffer < align_size)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-                    union
-                    {
-                        lua_Number x;
-                        char buf[sizeof(lua_Number)];
-                    };
-
-                    x = lua_tonumber(L, -1);
-                    memcpy(buffer, buf, sizeof(lua_Number));
-                    buffer += sizeof(lua_Number);
+                    WriteAlignment(L, writer, "value", count);
+                    lua_Number value = lua_tonumber(L, -1);
+                    Write(L, writer, &value, sizeof(lua_Number), "value", count);
                 }
                 break;
 
                 case LUA_TSTRING:
                 {
-                    buffer += SaveTSTRING(L, -1, buffer, buffer_size, buffer_end, count);
+                    WriteString(L, writer, -1, type_offset + 1, "value", count);
                 }
                 break;
 
                 case LUA_TUSERDATA:
                 {
-                    if (buffer_end - buffer < 1)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-                    char* sub_type = buffer++;
-
-                    // NOTE: We align lua_Number to sizeof(float) even if lua_Number probably is of double type
-                    intptr_t offset = buffer - original_buffer;
-                    intptr_t aligned_buffer = ((intptr_t) offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    intptr_t align_size = aligned_buffer - (intptr_t) offset;
+                    uint32_t sub_type_offset = writer.m_Size;
+                    Reserve(L, writer, 1, "value", count);
+                    writer.m_Size += 1;
 
-                    if (buffer_end - buffer < align_size)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-#ifndef NDEBUG
-                    memset(buffer, 0, align_size);
-#endif
-                    buffer += align_size;
+                    WriteAlignment(L, writer, "value", count);
 
-                    float* f = (float*) (buffer);
+                    float f[16];
                     dmVMath::Vector3* v3;
                     dmVMath::Vector4* v4;
                     dmVMath::Quat* q;
                     dmVMath::Matrix4* m;
                     if ((v3 = ToVector3(L, -1)))
                     {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 3))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_VECTOR3;
-                        *f++ = v3->getX();
-                        *f++ = v3->getY();
-                        *f++ = v3->getZ();
-
-                        buffer += sizeof(float) * 3;
+                        sub_type = SUB_TYPE_VECTOR3;
+                        WriteType(writer, sub_type_offset, (char) sub_type);
+                        f[0] = v3->getX();
+                        f[1] = v3->getY();
+                        f[2] = v3->getZ();
+                        Write(L, writer, f, sizeof(float) * 3, "value", count);
                     }
                     else if ((v4 = ToVector4(L, -1)))
                     {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 4))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_VECTOR4;
-                        *f++ = v4->getX();
-                        *f++ = v4->getY();
-                        *f++ = v4->getZ();
-                        *f++ = v4->getW();
-
-                        buffer += sizeof(float) * 4;
+                        sub_type = SUB_TYPE_VECTOR4;
+                        WriteType(writer, sub_type_offset, (char) sub_type);
+                        f[0] = v4->getX();
+                        f[1] = v4->getY();
+                        f[2] = v4->getZ();
+                        f[3] = v4->getW();
+                        Write(L, writer, f, sizeof(float) * 4, "value", count);
                     }
                     else if ((q = ToQuat(L, -1)))
                     {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 4))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_QUAT;
-                        *f++ = q->getX();
-                        *f++ = q->getY();
-                        *f++ = q->getZ();
-                        *f++ = q->getW();
-
-                        buffer += sizeof(float) * 4;
+                        sub_type = SUB_TYPE_QUAT;
+                        WriteType(writer, sub_type_offset, (char) sub_type);
+                        f[0] = q->getX();
+                        f[1] = q->getY();
+                        f[2] = q->getZ();
+                        f[3] = q->getW();
+                        Write(L, writer, f, sizeof(float) * 4, "value", count);
                     }
                     else if ((m = ToMatrix4(L, -1)))
                     {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 16))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_MATRIX4;
+                        sub_type = SUB_TYPE_MATRIX4;
+                        WriteType(writer, sub_type_offset, (char) sub_type);
                         for (uint32_t i = 0; i < 4; ++i)
                             for (uint32_t j = 0; j < 4; ++j)
-                                *f++ = m->getElem(i, j);
-
-                        buffer += sizeof(float) * 16;
+                                f[i * 4 + j] = m->getElem(i, j);
+                        Write(L, writer, f, sizeof(float) * 16, "value", count);
                     }
                     else if (IsHash(L, -1))
                     {
-                        dmhash_t hash = *(dmhash_t*)lua_touserdata(L, -1);
-                        const uint32_t hash_size = sizeof(dmhash_t);
-
-                        if (buffer_end - buffer < int32_t(hash_size))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_HASH;
-
-                        memcpy(buffer, (const void*)&hash, hash_size);
-                        buffer += hash_size;
+                        sub_type = SUB_TYPE_HASH;
+                        WriteType(writer, sub_type_offset, (char) sub_type);
+                        Write(L, writer, lua_touserdata(L, -1), sizeof(dmhash_t), "value", count);
                     }
                     else if (IsURL(L, -1))
                     {
-                        dmMessage::URL* url = (dmMessage::URL*)lua_touserdata(L, -1);
-                        const uint32_t url_size = sizeof(dmMessage::URL);
-
-                        if (buffer_end - buffer < int32_t(url_size))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_URL;
-
-                        memcpy(buffer, (const void*)url, url_size);
-                        buffer += url_size;
+                        sub_type = SUB_TYPE_URL;
+                        WriteType(writer, sub_type_offset, (char) sub_type);
+                        Write(L, writer, lua_touserdata(L, -1), sizeof(dmMessage::URL), "value", count);
                     }
                     else
                     {
@@ -689,8 +576,18 @@ namespace dmScript
 
                 case LUA_TTABLE:
                 {
-                    uint32_t n_used = DoCheckTable(L, header, original_buffer, buffer, buffer_end - buffer, -1, table_stack);
-                    buffer += n_used;
+                    if (copy != 0)
+                    {
+                        lua_createtable(L, lua_objlen(L, -1), 0);
+                        DoCheckTable(L, header, writer, -2, table_stack, lua_gettop(L));
+                        lua_pushvalue(L, -3);
+                        lua_insert(L, -2);
+                        lua_rawset(L, copy);
+                    }
+                    else
+                    {
+                        DoCheckTable(L, header, writer, -1, table_stack, 0);
+                    }
                 }
                 break;
 
@@ -699,6 +596,22 @@ namespace dmScript
                     break;
             }
 
+            if (copy != 0 && value_type != LUA_TTABLE)
+            {
+                // The values that are mutable (vector, quat, matrix and url) are copied, the rest are shared
+                lua_pushvalue(L, -2);
+                switch (sub_type)
+                {
+                    case SUB_TYPE_VECTOR3:  PushVector3(L, *ToVector3(L, -2)); break;
+                    case SUB_TYPE_VECTOR4:  PushVector4(L, *ToVector4(L, -2)); break;
+                    case SUB_TYPE_QUAT:     PushQuat(L, *ToQuat(L, -2)); break;
+                    case SUB_TYPE_MATRIX4:  PushMatrix4(L, *ToMatrix4(L, -2)); break;
+                    case SUB_TYPE_URL:      PushURL(L, *(dmMessage::URL*)lua_touserdata(L, -2)); break;
+                    default:                lua_pushvalue(L, -2); break;
+                }
+                lua_rawset(L, copy);
+            }
+
             lua_pop(L, 1);
         }
         lua_pop(L, 1);
@@ -706,32 +619,133 @@ namespace dmScript
         const void* p = StackPop(table_stack);
         assert(p == table_data);
 
-        memcpy(buffer_start, &count, sizeof(uint32_t));
+        if (writer.m_Buffer)
+        {
+            memcpy(writer.m_Buffer + count_offset, &count, sizeof(uint32_t));
+        }
 
         assert(top == lua_gettop(L));
-        return buffer - buffer_start;
+    }
+
+    static const uint32_t TABLE_STRINGS_CAPACITY = 256;
+
+    // Tables with many strings grow the string table, which is then replaced to keep it cheap to clear for small payloads (e.g. messages)
+    static void ResetTableStrings()
+    {
+        if (g_TableStrings.Capacity() != TABLE_STRINGS_CAPACITY)
+        {
+            dmHashTable<uintptr_t, uint32_t> strings;
+            strings.SetCapacity(171, TABLE_STRINGS_CAPACITY);
+            g_TableStrings.Swap(strings);
+        }
+        else
+        {
+            g_TableStrings.Clear();
+        }
+    }
+
+    static uint32_t DoSerializeTable(lua_State* L, TableWriter& writer, int index, int copy)
+    {
+        TableHeader header;
+        header.m_Magic = TABLE_MAGIC;
+        header.m_Version = TABLE_VERSION_CURRENT;
+        Write(L, writer, &header, sizeof(TableHeader), "header", 0);
+
+        ResetTableStrings();
+
+        dmArray<const void*> table_stack;
+        DoCheckTable(L, header, writer, index, table_stack, copy);
+        return writer.m_Size;
     }
 
     uint32_t CheckTable(lua_State* L, char* buffer, uint32_t buffer_size, int index)
     {
         assert((intptr_t)buffer % 16 == 0);
         if (buffer_size > sizeof(TableHeader)) {
-            char* original_buffer = buffer;
-
-            TableHeader* header = (TableHeader*)buffer;
-            header->m_Magic = TABLE_MAGIC;
-            header->m_Version = TABLE_VERSION_CURRENT;
-            buffer += sizeof(TableHeader);
-            buffer_size -= (buffer - original_buffer);
-
-            dmArray<const void*> table_stack;
-            return sizeof(TableHeader) + DoCheckTable(L, *header, original_buffer, buffer, buffer_size, index, table_stack);
+            TableWriter writer;
+            writer.m_Buffer = buffer;
+            writer.m_Size = 0;
+            writer.m_Capacity = buffer_size;
+            writer.m_Growable = false;
+            return DoSerializeTable(L, writer, index, 0);
         } else {
             luaL_error(L, "buffer (%d bytes) too small for header (%zu bytes)", buffer_size, sizeof(TableHeader));
             return 0;
         }
     }
 
+    uint32_t SerializeTableTemp(lua_State* L, int index, const char** out_buffer)
+    {
+        // A buffer that grew for a large table is released again rather than held on to
+        if (g_TableBufferCapacity > TABLE_BUFFER_MAX_KEPT_SIZE)
+        {
+            dmMemory::AlignedFree(g_TableBuffer);
+            g_TableBuffer = 0;
+            g_TableBufferCapacity = 0;
+        }
+        if (g_TableBuffer == 0)
+        {
+            if (dmMemory::AlignedMalloc((void**)&g_TableBuffer, 16, TABLE_BUFFER_MIN_SIZE) != dmMemory::RESULT_OK)
+            {
+                g_TableBuffer = 0;
+                return luaL_error(L, "Could not allocate %d bytes for table serialization.", TABLE_BUFFER_MIN_SIZE);
+            }
+            g_TableBufferCapacity = TABLE_BUFFER_MIN_SIZE;
+        }
+
+        TableWriter writer;
+        writer.m_Buffer = g_TableBuffer;
+        writer.m_Size = 0;
+        writer.m_Capacity = g_TableBufferCapacity;
+        writer.m_Growable = true;
+        uint32_t size = DoSerializeTable(L, writer, index, 0);
+
+        *out_buffer = g_TableBuffer;
+        return size;
+    }
+
+    uint32_t SerializeTable(lua_State* L, int index, char** out_buffer)
+    {
+        const char* data = 0;
+        uint32_t size = SerializeTableTemp(L, index, &data);
+
+        char* buffer = 0;
+        if (dmMemory::AlignedMalloc((void**)&buffer, 16, size) != dmMemory::RESULT_OK)
+        {
+            return luaL_error(L, "Could not allocate %d bytes for table serialization.", size);
+        }
+        memcpy(buffer, data, size);
+        *out_buffer = buffer;
+        return size;
+    }
+
+    uint32_t CheckTableSize(lua_State* L, int index)
+    {
+        TableWriter writer;
+        writer.m_Buffer = 0;
+        writer.m_Size = 0;
+        writer.m_Capacity = 0xffffffff;
+        writer.m_Growable = false;
+        return DoSerializeTable(L, writer, index, 0);
+    }
+
+    uint32_t PushTableCopy(lua_State* L, int index, uint32_t buffer_size)
+    {
+        luaL_checktype(L, index, LUA_TTABLE);
+        if (index < 0)
+        {
+            index = lua_gettop(L) + index + 1;
+        }
+        lua_createtable(L, lua_objlen(L, index), 0);
+
+        TableWriter writer;
+        writer.m_Buffer = 0;
+        writer.m_Size = 0;
+        writer.m_Capacity = buffer_size;
+        writer.m_Growable = false;
+        return DoSerializeTable(L, writer, index, lua_gettop(L));
+    }
+
     static const char* ReadHeader(const char* buffer, TableHeader& header)
     {
         TableHeader* buffered_header = (TableHeader*)buffer;
@@ -771,7 +785,7 @@ namespace dmScript
                 luaL_error(L, "Invalid number encoding");
             }
         }
-        else if ((3 == header.m_Version) || (4 == header.m_Version))
+        else if ((3 == header.m_Version) || (4 == header.m_Version) || (5 == header.m_Version))
         {
             if (key_type != LUA_TNUMBER && key_type != LUA_TNEGATIVENUMBER)
             {
@@ -857,7 +871,33 @@ namespace dmScript
         return luaL_error(L, "%s", str); \
     }
 
-    int DoPushTable(lua_State*L, PushTableLogger& logger, const TableHeader& header, const char* original_buffer, const char* buffer, uint32_t buffer_size, uint32_t depth)
+    // Strings read from a version 5+ payload are added to the table at stack index 'strings', to resolve the LUA_TSTRINGREF references.
+    // The slot holds nil until the first string is read, so that payloads without strings don't create the table.
+    static void AddString(lua_State* L, int strings, uint32_t& string_count)
+    {
+        if (string_count == 0)
+        {
+            lua_newtable(L);
+            lua_replace(L, strings);
+        }
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, strings, ++string_count);
+    }
+
+    static const char* LoadStringRef(lua_State* L, const char* buffer, int strings, uint32_t string_count, uint32_t count, PushTableLogger& logger)
+    {
+        uint32_t string_number;
+        if (!DecodeMSB(string_number, buffer) || string_number >= string_count)
+        {
+            char log_str[PUSH_TABLE_LOGGER_STR_SIZE];
+            PushTableLogPrint(logger, log_str);
+            luaL_error(L, "Invalid string reference at element #%d [BufStart: %p, BufSize: %lu]\n'%s'", count, logger.m_BufferStart, logger.m_BufferSize, log_str);
+        }
+        lua_rawgeti(L, strings, string_number + 1);
+        return buffer;
+    }
+
+    int DoPushTable(lua_State*L, PushTableLogger& logger, const TableHeader& header, const char* original_buffer, const char* buffer, uint32_t buffer_size, uint32_t depth, int strings, uint32_t& string_count)
     {
         int top = lua_gettop(L);
         (void)top;
@@ -888,7 +928,14 @@ namespace dmScript
             return luaL_error(L, "%s", str);
         }
 
-        lua_newtable(L);
+        // Tables are serialized in the order lua_next visits them, so an array comes first if the first key is a number.
+        // The count comes from the payload, so the preallocation is limited to the number of elements that fit in the
+        // rest of the buffer (each takes at least 3 bytes), for a corrupt count to not allocate a huge table.
+        uint32_t size_hint = dmMath::Min(count, (uint32_t)(buffer_end - buffer) / 3);
+        if (count > 0 && buffer + 1 <= buffer_end && *buffer == LUA_TNUMBER)
+            lua_createtable(L, size_hint, 0);
+        else
+            lua_createtable(L, 0, size_hint);
 
         for (uint32_t i = 0; i < count; ++i)
         {
@@ -906,8 +953,18 @@ namespace dmScript
                 else
                     buffer += LoadTSTRING(L, buffer, buffer_end, count, logger);
 
+                if (header.m_Version >= 5)
+                    AddString(L, strings, string_count);
+
                 CHECK_PUSHTABLE_OOB("key string", logger, buffer, buffer_end, count, depth);
             }
+            else if (key_type == LUA_TSTRINGREF && header.m_Version >= 5)
+            {
+                PushTableLogString(logger, "KR");
+
+                buffer = LoadStringRef(L, buffer, strings, string_count, count, logger);
+                CHECK_PUSHTABLE_OOB("key string reference", logger, buffer, buffer_end, count, depth);
+            }
             else if (key_type == LUA_TNUMBER || key_type == LUA_TNEGATIVENUMBER)
             {
                 PushTableLogString(logger, "KN");
@@ -959,10 +1016,27 @@ namespace dmScript
                     else
                         buffer += LoadTSTRING(L, buffer, buffer_end, count, logger);
 
+                    if (header.m_Version >= 5)
+                        AddString(L, strings, string_count);
+
                     CHECK_PUSHTABLE_OOB("value string", logger, buffer, buffer_end, count, depth);
                 }
                 break;
 
+                case LUA_TSTRINGREF:
+                {
+                    if (header.m_Version < 5)
+                    {
+                        return luaL_error(L, "Table contains invalid type (%s) at element #%d: %s", lua_typename(L, key_type), i, buffer);
+                    }
+
+                    PushTableLogString(logger, "VR");
+
+                    buffer = LoadStringRef(L, buffer, strings, string_count, count, logger);
+                    CHECK_PUSHTABLE_OOB("value string reference", logger, buffer, buffer_end, count, depth);
+                }
+                break;
+
                 case LUA_TUSERDATA:
                 {
                     PushTableLogString(logger, "VU");
@@ -1049,7 +1123,7 @@ namespace dmScript
                 break;
                 case LUA_TTABLE:
                 {
-                    int n_consumed = DoPushTable(L, logger, header, original_buffer, buffer, buffer_size, depth+1);
+                    int n_consumed = DoPushTable(L, logger, header, original_buffer, buffer, buffer_size, depth+1, strings, string_count);
                     buffer += n_consumed;
                     CHECK_PUSHTABLE_OOB("table", logger, buffer, buffer_end, count, depth);
                 }
@@ -1059,7 +1133,7 @@ namespace dmScript
                     return luaL_error(L, "Table contains invalid type (%s) at element #%d: %s", lua_typename(L, key_type), i, buffer);
                     break;
             }
-            lua_settable(L, -3);
+            lua_rawset(L, -3);
 
             CHECK_PUSHTABLE_OOB("loop end", logger, buffer, buffer_end, count, depth);
         }
@@ -1091,7 +1165,12 @@ namespace dmScript
             PushTableLogger logger;
             logger.m_BufferStart = buffer;
             logger.m_BufferSize = buffer_size;
-            DoPushTable(L, logger, header, original_buffer, buffer, buffer_size, 0);
+
+            lua_pushnil(L); // The strings table, created by AddString
+            int strings = lua_gettop(L);
+            uint32_t string_count = 0;
+            DoPushTable(L, logger, header, original_buffer, buffer, buffer_size, 0, strings, string_count);
+            lua_remove(L, strings);
         }
         else
         {
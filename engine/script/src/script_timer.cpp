@@ -42,19 +42,16 @@ namespace dmScript
      */
 
     /*
-        The timers are stored in a flat array with no holes which we scan sequenctially on each update.
+        The timers are stored in an array of slots, and the scheduled timers are kept in a binary min-heap
+        ordered by the absolute world time when they fire. Each update only touches the timers that
+        fire, the cost no longer depends on the total number of live timers.
 
-        When a timer is removed the last timer in the list may change location (EraseSwap).
+        Timers that are added or re-scheduled (repeating) while the timers are updated are kept in a
+        pending list and pushed to the heap after the update, so they can't fire in the same update.
 
-        This is to keep the array sweep fast and handle cases where multiple short lived timers are
-        created followed by one long-lived timer. If we did not re-shuffle and keep holes we would keep
-        scanning the array to the end where the only live timer exists skipping all the holes.
-        How much of an issue this is guesswork at this point.
-
-        The timer identity is an index into an indirection layer combined with a generation counter,
-        this makes it possible to reuse the index for the indirection layer without risk of using
-        stale indexes - the caller to CancelTimer is allowed to call with an handle of a timer that already
-        has expired.
+        The timer identity is a slot index combined with a generation counter, this makes it possible
+        to reuse slots without risk of using stale handles - the caller to CancelTimer is allowed to call
+        with an handle of a timer that already has expired.
 
         Each script instance needs to call KillTimers for its owner to clean up potential timers
         that has not yet been cancelled or completed (one-shot).
@@ -69,31 +66,40 @@ namespace dmScript
         uintptr_t       m_Owner;
         uintptr_t       m_UserData;
 
+        // The world time when the timer fires
+        double          m_Expiry;
+
+        // Breaks ties between timers with the same expiry, so they fire in the order they were scheduled
+        uint32_t        m_Order;
+
         // Store complete timer handle with generation here to identify stale timer handles
         HTimer          m_Handle;
 
-        // How much time remaining until the timer fires
-        float           m_Remaining;
-
         // The timer delay, we need to keep this for repeating timers
         float           m_Delay;
 
+        // Position in the heap, INVALID_HEAP_INDEX while the timer is firing or pending
+        uint16_t        m_HeapIndex;
+
         // Flag if the timer should repeat
-        uint32_t        m_Repeat : 1;
+        uint16_t        m_Repeat : 1;
         // Flag if the timer is alive
-        uint32_t        m_IsAlive : 1;
+        uint16_t        m_IsAlive : 1;
     };
 
-    #define INVALID_TIMER_LOOKUP_INDEX  0xffffu
+    #define INVALID_HEAP_INDEX          0xffffu
     #define INITIAL_TIMER_CAPACITY      8u
     #define MAX_TIMER_CAPACITY          65000u  // Needs to be less that 65535 since 65535 is reserved for invalid index
     #define TIMER_CAPACITY_GROWTH       16u
 
     struct TimerWorld
     {
-        dmArray<Timer>                      m_Timers;
-        dmArray<uint16_t>                   m_IndexLookup;
+        dmArray<Timer>                      m_Timers;   // Indexed by the slot in the timer handle
+        dmArray<uint16_t>                   m_Heap;     // Slots of the scheduled timers
+        dmArray<HTimer>                     m_Pending;  // Timers scheduled during UpdateTimers
         dmIndexPool<uint16_t>               m_IndexPool;
+        double                              m_Time;
+        uint32_t                            m_Order;
         uint16_t                            m_Version;   // Incremented to avoid collisions each time we push timer indexes back to the m_IndexPool
         uint16_t                            m_InUpdate : 1;
     };
@@ -108,57 +114,147 @@ namespace dmScript
         return (((uint32_t)generation) << 16) | (lookup_index);
     }
 
-    static Timer* AllocateTimer(HTimerWorld timer_world, uintptr_t owner)
+    static Timer* GetTimer(HTimerWorld timer_world, HTimer handle)
     {
-        assert(timer_world != 0x0);
-        uint32_t timer_count = timer_world->m_Timers.Size();
-        if (timer_count == MAX_TIMER_CAPACITY)
+        uint16_t lookup_index = GetLookupIndex(handle);
+        if (lookup_index >= timer_world->m_Timers.Size())
         {
-            dmLogError("Timer could not be stored since the timer buffer is full (%d).", MAX_TIMER_CAPACITY);
             return 0x0;
         }
+        Timer* timer = &timer_world->m_Timers[lookup_index];
+        return timer->m_Handle == handle ? timer : 0x0;
+    }
 
-        if (timer_world->m_IndexPool.Remaining() == 0)
+    static inline bool IsEarlier(const Timer& a, const Timer& b)
+    {
+        return a.m_Expiry < b.m_Expiry || (a.m_Expiry == b.m_Expiry && (int32_t)(a.m_Order - b.m_Order) < 0);
+    }
+
+    static inline void SetHeapEntry(HTimerWorld timer_world, uint32_t heap_index, uint16_t slot)
+    {
+        timer_world->m_Heap[heap_index] = slot;
+        timer_world->m_Timers[slot].m_HeapIndex = (uint16_t)heap_index;
+    }
+
+    static void SiftUp(HTimerWorld timer_world, uint32_t heap_index)
+    {
+        uint16_t slot = timer_world->m_Heap[heap_index];
+        const Timer& timer = timer_world->m_Timers[slot];
+        while (heap_index > 0)
+        {
+            uint32_t parent = (heap_index - 1) / 2;
+            uint16_t parent_slot = timer_world->m_Heap[parent];
+            if (!IsEarlier(timer, timer_world->m_Timers[parent_slot]))
+            {
+                break;
+            }
+            SetHeapEntry(timer_world, heap_index, parent_slot);
+            heap_index = parent;
+        }
+        SetHeapEntry(timer_world, heap_index, slot);
+    }
+
+    static void SiftDown(HTimerWorld timer_world, uint32_t heap_index)
+    {
+        uint32_t size = timer_world->m_Heap.Size();
+        uint16_t slot = timer_world->m_Heap[heap_index];
+        const Timer& timer = timer_world->m_Timers[slot];
+        while (true)
+        {
+            uint32_t child = heap_index * 2 + 1;
+            if (child >= size)
+            {
+                break;
+            }
+            if (child + 1 < size && IsEarlier(timer_world->m_Timers[timer_world->m_Heap[child + 1]], timer_world->m_Timers[timer_world->m_Heap[child]]))
+            {
+                ++child;
+            }
+            uint16_t child_slot = timer_world->m_Heap[child];
+            if (!IsEarlier(timer_world->m_Timers[child_slot], timer))
+            {
+                break;
+            }
+            SetHeapEntry(timer_world, heap_index, child_slot);
+            heap_index = child;
+        }
+        SetHeapEntry(timer_world, heap_index, slot);
+    }
+
+    static void ScheduleTimer(HTimerWorld timer_world, Timer& timer)
+    {
+        timer.m_Order = timer_world->m_Order++;
+        if (timer_world->m_InUpdate)
         {
-            uint32_t old_capacity = timer_world->m_IndexPool.Capacity();
-            uint32_t capacity = dmMath::Min(old_capacity + TIMER_CAPACITY_GROWTH, MAX_TIMER_CAPACITY);
-            timer_world->m_IndexPool.SetCapacity(capacity);
-            timer_world->m_IndexLookup.SetCapacity(capacity);
-            timer_world->m_IndexLookup.SetSize(capacity);
-            memset(&timer_world->m_IndexLookup[old_capacity], 0u, (capacity - old_capacity) * sizeof(uint16_t));
+            if (timer_world->m_Pending.Full())
+            {
+                timer_world->m_Pending.OffsetCapacity(TIMER_CAPACITY_GROWTH);
+            }
+            timer_world->m_Pending.Push(timer.m_Handle);
+            return;
         }
 
-        HTimer handle = MakeHandle(timer_world->m_Version, timer_world->m_IndexPool.Pop());
+        uint16_t slot = GetLookupIndex(timer.m_Handle);
+        timer_world->m_Heap.Push(slot);
+        SiftUp(timer_world, timer_world->m_Heap.Size() - 1);
+    }
 
-        if (timer_world->m_Timers.Full())
+    static void UnscheduleTimer(HTimerWorld timer_world, Timer& timer)
+    {
+        uint32_t heap_index = timer.m_HeapIndex;
+        if (heap_index == INVALID_HEAP_INDEX)
         {
-            uint32_t capacity = timer_world->m_Timers.Capacity();
-            capacity = dmMath::Min(capacity + TIMER_CAPACITY_GROWTH, MAX_TIMER_CAPACITY);
-            timer_world->m_Timers.SetCapacity(capacity);
+            return; // Firing or pending
         }
+        timer.m_HeapIndex = INVALID_HEAP_INDEX;
 
-        timer_world->m_Timers.SetSize(timer_count + 1);
-        Timer& timer = timer_world->m_Timers[timer_count];
-        timer.m_Handle = handle;
-        timer.m_Owner = owner;
+        uint16_t last_slot = timer_world->m_Heap.Back();
+        timer_world->m_Heap.Pop();
+        if (heap_index == timer_world->m_Heap.Size())
+        {
+            return;
+        }
 
-        uint16_t lookup_index = GetLookupIndex(handle);
+        SetHeapEntry(timer_world, heap_index, last_slot);
+        SiftDown(timer_world, heap_index);
+        SiftUp(timer_world, timer_world->m_Timers[last_slot].m_HeapIndex);
+    }
 
-        timer_world->m_IndexLookup[lookup_index] = timer_count;
-        return &timer;
+    static void SetTimerCapacity(HTimerWorld timer_world, uint32_t capacity)
+    {
+        uint32_t old_capacity = timer_world->m_Timers.Size();
+        timer_world->m_IndexPool.SetCapacity(capacity);
+        timer_world->m_Timers.SetCapacity(capacity);
+        timer_world->m_Timers.SetSize(capacity);
+        memset(&timer_world->m_Timers[old_capacity], 0u, (capacity - old_capacity) * sizeof(Timer));
+        for (uint32_t i = old_capacity; i < capacity; ++i)
+        {
+            timer_world->m_Timers[i].m_Handle = INVALID_TIMER_HANDLE;
+        }
+        timer_world->m_Heap.SetCapacity(capacity);
     }
 
-    static void EraseTimer(HTimerWorld timer_world, uint32_t timer_index)
+    static Timer* AllocateTimer(HTimerWorld timer_world, uintptr_t owner)
     {
         assert(timer_world != 0x0);
+        if (timer_world->m_IndexPool.Size() == MAX_TIMER_CAPACITY)
+        {
+            dmLogError("Timer could not be stored since the timer buffer is full (%d).", MAX_TIMER_CAPACITY);
+            return 0x0;
+        }
 
-        Timer& movedTimer = timer_world->m_Timers.EraseSwap(timer_index);
-
-        if (timer_index < timer_world->m_Timers.Size())
+        if (timer_world->m_IndexPool.Remaining() == 0)
         {
-            uint16_t moved_lookup_index = GetLookupIndex(movedTimer.m_Handle);
-            timer_world->m_IndexLookup[moved_lookup_index] = timer_index;
+            uint32_t capacity = dmMath::Min(timer_world->m_IndexPool.Capacity() + TIMER_CAPACITY_GROWTH, MAX_TIMER_CAPACITY);
+            SetTimerCapacity(timer_world, capacity);
         }
+
+        uint16_t lookup_index = timer_world->m_IndexPool.Pop();
+        Timer& timer = timer_world->m_Timers[lookup_index];
+        timer.m_Handle = MakeHandle(timer_world->m_Version, lookup_index);
+        timer.m_Owner = owner;
+        timer.m_HeapIndex = INVALID_HEAP_INDEX;
+        return &timer;
     }
 
     static void FreeTimer(HTimerWorld timer_world, Timer& timer)
@@ -166,21 +262,20 @@ namespace dmScript
         assert(timer_world != 0x0);
         assert(timer.m_IsAlive == 0);
 
+        UnscheduleTimer(timer_world, timer);
+
         uint16_t lookup_index = GetLookupIndex(timer.m_Handle);
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
+        timer.m_Handle = INVALID_TIMER_HANDLE;
         timer_world->m_IndexPool.Push(lookup_index);
-
-        EraseTimer(timer_world, timer_index);
+        ++timer_world->m_Version;
     }
 
     HTimerWorld NewTimerWorld()
     {
         TimerWorld* timer_world = new TimerWorld();
-        timer_world->m_Timers.SetCapacity(INITIAL_TIMER_CAPACITY);
-        timer_world->m_IndexLookup.SetCapacity(INITIAL_TIMER_CAPACITY);
-        timer_world->m_IndexLookup.SetSize(INITIAL_TIMER_CAPACITY);
-        memset(&timer_world->m_IndexLookup[0], 0u, INITIAL_TIMER_CAPACITY * sizeof(uint16_t));
-        timer_world->m_IndexPool.SetCapacity(INITIAL_TIMER_CAPACITY);
+        SetTimerCapacity(timer_world, INITIAL_TIMER_CAPACITY);
+        timer_world->m_Time = 0.0;
+        timer_world->m_Order = 0;
         timer_world->m_Version = 0;
         timer_world->m_InUpdate = 0;
         return timer_world;
@@ -197,37 +292,34 @@ namespace dmScript
         assert(timer_world != 0x0);
         DM_PROFILE("Update");
 
-        timer_world->m_InUpdate = 1;
+        DM_PROPERTY_ADD_U32(rmtp_TimerCount, timer_world->m_IndexPool.Size());
 
-        // We only scan timers for trigger if the timer *existed at entry to UpdateTimers*, any timers added
-        // in a trigger callback will always be added at the end of m_Timers and not triggered in this scope.
-        uint32_t size = timer_world->m_Timers.Size();
-        DM_PROPERTY_ADD_U32(rmtp_TimerCount, size);
+        timer_world->m_InUpdate = 1;
+        timer_world->m_Time += dt;
+        const double now = timer_world->m_Time;
 
-        for (uint32_t i = 0; i < size; ++i)
+        // Any timers added or repeated in a trigger callback are pending and not triggered in this scope.
+        while (!timer_world->m_Heap.Empty())
         {
-            Timer* timer = &timer_world->m_Timers[i];
-            if (timer->m_IsAlive == 0)
+            uint16_t slot = timer_world->m_Heap[0];
+            Timer* timer = &timer_world->m_Timers[slot];
+            if (timer->m_Expiry > now)
             {
-                continue;
+                break;
             }
+            UnscheduleTimer(timer_world, *timer);
 
-            timer->m_Remaining -= dt;
-            if (timer->m_Remaining > 0.0f)
-            {
-                continue;
-            }
-
-            float elapsed_time = timer->m_Delay - timer->m_Remaining;
+            HTimer handle = timer->m_Handle;
+            float remaining = (float)(timer->m_Expiry - now);
+            float elapsed_time = timer->m_Delay - remaining;
 
             TimerEventType eventType = timer->m_Repeat == 0 ? TIMER_EVENT_TRIGGER_WILL_DIE : TIMER_EVENT_TRIGGER_WILL_REPEAT;
 
-            timer->m_Callback(timer_world, eventType, timer->m_Handle, elapsed_time, timer->m_Owner, timer->m_UserData);
-
-            // The array might have been reallocated here! So grab the pointer again...
-            timer = &timer_world->m_Timers[i];
+            timer->m_Callback(timer_world, eventType, handle, elapsed_time, timer->m_Owner, timer->m_UserData);
 
-            if (timer->m_IsAlive == 0)
+            // The array might have been reallocated, and the timer cancelled, here! So grab the pointer again...
+            timer = GetTimer(timer_world, handle);
+            if (timer == 0x0 || timer->m_IsAlive == 0)
             {
                 continue;
             }
@@ -235,45 +327,39 @@ namespace dmScript
             if (timer->m_Repeat == 0)
             {
                 timer->m_IsAlive = 0;
+                FreeTimer(timer_world, *timer);
                 continue;
             }
 
             if (timer->m_Delay == 0.0f)
             {
-                timer->m_Remaining = 0.0f;
-                continue;
+                remaining = 0.0f;
             }
-
-            float wrapped_count = ((-timer->m_Remaining) / timer->m_Delay) + 1.f;
-            float offset_to_next_trigger  = floor(wrapped_count) * timer->m_Delay;
-            timer->m_Remaining += offset_to_next_trigger;
-            if (timer->m_Remaining < 0) // If the delay is very small, the floating point precision might produce issues
-                timer->m_Remaining = timer->m_Delay; // reset the timer
+            else
+            {
+                float wrapped_count = ((-remaining) / timer->m_Delay) + 1.f;
+                float offset_to_next_trigger  = floor(wrapped_count) * timer->m_Delay;
+                remaining += offset_to_next_trigger;
+                if (remaining < 0) // If the delay is very small, the floating point precision might produce issues
+                    remaining = timer->m_Delay; // reset the timer
+            }
+            timer->m_Expiry = now + remaining;
+            ScheduleTimer(timer_world, *timer);
         }
 
         timer_world->m_InUpdate = 0;
 
-        size = timer_world->m_Timers.Size();
-        uint32_t original_size = size;
-        uint32_t i = 0;
-        while (i < size)
+        for (uint32_t i = 0; i < timer_world->m_Pending.Size(); ++i)
         {
-            Timer& timer = timer_world->m_Timers[i];
-            if (timer.m_IsAlive == 0)
-            {
-                FreeTimer(timer_world, timer);
-                --size;
-            }
-            else
+            Timer* timer = GetTimer(timer_world, timer_world->m_Pending[i]);
+            if (timer != 0x0 && timer->m_IsAlive == 1)
             {
-                ++i;
+                uint16_t slot = GetLookupIndex(timer->m_Handle);
+                timer_world->m_Heap.Push(slot);
+                SiftUp(timer_world, timer_world->m_Heap.Size() - 1);
             }
         }
-
-        if (size != original_size)
-        {
-            ++timer_world->m_Version;
-        }
+        timer_world->m_Pending.SetSize(0);
     }
 
     HTimer AddTimer(HTimerWorld timer_world,
@@ -293,48 +379,34 @@ namespace dmScript
         }
 
         timer->m_Delay = delay;
-        timer->m_Remaining = delay;
+        timer->m_Expiry = timer_world->m_Time + delay;
         timer->m_UserData = userdata;
         timer->m_Callback = timer_callback;
         timer->m_Repeat = repeat;
         timer->m_IsAlive = 1;
 
+        ScheduleTimer(timer_world, *timer);
+
         return timer->m_Handle;
     }
 
     bool CancelTimer(HTimerWorld timer_world, HTimer handle)
     {
         assert(timer_world != 0x0);
-        uint16_t lookup_index = GetLookupIndex(handle);
-        if (lookup_index >= timer_world->m_IndexLookup.Size())
+        Timer* timer = GetTimer(timer_world, handle);
+        if (timer == 0x0 || timer->m_IsAlive == 0)
         {
             return false;
         }
 
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
-        if (timer_index >= timer_world->m_Timers.Size())
-        {
-            return false;
-        }
+        timer->m_IsAlive = 0;
+        timer->m_Callback(timer_world, TIMER_EVENT_CANCELLED, timer->m_Handle, 0.f, timer->m_Owner, timer->m_UserData);
 
-        Timer& timer = timer_world->m_Timers[timer_index];
-        if (timer.m_Handle != handle)
+        // The array might have been reallocated in the callback
+        timer = GetTimer(timer_world, handle);
+        if (timer != 0x0)
         {
-            return false;
-        }
-
-        if (timer.m_IsAlive == 0)
-        {
-            return false;
-        }
-
-        timer.m_IsAlive = 0;
-        timer.m_Callback(timer_world, TIMER_EVENT_CANCELLED, timer.m_Handle, 0.f, timer.m_Owner, timer.m_UserData);
-
-        if (timer_world->m_InUpdate == 0)
-        {
-            FreeTimer(timer_world, timer);
-            ++timer_world->m_Version;
+            FreeTimer(timer_world, *timer);
         }
         return true;
     }
@@ -345,36 +417,17 @@ namespace dmScript
 
         uint32_t size = timer_world->m_Timers.Size();
         uint32_t cancelled_count = 0;
-        uint32_t timer_index = 0;
-        while (timer_index < size)
+        for (uint32_t i = 0; i < size; ++i)
         {
-            Timer& timer = timer_world->m_Timers[timer_index];
-            if (timer.m_Owner != owner)
+            Timer& timer = timer_world->m_Timers[i];
+            if (timer.m_Handle == INVALID_TIMER_HANDLE || timer.m_Owner != owner || timer.m_IsAlive == 0)
             {
-                ++timer_index;
                 continue;
             }
 
-            if (timer.m_IsAlive == 1)
-            {
-                timer.m_IsAlive = 0;
-                ++cancelled_count;
-            }
-
-            if (timer_world->m_InUpdate == 0)
-            {
-                FreeTimer(timer_world, timer);
-                --size;
-            }
-            else
-            {
-                ++timer_index;
-            }
-        }
-
-        if (cancelled_count > 0)
-        {
-            ++timer_world->m_Version;
+            timer.m_IsAlive = 0;
+            FreeTimer(timer_world, timer);
+            ++cancelled_count;
         }
 
         return cancelled_count;
@@ -386,15 +439,13 @@ namespace dmScript
 
         uint32_t alive_timers = 0u;
         uint32_t size = timer_world->m_Timers.Size();
-        uint32_t i = 0;
-        while (i < size)
+        for (uint32_t i = 0; i < size; ++i)
         {
-            Timer& timer = timer_world->m_Timers[i];
-            if(timer.m_IsAlive == 1)
+            const Timer& timer = timer_world->m_Timers[i];
+            if (timer.m_Handle != INVALID_TIMER_HANDLE && timer.m_IsAlive == 1)
             {
                 ++alive_timers;
             }
-            ++i;
         }
         return alive_timers;
     }
@@ -688,30 +739,21 @@ namespace dmScript
             return 1;
         }
 
-        uint16_t lookup_index = GetLookupIndex(timer_handle);
-        if (lookup_index >= timer_world->m_IndexLookup.Size())
-        {
-            lua_pushboolean(L, 0);
-            return 1;
-        }
-
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
-        if (timer_index >= timer_world->m_Timers.Size())
+        Timer* timer = GetTimer(timer_world, timer_handle);
+        if (timer == 0x0)
         {
             lua_pushboolean(L, 0);
             return 1;
         }
 
-        Timer& timer = timer_world->m_Timers[timer_index];
-
-        LuaCallbackInfo* callback = (LuaCallbackInfo*)timer.m_UserData;
+        LuaCallbackInfo* callback = (LuaCallbackInfo*)timer->m_UserData;
         if (!IsCallbackValid(callback))
         {
             lua_pushboolean(L, 0);
             return 1;
         }
 
-        LuaTimerCallbackArgs args = { timer.m_Handle, timer.m_Delay - timer.m_Remaining };
+        LuaTimerCallbackArgs args = { timer->m_Handle, timer->m_Delay - (float)(timer->m_Expiry - timer_world->m_Time) };
         InvokeCallback(callback, LuaTimerCallbackArgsCB, &args);
 
         lua_pushboolean(L, 1);
@@ -763,34 +805,19 @@ namespace dmScript
             return 1;
         }
 
-        uint16_t lookup_index = GetLookupIndex(timer_handle);
-        if (lookup_index >= timer_world->m_IndexLookup.Size())
-        {
-            lua_pushnil(L);
-            return 1;
-        }
-
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
-        if (timer_index >= timer_world->m_Timers.Size())
-        {
-            lua_pushnil(L);
-            return 1;
-        }
-
-        Timer& timer = timer_world->m_Timers[timer_index];
-
-        if (timer.m_Handle != timer_handle)
+        Timer* timer = GetTimer(timer_world, timer_handle);
+        if (timer == 0x0)
         {
             lua_pushnil(L);
             return 1;
         }
 
         lua_newtable(L);
-        lua_pushnumber(L,timer.m_Remaining);
+        lua_pushnumber(L,timer->m_Expiry - timer_world->m_Time);
         lua_setfield(L, -2, "time_remaining");
-        lua_pushnumber(L,timer.m_Delay);
+        lua_pushnumber(L,timer->m_Delay);
         lua_setfield(L, -2, "delay");
-        lua_pushboolean(L,timer.m_Repeat==1);
+        lua_pushboolean(L,timer->m_Repeat==1);
         lua_setfield(L, -2, "repeating");
         return 1;
     }
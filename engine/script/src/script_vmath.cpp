@@ -22,6 +22,7 @@
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
+#include <dlib/profile.h>
 
 extern "C"
 {
@@ -29,6 +30,9 @@ extern "C"
 #include <lua/lualib.h>
 }
 
+DM_PROPERTY_EXTERN(rmtp_Script);
+DM_PROPERTY_U32(rmtp_VMathAllocations, 0, FrameReset, "# vmath values created / frame", &rmtp_Script);
+
 namespace dmScript
 {
     using namespace dmVMath;
@@ -2299,6 +2303,207 @@ namespace dmScript
         return 1;
     }
 
+    /*# sets the value of a vector, quaternion or matrix in place
+     *
+     * Copies the value of `v` into `out`, or sets the components of `out` from numbers,
+     * without creating a new value.
+     *
+     * @name vmath.set
+     * @param out [type:vector3|vector4|quaternion|matrix4] value to modify
+     * @param v [type:vector3|vector4|quaternion|matrix4|number] value of the same type as `out`, or the first of the components
+     * @return out [type:vector3|vector4|quaternion|matrix4] the modified value
+     * @examples
+     *
+     * ```lua
+     * local p = vmath.vector3()
+     * vmath.set(p, 1, 2, 3)
+     * vmath.set(self.position, p)
+     * ```
+     */
+    static int Set(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        const bool from_numbers = lua_type(L, 2) == LUA_TNUMBER;
+        if (!from_numbers && GetType(L, 2) != type)
+        {
+            return luaL_error(L, "%s.%s Arguments needs to be of same type!", SCRIPT_LIB_NAME, "set");
+        }
+        switch (type)
+        {
+        case SCRIPT_TYPE_VECTOR3:
+            {
+                Vector3* out = CheckVector3(L, 1);
+                if (from_numbers)
+                    *out = Vector3((float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4));
+                else
+                    *out = *CheckVector3(L, 2);
+            }
+            break;
+        case SCRIPT_TYPE_VECTOR4:
+            {
+                Vector4* out = CheckVector4(L, 1);
+                if (from_numbers)
+                    *out = Vector4((float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4), (float)luaL_checknumber(L, 5));
+                else
+                    *out = *CheckVector4(L, 2);
+            }
+            break;
+        case SCRIPT_TYPE_QUAT:
+            {
+                Quat* out = CheckQuat(L, 1);
+                if (from_numbers)
+                    *out = Quat((float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4), (float)luaL_checknumber(L, 5));
+                else
+                    *out = *CheckQuat(L, 2);
+            }
+            break;
+        case SCRIPT_TYPE_MATRIX4:
+            {
+                if (from_numbers)
+                    return luaL_error(L, "%s.%s can only set a %s from another %s.", SCRIPT_LIB_NAME, "set", SCRIPT_TYPE_NAME_MATRIX4, SCRIPT_TYPE_NAME_MATRIX4);
+                *CheckMatrix4(L, 1) = *CheckMatrix4(L, 2);
+            }
+            break;
+        default:
+            return luaL_error(L, "%s.%s accepts (%s|%s|%s|%s) as arguments.", SCRIPT_LIB_NAME, "set", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4, SCRIPT_TYPE_NAME_QUAT, SCRIPT_TYPE_NAME_MATRIX4);
+        }
+        lua_pushvalue(L, 1);
+        return 1;
+    }
+
+    /*# adds two vectors in place
+     *
+     * Stores `v1 + v2` in `out`, without creating a new vector. `out` may be one of the arguments.
+     *
+     * @name vmath.add
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] first vector
+     * @param v2 [type:vector3|vector4] second vector
+     * @return out [type:vector3|vector4] the modified vector
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     vmath.add(self.position, self.position, self.velocity)
+     * end
+     * ```
+     */
+    static int Add(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vector3* out = CheckVector3(L, 1);
+            *out = *CheckVector3(L, 2) + *CheckVector3(L, 3);
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vector4* out = CheckVector4(L, 1);
+            *out = *CheckVector4(L, 2) + *CheckVector4(L, 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, "add", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        lua_pushvalue(L, 1);
+        return 1;
+    }
+
+    /*# subtracts two vectors in place
+     *
+     * Stores `v1 - v2` in `out`, without creating a new vector. `out` may be one of the arguments.
+     *
+     * @name vmath.sub
+     * @param out [type:vector3|vector4] vector to store the result in
+     * @param v1 [type:vector3|vector4] first vector
+     * @param v2 [type:vector3|vector4] second vector
+     * @return out [type:vector3|vector4] the modified vector
+     */
+    static int Sub(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vector3* out = CheckVector3(L, 1);
+            *out = *CheckVector3(L, 2) - *CheckVector3(L, 3);
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vector4* out = CheckVector4(L, 1);
+            *out = *CheckVector4(L, 2) - *CheckVector4(L, 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s) as arguments.", SCRIPT_LIB_NAME, "sub", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        lua_pushvalue(L, 1);
+        return 1;
+    }
+
+    /*# multiplies in place
+     *
+     * Stores `a * b` in `out`, without creating a new value. `out` may be one of the arguments.
+     * Supports the same combinations as the `*` operator:
+     *
+     * - vector3 or vector4 multiplied with a number
+     * - quaternion multiplied with a quaternion
+     * - matrix4 multiplied with a matrix4 or a number
+     * - matrix4 multiplied with a vector4, stored in a vector4
+     *
+     * @name vmath.mul
+     * @param out [type:vector3|vector4|quaternion|matrix4] value to store the result in
+     * @param a [type:vector3|vector4|quaternion|matrix4] first operand
+     * @param b [type:number|quaternion|matrix4|vector4] second operand
+     * @return out [type:vector3|vector4|quaternion|matrix4] the modified value
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     vmath.mul(self.step, self.velocity, dt)
+     *     vmath.add(self.position, self.position, self.step)
+     * end
+     * ```
+     */
+    static int Mul(lua_State* L)
+    {
+        const ScriptUserType out_type = GetType(L, 1);
+        const ScriptUserType type = GetType(L, 2);
+        if (out_type == SCRIPT_TYPE_VECTOR3 && type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vector3* out = CheckVector3(L, 1);
+            *out = *CheckVector3(L, 2) * (float)luaL_checknumber(L, 3);
+        }
+        else if (out_type == SCRIPT_TYPE_VECTOR4 && type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vector4* out = CheckVector4(L, 1);
+            *out = *CheckVector4(L, 2) * (float)luaL_checknumber(L, 3);
+        }
+        else if (out_type == SCRIPT_TYPE_QUAT && type == SCRIPT_TYPE_QUAT)
+        {
+            Quat* out = CheckQuat(L, 1);
+            *out = *CheckQuat(L, 2) * *CheckQuat(L, 3);
+        }
+        else if (out_type == SCRIPT_TYPE_MATRIX4 && type == SCRIPT_TYPE_MATRIX4)
+        {
+            Matrix4* out = CheckMatrix4(L, 1);
+            if (lua_type(L, 3) == LUA_TNUMBER)
+                *out = *CheckMatrix4(L, 2) * (float)lua_tonumber(L, 3);
+            else
+                *out = *CheckMatrix4(L, 2) * *CheckMatrix4(L, 3);
+        }
+        else if (out_type == SCRIPT_TYPE_VECTOR4 && type == SCRIPT_TYPE_MATRIX4)
+        {
+            Vector4* out = CheckVector4(L, 1);
+            *out = *CheckMatrix4(L, 2) * *CheckVector4(L, 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s got an unsupported combination of arguments.", SCRIPT_LIB_NAME, "mul");
+        }
+        lua_pushvalue(L, 1);
+        return 1;
+    }
+
     static const luaL_reg methods[] =
     {
         {SCRIPT_TYPE_NAME_VECTOR, Vector_new},
@@ -2335,6 +2540,10 @@ namespace dmScript
         {"inv", Inverse},
         {"ortho_inv", OrthoInverse},
         {"mul_per_elem", MulPerElem},
+        {"set", Set},
+        {"add", Add},
+        {"sub", Sub},
+        {"mul", Mul},
         {0, 0}
     };
 
@@ -2369,6 +2578,7 @@ namespace dmScript
 
     void PushVector(lua_State* L, FloatVector* v)
     {
+        DM_PROPERTY_ADD_U32(rmtp_VMathAllocations, 1);
         FloatVector** vp = (FloatVector**)lua_newuserdata(L, sizeof(FloatVector*));
         *vp = v;
         luaL_getmetatable(L, SCRIPT_TYPE_NAME_VECTOR);
@@ -2382,6 +2592,7 @@ namespace dmScript
 
     void PushVector3(lua_State* L, const Vector3& v)
     {
+        DM_PROPERTY_ADD_U32(rmtp_VMathAllocations, 1);
         Vector3* vp = (Vector3*)lua_newuserdata(L, sizeof(Vector3));
         *vp = v;
         luaL_getmetatable(L, SCRIPT_TYPE_NAME_VECTOR3);
@@ -2400,6 +2611,7 @@ namespace dmScript
 
     void PushVector4(lua_State* L, const Vector4& v)
     {
+        DM_PROPERTY_ADD_U32(rmtp_VMathAllocations, 1);
         Vector4* vp = (Vector4*)lua_newuserdata(L, sizeof(Vector4));
         *vp = v;
         luaL_getmetatable(L, SCRIPT_TYPE_NAME_VECTOR4);
@@ -2418,6 +2630,7 @@ namespace dmScript
 
     void PushQuat(lua_State* L, const Quat& q)
     {
+        DM_PROPERTY_ADD_U32(rmtp_VMathAllocations, 1);
         Quat* qp = (Quat*)lua_newuserdata(L, sizeof(Quat));
         *qp = q;
         luaL_getmetatable(L, SCRIPT_TYPE_NAME_QUAT);
@@ -2436,6 +2649,7 @@ namespace dmScript
 
     void PushMatrix4(lua_State* L, const Matrix4& m)
     {
+        DM_PROPERTY_ADD_U32(rmtp_VMathAllocations, 1);
         Matrix4* mp = (Matrix4*)lua_newuserdata(L, sizeof(Matrix4));
         *mp = m;
         luaL_getmetatable(L, SCRIPT_TYPE_NAME_MATRIX4);
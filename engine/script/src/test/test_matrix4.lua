@@ -169,3 +169,13 @@ m.c1 = vmath.vector4(-10.01,-10.01,-10.01,-10.01)
 m.c2 = vmath.vector4(-10.01,-10.01,-10.01,-10.01)
 m.c3 = vmath.vector4(-10.01,-10.01,-10.01,-10.01)
 assert(tostring(m) == ("" .. m))
+
+-- in place operations
+local out = vmath.matrix4()
+vmath.set(out, vmath.matrix4_translation(vmath.vector4(1, 2, 3, 1)))
+assert(out.m03 == 1 and out.m13 == 2 and out.m23 == 3, "set")
+vmath.mul(out, out, vmath.matrix4_translation(vmath.vector4(1, 1, 1, 1)))
+assert(out.m03 == 2 and out.m13 == 3 and out.m23 == 4, "mul")
+local v = vmath.vector4()
+vmath.mul(v, out, vmath.vector4(0, 0, 0, 1))
+assert(v == vmath.vector4(2, 3, 4, 1), "mul vector4")
@@ -13,6 +13,8 @@
 // specific language governing permissions and limitations under the License.
 
 #include "script.h"
+#include "script_private.h"
+#include "script_alloc.h"
 #include "test_script.h"
 #include "test_script_private.h"
 
@@ -489,6 +491,144 @@ TEST_F(ScriptTestLua, TestErrorHandlerFunction)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+TEST_F(ScriptTestLua, TestAllocatorStats)
+{
+    dmScript::LuaAllocatorStats stats;
+    if (!dmScript::GetLuaAllocatorStats(m_Context, &stats))
+    {
+        return; // The Lua state uses the default allocator on this platform
+    }
+    dmScript::ResetLuaAllocatorCounters(m_Context);
+
+    ASSERT_TRUE(RunString(L, "_tables = {} for i = 1, 1000 do _tables[i] = { i, tostring(i) } end"));
+
+    dmScript::LuaAllocatorStats after;
+    ASSERT_TRUE(dmScript::GetLuaAllocatorStats(m_Context, &after));
+    ASSERT_LT(1000U, after.m_AllocationCount);
+    ASSERT_LT(stats.m_Bytes, after.m_Bytes);
+    ASSERT_LE(after.m_Bytes, after.m_PeakBytes);
+    ASSERT_LT(0U, after.m_PageBytes);
+
+    uint64_t total = 0;
+    for (uint32_t i = 0; i <= dmScript::LUA_ALLOCATOR_SIZE_CLASS_COUNT; ++i)
+    {
+        total += after.m_SizeClassBytes[i];
+    }
+    ASSERT_EQ(after.m_Bytes, total);
+
+    ASSERT_TRUE(RunString(L, "_tables = nil collectgarbage()"));
+    dmScript::LuaAllocatorStats collected;
+    ASSERT_TRUE(dmScript::GetLuaAllocatorStats(m_Context, &collected));
+    ASSERT_GT(after.m_Bytes, collected.m_Bytes);
+    ASSERT_EQ(after.m_PeakBytes, collected.m_PeakBytes);
+    // The pages that only held the tables are released
+    ASSERT_GT(after.m_PageBytes, collected.m_PageBytes);
+}
+
+static uint64_t SumSizeClassBytes(const dmScript::LuaAllocatorStats& stats)
+{
+    uint64_t total = 0;
+    for (uint32_t i = 0; i <= dmScript::LUA_ALLOCATOR_SIZE_CLASS_COUNT; ++i)
+    {
+        total += stats.m_SizeClassBytes[i];
+    }
+    return total;
+}
+
+// Uses the allocator directly, so that it is tested also where the Lua state can't use it
+TEST(LuaAllocator, AllocReallocFree)
+{
+    dmScript::HLuaAllocator allocator = dmScript::NewLuaAllocator();
+    dmScript::LuaAllocatorStats stats;
+
+    const uint32_t count = 4000;
+    const size_t small_size = 24;
+    void** blocks = new void*[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        blocks[i] = dmScript::LuaAlloc(allocator, 0, 0, small_size);
+        ASSERT_NE((void*)0, blocks[i]);
+        ASSERT_EQ(0U, (uintptr_t)blocks[i] & 15);
+        memset(blocks[i], i & 0xff, small_size);
+    }
+    dmScript::GetLuaAllocatorStats(allocator, &stats);
+    ASSERT_EQ(count, stats.m_AllocationCount);
+    ASSERT_EQ(count * small_size, stats.m_Bytes);
+    ASSERT_EQ(count * small_size, stats.m_SizeClassBytes[1]);
+    ASSERT_EQ(stats.m_Bytes, SumSizeClassBytes(stats));
+    ASSERT_LE(count * 32, stats.m_PageBytes);
+    uint64_t full_page_bytes = stats.m_PageBytes;
+
+    // Within the size class, then to a larger class, then to a large block
+    const size_t large_size = dmScript::LUA_ALLOCATOR_MAX_SMALL_SIZE + 1000;
+    blocks[0] = dmScript::LuaAlloc(allocator, blocks[0], small_size, 32);
+    blocks[0] = dmScript::LuaAlloc(allocator, blocks[0], 32, 100);
+    blocks[0] = dmScript::LuaAlloc(allocator, blocks[0], 100, large_size);
+    ASSERT_NE((void*)0, blocks[0]);
+    for (uint32_t i = 0; i < small_size; ++i)
+    {
+        ASSERT_EQ(0, ((uint8_t*)blocks[0])[i]);
+    }
+    dmScript::GetLuaAllocatorStats(allocator, &stats);
+    ASSERT_EQ((count - 1) * small_size, stats.m_SizeClassBytes[1]);
+    ASSERT_EQ(0U, stats.m_SizeClassBytes[6]);
+    ASSERT_EQ(large_size, stats.m_SizeClassBytes[dmScript::LUA_ALLOCATOR_SIZE_CLASS_COUNT]);
+    ASSERT_EQ(stats.m_Bytes, SumSizeClassBytes(stats));
+    ASSERT_EQ((count - 1) * small_size + large_size, stats.m_Bytes);
+    ASSERT_LE(stats.m_Bytes, stats.m_PeakBytes);
+
+    // And back to a small block
+    blocks[0] = dmScript::LuaAlloc(allocator, blocks[0], large_size, small_size);
+    ASSERT_NE((void*)0, blocks[0]);
+    ASSERT_EQ(0, ((uint8_t*)blocks[0])[small_size - 1]);
+
+    dmScript::ResetLuaAllocatorCounters(allocator);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ((uint8_t)(i & 0xff), ((uint8_t*)blocks[i])[small_size - 1]);
+        ASSERT_EQ((void*)0, dmScript::LuaAlloc(allocator, blocks[i], small_size, 0));
+    }
+    delete[] blocks;
+
+    dmScript::GetLuaAllocatorStats(allocator, &stats);
+    ASSERT_EQ(0U, stats.m_AllocationCount);
+    ASSERT_EQ(count, stats.m_FreeCount);
+    ASSERT_EQ(0U, stats.m_Bytes);
+    ASSERT_EQ(0U, SumSizeClassBytes(stats));
+    // The emptied pages are released, except one per size class that was used (24 and 100 bytes)
+    ASSERT_GT(full_page_bytes, stats.m_PageBytes);
+    ASSERT_EQ(2U * 32U * 1024U, stats.m_PageBytes);
+
+    // Freeing a null pointer does nothing
+    ASSERT_EQ((void*)0, dmScript::LuaAlloc(allocator, 0, 0, 0));
+
+    dmScript::DeleteLuaAllocator(allocator);
+}
+
+TEST_F(ScriptTestLua, TestGCBudget)
+{
+    ASSERT_TRUE(RunString(L, "collectgarbage()"));
+    int base = lua_gc(L, LUA_GCCOUNT, 0);
+
+    dmScript::SetGCBudget(m_Context, 1000);
+
+    // The collector waits longer before it starts a cycle by itself
+    ASSERT_TRUE(RunString(L, "for i = 1, 10000 do local t = { i } end"));
+    int garbage = lua_gc(L, LUA_GCCOUNT, 0);
+    ASSERT_LT(base, garbage);
+
+    for (int i = 0; i < 1000 && lua_gc(L, LUA_GCCOUNT, 0) >= garbage; ++i)
+    {
+        dmScript::Update(m_Context);
+    }
+    ASSERT_GT(garbage, lua_gc(L, LUA_GCCOUNT, 0));
+
+    // The collector still runs when the script allocates a lot without any update
+    ASSERT_TRUE(RunString(L, "for i = 1, 1000000 do local t = { i } end"));
+    ASSERT_GT(16 * 1024, lua_gc(L, LUA_GCCOUNT, 0));
+
+    dmScript::SetGCBudget(m_Context, 0);
+}
 
 struct CallbackArgs
 {
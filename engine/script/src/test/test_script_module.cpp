@@ -21,6 +21,8 @@
 #include <testmain/testmain.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/sys.h>
+#include <dlib/testutil.h>
 
 class ScriptModuleTest : public dmScriptTest::ScriptTest
 {
@@ -135,6 +137,121 @@ TEST_F(ScriptModuleTest, TestReloadNotLoaded)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+struct LazyModuleContext
+{
+    const char* m_Script;
+    uint32_t    m_LoadCount;
+    bool        m_Fail;
+};
+
+static bool LoadLazyModule(dmScript::HContext context, const char* resource_path, void* user_context, void** resource, dmLuaDDF::LuaSource** source)
+{
+    LazyModuleContext* lazy_context = (LazyModuleContext*) user_context;
+    lazy_context->m_LoadCount++;
+    if (lazy_context->m_Fail)
+    {
+        return false;
+    }
+    *resource = 0;
+    *source = LuaSourceFromText(lazy_context->m_Script);
+    return true;
+}
+
+TEST_F(ScriptModuleTest, TestLazyModule)
+{
+    int top = lua_gettop(L);
+    LazyModuleContext lazy_context;
+    lazy_context.m_Script = "module(..., package.seeall)\n function f1()\n return 123\n end\n";
+    lazy_context.m_LoadCount = 0;
+    lazy_context.m_Fail = false;
+    const char* script_file_name = "x.test_mod";
+    dmhash_t path_hash = dmHashString64("/x/test_mod.luac");
+
+    dmScript::Result ret = dmScript::AddLazyModule(m_Context, script_file_name, "/x/test_mod.luac", path_hash, LoadLazyModule, &lazy_context);
+    ASSERT_EQ(dmScript::RESULT_OK, ret);
+    ASSERT_TRUE(dmScript::ModuleLoaded(m_Context, script_file_name));
+    ASSERT_TRUE(dmScript::ModuleLoaded(m_Context, path_hash));
+    ASSERT_EQ(0u, lazy_context.m_LoadCount);
+
+    // Reloading a module that hasn't been required yet doesn't load it
+    ret = dmScript::ReloadModule(m_Context, LuaSourceFromText(lazy_context.m_Script), path_hash);
+    ASSERT_EQ(dmScript::RESULT_OK, ret);
+    ASSERT_EQ(0u, lazy_context.m_LoadCount);
+
+    ASSERT_TRUE(RunFile(L, "test_module.luac"));
+    ASSERT_EQ(1u, lazy_context.m_LoadCount);
+    ASSERT_TRUE(RunString(L, "require \"x.test_mod\""));
+    ASSERT_EQ(1u, lazy_context.m_LoadCount);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(ScriptModuleTest, TestLazyModuleFail)
+{
+    int top = lua_gettop(L);
+    LazyModuleContext lazy_context;
+    lazy_context.m_Script = "";
+    lazy_context.m_LoadCount = 0;
+    lazy_context.m_Fail = true;
+
+    dmScript::Result ret = dmScript::AddLazyModule(m_Context, "x.test_mod", "/x/test_mod.luac", dmHashString64("/x/test_mod.luac"), LoadLazyModule, &lazy_context);
+    ASSERT_EQ(dmScript::RESULT_OK, ret);
+    ASSERT_FALSE(RunString(L, "require \"x.test_mod\""));
+    ASSERT_EQ(1u, lazy_context.m_LoadCount);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+static int LoadAndCall(lua_State* L, const char* script)
+{
+    if (dmScript::LuaLoad(L, LuaSourceFromText(script)) != 0)
+    {
+        lua_pop(L, 1);
+        return -1;
+    }
+    lua_call(L, 0, 1);
+    int result = (int) lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    return result;
+}
+
+TEST_F(ScriptModuleTest, TestBytecodeCache)
+{
+    int top = lua_gettop(L);
+    char path[1024];
+    dmTestUtil::MakeHostPath(path, sizeof(path), "build/src/test/test_bytecode.cache");
+    dmSys::Unlink(path);
+
+    dmScript::HBytecodeCache cache = dmScript::NewBytecodeCache(path, "version_a");
+    ASSERT_EQ(0u, dmScript::GetBytecodeCacheEntryCount(cache));
+    dmScript::SetBytecodeCache(m_Context, cache);
+    ASSERT_EQ(3, LoadAndCall(L, "return 1 + 2"));
+    ASSERT_EQ(1u, dmScript::GetBytecodeCacheEntryCount(cache));
+    ASSERT_EQ(3, LoadAndCall(L, "return 1 + 2"));
+    ASSERT_EQ(1u, dmScript::GetBytecodeCacheEntryCount(cache));
+    // Chunks that fail to compile aren't cached
+    ASSERT_EQ(-1, LoadAndCall(L, "return +"));
+    ASSERT_EQ(1u, dmScript::GetBytecodeCacheEntryCount(cache));
+    ASSERT_TRUE(dmScript::SaveBytecodeCache(cache));
+    dmScript::SetBytecodeCache(m_Context, 0);
+    dmScript::DeleteBytecodeCache(cache);
+
+    // Same engine version, the chunk is read from the file
+    cache = dmScript::NewBytecodeCache(path, "version_a");
+    ASSERT_EQ(1u, dmScript::GetBytecodeCacheEntryCount(cache));
+    dmScript::SetBytecodeCache(m_Context, cache);
+    ASSERT_EQ(3, LoadAndCall(L, "return 1 + 2"));
+    ASSERT_EQ(1u, dmScript::GetBytecodeCacheEntryCount(cache));
+    dmScript::SetBytecodeCache(m_Context, 0);
+    dmScript::DeleteBytecodeCache(cache);
+
+    // Another engine version discards the file
+    cache = dmScript::NewBytecodeCache(path, "version_b");
+    ASSERT_EQ(0u, dmScript::GetBytecodeCacheEntryCount(cache));
+    dmScript::DeleteBytecodeCache(cache);
+
+    dmSys::Unlink(path);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 extern "C" void dmExportedSymbols();
 
 int main(int argc, char **argv)
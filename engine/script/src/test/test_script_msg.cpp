@@ -43,10 +43,21 @@ static int GetURLCallback(lua_State* L)
     return 1;
 }
 
+// Components named "script" are scripts in the same Lua state
+static int IsScriptReceiverCallback(lua_State* L)
+{
+    uint32_t* user_data = (uint32_t*)lua_touserdata(L, 1);
+    assert(*user_data == 1);
+    dmMessage::URL* url = dmScript::CheckURL(L, 2);
+    lua_pushboolean(L, url->m_Fragment == dmHashString64("script"));
+    return 1;
+}
+
 static const luaL_reg META_TABLE[] =
 {
-    {dmScript::META_TABLE_RESOLVE_PATH, ResolvePathCallback},
-    {dmScript::META_TABLE_GET_URL,      GetURLCallback},
+    {dmScript::META_TABLE_RESOLVE_PATH,       ResolvePathCallback},
+    {dmScript::META_TABLE_GET_URL,            GetURLCallback},
+    {dmScript::META_TABLE_IS_SCRIPT_RECEIVER, IsScriptReceiverCallback},
     {0, 0}
 };
 
@@ -596,7 +607,7 @@ void DispatchCallbackTable(dmMessage::Message *message, void* user_ptr)
 {
     assert(message->m_Id == dmHashString64("table"));
     TableUserData* user_data = (TableUserData*)user_ptr;
-    dmScript::PushTable(user_data->L, (const char*)message->m_Data, message->m_DataSize);
+    dmScript::PushMessageTable(user_data->L, message);
     lua_getfield(user_data->L, -1, "uint_value");
     user_data->m_TestValue = (uint32_t) lua_tonumber(user_data->L, -1);
     lua_pop(user_data->L, 2);
@@ -680,6 +691,66 @@ TEST_F(ScriptMsgTest, TestPost)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+void DispatchCallbackTableRef(dmMessage::Message *message, void* user_ptr)
+{
+    lua_State* L = (lua_State*)user_ptr;
+    dmScript::PushMessageTable(L, message);
+    lua_setglobal(L, "received");
+}
+
+// Native receivers only know about the binary table format
+void DispatchCallbackTableBinary(dmMessage::Message *message, void* user_ptr)
+{
+    lua_State* L = (lua_State*)user_ptr;
+    assert(message->m_DestroyCallback == 0);
+    dmScript::PushTable(L, (const char*)message->m_Data, message->m_DataSize);
+    lua_setglobal(L, "received");
+}
+
+TEST_F(ScriptMsgTest, TestPostTableSameSocket)
+{
+    int top = lua_gettop(L);
+
+    ASSERT_TRUE(dmScriptTest::RunString(L,
+        "sent = {uint_value = 1, position = vmath.vector3(1, 2, 3), nested = {url = msg.url(\"path2#fragment2\")}}\n"
+        "msg.post(\"path2#script\", \"table\", sent)\n"
+        "sent.uint_value = 2\n"
+        "sent.position.x = 4\n"
+        "sent.nested.url.fragment = hash(\"fragment3\")\n"
+        ));
+    ASSERT_EQ(1u, dmMessage::Dispatch(m_DefaultURL.m_Socket, DispatchCallbackTableRef, L));
+
+    // The receiver gets a copy of the table as it was when it was posted
+    ASSERT_TRUE(dmScriptTest::RunString(L,
+        "assert(received ~= sent)\n"
+        "assert(received.uint_value == 1)\n"
+        "assert(received.position == vmath.vector3(1, 2, 3))\n"
+        "assert(received.nested.url.fragment == hash(\"fragment2\"))\n"
+        "received = nil\n"
+        "sent = nil\n"
+        ));
+
+    // Receivers that aren't scripts get the encoded table
+    ASSERT_TRUE(dmScriptTest::RunString(L,
+        "msg.post(\"path2#fragment2\", \"table\", {uint_value = 1, position = vmath.vector3(1, 2, 3)})\n"
+        ));
+    ASSERT_EQ(1u, dmMessage::Dispatch(m_DefaultURL.m_Socket, DispatchCallbackTableBinary, L));
+    ASSERT_TRUE(dmScriptTest::RunString(L,
+        "assert(received.uint_value == 1)\n"
+        "assert(received.position == vmath.vector3(1, 2, 3))\n"
+        "received = nil\n"
+        ));
+
+    // Undelivered messages release their table
+    ASSERT_TRUE(dmScriptTest::RunString(L,
+        "msg.post(\"path2#script\", \"table\", {uint_value = 1})\n"
+        ));
+    dmMessage::DeleteSocket(m_DefaultURL.m_Socket);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("default_socket", &m_DefaultURL.m_Socket));
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 TEST_F(ScriptMsgTest, TestFailPost)
 {
     int top = lua_gettop(L);
@@ -763,6 +834,32 @@ TEST_F(ScriptMsgTest, TestPerf)
     printf("Time per post: %.4f\n", time / (double)count);
 }
 
+// Post and dispatch of a table to a script in the same Lua state (passed by reference) and to another receiver (encoded)
+TEST_F(ScriptMsgTest, TestPerfSameState)
+{
+    const uint32_t count = 10000;
+    const char* receivers[] = {"path2#script", "path2#fragment2"};
+    dmMessage::DispatchCallback callbacks[] = {DispatchCallbackTableRef, DispatchCallbackTableBinary};
+    for (uint32_t r = 0; r < 2; ++r)
+    {
+        char program[512];
+        dmSnPrintf(program, sizeof(program),
+            "for i = 1,%u do\n"
+            "    msg.post(\"%s\", \"table\", {id = i, name = \"enemy\", position = vmath.vector3(i, 2, 3), tags = {\"a\", \"b\", \"c\"}})\n"
+            "end\n",
+            count, receivers[r]);
+
+        uint64_t time = dmTime::GetTime();
+        ASSERT_TRUE(dmScriptTest::RunString(L, program));
+        uint64_t post_time = dmTime::GetTime() - time;
+        ASSERT_EQ(count, dmMessage::Dispatch(m_DefaultURL.m_Socket, callbacks[r], L));
+        time = dmTime::GetTime() - time;
+        printf("%s: time per post: %.4f us, per post and dispatch: %.4f us\n", receivers[r], post_time / (double)count, time / (double)count);
+    }
+    lua_pushnil(L);
+    lua_setglobal(L, "received");
+}
+
 TEST_F(ScriptMsgTest, TestPostDeletedSocket)
 {
     dmMessage::HSocket socket;
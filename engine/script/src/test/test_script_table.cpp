@@ -43,6 +43,12 @@ class LuaTableTest : public dmScriptTest::ScriptTest
 {
 };
 
+static int ProtectedPushTableCopy(lua_State* L)
+{
+    dmScript::PushTableCopy(L, 1, (uint32_t) luaL_checkinteger(L, 2));
+    return 1;
+}
+
 TEST_F(LuaTableTest, EmptyTable)
 {
     lua_newtable(L);
@@ -115,7 +121,7 @@ TEST_F(LuaTableTest, AttemptReadUnsupportedVersion)
     int result = lua_cpcall(L, ReadUnsupportedVersion, 0x0);
     ASSERT_NE(0, result);
     char str[256];
-    dmSnPrintf(str, sizeof(str), "Unsupported serialized table data: version = 0x%x (current = 0x%x)", 818192, 4);
+    dmSnPrintf(str, sizeof(str), "Unsupported serialized table data: version = 0x%x (current = 0x%x)", 818192, 5);
     ASSERT_STREQ(str, lua_tostring(L, -1));
     // pop error message
     lua_pop(L, 1);
@@ -653,6 +659,120 @@ TEST_F(LuaTableTest, TSTRING) // binary strings (def2821)
     lua_pop(L, 1);
 }
 
+TEST_F(LuaTableTest, RepeatedStrings)
+{
+    ASSERT_TRUE(RunString(L, " \
+        t = {} \
+        for i=1,100 do \
+            t[i] = { name = 'enemy', state = 'idle', ['\\0key'] = 'value\\0' } \
+        end \
+    "));
+
+    lua_getglobal(L, "t");
+    uint32_t size = dmScript::CheckTableSize(L, -1);
+    char* buf;
+    dmMemory::AlignedMalloc((void**)&buf, 16, size);
+    uint32_t buffer_used = dmScript::CheckTable(L, buf, size, -1);
+    ASSERT_EQ(size, buffer_used);
+    // Each string is written once, the rest are references. Written out, the strings alone take 52 bytes per element.
+    ASSERT_LT(buffer_used, 100 * 48u);
+    lua_pop(L, 1);
+
+    dmScript::PushTable(L, buf, buffer_used);
+    lua_setglobal(L, "t2");
+    dmMemory::AlignedFree(buf);
+
+    ASSERT_TRUE(RunString(L, " \
+        assert(#t2 == 100) \
+        for i=1,100 do \
+            assert(t2[i].name == 'enemy') \
+            assert(t2[i].state == 'idle') \
+            assert(t2[i]['\\0key'] == 'value\\0') \
+        end \
+    "));
+}
+
+TEST_F(LuaTableTest, SerializeTable)
+{
+    ASSERT_TRUE(RunString(L, " \
+        t = { v = vmath.vector3(1, 2, 3), h = hash('hashed value'), n = { 1, 2, 3 } } \
+        for i=1,10000 do \
+            t['key' .. i] = i \
+        end \
+    "));
+
+    lua_getglobal(L, "t");
+    char* buf = 0;
+    uint32_t buffer_used = dmScript::SerializeTable(L, -1, &buf);
+    ASSERT_NE((char*)0, buf);
+    ASSERT_EQ(dmScript::CheckTableSize(L, -1), buffer_used);
+
+    const char* temp_buf = 0;
+    ASSERT_EQ(buffer_used, dmScript::SerializeTableTemp(L, -1, &temp_buf));
+    ASSERT_EQ(0, memcmp(buf, temp_buf, buffer_used));
+    lua_pop(L, 1);
+
+    dmScript::PushTable(L, buf, buffer_used);
+    lua_setglobal(L, "t2");
+    dmMemory::AlignedFree(buf);
+
+    ASSERT_TRUE(RunString(L, " \
+        assert(t2.v == vmath.vector3(1, 2, 3)) \
+        assert(t2.h == hash('hashed value')) \
+        assert(#t2.n == 3 and t2.n[3] == 3) \
+        for i=1,10000 do \
+            assert(t2['key' .. i] == i) \
+        end \
+    "));
+}
+
+TEST_F(LuaTableTest, PushTableCopy)
+{
+    int top = lua_gettop(L);
+    ASSERT_TRUE(RunString(L, " \
+        t = { v = vmath.vector3(1, 2, 3), q = vmath.quat(1, 2, 3, 4), h = hash('hashed value'), n = { 'enemy', 'enemy', true } } \
+    "));
+
+    lua_getglobal(L, "t");
+    dmMessage::URL url = dmMessage::URL();
+    url.m_Socket = 1;
+    url.m_Path = 2;
+    url.m_Fragment = 3;
+    dmScript::PushURL(L, url);
+    lua_setfield(L, -2, "u");
+
+    uint32_t size = dmScript::CheckTableSize(L, -1);
+    char* buf;
+    dmMemory::AlignedMalloc((void**)&buf, 16, size);
+    ASSERT_EQ(size, dmScript::CheckTable(L, buf, size, -1));
+    dmMemory::AlignedFree(buf);
+
+    ASSERT_EQ(size, dmScript::PushTableCopy(L, -1, size));
+    lua_setglobal(L, "t2");
+    lua_pop(L, 1);
+
+    ASSERT_TRUE(RunString(L, " \
+        assert(t2 ~= t and t2.n ~= t.n) \
+        t.v.x = 4 \
+        t.u.fragment = hash('d') \
+        assert(t2.v == vmath.vector3(1, 2, 3)) \
+        assert(t2.q == vmath.quat(1, 2, 3, 4)) \
+        assert(t2.h == hash('hashed value')) \
+        assert(t2.u.fragment ~= t.u.fragment) \
+        assert(#t2.n == 3 and t2.n[2] == 'enemy' and t2.n[3] == true) \
+    "));
+
+    // The same size limit as CheckTable
+    lua_getglobal(L, "t");
+    lua_pushcfunction(L, ProtectedPushTableCopy);
+    lua_pushvalue(L, -2);
+    lua_pushinteger(L, size - 1);
+    ASSERT_NE(0, lua_pcall(L, 2, 1, 0));
+    ASSERT_NE((const char*)0, strstr(lua_tostring(L, -1), "too small for table"));
+    lua_pop(L, 2);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 TEST_F(LuaTableTest, Vector3)
 {
     // Create table
@@ -941,6 +1061,39 @@ TEST_F(LuaTableTest, CorruptedTables)
     ASSERT_EQ(top, lua_gettop(L));
 }
 
+TEST_F(LuaTableTest, TruncatedOversizedCount)
+{
+    int top = lua_gettop(L);
+
+    lua_newtable(L);
+    lua_pushnumber(L, 2);
+    lua_rawseti(L, -2, 1);
+    lua_pushnumber(L, 4);
+    lua_rawseti(L, -2, 2);
+
+    memset(g_Buf, 0, sizeof(g_Buf));
+    uint32_t buffer_used = dmScript::CheckTable(L, g_Buf, sizeof(g_Buf), -1);
+    lua_pop(L, 1);
+
+    // The element count follows the 8 byte header (magic and version)
+    uint32_t count = 0x7fffffff;
+    memcpy(g_Buf + 8, &count, sizeof(count));
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    int memory_kb = lua_gc(L, LUA_GCCOUNT, 0);
+
+    // The table isn't preallocated for the corrupt count, the read fails when the buffer ends
+    lua_pushcfunction(L, ParseTruncatedTable);
+    lua_pushlstring(L, g_Buf, buffer_used);
+    lua_pushnumber(L, buffer_used);
+    int res = lua_pcall(L, 2, 0, 0x0);
+    ASSERT_EQ(LUA_ERRRUN, res);
+    ASSERT_LT(lua_gc(L, LUA_GCCOUNT, 0) - memory_kb, 64);
+    lua_pop(L, 1);
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 static void RandomString(char* s, int max_len)
 {
     int n = rand() % max_len + 1;
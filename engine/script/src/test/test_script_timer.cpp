@@ -706,6 +706,52 @@ TEST_F(ScriptTimerTest, TestKillTimers)
     dmScript::DeleteTimerWorld(timer_world);
 }
 
+TEST_F(ScriptTimerTest, TestManyLongLivedTimers)
+{
+    dmScript::HTimerWorld timer_world = dmScript::NewTimerWorld();
+
+    const uint32_t count = 20000;
+    dmArray<dmScript::HTimer> handles;
+    handles.SetCapacity(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        // Expires in reverse order of creation
+        dmScript::HTimer handle = dmScript::AddTimer(timer_world, 100.f + (count - i), false, TestCallback, 0x10, 0x0);
+        ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, handle);
+        handles.Push(handle);
+    }
+    dmScript::HTimer short_handle = dmScript::AddTimer(timer_world, 1.f, true, TestCallback, 0x10, 0x0);
+    ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, short_handle);
+
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        dmScript::UpdateTimers(timer_world, 1.f);
+    }
+    ASSERT_EQ(10u, TimerTestCallback::callback_count);
+    ASSERT_EQ(count + 1, GetAliveTimers(timer_world));
+
+    // Cancel every other long lived timer, the rest fire one per update
+    for (uint32_t i = 0; i < count; i += 2)
+    {
+        ASSERT_TRUE(dmScript::CancelTimer(timer_world, handles[i]));
+    }
+    ASSERT_TRUE(dmScript::CancelTimer(timer_world, short_handle));
+    ASSERT_EQ(count / 2, GetAliveTimers(timer_world));
+
+    dmScript::UpdateTimers(timer_world, 90.f); // time is 100
+    ASSERT_EQ(10u, TimerTestCallback::callback_count);
+    dmScript::UpdateTimers(timer_world, 1.f); // time is 101, the last timer (odd index) fires
+    ASSERT_EQ(11u, TimerTestCallback::callback_count);
+    ASSERT_FALSE(dmScript::CancelTimer(timer_world, handles[count - 1]));
+    ASSERT_TRUE(dmScript::CancelTimer(timer_world, handles[count - 3]));
+
+    uint32_t kill_count = dmScript::KillTimers(timer_world, 0x10);
+    ASSERT_EQ(count / 2 - 2, kill_count);
+    ASSERT_EQ(0u, GetAliveTimers(timer_world));
+
+    dmScript::DeleteTimerWorld(timer_world);
+}
+
 static dmScript::HTimer cb_callback_handle = dmScript::INVALID_TIMER_HANDLE;
 static uint32_t cb_callback_counter = 0u;
 static float cb_elapsed_time = 0.0f;
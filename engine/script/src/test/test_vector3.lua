@@ -130,3 +130,16 @@ assert(("foo " .. tostring(v)) == "foo vmath.vector3(1, 2, 3)")
 assert(("foo " .. v) == "foo vmath.vector3(1, 2, 3)")
 v = vmath.vector3(-10.01, -10.01, -10.01)
 assert(tostring(v) == ("" .. v))
+
+-- in place operations
+local out = vmath.vector3()
+assert(vmath.set(out, 1, 2, 3) == out)
+assert(out == vmath.vector3(1, 2, 3), "set")
+vmath.set(out, vmath.vector3(4, 5, 6))
+assert(out == vmath.vector3(4, 5, 6), "set from vector3")
+assert(vmath.add(out, out, vmath.vector3(1, 1, 1)) == out)
+assert(out == vmath.vector3(5, 6, 7), "add")
+vmath.sub(out, out, vmath.vector3(5, 6, 7))
+assert(out == vmath.vector3(0, 0, 0), "sub")
+vmath.mul(out, vmath.vector3(1, 2, 3), 2)
+assert(out == vmath.vector3(2, 4, 6), "mul")
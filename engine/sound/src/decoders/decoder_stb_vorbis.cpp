@@ -13,6 +13,8 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
@@ -26,33 +28,171 @@ namespace dmSoundCodec
 {
     namespace
     {
+        // Upper limit of the input buffer used when decoding streamed sound data.
+        // A single ogg page is at most ~64kb
+        const uint32_t STREAM_INPUT_SIZE_INITIAL = 16 * 1024;
+        const uint32_t STREAM_INPUT_SIZE_MAX = 256 * 1024;
+
         struct DecodeStreamInfo {
             Info m_Info;
             stb_vorbis* m_StbVorbis;
             uint32_t m_NumSamples;
+
+            // Used when the sound data isn't resident in memory, and we decode using the pushdata api
+            dmSound::HSoundData m_SoundData;
+            uint8_t* m_Input;
+            uint32_t m_InputCapacity;
+            uint32_t m_InputStart;      // First unconsumed byte in m_Input
+            uint32_t m_InputSize;       // Number of valid bytes in m_Input
+            uint32_t m_InputOffset;     // Offset in the sound data of the next byte to read
+            float**  m_Output;
+            int      m_OutputSamples;
+            int      m_OutputPos;
+            int64_t  m_SamplePos;
         };
     }
 
-    static Result StbVorbisOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
+    static bool StbVorbisFillInput(DecodeStreamInfo* streamInfo)
+    {
+        if (streamInfo->m_InputStart > 0) {
+            uint32_t remaining = streamInfo->m_InputSize - streamInfo->m_InputStart;
+            memmove(streamInfo->m_Input, streamInfo->m_Input + streamInfo->m_InputStart, remaining);
+            streamInfo->m_InputStart = 0;
+            streamInfo->m_InputSize = remaining;
+        }
+
+        if (streamInfo->m_InputSize == streamInfo->m_InputCapacity) {
+            if (streamInfo->m_InputCapacity >= STREAM_INPUT_SIZE_MAX) {
+                dmLogError("Unable to find a complete ogg page within %u bytes", STREAM_INPUT_SIZE_MAX);
+                return false;
+            }
+            streamInfo->m_InputCapacity *= 2;
+            streamInfo->m_Input = (uint8_t*) realloc(streamInfo->m_Input, streamInfo->m_InputCapacity);
+        }
+
+        uint32_t nread = 0;
+        dmSound::Result r = dmSound::GetSoundData(streamInfo->m_SoundData, streamInfo->m_Input + streamInfo->m_InputSize,
+                                                  streamInfo->m_InputCapacity - streamInfo->m_InputSize, streamInfo->m_InputOffset, &nread);
+        if (r != dmSound::RESULT_OK) {
+            return false;
+        }
+        streamInfo->m_InputSize += nread;
+        streamInfo->m_InputOffset += nread;
+        return nread > 0;
+    }
+
+    static Result StbVorbisOpenPushData(DecodeStreamInfo* streamInfo)
+    {
+        streamInfo->m_StbVorbis = 0;
+        streamInfo->m_InputStart = 0;
+        streamInfo->m_InputSize = 0;
+        streamInfo->m_InputOffset = 0;
+        streamInfo->m_Output = 0;
+        streamInfo->m_OutputSamples = 0;
+        streamInfo->m_OutputPos = 0;
+        streamInfo->m_SamplePos = 0;
+
+        // The headers must be passed in one block from the start of the file, so keep
+        // reading until stb_vorbis is satisfied
+        while (StbVorbisFillInput(streamInfo)) {
+            int used = 0;
+            int error = 0;
+            stb_vorbis* vorbis = stb_vorbis_open_pushdata(streamInfo->m_Input, (int) streamInfo->m_InputSize, &used, &error, NULL);
+            if (vorbis) {
+                streamInfo->m_StbVorbis = vorbis;
+                streamInfo->m_InputStart = (uint32_t) used;
+                return RESULT_OK;
+            }
+            if (error != VORBIS_need_more_data) {
+                break;
+            }
+        }
+        return RESULT_INVALID_FORMAT;
+    }
+
+    static inline int16_t StbVorbisFloatToShort(float f)
+    {
+        int v = (int) (f * 32768.0f);
+        return (int16_t) dmMath::Clamp(v, -32768, 32767);
+    }
+
+    static Result StbVorbisDecodePushData(DecodeStreamInfo* streamInfo, char* buffer, uint32_t buffer_size, uint32_t* decoded)
     {
-        int error;
-        stb_vorbis* vorbis = stb_vorbis_open_memory((unsigned char*) buffer, buffer_size, &error, NULL);
+        const int channels = streamInfo->m_Info.m_Channels;
+        const uint32_t frame_size = channels * sizeof(int16_t);
+        const uint32_t frames_wanted = buffer_size / frame_size;
+        uint32_t frames_done = 0;
+        int16_t* out = (int16_t*) buffer;
 
+        while (frames_done < frames_wanted) {
+            if (streamInfo->m_OutputPos < streamInfo->m_OutputSamples) {
+                uint32_t n = dmMath::Min(frames_wanted - frames_done, (uint32_t) (streamInfo->m_OutputSamples - streamInfo->m_OutputPos));
+                // A null buffer means we're skipping
+                if (out) {
+                    for (uint32_t i = 0; i < n; ++i) {
+                        for (int c = 0; c < channels; ++c) {
+                            *out++ = StbVorbisFloatToShort(streamInfo->m_Output[c][streamInfo->m_OutputPos + i]);
+                        }
+                    }
+                }
+                streamInfo->m_OutputPos += n;
+                frames_done += n;
+                continue;
+            }
+
+            int used = stb_vorbis_decode_frame_pushdata(streamInfo->m_StbVorbis,
+                                                        streamInfo->m_Input + streamInfo->m_InputStart,
+                                                        (int) (streamInfo->m_InputSize - streamInfo->m_InputStart),
+                                                        0, &streamInfo->m_Output, &streamInfo->m_OutputSamples);
+            streamInfo->m_InputStart += used;
+            streamInfo->m_OutputPos = 0;
+            if (used == 0 && streamInfo->m_OutputSamples == 0) {
+                if (!StbVorbisFillInput(streamInfo)) {
+                    // End of stream
+                    break;
+                }
+            }
+        }
+
+        streamInfo->m_SamplePos += frames_done;
+        *decoded = frames_done * frame_size;
+        return RESULT_OK;
+    }
+
+    static Result StbVorbisOpenStream(dmSound::HSoundData sound_data, HDecodeStream* stream)
+    {
+        DecodeStreamInfo *streamInfo = new DecodeStreamInfo;
+        memset(streamInfo, 0, sizeof(*streamInfo));
+
+        uint32_t buffer_size = 0;
+        const void* buffer = dmSound::GetResidentSoundData(sound_data, &buffer_size);
+        if (buffer) {
+            int error;
+            streamInfo->m_StbVorbis = stb_vorbis_open_memory((unsigned char*) buffer, buffer_size, &error, NULL);
+        } else {
+            streamInfo->m_SoundData = sound_data;
+            streamInfo->m_InputCapacity = STREAM_INPUT_SIZE_INITIAL;
+            streamInfo->m_Input = (uint8_t*) malloc(streamInfo->m_InputCapacity);
+            StbVorbisOpenPushData(streamInfo);
+        }
+
+        stb_vorbis* vorbis = streamInfo->m_StbVorbis;
         if (vorbis) {
             stb_vorbis_info info = stb_vorbis_get_info(vorbis);
 
-            DecodeStreamInfo *streamInfo = new DecodeStreamInfo;
+            // The length is only known up front when the whole file is in memory
+            streamInfo->m_NumSamples = buffer ? (uint32_t)stb_vorbis_stream_length_in_samples(vorbis) : 0;
+
             streamInfo->m_Info.m_Rate = info.sample_rate;
-            streamInfo->m_Info.m_Size = 0;
+            streamInfo->m_Info.m_Size = streamInfo->m_NumSamples * info.channels * 2;
             streamInfo->m_Info.m_Channels = info.channels;
             streamInfo->m_Info.m_BitsPerSample = 16;
-            streamInfo->m_StbVorbis = vorbis;
-
-            streamInfo->m_NumSamples = (uint32_t)stb_vorbis_stream_length_in_samples(vorbis);
 
             *stream = streamInfo;
             return RESULT_OK;
         } else {
+            free(streamInfo->m_Input);
+            delete streamInfo;
             return RESULT_INVALID_FORMAT;
         }
     }
@@ -63,6 +203,10 @@ namespace dmSoundCodec
 
         DM_PROFILE(__FUNCTION__);
 
+        if (streamInfo->m_SoundData) {
+            return StbVorbisDecodePushData(streamInfo, buffer, buffer_size, decoded);
+        }
+
         int ret = 0;
         if (streamInfo->m_Info.m_Channels == 1) {
             ret = stb_vorbis_get_samples_short_interleaved(streamInfo->m_StbVorbis, 1, (short*) buffer, buffer_size / 2);
@@ -89,7 +233,14 @@ namespace dmSoundCodec
 
     static Result StbVorbisResetStream(HDecodeStream stream)
     {
-        stb_vorbis_seek_start(((DecodeStreamInfo*)stream)->m_StbVorbis);
+        DecodeStreamInfo *streamInfo = (DecodeStreamInfo*) stream;
+        if (streamInfo->m_SoundData) {
+            // Seeking with the pushdata api loses the first frame after the seek point,
+            // so we start over from the headers instead
+            stb_vorbis_close(streamInfo->m_StbVorbis);
+            return StbVorbisOpenPushData(streamInfo);
+        }
+        stb_vorbis_seek_start(streamInfo->m_StbVorbis);
         return RESULT_OK;
     }
 
@@ -106,7 +257,10 @@ namespace dmSoundCodec
     static void StbVorbisCloseStream(HDecodeStream stream)
     {
         DecodeStreamInfo *streamInfo = (DecodeStreamInfo*) stream;
-        stb_vorbis_close(streamInfo->m_StbVorbis);
+        if (streamInfo->m_StbVorbis) {
+            stb_vorbis_close(streamInfo->m_StbVorbis);
+        }
+        free(streamInfo->m_Input);
         delete streamInfo;
     }
 
@@ -118,6 +272,9 @@ namespace dmSoundCodec
     static int64_t StbVorbisGetInternalPos(HDecodeStream stream)
     {
         DecodeStreamInfo *streamInfo = (DecodeStreamInfo *) stream;
+        if (streamInfo->m_SoundData) {
+            return streamInfo->m_SamplePos;
+        }
         return stb_vorbis_get_sample_offset(streamInfo->m_StbVorbis);
     }
 
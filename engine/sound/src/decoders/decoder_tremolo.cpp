@@ -32,26 +32,33 @@ namespace dmSoundCodec
             Info m_Info;
             OggVorbis_File m_File;
             size_t m_Size, m_Cursor;
-            const char *m_Buffer;
+            dmSound::HSoundData m_SoundData;
             ogg_int64_t m_SeekTo;
             ogg_int64_t m_PcmLength;
         };
     }
 
-    // The functions below mimic the usual fopen/fread etc functions, reading from a buffer
-    // in memory
+    // The functions below mimic the usual fopen/fread etc functions, reading from the
+    // sound data (which might be streamed)
     static size_t OggRead(void *ptr, size_t size, size_t nmemb, void *datasource)
     {
         DecodeStreamInfo *info = (DecodeStreamInfo*) datasource;
 
+        if (info->m_Cursor >= info->m_Size) {
+            return 0;
+        }
+
         size_t tot = nmemb * size;
         if (tot > (info->m_Size - info->m_Cursor)) {
             tot = info->m_Size - info->m_Cursor;
         }
 
-        memcpy(ptr, &info->m_Buffer[info->m_Cursor], tot);
-        info->m_Cursor += tot;
-        return tot;
+        uint32_t nread = 0;
+        if (dmSound::GetSoundData(info->m_SoundData, ptr, (uint32_t) tot, (uint32_t) info->m_Cursor, &nread) != dmSound::RESULT_OK) {
+            return 0;
+        }
+        info->m_Cursor += nread;
+        return nread;
     }
 
     static int OggSeek(void *datasource, long long offset, int whence)
@@ -80,11 +87,11 @@ namespace dmSoundCodec
         return info->m_Cursor;
     }
 
-    static Result TremoloOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
+    static Result TremoloOpenStream(dmSound::HSoundData sound_data, HDecodeStream* stream)
     {
         DecodeStreamInfo *tmp = new DecodeStreamInfo();
-        tmp->m_Buffer = (const char*) buffer;
-        tmp->m_Size = buffer_size;
+        tmp->m_SoundData = sound_data;
+        tmp->m_Size = dmSound::GetSoundDataSize(sound_data);
         tmp->m_Cursor = 0;
 
         ov_callbacks cb;
@@ -102,12 +109,12 @@ namespace dmSoundCodec
 
         vorbis_info *info = ov_info(&tmp->m_File, -1);
 
+        tmp->m_PcmLength = ov_pcm_total(&tmp->m_File, -1);
+
         tmp->m_Info.m_Rate = info->rate;
-        tmp->m_Info.m_Size = 0;
+        tmp->m_Info.m_Size = tmp->m_PcmLength > 0 ? (uint32_t)(tmp->m_PcmLength * info->channels * 2) : 0;
         tmp->m_Info.m_Channels = info->channels;
         tmp->m_Info.m_BitsPerSample = 16;
-
-        tmp->m_PcmLength = ov_pcm_total(&tmp->m_File, -1);
         tmp->m_SeekTo = -1;
 
         *stream = tmp;
@@ -111,46 +111,43 @@ namespace dmSoundCodec
         struct DecodeStreamInfo {
             Info m_Info;
             uint32_t m_Cursor;
-            const void* m_Buffer;
+            uint32_t m_DataOffset;
+            dmSound::HSoundData m_SoundData;
         };
     }
 
-    static Result WavOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
+    static Result WavOpenStream(dmSound::HSoundData sound_data, HDecodeStream* stream)
     {
-        RiffHeader* header = (RiffHeader*) buffer;
+        RiffHeader header;
         DecodeStreamInfo streamTemp;
 
         bool fmt_found = false;
         bool data_found = false;
 
-        if (buffer_size < sizeof(RiffHeader)) {
+        uint32_t nread = 0;
+        if (dmSound::GetSoundData(sound_data, &header, sizeof(header), 0, &nread) != dmSound::RESULT_OK || nread < sizeof(header)) {
             return RESULT_INVALID_FORMAT;
         }
 
-        if (header->m_ChunkID == FOUR_CC('R', 'I', 'F', 'F') &&
-            header->m_Format == FOUR_CC('W', 'A', 'V', 'E')) {
+        if (header.m_ChunkID == FOUR_CC('R', 'I', 'F', 'F') &&
+            header.m_Format == FOUR_CC('W', 'A', 'V', 'E')) {
 
-            const char* begin = (const char*) buffer;
-            const char* current = (const char*) buffer;
-            const char* end = (const char*) buffer + buffer_size;
-            current += sizeof(RiffHeader);
+            uint32_t current = sizeof(RiffHeader);
             do {
                 CommonHeader header;
-                if (current + sizeof(header) > end) {
+                if (dmSound::GetSoundData(sound_data, &header, sizeof(header), current, &nread) != dmSound::RESULT_OK || nread < sizeof(header)) {
                     // not enough bytes left for a full header. just ignore this.
                     break;
                 }
 
-                memcpy(&header, current, sizeof(header));
                 header.SwapHeader();
                 if (header.m_ChunkID == FOUR_CC('f', 'm', 't', ' ')) {
                     FmtChunk fmt;
-                    if (current + sizeof(fmt) > end) {
-                        dmLogWarning("WAV sound data seems corrupt or truncated at position %d out of %d", (int)(current - begin), buffer_size);
+                    if (dmSound::GetSoundData(sound_data, &fmt, sizeof(fmt), current, &nread) != dmSound::RESULT_OK || nread < sizeof(fmt)) {
+                        dmLogWarning("WAV sound data seems corrupt or truncated at position %u", current);
                         return RESULT_INVALID_FORMAT;
                     }
 
-                    memcpy(&fmt, current, sizeof(fmt));
                     fmt.Swap();
                     fmt_found = true;
 
@@ -165,26 +162,23 @@ namespace dmSoundCodec
 
                 } else if (header.m_ChunkID == FOUR_CC('d', 'a', 't', 'a')) {
                     // NOTE: We don't byte-swap PCM-data and a potential problem on big-endian architectures
-                    DataChunk data;
-                    if (current + sizeof(data) > end) {
-                        dmLogWarning("WAV sound data seems corrupt or truncated at position %d out of %d", (int)(current - begin), buffer_size);
-                        return RESULT_INVALID_FORMAT;
-                    }
-
-                    memcpy(&data, current, sizeof(data));
-                    data.Swap();
-                    streamTemp.m_Buffer = (void*) (current + sizeof(DataChunk));
-                    streamTemp.m_Info.m_Size = data.m_ChunkSize;
+                    streamTemp.m_DataOffset = current + sizeof(DataChunk);
+                    streamTemp.m_Info.m_Size = header.m_ChunkSize;
                     data_found = true;
                 }
-                current += header.m_ChunkSize + sizeof(CommonHeader);
-            } while (current < end && !(fmt_found && data_found));
+                uint32_t next = current + header.m_ChunkSize + sizeof(CommonHeader);
+                if (next <= current) {
+                    break;
+                }
+                current = next;
+            } while (!(fmt_found && data_found));
 
             if (fmt_found && data_found) {
                 // Allocate stream output and copy temporary data over there.
                 // Doing this last-minute avoids having to worry about deallocating
                 // on failure. NOTE: Maybe pool allocate here.
                 streamTemp.m_Cursor = 0;
+                streamTemp.m_SoundData = sound_data;
                 DecodeStreamInfo *streamOut = new DecodeStreamInfo;
                 *streamOut = streamTemp;
                 *stream = streamOut;
@@ -219,9 +213,18 @@ namespace dmSoundCodec
 
         assert(streamInfo->m_Cursor <= streamInfo->m_Info.m_Size);
         uint32_t n = dmMath::Min(buffer_size, streamInfo->m_Info.m_Size - streamInfo->m_Cursor);
-        *decoded = n;
-        memcpy(buffer, (const char*) streamInfo->m_Buffer + streamInfo->m_Cursor, n);
-        streamInfo->m_Cursor += n;
+        *decoded = 0;
+        if (n == 0) {
+            return RESULT_OK;
+        }
+
+        uint32_t nread = 0;
+        dmSound::Result r = dmSound::GetSoundData(streamInfo->m_SoundData, buffer, n, streamInfo->m_DataOffset + streamInfo->m_Cursor, &nread);
+        if (r != dmSound::RESULT_OK) {
+            return RESULT_DECODE_ERROR;
+        }
+        *decoded = nread;
+        streamInfo->m_Cursor += nread;
         return RESULT_OK;
     }
 
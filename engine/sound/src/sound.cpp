@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <dlib/array.h>
 #include <dlib/atomic.h>
+#include <dlib/condition_variable.h>
 #include <dlib/hashtable.h>
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
@@ -28,6 +29,7 @@
 
 #include "sound.h"
 #include "sound_codec.h"
+#include "sound_mix.h"
 #include "sound_private.h"
 
 #include <math.h>
@@ -53,6 +55,7 @@ namespace dmSound
     const uint32_t GROUP_MEMORY_BUFFER_COUNT = 64;
 
     static void SoundThread(void* ctx);
+    static void WorkerThread(void* ctx);
 
     /**
      * Value with memory for "ramping" of values. See also struct Ramp below.
@@ -108,22 +111,19 @@ namespace dmSound
     /**
      * Helper for calculating ramps
      */
-    struct Ramp
+    struct Ramp : MixRamp
     {
-        float m_From, m_To, m_TotalSamplesRecip;
-
         Ramp(const Value* value, uint32_t buffer, uint32_t total_buffers, uint32_t total_samples)
         {
             float ramp_length = (value->m_Current - value->m_Prev) / total_buffers;
             m_From = value->m_Prev + ramp_length * buffer;
             m_To = m_From + ramp_length;
-            m_TotalSamplesRecip = 1.0f / total_samples;
+            m_Recip = 1.0f / total_samples;
         }
 
-        inline float GetValue(int i) const
+        inline bool IsConstant() const
         {
-            float mix = i * m_TotalSamplesRecip;
-            return m_From + mix * (m_To - m_From);
+            return m_From == m_To;
         }
     };
 
@@ -149,15 +149,61 @@ namespace dmSound
         return ramp;
     }
 
+    const uint32_t STREAM_CHUNK_COUNT = 4;
+    const uint32_t INVALID_STREAM_OFFSET = 0xffffffff;
+
+    struct SoundDataChunk
+    {
+        uint8_t*  m_Data;
+        uint32_t  m_Offset;
+        uint32_t  m_Size;
+        uint32_t  m_LastUse;
+    };
+
+    // Where the streamed part of a sound file is read from. Owns the read context, and is reference
+    // counted (guarded by the sound mutex) since a read may still be in flight when the sound data is released
+    struct SoundDataStream
+    {
+        FSoundDataGetData       m_Callback;
+        FSoundDataDeleteContext m_DeleteContext;
+        void*                   m_Context;
+        uint32_t                m_RefCount;
+    };
+
     struct SoundData
     {
         dmhash_t      m_NameHash;
+        // The resident part of the sound file. The whole file unless it's streamed
         void*         m_Data;
         int           m_Size;
         // Index in m_SoundData
         uint16_t      m_Index;
         SoundDataType m_Type;
         uint16_t      m_RefCount;
+
+        // Streamed sound data (see sound.stream_enabled). Data after the resident part
+        // is read in chunks through m_Stream
+        SoundDataStream* m_Stream;
+        uint32_t      m_DataSize;
+        SoundDataChunk* m_Chunks; // STREAM_CHUNK_COUNT chunks, allocated on first read
+        uint32_t      m_ChunkSize;
+        uint32_t      m_ChunkTick;
+        // Offset of the next chunk to read ahead on the stream thread
+        uint32_t      m_ReadAheadOffset;
+
+        // Fully decoded sound, stored as wav data shared by all instances (see sound.pcm_cache_size).
+        // Allocated outside of m_SoundData, so that it can be opened by the wav decoder
+        // Reference counted, since instances keep playing it after it's replaced or evicted
+        SoundData*    m_PcmCache;
+        uint32_t      m_PcmCacheSize;
+        uint32_t      m_PcmCacheLastUse;
+        uint16_t      m_PcmCacheUsers;
+        // Set when the sound is too large to be cached, to avoid decoding it again for each new instance
+        uint8_t       m_PcmCacheRejected : 1;
+        // Set while waiting for the worker thread to decode the sound
+        uint8_t       m_PcmCachePending : 1;
+        // Incremented when the data is replaced, to discard decodes of the old data
+        uint16_t      m_Version;
     };
 
     struct SoundInstance
@@ -172,6 +218,8 @@ namespace dmSound
         uint32_t    m_FrameCount;
         uint64_t    m_FrameFraction;
 
+        SoundData*  m_PcmCache; // The decoded sound played, if it was cached
+
         uint16_t    m_Index;
         uint16_t    m_SoundDataIndex;
         uint8_t     m_Looping : 1;
@@ -198,6 +246,10 @@ namespace dmSound
         HDevice                       m_Device;
         dmThread::Thread              m_Thread;
         dmMutex::HMutex               m_Mutex;
+        // Reads ahead the streamed sound data and decodes sounds for the pcm cache, outside of the sound mutex
+        dmThread::Thread              m_WorkerThread;
+        dmConditionVariable::HConditionVariable m_WorkerCondition;
+        uint8_t*                      m_StreamBuffer;
 
         dmArray<SoundInstance>  m_Instances;
         dmIndexPool16           m_InstancesPool;
@@ -216,6 +268,14 @@ namespace dmSound
         uint32_t                m_FrameCount;
         uint32_t                m_PlayCounter;
 
+        uint32_t                m_PcmCacheBudget;   // Max bytes of decoded sound data to keep. 0 means disabled
+        uint32_t                m_PcmCacheUsed;
+        uint32_t                m_PcmCacheTick;
+
+        uint32_t                m_StreamChunkSize;
+        uint32_t                m_StreamPreloadSize;
+        bool                    m_StreamEnabled;
+
         int16_t*                m_OutBuffers[SOUND_OUTBUFFER_COUNT];
         uint16_t                m_NextOutBuffer;
 
@@ -256,6 +316,10 @@ namespace dmSound
         params->m_FrameCount = 768;
         params->m_MaxInstances = 256;
         params->m_UseThread = true;
+        params->m_PcmCacheSize = 0;
+        params->m_StreamEnabled = false;
+        params->m_StreamChunkSize = 16 * 1024;
+        params->m_StreamPreloadSize = 16 * 1024;
     }
 
     Result RegisterDevice(struct DeviceType* device)
@@ -345,6 +409,10 @@ namespace dmSound
         uint32_t max_buffers = params->m_MaxBuffers;
         uint32_t max_sources = params->m_MaxSources;
         uint32_t max_instances = params->m_MaxInstances;
+        uint32_t pcm_cache_size = params->m_PcmCacheSize;
+        bool stream_enabled = params->m_StreamEnabled;
+        uint32_t stream_chunk_size = params->m_StreamChunkSize;
+        uint32_t stream_preload_size = params->m_StreamPreloadSize;
 
         if (config)
         {
@@ -353,8 +421,20 @@ namespace dmSound
             max_buffers = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_buffers", (int32_t) max_buffers);
             max_sources = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_sources", (int32_t) max_sources);
             max_instances = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_instances", (int32_t) max_instances);
+            pcm_cache_size = (uint32_t) dmConfigFile::GetInt(config, "sound.pcm_cache_size", (int32_t) (pcm_cache_size / 1024)) * 1024;
+            stream_enabled = dmConfigFile::GetInt(config, "sound.stream_enabled", (int32_t) stream_enabled) != 0;
+            stream_chunk_size = (uint32_t) dmConfigFile::GetInt(config, "sound.stream_chunk_size", (int32_t) stream_chunk_size);
+            stream_preload_size = (uint32_t) dmConfigFile::GetInt(config, "sound.stream_preload_size", (int32_t) stream_preload_size);
         }
 
+        sound->m_PcmCacheBudget = pcm_cache_size;
+        sound->m_PcmCacheUsed = 0;
+        sound->m_PcmCacheTick = 0;
+
+        sound->m_StreamEnabled = stream_enabled;
+        sound->m_StreamChunkSize = dmMath::Max(stream_chunk_size, 1024U);
+        sound->m_StreamPreloadSize = stream_preload_size;
+
         sound->m_Instances.SetCapacity(max_instances);
         sound->m_Instances.SetSize(max_instances);
         sound->m_InstancesPool.SetCapacity(max_instances);
@@ -376,6 +456,7 @@ namespace dmSound
         sound->m_SoundDataPool.SetCapacity(max_sound_data);
         for (uint32_t i = 0; i < max_sound_data; ++i)
         {
+            memset(&sound->m_SoundData[i], 0, sizeof(SoundData));
             sound->m_SoundData[i].m_Index = 0xffff;
         }
 
@@ -401,10 +482,21 @@ namespace dmSound
 
         sound->m_Thread = 0;
         sound->m_Mutex = 0;
+        sound->m_WorkerThread = 0;
+        sound->m_WorkerCondition = 0;
+        sound->m_StreamBuffer = 0;
         if (params->m_UseThread)
         {
             sound->m_Mutex = dmMutex::New();
             sound->m_Thread = dmThread::New((dmThread::ThreadStart)SoundThread, 0x80000, sound, "sound");
+
+            if (sound->m_StreamEnabled || sound->m_PcmCacheBudget > 0)
+            {
+                sound->m_WorkerCondition = dmConditionVariable::New();
+                if (sound->m_StreamEnabled)
+                    sound->m_StreamBuffer = (uint8_t*) malloc(sound->m_StreamChunkSize);
+                sound->m_WorkerThread = dmThread::New((dmThread::ThreadStart)WorkerThread, 0x20000, sound, "sound_worker");
+            }
         }
 
         return r;
@@ -417,6 +509,16 @@ namespace dmSound
             return RESULT_OK;
 
         dmAtomicStore32(&sound->m_IsRunning, 0);
+        if (sound->m_WorkerThread)
+        {
+            {
+                DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
+                dmConditionVariable::Signal(sound->m_WorkerCondition);
+            }
+            dmThread::Join(sound->m_WorkerThread);
+            dmConditionVariable::Delete(sound->m_WorkerCondition);
+            free(sound->m_StreamBuffer);
+        }
         if (sound->m_Thread)
         {
             dmThread::Join(sound->m_Thread);
@@ -470,11 +572,188 @@ namespace dmSound
     }
 
 
+    // Sound data that isn't registered in the sound system (decoded pcm cache entries, and copies decoded from)
+    static SoundData* NewStandaloneSoundData(dmhash_t name, void* data, uint32_t size, SoundDataType type)
+    {
+        SoundData* sd = new SoundData;
+        memset(sd, 0, sizeof(SoundData));
+        sd->m_NameHash = name;
+        sd->m_Data = data;
+        sd->m_Size = size;
+        sd->m_DataSize = size;
+        sd->m_Index = 0xffff;
+        sd->m_Type = type;
+        sd->m_RefCount = 1;
+        sd->m_ReadAheadOffset = INVALID_STREAM_OFFSET;
+        return sd;
+    }
+
+    static void ReleaseStandaloneSoundData(SoundData* sound_data)
+    {
+        if (--sound_data->m_RefCount == 0)
+        {
+            free(sound_data->m_Data);
+            delete sound_data;
+        }
+    }
+
+    // Instances playing the cached sound keep their reference, and it's freed when the last one is deleted
+    static void FreePcmCacheNoLock(SoundSystem* sound, SoundData* sound_data)
+    {
+        if (sound_data->m_PcmCache)
+        {
+            ReleaseStandaloneSoundData(sound_data->m_PcmCache);
+            sound->m_PcmCacheUsed -= sound_data->m_PcmCacheSize;
+            sound_data->m_PcmCache = 0;
+            sound_data->m_PcmCacheSize = 0;
+            sound_data->m_PcmCacheUsers = 0;
+        }
+    }
+
+    // Evicts the least recently used entries, not used by any instance, until there is room for 'size' bytes
+    static bool MakeRoomInPcmCacheNoLock(SoundSystem* sound, uint32_t size)
+    {
+        while (sound->m_PcmCacheUsed + size > sound->m_PcmCacheBudget)
+        {
+            SoundData* lru = 0;
+            for (uint32_t i = 0; i < sound->m_SoundData.Size(); ++i)
+            {
+                SoundData* sd = &sound->m_SoundData[i];
+                if (sd->m_Index == 0xffff || sd->m_PcmCache == 0 || sd->m_PcmCacheUsers > 0)
+                    continue;
+                if (lru == 0 || sd->m_PcmCacheLastUse < lru->m_PcmCacheLastUse)
+                    lru = sd;
+            }
+            if (lru == 0)
+                return false;
+            FreePcmCacheNoLock(sound, lru);
+        }
+        return true;
+    }
+
+    static void WriteLE16(uint8_t* p, uint16_t x)
+    {
+        p[0] = (uint8_t) x;
+        p[1] = (uint8_t) (x >> 8);
+    }
+
+    static void WriteLE32(uint8_t* p, uint32_t x)
+    {
+        WriteLE16(p, (uint16_t) x);
+        WriteLE16(p + 2, (uint16_t) (x >> 16));
+    }
+
+    static const uint32_t PCM_CACHE_WAV_HEADER_SIZE = 44;
+    static const uint32_t PCM_CACHE_DECODE_CHUNK_SIZE = 32 * 1024;
+
+    /*
+     * Decodes the full stream into a wav file in memory, which can later be played with a wav decoder.
+     * Returns 0 if the decoded data would be larger than max_size
+     */
+    static void* DecodePcm(SoundSystem* sound, dmSoundCodec::HDecoder decoder, uint32_t max_size, uint32_t* out_size)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        dmSoundCodec::Info info;
+        dmSoundCodec::GetInfo(sound->m_CodecContext, decoder, &info);
+
+        max_size &= ~3U; // Keep whole stereo 16 bit frames
+        uint32_t capacity = PCM_CACHE_WAV_HEADER_SIZE + dmMath::Max(info.m_Size, PCM_CACHE_DECODE_CHUNK_SIZE);
+        if (capacity > max_size)
+            capacity = max_size;
+        uint8_t* buffer = (uint8_t*) malloc(capacity);
+        uint32_t size = PCM_CACHE_WAV_HEADER_SIZE;
+
+        while (true)
+        {
+            if (size == capacity)
+            {
+                if (capacity == max_size)
+                {
+                    free(buffer);
+                    return 0;
+                }
+                capacity = dmMath::Min(capacity * 2, max_size);
+                buffer = (uint8_t*) realloc(buffer, capacity);
+            }
+
+            uint32_t decoded = 0;
+            dmSoundCodec::Result r = dmSoundCodec::Decode(sound->m_CodecContext, decoder, (char*) buffer + size, capacity - size, &decoded);
+            if (r != dmSoundCodec::RESULT_OK)
+            {
+                free(buffer);
+                return 0;
+            }
+            if (decoded == 0)
+                break;
+            size += decoded;
+        }
+
+        const uint32_t data_size = size - PCM_CACHE_WAV_HEADER_SIZE;
+        const uint32_t block_align = info.m_Channels * (info.m_BitsPerSample / 8);
+        memcpy(buffer, "RIFF", 4);
+        WriteLE32(buffer + 4, size - 8);
+        memcpy(buffer + 8, "WAVE", 4);
+        memcpy(buffer + 12, "fmt ", 4);
+        WriteLE32(buffer + 16, 16);
+        WriteLE16(buffer + 20, 1); // PCM
+        WriteLE16(buffer + 22, info.m_Channels);
+        WriteLE32(buffer + 24, info.m_Rate);
+        WriteLE32(buffer + 28, info.m_Rate * block_align);
+        WriteLE16(buffer + 32, block_align);
+        WriteLE16(buffer + 34, info.m_BitsPerSample);
+        memcpy(buffer + 36, "data", 4);
+        WriteLE32(buffer + 40, data_size);
+
+        *out_size = size;
+        return buffer;
+    }
+
+    static void FreeStreamChunks(SoundData* sound_data)
+    {
+        if (sound_data->m_Chunks)
+        {
+            free(sound_data->m_Chunks[0].m_Data);
+            free(sound_data->m_Chunks);
+            sound_data->m_Chunks = 0;
+        }
+    }
+
+    static void ReleaseStreamNoLock(SoundDataStream* stream)
+    {
+        if (--stream->m_RefCount == 0)
+        {
+            if (stream->m_DeleteContext)
+                stream->m_DeleteContext(stream->m_Context);
+            delete stream;
+        }
+    }
+
+    static void FreeStreamNoLock(SoundData* sound_data)
+    {
+        FreeStreamChunks(sound_data);
+        if (sound_data->m_Stream)
+        {
+            ReleaseStreamNoLock(sound_data->m_Stream);
+            sound_data->m_Stream = 0;
+        }
+        sound_data->m_ReadAheadOffset = INVALID_STREAM_OFFSET;
+    }
+
     static Result SetSoundDataNoLock(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
+        FreePcmCacheNoLock(g_SoundSystem, sound_data);
+        sound_data->m_PcmCacheRejected = 0;
+        sound_data->m_PcmCachePending = 0;
+        sound_data->m_Version++;
+
+        // The new data is always fully resident
+        FreeStreamNoLock(sound_data);
+
         free(sound_data->m_Data);
         sound_data->m_Data = malloc(sound_buffer_size);
         sound_data->m_Size = sound_buffer_size;
+        sound_data->m_DataSize = sound_buffer_size;
         memcpy(sound_data->m_Data, sound_buffer, sound_buffer_size);
         return RESULT_OK;
     }
@@ -503,6 +782,19 @@ namespace dmSound
         sd->m_Data = 0;
         sd->m_Size = 0;
         sd->m_RefCount = 1;
+        sd->m_Stream = 0;
+        sd->m_DataSize = 0;
+        sd->m_Chunks = 0;
+        sd->m_ChunkSize = sound->m_StreamChunkSize;
+        sd->m_ChunkTick = 0;
+        sd->m_ReadAheadOffset = INVALID_STREAM_OFFSET;
+        sd->m_PcmCache = 0;
+        sd->m_PcmCacheSize = 0;
+        sd->m_PcmCacheLastUse = 0;
+        sd->m_PcmCacheUsers = 0;
+        sd->m_PcmCacheRejected = 0;
+        sd->m_PcmCachePending = 0;
+        sd->m_Version = 0;
 
         Result result = SetSoundDataNoLock(sd, sound_buffer, sound_buffer_size);
         if (result == RESULT_OK)
@@ -513,6 +805,68 @@ namespace dmSound
         return result;
     }
 
+    static Result NewSoundDataResident(FSoundDataGetData cbk, void* cbk_ctx, const void* preload_buffer, uint32_t preload_size, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        if (preload_size == size)
+            return NewSoundData(preload_buffer, size, type, sound_data, name);
+
+        // We need the whole file
+        uint8_t* buffer = (uint8_t*) malloc(size);
+        memcpy(buffer, preload_buffer, preload_size);
+        uint32_t offset = preload_size;
+        while (offset < size)
+        {
+            uint32_t nread = 0;
+            Result r = cbk(cbk_ctx, offset, size - offset, buffer + offset, &nread);
+            if (r != RESULT_OK || nread == 0)
+            {
+                free(buffer);
+                *sound_data = 0;
+                return r != RESULT_OK ? r : RESULT_INVALID_STREAM_DATA;
+            }
+            offset += nread;
+        }
+        Result r = NewSoundData(buffer, size, type, sound_data, name);
+        free(buffer);
+        return r;
+    }
+
+    Result NewSoundDataStreaming(FSoundDataGetData cbk, FSoundDataDeleteContext delete_cbk, void* cbk_ctx, const void* preload_buffer, uint32_t preload_size, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        SoundSystem* sound = g_SoundSystem;
+        assert(preload_size <= size);
+
+        uint32_t resident_size = dmMath::Min(preload_size, sound->m_StreamPreloadSize);
+        bool stream = sound->m_StreamEnabled && cbk != 0 && size > resident_size + sound->m_StreamChunkSize;
+        if (!stream)
+        {
+            Result r = NewSoundDataResident(cbk, cbk_ctx, preload_buffer, preload_size, size, type, sound_data, name);
+            if (delete_cbk)
+                delete_cbk(cbk_ctx);
+            return r;
+        }
+
+        Result r = NewSoundData(preload_buffer, resident_size, type, sound_data, name);
+        if (r != RESULT_OK)
+        {
+            if (delete_cbk)
+                delete_cbk(cbk_ctx);
+            return r;
+        }
+
+        SoundDataStream* stream_source = new SoundDataStream;
+        stream_source->m_Callback = cbk;
+        stream_source->m_DeleteContext = delete_cbk;
+        stream_source->m_Context = cbk_ctx;
+        stream_source->m_RefCount = 1;
+
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+        SoundData* sd = *sound_data;
+        sd->m_Stream = stream_source;
+        sd->m_DataSize = size;
+        return RESULT_OK;
+    }
+
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
@@ -521,7 +875,229 @@ namespace dmSound
 
     uint32_t GetSoundResourceSize(HSoundData sound_data)
     {
-        return sound_data->m_Size + sizeof(SoundData);
+        uint32_t chunks_size = sound_data->m_Chunks ? STREAM_CHUNK_COUNT * (sound_data->m_ChunkSize + sizeof(SoundDataChunk)) : 0;
+        return sound_data->m_Size + chunks_size + sound_data->m_PcmCacheSize + sizeof(SoundData);
+    }
+
+    /*
+     * Returns the chunk starting at 'offset' if it's loaded. Otherwise returns 0, and the least
+     * recently used chunk to replace in 'lru_out'
+     */
+    static SoundDataChunk* FindStreamChunk(SoundData* sound_data, uint32_t offset, SoundDataChunk** lru_out)
+    {
+        if (!sound_data->m_Chunks)
+        {
+            sound_data->m_Chunks = (SoundDataChunk*) malloc(STREAM_CHUNK_COUNT * sizeof(SoundDataChunk));
+            uint8_t* data = (uint8_t*) malloc(STREAM_CHUNK_COUNT * sound_data->m_ChunkSize);
+            for (uint32_t i = 0; i < STREAM_CHUNK_COUNT; ++i)
+            {
+                SoundDataChunk* chunk = &sound_data->m_Chunks[i];
+                chunk->m_Data = data + i * sound_data->m_ChunkSize;
+                chunk->m_Offset = INVALID_STREAM_OFFSET;
+                chunk->m_Size = 0;
+                chunk->m_LastUse = 0;
+            }
+        }
+
+        SoundDataChunk* lru = &sound_data->m_Chunks[0];
+        for (uint32_t i = 0; i < STREAM_CHUNK_COUNT; ++i)
+        {
+            SoundDataChunk* chunk = &sound_data->m_Chunks[i];
+            if (chunk->m_Offset == offset)
+                return chunk;
+            if (chunk->m_LastUse < lru->m_LastUse)
+                lru = chunk;
+        }
+        *lru_out = lru;
+        return 0;
+    }
+
+    /*
+     * Returns the chunk starting at 'offset', reading it if it isn't already loaded.
+     * The read blocks the mixing, and only happens if the stream thread didn't get to it first.
+     */
+    static SoundDataChunk* GetStreamChunk(SoundData* sound_data, uint32_t offset)
+    {
+        SoundDataChunk* lru = 0;
+        SoundDataChunk* chunk = FindStreamChunk(sound_data, offset, &lru);
+        if (chunk)
+        {
+            chunk->m_LastUse = ++sound_data->m_ChunkTick;
+            return chunk;
+        }
+
+        DM_PROFILE(__FUNCTION__);
+        uint32_t size = dmMath::Min(sound_data->m_ChunkSize, sound_data->m_DataSize - offset);
+        uint32_t nread = 0;
+        SoundDataStream* stream = sound_data->m_Stream;
+        Result r = stream->m_Callback(stream->m_Context, offset, size, lru->m_Data, &nread);
+        if (r != RESULT_OK || nread == 0)
+        {
+            dmLogError("Failed to read sound data '%s' at offset %u (%d)", dmHashReverseSafe64(sound_data->m_NameHash), offset, r);
+            lru->m_Offset = INVALID_STREAM_OFFSET;
+            lru->m_LastUse = 0;
+            return 0;
+        }
+        lru->m_Offset = offset;
+        lru->m_Size = nread;
+        lru->m_LastUse = ++sound_data->m_ChunkTick;
+        return lru;
+    }
+
+    Result GetSoundData(HSoundData sound_data, void* out, uint32_t size, uint32_t offset, uint32_t* nread)
+    {
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+
+        *nread = 0;
+        if (offset >= sound_data->m_DataSize)
+            return RESULT_OK;
+
+        size = dmMath::Min(size, sound_data->m_DataSize - offset);
+        uint8_t* dst = (uint8_t*) out;
+
+        uint32_t resident_size = (uint32_t) sound_data->m_Size;
+        if (offset < resident_size)
+        {
+            uint32_t n = dmMath::Min(size, resident_size - offset);
+            memcpy(dst, (const uint8_t*) sound_data->m_Data + offset, n);
+            dst += n;
+            offset += n;
+            size -= n;
+            *nread += n;
+        }
+
+        while (size > 0)
+        {
+            uint32_t chunk_offset = offset - offset % sound_data->m_ChunkSize;
+            SoundDataChunk* chunk = GetStreamChunk(sound_data, chunk_offset);
+            if (!chunk)
+                return RESULT_INVALID_STREAM_DATA;
+
+            uint32_t chunk_pos = offset - chunk_offset;
+            if (chunk_pos >= chunk->m_Size)
+                break; // The file was shorter than expected
+
+            uint32_t n = dmMath::Min(size, chunk->m_Size - chunk_pos);
+            memcpy(dst, chunk->m_Data + chunk_pos, n);
+            dst += n;
+            offset += n;
+            size -= n;
+            *nread += n;
+
+            uint32_t next_offset = chunk_offset + sound_data->m_ChunkSize;
+            sound_data->m_ReadAheadOffset = next_offset < sound_data->m_DataSize ? next_offset : INVALID_STREAM_OFFSET;
+        }
+        return RESULT_OK;
+    }
+
+    uint32_t GetSoundDataSize(HSoundData sound_data)
+    {
+        return sound_data->m_DataSize;
+    }
+
+    const void* GetResidentSoundData(HSoundData sound_data, uint32_t* size)
+    {
+        if (sound_data->m_Stream)
+        {
+            *size = 0;
+            return 0;
+        }
+        *size = (uint32_t) sound_data->m_Size;
+        return sound_data->m_Data;
+    }
+
+    // Returns the next streamed sound with a chunk to read ahead, or 0 if there is none
+    static SoundData* GetNextReadAheadNoLock(SoundSystem* sound)
+    {
+        for (uint32_t i = 0; i < sound->m_SoundData.Size(); ++i)
+        {
+            SoundData* sd = &sound->m_SoundData[i];
+            if (sd->m_Index == 0xffff || sd->m_Stream == 0 || sd->m_ReadAheadOffset == INVALID_STREAM_OFFSET)
+                continue;
+
+            SoundDataChunk* lru = 0;
+            if (FindStreamChunk(sd, sd->m_ReadAheadOffset, &lru) == 0)
+                return sd;
+            sd->m_ReadAheadOffset = INVALID_STREAM_OFFSET;
+        }
+        return 0;
+    }
+
+    /*
+     * Reads the next chunk of a streamed sound that is being decoded, so that the mixing
+     * doesn't have to wait for the read. The read is done without holding the sound mutex.
+     */
+    static void StreamReadAheadNoLock(SoundSystem* sound, SoundData* sd)
+    {
+        {
+            uint32_t offset = sd->m_ReadAheadOffset;
+            uint32_t size = dmMath::Min(sd->m_ChunkSize, sd->m_DataSize - offset);
+            sd->m_ReadAheadOffset = INVALID_STREAM_OFFSET;
+
+            // The sound data may be deleted or replaced during the read, but the stream stays alive
+            SoundDataStream* stream = sd->m_Stream;
+            stream->m_RefCount++;
+
+            dmMutex::Unlock(sound->m_Mutex);
+            uint32_t nread = 0;
+            Result r;
+            {
+                DM_PROFILE("StreamReadAhead");
+                r = stream->m_Callback(stream->m_Context, offset, size, sound->m_StreamBuffer, &nread);
+            }
+            dmMutex::Lock(sound->m_Mutex);
+
+            if (r == RESULT_OK && nread > 0 && sd->m_Index != 0xffff && sd->m_Stream == stream)
+            {
+                SoundDataChunk* lru = 0;
+                if (FindStreamChunk(sd, offset, &lru) == 0)
+                {
+                    memcpy(lru->m_Data, sound->m_StreamBuffer, nread);
+                    lru->m_Offset = offset;
+                    lru->m_Size = nread;
+                    lru->m_LastUse = ++sd->m_ChunkTick;
+                }
+            }
+            ReleaseStreamNoLock(stream);
+        }
+    }
+
+    static SoundData* GetNextPcmCacheDecodeNoLock(SoundSystem* sound)
+    {
+        for (uint32_t i = 0; i < sound->m_SoundData.Size(); ++i)
+        {
+            SoundData* sd = &sound->m_SoundData[i];
+            if (sd->m_Index != 0xffff && sd->m_PcmCachePending)
+                return sd;
+        }
+        return 0;
+    }
+
+    static void DecodePcmCacheNoLock(SoundSystem* sound, SoundData* sound_data);
+
+    static void WorkerThread(void* ctx)
+    {
+        SoundSystem* sound = (SoundSystem*)ctx;
+        DM_MUTEX_SCOPED_LOCK(sound->m_Mutex);
+        while (dmAtomicGet32(&sound->m_IsRunning))
+        {
+            // Reading ahead is more urgent, since the mixing depends on it
+            SoundData* sd = GetNextReadAheadNoLock(sound);
+            if (sd)
+            {
+                StreamReadAheadNoLock(sound, sd);
+                continue;
+            }
+
+            sd = GetNextPcmCacheDecodeNoLock(sound);
+            if (sd)
+            {
+                DecodePcmCacheNoLock(sound, sd);
+                continue;
+            }
+
+            dmConditionVariable::Wait(sound->m_WorkerCondition, sound->m_Mutex);
+        }
     }
 
     Result DeleteSoundData(HSoundData sound_data)
@@ -536,14 +1112,138 @@ namespace dmSound
 
         if (sound_data->m_Data != 0x0)
             free((void*) sound_data->m_Data);
+        sound_data->m_Data = 0;
+
+        FreeStreamNoLock(sound_data);
 
         SoundSystem* sound = g_SoundSystem;
+        FreePcmCacheNoLock(sound, sound_data);
         sound->m_SoundDataPool.Push(sound_data->m_Index);
         sound_data->m_Index = 0xffff;
 
         return RESULT_OK;
     }
 
+    /*
+     * Opens a decoder for caching the sound. Sounds larger than a quarter of the cache budget are never cached,
+     * which is known from the stream info before decoding anything.
+     */
+    static dmSoundCodec::HDecoder NewPcmCacheDecoderNoLock(SoundSystem* sound, SoundData* source, SoundData* sound_data)
+    {
+        dmSoundCodec::HDecoder decoder;
+        dmSoundCodec::Result r = dmSoundCodec::NewDecoder(sound->m_CodecContext, dmSoundCodec::FORMAT_VORBIS, source, &decoder);
+        if (r != dmSoundCodec::RESULT_OK)
+        {
+            // Out of decoders is temporary, try again on the next instance
+            if (r != dmSoundCodec::RESULT_OUT_OF_RESOURCES)
+                sound_data->m_PcmCacheRejected = 1;
+            return 0;
+        }
+
+        dmSoundCodec::Info info;
+        dmSoundCodec::GetInfo(sound->m_CodecContext, decoder, &info);
+        if (info.m_Size == 0 || PCM_CACHE_WAV_HEADER_SIZE + info.m_Size > sound->m_PcmCacheBudget / 4)
+        {
+            dmSoundCodec::DeleteDecoder(sound->m_CodecContext, decoder);
+            sound_data->m_PcmCacheRejected = 1;
+            return 0;
+        }
+        return decoder;
+    }
+
+    static bool AddPcmCacheNoLock(SoundSystem* sound, SoundData* sound_data, void* pcm, uint32_t size)
+    {
+        if (pcm == 0)
+        {
+            sound_data->m_PcmCacheRejected = 1;
+            return false;
+        }
+
+        if (!MakeRoomInPcmCacheNoLock(sound, size))
+        {
+            // Everything cached is currently playing, try again on the next instance
+            free(pcm);
+            return false;
+        }
+
+        sound_data->m_PcmCache = NewStandaloneSoundData(sound_data->m_NameHash, pcm, size, SOUND_DATA_TYPE_WAV);
+        sound_data->m_PcmCacheSize = size;
+        sound->m_PcmCacheUsed += size;
+        return true;
+    }
+
+    /*
+     * Decodes a sound for the pcm cache on the worker thread. The decoding is done without holding the sound mutex,
+     * from a copy of the data since it may be replaced meanwhile.
+     */
+    static void DecodePcmCacheNoLock(SoundSystem* sound, SoundData* sound_data)
+    {
+        sound_data->m_PcmCachePending = 0;
+
+        void* data = malloc(sound_data->m_Size);
+        memcpy(data, sound_data->m_Data, sound_data->m_Size);
+        SoundData* source = NewStandaloneSoundData(sound_data->m_NameHash, data, sound_data->m_Size, sound_data->m_Type);
+
+        dmSoundCodec::HDecoder decoder = NewPcmCacheDecoderNoLock(sound, source, sound_data);
+        if (decoder == 0)
+        {
+            ReleaseStandaloneSoundData(source);
+            return;
+        }
+
+        uint16_t version = sound_data->m_Version;
+        sound_data->m_RefCount++;
+
+        dmMutex::Unlock(sound->m_Mutex);
+        uint32_t size = 0;
+        void* pcm = DecodePcm(sound, decoder, sound->m_PcmCacheBudget / 4, &size);
+        dmMutex::Lock(sound->m_Mutex);
+
+        dmSoundCodec::DeleteDecoder(sound->m_CodecContext, decoder);
+        ReleaseStandaloneSoundData(source);
+
+        if (sound_data->m_Version == version && sound_data->m_PcmCache == 0)
+            AddPcmCacheNoLock(sound, sound_data, pcm, size);
+        else
+            free(pcm);
+
+        DeleteSoundData(sound_data);
+    }
+
+    /*
+     * Returns true if the decoded sound is available in the pcm cache. With a worker thread, the sound is decoded
+     * in the background and used by later instances. Otherwise it's decoded right away.
+     */
+    static bool GetPcmCacheNoLock(SoundSystem* sound, SoundData* sound_data)
+    {
+        if (sound_data->m_PcmCache == 0)
+        {
+            if (sound->m_WorkerThread)
+            {
+                if (!sound_data->m_PcmCachePending)
+                {
+                    sound_data->m_PcmCachePending = 1;
+                    dmConditionVariable::Signal(sound->m_WorkerCondition);
+                }
+                return false;
+            }
+
+            dmSoundCodec::HDecoder decoder = NewPcmCacheDecoderNoLock(sound, sound_data, sound_data);
+            if (decoder == 0)
+                return false;
+
+            uint32_t size = 0;
+            void* pcm = DecodePcm(sound, decoder, sound->m_PcmCacheBudget / 4, &size);
+            dmSoundCodec::DeleteDecoder(sound->m_CodecContext, decoder);
+
+            if (!AddPcmCacheNoLock(sound, sound_data, pcm, size))
+                return false;
+        }
+
+        sound_data->m_PcmCacheLastUse = ++sound->m_PcmCacheTick;
+        return true;
+    }
+
     Result NewSoundInstance(HSoundData sound_data, HSoundInstance* sound_instance)
     {
         SoundSystem* ss = g_SoundSystem;
@@ -560,6 +1260,7 @@ namespace dmSound
         }
 
         uint16_t index;
+        bool pcm_cached = false;
         {
             DM_MUTEX_OPTIONAL_SCOPED_LOCK(ss->m_Mutex);
 
@@ -570,31 +1271,49 @@ namespace dmSound
                 return RESULT_OUT_OF_INSTANCES;
             }
 
-            dmSoundCodec::Result r = dmSoundCodec::NewDecoder(ss->m_CodecContext, codec_format, sound_data->m_Data, sound_data->m_Size, &decoder);
+            // Streamed sounds are typically long, and we don't want to read the whole file just to find out
+            if (codec_format == dmSoundCodec::FORMAT_VORBIS && ss->m_PcmCacheBudget > 0 && !sound_data->m_PcmCacheRejected && !sound_data->m_Stream)
+            {
+                pcm_cached = GetPcmCacheNoLock(ss, sound_data);
+            }
+
+            dmSoundCodec::Result r;
+            if (pcm_cached)
+                r = dmSoundCodec::NewDecoder(ss->m_CodecContext, dmSoundCodec::FORMAT_WAV, sound_data->m_PcmCache, &decoder);
+            else
+                r = dmSoundCodec::NewDecoder(ss->m_CodecContext, codec_format, sound_data, &decoder);
             if (r != dmSoundCodec::RESULT_OK) {
                 dmLogError("Failed to decode sound (%d)", r);
                 return RESULT_INVALID_STREAM_DATA;
             }
 
+            if (pcm_cached)
+            {
+                sound_data->m_PcmCacheUsers++;
+                sound_data->m_PcmCache->m_RefCount++;
+            }
+
             index = ss->m_InstancesPool.Pop();
-        }
 
-        sound_data->m_RefCount ++;
+            // The worker thread also holds references while decoding
+            sound_data->m_RefCount ++;
 
-        SoundInstance* si = &ss->m_Instances[index];
-        assert(si->m_Index == 0xffff);
+            SoundInstance* si = &ss->m_Instances[index];
+            assert(si->m_Index == 0xffff);
 
-        si->m_SoundDataIndex = sound_data->m_Index;
-        si->m_Index = index;
-        si->m_Gain.Reset(1.0f);
-        si->m_Pan.Reset(0.5f);
-        si->m_Looping = 0;
-        si->m_EndOfStream = 0;
-        si->m_Playing = 0;
-        si->m_Decoder = decoder;
-        si->m_Group = MASTER_GROUP_HASH;
+            si->m_SoundDataIndex = sound_data->m_Index;
+            si->m_Index = index;
+            si->m_Gain.Reset(1.0f);
+            si->m_Pan.Reset(0.5f);
+            si->m_Looping = 0;
+            si->m_EndOfStream = 0;
+            si->m_Playing = 0;
+            si->m_PcmCache = pcm_cached ? sound_data->m_PcmCache : 0;
+            si->m_Decoder = decoder;
+            si->m_Group = MASTER_GROUP_HASH;
 
-        *sound_instance = si;
+            *sound_instance = si;
+        }
 
         return RESULT_OK;
     }
@@ -615,10 +1334,19 @@ namespace dmSound
         uint16_t index = sound_instance->m_Index;
         sound->m_InstancesPool.Push(index);
         sound_instance->m_Index = 0xffff;
-        DeleteSoundData(&sound->m_SoundData[sound_instance->m_SoundDataIndex]);
-        sound_instance->m_SoundDataIndex = 0xffff;
+        SoundData* sound_data = &sound->m_SoundData[sound_instance->m_SoundDataIndex];
         dmSoundCodec::DeleteDecoder(sound->m_CodecContext, sound_instance->m_Decoder);
         sound_instance->m_Decoder = 0;
+        if (sound_instance->m_PcmCache)
+        {
+            // The sound data may have dropped the cached sound while it was playing
+            if (sound_data->m_PcmCache == sound_instance->m_PcmCache)
+                sound_data->m_PcmCacheUsers--;
+            ReleaseStandaloneSoundData(sound_instance->m_PcmCache);
+            sound_instance->m_PcmCache = 0;
+        }
+        DeleteSoundData(sound_data);
+        sound_instance->m_SoundDataIndex = 0xffff;
         sound_instance->m_FrameCount = 0;
         sound_instance->m_Speed = 1.0f;
 
@@ -892,18 +1620,21 @@ namespace dmSound
 
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
+        const bool constant_pan = pan_ramp.IsConstant();
+        float left_scale, right_scale;
+        GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip; // determines the bias between two consecutive samples in the sound instance. It ranges from 0-1. A mix of 0, makes only the first sample count while a mix of 0.5 will count equally both samples.
             T s1 = frames[index];
             T s2 = frames[index + 1];
             s1 = (s1 - offset) * scale;
             s2 = (s2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
+            // The trigonometry is only needed while the pan is changing
+            if (!constant_pan)
+                GetPanScale(pan_ramp.GetValue(i), &left_scale, &right_scale);
 
             float s = (1.0f - mix) * s1 + mix * s2; // resulting destination sample value is a mix of two source samples since a kind of fractional indexing is used
             mix_buffer[2 * i] += s * gain * left_scale;
@@ -947,10 +1678,12 @@ namespace dmSound
 
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
+        const bool constant_pan = pan_ramp.IsConstant();
+        float left_scale, right_scale;
+        GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip;
             T sl1 = frames[2 * index];
             T sl2 = frames[2 * index + 2];
@@ -962,8 +1695,8 @@ namespace dmSound
             sr1 = (sr1 - offset) * scale;
             sr2 = (sr2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
+            if (!constant_pan)
+                GetPanScale(pan_ramp.GetValue(i), &left_scale, &right_scale);
 
             float sl = (1.0f - mix) * sl1 + mix * sl2;
             float sr = (1.0f - mix) * sr1 + mix * sr2;
@@ -994,6 +1727,15 @@ namespace dmSound
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
+        if (pan_ramp.IsConstant())
+        {
+            float left_scale, right_scale;
+            GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
+            MixMono<T, offset, scale>(mix_buffer, frames, mix_buffer_count, gain_ramp, left_scale, right_scale);
+            instance->m_FrameCount -= mix_buffer_count;
+            return;
+        }
+
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
@@ -1019,6 +1761,15 @@ namespace dmSound
         Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
         Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
+        if (pan_ramp.IsConstant())
+        {
+            float left_scale, right_scale;
+            GetPanScale(pan_ramp.m_From, &left_scale, &right_scale);
+            MixStereo<T, offset, scale>(mix_buffer, frames, mix_buffer_count, gain_ramp, left_scale, right_scale);
+            instance->m_FrameCount -= mix_buffer_count;
+            return;
+        }
+
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
             float gain = gain_ramp.GetValue(i);
@@ -1258,28 +2009,9 @@ namespace dmSound
             SoundGroup* g = &sound->m_Groups[i];
 
             if (g->m_MixBuffer) {
-                uint32_t frame_count = sound->m_FrameCount;
-                float sum_sq_left = 0;
-                float sum_sq_right = 0;
-                float max_sq_left = 0;
-                float max_sq_right = 0;
-                for (uint32_t j = 0; j < frame_count; j++) {
-
-                    float gain = g->m_Gain.m_Current;
-
-                    float left = g->m_MixBuffer[2 * j + 0] * gain;
-                    float right = g->m_MixBuffer[2 * j + 1] * gain;
-                    float left_sq = left * left;
-                    float right_sq = right * right;
-                    sum_sq_left += left_sq;
-                    sum_sq_right += right_sq;
-                    max_sq_left = dmMath::Max(max_sq_left, left_sq);
-                    max_sq_right = dmMath::Max(max_sq_right, right_sq);
-                }
-                g->m_SumSquaredMemory[2 * g->m_NextMemorySlot + 0] = sum_sq_left;
-                g->m_SumSquaredMemory[2 * g->m_NextMemorySlot + 1] = sum_sq_right;
-                g->m_PeakMemorySq[2 * g->m_NextMemorySlot + 0] = max_sq_left;
-                g->m_PeakMemorySq[2 * g->m_NextMemorySlot + 1] = max_sq_right;
+                SumSquares(g->m_MixBuffer, sound->m_FrameCount, g->m_Gain.m_Current,
+                           &g->m_SumSquaredMemory[2 * g->m_NextMemorySlot],
+                           &g->m_PeakMemorySq[2 * g->m_NextMemorySlot]);
                 g->m_NextMemorySlot = (g->m_NextMemorySlot + 1) % GROUP_MEMORY_BUFFER_COUNT;
 
                 memset(g->m_MixBuffer, 0, sound->m_FrameCount * sizeof(float) * 2);
@@ -1332,29 +2064,11 @@ namespace dmSound
                 continue;
             }
             Ramp ramp = GetRamp(mix_context, &g->m_Gain, n);
-            for (uint32_t i = 0; i < n; i++) {
-                float gain = ramp.GetValue(i);
-                gain = dmMath::Clamp(gain, 0.0f, 1.0f);
-
-                float s1 = g->m_MixBuffer[2 * i];
-                float s2 = g->m_MixBuffer[2 * i + 1];
-                mix_buffer[2 * i] += s1 * gain;
-                mix_buffer[2 * i + 1] += s2 * gain;
-            }
+            MixBuffer(mix_buffer, g->m_MixBuffer, n, ramp);
         }
 
         Ramp ramp = GetRamp(mix_context, &master->m_Gain, n);
-        for (uint32_t i = 0; i < n; i++) {
-            float gain = ramp.GetValue(i);
-            float s1 = mix_buffer[2 * i] * gain;
-            float s2 = mix_buffer[2 * i + 1] * gain;
-            s1 = dmMath::Min(32767.0f, s1);
-            s1 = dmMath::Max(-32768.0f, s1);
-            s2 = dmMath::Min(32767.0f, s2);
-            s2 = dmMath::Max(-32768.0f, s2);
-            out[2 * i] = (int16_t) s1;
-            out[2 * i + 1] = (int16_t) s2;
-        }
+        ConvertToS16(out, mix_buffer, n, ramp);
     }
 
     static void StepGroupValues()
@@ -1480,6 +2194,11 @@ namespace dmSound
             free_slots--;
         }
 
+        if (sound->m_StreamBuffer)
+        {
+            dmConditionVariable::Signal(sound->m_WorkerCondition);
+        }
+
         return RESULT_OK;
     }
 
@@ -1550,4 +2269,11 @@ namespace dmSound
     {
         return data->m_RefCount;
     }
+
+    // Unit tests
+    bool IsPcmCached(HSoundData data)
+    {
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+        return data->m_PcmCache != 0;
+    }
 }
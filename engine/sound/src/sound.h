@@ -67,9 +67,6 @@ namespace dmSound
 
     const uint32_t MAX_GROUPS = 32;
 
-    // TODO:
-    // - Music streaming.
-
     struct InitializeParams;
     void SetDefaultInitializeParams(InitializeParams* params);
 
@@ -83,7 +80,11 @@ namespace dmSound
         uint32_t m_BufferSize;
         uint32_t m_FrameCount;
         uint32_t m_MaxInstances;
+        uint32_t m_PcmCacheSize; // Bytes of decoded sound data shared between instances. 0 disables the cache
+        uint32_t m_StreamChunkSize; // Size of each chunk read on demand for streamed sound data
+        uint32_t m_StreamPreloadSize; // Bytes of streamed sound data kept resident in memory
         bool     m_UseThread;
+        bool     m_StreamEnabled; // If set, sound data created with NewSoundDataStreaming is read in chunks when played
 
         InitializeParams()
         {
@@ -100,12 +101,32 @@ namespace dmSound
     // Pauses the (threaded) sound system
     Result Pause(bool pause);
 
+    // Reads 'size' bytes at 'offset' of the sound file into 'out'. Called from the sound stream thread,
+    // or from the sound thread if a chunk wasn't read ahead in time
+    typedef Result (*FSoundDataGetData)(void* context, uint32_t offset, uint32_t size, void* out, uint32_t* nread);
+    // Deletes the context passed to NewSoundDataStreaming, once it is no longer used
+    typedef void (*FSoundDataDeleteContext)(void* context);
+
     // Thread safe
     Result NewSoundData(const void* sound_buffer, uint32_t sound_buffer_size, SoundDataType type, HSoundData* sound_data, dmhash_t name);
+    // Creates sound data of 'size' bytes, where the first 'preload_size' bytes are given in 'preload_buffer'.
+    // If streaming is enabled, only the preload part is kept in memory and the rest is read through 'cbk' while playing.
+    // Otherwise, the remaining data is read at once.
+    // The sound data takes ownership of 'cbk_ctx', and calls 'delete_cbk' (if set) when it's no longer used,
+    // which may be after the sound data is deleted.
+    Result NewSoundDataStreaming(FSoundDataGetData cbk, FSoundDataDeleteContext delete_cbk, void* cbk_ctx, const void* preload_buffer, uint32_t preload_size, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name);
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size);
     uint32_t GetSoundResourceSize(HSoundData sound_data);
     Result DeleteSoundData(HSoundData sound_data);
 
+    // Used by the decoders. Reads from the sound file, which may not be resident in memory.
+    // Reading at or past the end of the data returns RESULT_OK with nread = 0
+    Result GetSoundData(HSoundData sound_data, void* out, uint32_t size, uint32_t offset, uint32_t* nread);
+    // Total size of the sound file
+    uint32_t GetSoundDataSize(HSoundData sound_data);
+    // Returns the sound file if it's fully resident in memory, or 0 if it's streamed
+    const void* GetResidentSoundData(HSoundData sound_data, uint32_t* size);
+
     Result NewSoundInstance(HSoundData sound_data, HSoundInstance* sound_instance);
     Result DeleteSoundInstance(HSoundInstance sound_instance);
 
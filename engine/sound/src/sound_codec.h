@@ -15,6 +15,11 @@
 #ifndef DM_SOUND_CODEC_H
 #define DM_SOUND_CODEC_H
 
+namespace dmSound
+{
+    typedef struct SoundData* HSoundData;
+}
+
 /**
  * Sound decoding support
  */
@@ -54,7 +59,7 @@ namespace dmSoundCodec
     {
         /// Rate
         uint32_t m_Rate;
-        /// Size in bytes for decompressed stream. Might be 0 for ogg streams and similar
+        /// Size in bytes for decompressed stream. 0 if the length isn't known up front, e.g. for streamed ogg data
         uint32_t m_Size;
         /// Number of channels
         uint8_t  m_Channels;
@@ -93,12 +98,11 @@ namespace dmSoundCodec
      * Create a new decoder
      * @param context context
      * @param format format
-     * @param buffer buffer
-     * @param buffer_size buffer size
+     * @param sound_data sound data to decode. The data is read through dmSound::GetSoundData
      * @param decoder decoder (out)
      * @return RESULT_OK on success
      */
-    Result NewDecoder(HCodecContext context, Format format, const void* buffer, uint32_t buffer_size, HDecoder* decoder);
+    Result NewDecoder(HCodecContext context, Format format, dmSound::HSoundData sound_data, HDecoder* decoder);
 
     /**
      * Delete decoder
@@ -47,9 +47,10 @@ namespace dmSoundCodec
         int m_Score;
 
         /**
-         * Open a stream for decoding
+         * Open a stream for decoding. The compressed data is read with dmSound::GetSoundData,
+         * and might not be resident in memory
          */
-        Result (*m_OpenStream)(const void* buffer, const uint32_t size, HDecodeStream* out);
+        Result (*m_OpenStream)(dmSound::HSoundData sound_data, HDecodeStream* out);
 
         /**
          * Close and free decoding resources
@@ -0,0 +1,443 @@
+// Copyright 2020-2024 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SOUND_MIX_H
+#define DM_SOUND_MIX_H
+
+#include <stdint.h>
+#include <dlib/math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_SOUND_MIX_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DM_SOUND_MIX_NEON
+    #include <arm_neon.h>
+#endif
+
+/*
+ * Mixing kernels for the sound system.
+ * Mix buffers are interleaved stereo floats. Gains are linear ramps over the buffer, evaluated
+ * as from + (i * recip) * (to - from), i.e. the same way as dmSound::Ramp.
+ * The *Scalar functions are the reference implementations. The others use SSE2/NEON
+ * when available, and otherwise fall back to the scalar versions.
+ */
+namespace dmSound
+{
+    struct MixRamp
+    {
+        float m_From;
+        float m_To;
+        float m_Recip;
+
+        inline float GetValue(uint32_t i) const
+        {
+            float mix = i * m_Recip;
+            return m_From + mix * (m_To - m_From);
+        }
+    };
+
+    /*
+     * Mixes mono frames into the mix buffer with a gain ramp and a constant pan
+     */
+    template <typename T, int offset, int scale>
+    static inline void MixMonoScalar(float* mix_buffer, const T* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float s = frames[i];
+            s = (s - offset) * scale * gain.GetValue(i);
+            mix_buffer[2 * i]       += s * left_scale;
+            mix_buffer[2 * i + 1]   += s * right_scale;
+        }
+    }
+
+    /*
+     * Mixes stereo frames into the mix buffer with a gain ramp and a constant pan
+     */
+    template <typename T, int offset, int scale>
+    static inline void MixStereoScalar(float* mix_buffer, const T* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            float s1 = frames[2 * i];
+            float s2 = frames[2 * i + 1];
+            s1 = (s1 - offset) * scale * g;
+            s2 = (s2 - offset) * scale * g;
+            mix_buffer[2 * i]       += s1 * left_scale;
+            mix_buffer[2 * i + 1]   += s2 * right_scale;
+        }
+    }
+
+    /*
+     * Adds a mix buffer to another, with the gain ramp clamped to [0,1]
+     */
+    static inline void MixBufferScalar(float* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            g = g < 0.0f ? 0.0f : (g > 1.0f ? 1.0f : g);
+            out[2 * i]      += in[2 * i] * g;
+            out[2 * i + 1]  += in[2 * i + 1] * g;
+        }
+    }
+
+    /*
+     * Applies the gain ramp and converts the mix buffer to 16 bit output, with clipping
+     */
+    static inline void ConvertToS16Scalar(int16_t* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            float s1 = in[2 * i] * g;
+            float s2 = in[2 * i + 1] * g;
+            s1 = s1 < 32767.0f ? s1 : 32767.0f;
+            s1 = s1 > -32768.0f ? s1 : -32768.0f;
+            s2 = s2 < 32767.0f ? s2 : 32767.0f;
+            s2 = s2 > -32768.0f ? s2 : -32768.0f;
+            out[2 * i] = (int16_t) s1;
+            out[2 * i + 1] = (int16_t) s2;
+        }
+    }
+
+    /*
+     * Sum of squares and max square per channel, for the group rms/peak meters
+     */
+    static inline void SumSquaresScalar(const float* in, uint32_t count, float gain, float* sum_sq, float* max_sq)
+    {
+        float sum_l = 0, sum_r = 0, max_l = 0, max_r = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float left = in[2 * i] * gain;
+            float right = in[2 * i + 1] * gain;
+            float left_sq = left * left;
+            float right_sq = right * right;
+            sum_l += left_sq;
+            sum_r += right_sq;
+            max_l = max_l > left_sq ? max_l : left_sq;
+            max_r = max_r > right_sq ? max_r : right_sq;
+        }
+        sum_sq[0] = sum_l;
+        sum_sq[1] = sum_r;
+        max_sq[0] = max_l;
+        max_sq[1] = max_r;
+    }
+
+    template <typename T, int offset, int scale>
+    static inline void MixMono(float* mix_buffer, const T* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        MixMonoScalar<T, offset, scale>(mix_buffer, frames, count, gain, left_scale, right_scale);
+    }
+
+    template <typename T, int offset, int scale>
+    static inline void MixStereo(float* mix_buffer, const T* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        MixStereoScalar<T, offset, scale>(mix_buffer, frames, count, gain, left_scale, right_scale);
+    }
+
+#if defined(DM_SOUND_MIX_SSE2)
+
+    // Gains for frames i..i+3
+    static inline __m128 MixRampValues(const MixRamp& gain, uint32_t i)
+    {
+        __m128 index = _mm_add_ps(_mm_set1_ps((float) i), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+        __m128 mix = _mm_mul_ps(index, _mm_set1_ps(gain.m_Recip));
+        return _mm_add_ps(_mm_set1_ps(gain.m_From), _mm_mul_ps(mix, _mm_set1_ps(gain.m_To - gain.m_From)));
+    }
+
+    template <>
+    inline void MixMono<int16_t, 0, 1>(float* mix_buffer, const int16_t* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        const __m128 vleft = _mm_set1_ps(left_scale);
+        const __m128 vright = _mm_set1_ps(right_scale);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i s16 = _mm_loadl_epi64((const __m128i*) (frames + i));
+            __m128 s = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+            s = _mm_mul_ps(s, MixRampValues(gain, i));
+            __m128 l = _mm_mul_ps(s, vleft);
+            __m128 r = _mm_mul_ps(s, vright);
+            float* out = mix_buffer + 2 * i;
+            _mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_unpacklo_ps(l, r)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(l, r)));
+        }
+        for (; i < count; i++)
+        {
+            float s = frames[i] * gain.GetValue(i);
+            mix_buffer[2 * i]       += s * left_scale;
+            mix_buffer[2 * i + 1]   += s * right_scale;
+        }
+    }
+
+    template <>
+    inline void MixStereo<int16_t, 0, 1>(float* mix_buffer, const int16_t* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        const __m128 vscale = _mm_setr_ps(left_scale, right_scale, left_scale, right_scale);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i s16 = _mm_loadu_si128((const __m128i*) (frames + 2 * i));
+            __m128 s_lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16));
+            __m128 s_hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16));
+            __m128 g = MixRampValues(gain, i);
+            s_lo = _mm_mul_ps(s_lo, _mm_unpacklo_ps(g, g));
+            s_hi = _mm_mul_ps(s_hi, _mm_unpackhi_ps(g, g));
+            float* out = mix_buffer + 2 * i;
+            _mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_mul_ps(s_lo, vscale)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(s_hi, vscale)));
+        }
+        for (; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            mix_buffer[2 * i]       += (frames[2 * i] * g) * left_scale;
+            mix_buffer[2 * i + 1]   += (frames[2 * i + 1] * g) * right_scale;
+        }
+    }
+
+    static inline void MixBuffer(float* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 g = _mm_min_ps(_mm_max_ps(MixRampValues(gain, i), zero), one);
+            _mm_storeu_ps(out + 2 * i,     _mm_add_ps(_mm_loadu_ps(out + 2 * i),     _mm_mul_ps(_mm_loadu_ps(in + 2 * i),     _mm_unpacklo_ps(g, g))));
+            _mm_storeu_ps(out + 2 * i + 4, _mm_add_ps(_mm_loadu_ps(out + 2 * i + 4), _mm_mul_ps(_mm_loadu_ps(in + 2 * i + 4), _mm_unpackhi_ps(g, g))));
+        }
+        for (; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            g = g < 0.0f ? 0.0f : (g > 1.0f ? 1.0f : g);
+            out[2 * i]      += in[2 * i] * g;
+            out[2 * i + 1]  += in[2 * i + 1] * g;
+        }
+    }
+
+    static inline void ConvertToS16(int16_t* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        const __m128 max = _mm_set1_ps(32767.0f);
+        const __m128 min = _mm_set1_ps(-32768.0f);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 g = MixRampValues(gain, i);
+            __m128 s_lo = _mm_mul_ps(_mm_loadu_ps(in + 2 * i),     _mm_unpacklo_ps(g, g));
+            __m128 s_hi = _mm_mul_ps(_mm_loadu_ps(in + 2 * i + 4), _mm_unpackhi_ps(g, g));
+            s_lo = _mm_max_ps(_mm_min_ps(s_lo, max), min);
+            s_hi = _mm_max_ps(_mm_min_ps(s_hi, max), min);
+            __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(s_lo), _mm_cvttps_epi32(s_hi));
+            _mm_storeu_si128((__m128i*) (out + 2 * i), packed);
+        }
+        for (; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            float s1 = in[2 * i] * g;
+            float s2 = in[2 * i + 1] * g;
+            s1 = s1 < 32767.0f ? s1 : 32767.0f;
+            s1 = s1 > -32768.0f ? s1 : -32768.0f;
+            s2 = s2 < 32767.0f ? s2 : 32767.0f;
+            s2 = s2 > -32768.0f ? s2 : -32768.0f;
+            out[2 * i] = (int16_t) s1;
+            out[2 * i + 1] = (int16_t) s2;
+        }
+    }
+
+    static inline void SumSquares(const float* in, uint32_t count, float gain, float* sum_sq, float* max_sq)
+    {
+        const __m128 vgain = _mm_set1_ps(gain);
+        __m128 sum = _mm_setzero_ps();
+        __m128 peak = _mm_setzero_ps();
+        uint32_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128 s = _mm_mul_ps(_mm_loadu_ps(in + 2 * i), vgain);
+            __m128 sq = _mm_mul_ps(s, s);
+            sum = _mm_add_ps(sum, sq);
+            peak = _mm_max_ps(peak, sq);
+        }
+        float sums[4], peaks[4];
+        _mm_storeu_ps(sums, sum);
+        _mm_storeu_ps(peaks, peak);
+
+        float tail_sum[2], tail_max[2];
+        SumSquaresScalar(in + 2 * i, count - i, gain, tail_sum, tail_max);
+        sum_sq[0] = sums[0] + sums[2] + tail_sum[0];
+        sum_sq[1] = sums[1] + sums[3] + tail_sum[1];
+        max_sq[0] = dmMath::Max(dmMath::Max(peaks[0], peaks[2]), tail_max[0]);
+        max_sq[1] = dmMath::Max(dmMath::Max(peaks[1], peaks[3]), tail_max[1]);
+    }
+
+#elif defined(DM_SOUND_MIX_NEON)
+
+    // Gains for frames i..i+3
+    static inline float32x4_t MixRampValues(const MixRamp& gain, uint32_t i)
+    {
+        static const float offsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+        float32x4_t index = vaddq_f32(vdupq_n_f32((float) i), vld1q_f32(offsets));
+        float32x4_t mix = vmulq_f32(index, vdupq_n_f32(gain.m_Recip));
+        return vaddq_f32(vdupq_n_f32(gain.m_From), vmulq_f32(mix, vdupq_n_f32(gain.m_To - gain.m_From)));
+    }
+
+    template <>
+    inline void MixMono<int16_t, 0, 1>(float* mix_buffer, const int16_t* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        const float32x4_t vleft = vdupq_n_f32(left_scale);
+        const float32x4_t vright = vdupq_n_f32(right_scale);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t s = vcvtq_f32_s32(vmovl_s16(vld1_s16(frames + i)));
+            s = vmulq_f32(s, MixRampValues(gain, i));
+            float32x4x2_t lr = vzipq_f32(vmulq_f32(s, vleft), vmulq_f32(s, vright));
+            float* out = mix_buffer + 2 * i;
+            vst1q_f32(out,     vaddq_f32(vld1q_f32(out),     lr.val[0]));
+            vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), lr.val[1]));
+        }
+        for (; i < count; i++)
+        {
+            float s = frames[i] * gain.GetValue(i);
+            mix_buffer[2 * i]       += s * left_scale;
+            mix_buffer[2 * i + 1]   += s * right_scale;
+        }
+    }
+
+    template <>
+    inline void MixStereo<int16_t, 0, 1>(float* mix_buffer, const int16_t* frames, uint32_t count, const MixRamp& gain, float left_scale, float right_scale)
+    {
+        const float scales[4] = {left_scale, right_scale, left_scale, right_scale};
+        const float32x4_t vscale = vld1q_f32(scales);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            int16x8_t s16 = vld1q_s16(frames + 2 * i);
+            float32x4_t s_lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16)));
+            float32x4_t s_hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16)));
+            float32x4_t g = MixRampValues(gain, i);
+            float32x4x2_t gg = vzipq_f32(g, g);
+            s_lo = vmulq_f32(s_lo, gg.val[0]);
+            s_hi = vmulq_f32(s_hi, gg.val[1]);
+            float* out = mix_buffer + 2 * i;
+            vst1q_f32(out,     vaddq_f32(vld1q_f32(out),     vmulq_f32(s_lo, vscale)));
+            vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), vmulq_f32(s_hi, vscale)));
+        }
+        for (; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            mix_buffer[2 * i]       += (frames[2 * i] * g) * left_scale;
+            mix_buffer[2 * i + 1]   += (frames[2 * i + 1] * g) * right_scale;
+        }
+    }
+
+    static inline void MixBuffer(float* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t g = vminq_f32(vmaxq_f32(MixRampValues(gain, i), zero), one);
+            float32x4x2_t gg = vzipq_f32(g, g);
+            vst1q_f32(out + 2 * i,     vaddq_f32(vld1q_f32(out + 2 * i),     vmulq_f32(vld1q_f32(in + 2 * i),     gg.val[0])));
+            vst1q_f32(out + 2 * i + 4, vaddq_f32(vld1q_f32(out + 2 * i + 4), vmulq_f32(vld1q_f32(in + 2 * i + 4), gg.val[1])));
+        }
+        for (; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            g = g < 0.0f ? 0.0f : (g > 1.0f ? 1.0f : g);
+            out[2 * i]      += in[2 * i] * g;
+            out[2 * i + 1]  += in[2 * i + 1] * g;
+        }
+    }
+
+    static inline void ConvertToS16(int16_t* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        const float32x4_t max = vdupq_n_f32(32767.0f);
+        const float32x4_t min = vdupq_n_f32(-32768.0f);
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t g = MixRampValues(gain, i);
+            float32x4x2_t gg = vzipq_f32(g, g);
+            float32x4_t s_lo = vmulq_f32(vld1q_f32(in + 2 * i),     gg.val[0]);
+            float32x4_t s_hi = vmulq_f32(vld1q_f32(in + 2 * i + 4), gg.val[1]);
+            s_lo = vmaxq_f32(vminq_f32(s_lo, max), min);
+            s_hi = vmaxq_f32(vminq_f32(s_hi, max), min);
+            int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(s_lo)), vqmovn_s32(vcvtq_s32_f32(s_hi)));
+            vst1q_s16(out + 2 * i, packed);
+        }
+        for (; i < count; i++)
+        {
+            float g = gain.GetValue(i);
+            float s1 = in[2 * i] * g;
+            float s2 = in[2 * i + 1] * g;
+            s1 = s1 < 32767.0f ? s1 : 32767.0f;
+            s1 = s1 > -32768.0f ? s1 : -32768.0f;
+            s2 = s2 < 32767.0f ? s2 : 32767.0f;
+            s2 = s2 > -32768.0f ? s2 : -32768.0f;
+            out[2 * i] = (int16_t) s1;
+            out[2 * i + 1] = (int16_t) s2;
+        }
+    }
+
+    static inline void SumSquares(const float* in, uint32_t count, float gain, float* sum_sq, float* max_sq)
+    {
+        const float32x4_t vgain = vdupq_n_f32(gain);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        float32x4_t peak = vdupq_n_f32(0.0f);
+        uint32_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            float32x4_t s = vmulq_f32(vld1q_f32(in + 2 * i), vgain);
+            float32x4_t sq = vmulq_f32(s, s);
+            sum = vaddq_f32(sum, sq);
+            peak = vmaxq_f32(peak, sq);
+        }
+        float sums[4], peaks[4];
+        vst1q_f32(sums, sum);
+        vst1q_f32(peaks, peak);
+
+        float tail_sum[2], tail_max[2];
+        SumSquaresScalar(in + 2 * i, count - i, gain, tail_sum, tail_max);
+        sum_sq[0] = sums[0] + sums[2] + tail_sum[0];
+        sum_sq[1] = sums[1] + sums[3] + tail_sum[1];
+        max_sq[0] = dmMath::Max(dmMath::Max(peaks[0], peaks[2]), tail_max[0]);
+        max_sq[1] = dmMath::Max(dmMath::Max(peaks[1], peaks[3]), tail_max[1]);
+    }
+
+#else
+
+    static inline void MixBuffer(float* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        MixBufferScalar(out, in, count, gain);
+    }
+
+    static inline void ConvertToS16(int16_t* out, const float* in, uint32_t count, const MixRamp& gain)
+    {
+        ConvertToS16Scalar(out, in, count, gain);
+    }
+
+    static inline void SumSquares(const float* in, uint32_t count, float gain, float* sum_sq, float* max_sq)
+    {
+        SumSquaresScalar(in, count, gain, sum_sq, max_sq);
+    }
+
+#endif
+}
+
+#endif // DM_SOUND_MIX_H
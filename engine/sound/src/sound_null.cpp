@@ -73,6 +73,14 @@ namespace dmSound
         return result;
     }
 
+    Result NewSoundDataStreaming(FSoundDataGetData cbk, FSoundDataDeleteContext delete_cbk, void* cbk_ctx, const void* preload_buffer, uint32_t preload_size, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        if (delete_cbk)
+            delete_cbk(cbk_ctx);
+        // Nothing is ever decoded, so we only keep the preloaded part
+        return NewSoundData(preload_buffer, preload_size, type, sound_data, name);
+    }
+
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
         if (sound_data->m_Buffer != 0x0)
@@ -96,6 +104,29 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result GetSoundData(HSoundData sound_data, void* out, uint32_t size, uint32_t offset, uint32_t* nread)
+    {
+        *nread = 0;
+        if (offset >= sound_data->m_BufferSize)
+            return RESULT_OK;
+        if (size > sound_data->m_BufferSize - offset)
+            size = sound_data->m_BufferSize - offset;
+        memcpy(out, sound_data->m_Buffer + offset, size);
+        *nread = size;
+        return RESULT_OK;
+    }
+
+    uint32_t GetSoundDataSize(HSoundData sound_data)
+    {
+        return sound_data->m_BufferSize;
+    }
+
+    const void* GetResidentSoundData(HSoundData sound_data, uint32_t* size)
+    {
+        *size = sound_data->m_BufferSize;
+        return sound_data->m_Buffer;
+    }
+
     Result NewSoundInstance(HSoundData sound_data, HSoundInstance* sound_instance)
     {
         SoundInstance* si = new SoundInstance();
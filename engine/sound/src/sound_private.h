@@ -31,6 +31,7 @@ namespace dmSound
     // Unit tests
     int64_t GetInternalPos(HSoundInstance);
     int32_t GetRefCount(HSoundData);
+    bool IsPcmCached(HSoundData);
 }
 
 #endif // #ifndef DM_SOUND_PRIVATE_H
@@ -19,6 +19,7 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dlib/array.h>
+#include <dlib/atomic.h>
 #include <dlib/hash.h>
 #include <dlib/message.h>
 #include <dlib/log.h>
@@ -27,6 +28,7 @@
 #include "../sound.h"
 #include "../sound_private.h"
 #include "../sound_codec.h"
+#include "../sound_mix.h"
 #include "../stb_vorbis/stb_vorbis.h"
 
 #include "test/mono_tone_440_22050_44100.wav.embed.h"
@@ -271,6 +273,100 @@ class dmSoundVerifyOggTest : public dmSoundTest
 {
 };
 
+class dmSoundVerifyOggCacheTest : public dmSoundTest
+{
+public:
+    virtual void SetUp()
+    {
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_UseThread = false;
+        params.m_PcmCacheSize = 4 * 1024 * 1024;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+};
+
+class dmSoundVerifyOggCacheThreadTest : public dmSoundTest
+{
+public:
+    virtual void SetUp()
+    {
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_UseThread = true;
+        params.m_PcmCacheSize = 4 * 1024 * 1024;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+};
+
+class dmSoundVerifyOggCacheSmallTest : public dmSoundTest
+{
+public:
+    virtual void SetUp()
+    {
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_UseThread = false;
+        params.m_PcmCacheSize = 16 * 1024;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+};
+
+class dmSoundVerifyOggStreamTest : public dmSoundTest
+{
+public:
+    virtual void SetUp()
+    {
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_UseThread = false;
+        params.m_StreamEnabled = true;
+        params.m_StreamChunkSize = 4096;
+        params.m_StreamPreloadSize = 4096;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+};
+
+class dmSoundVerifyOggStreamThreadTest : public dmSoundTest
+{
+public:
+    virtual void SetUp()
+    {
+        dmSound::InitializeParams params;
+        params.m_MaxBuffers = MAX_BUFFERS;
+        params.m_MaxSources = MAX_SOURCES;
+        params.m_OutputDevice = m_DeviceName;
+        params.m_FrameCount = GetParam().m_BufferFrameCount;
+        params.m_UseThread = true;
+        params.m_StreamEnabled = true;
+        params.m_StreamChunkSize = 4096;
+        params.m_StreamPreloadSize = 4096;
+
+        dmSound::Result r = dmSound::Initialize(0, &params);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+};
+
 class dmSoundTestPlayTest : public dmSoundTest
 {
 };
@@ -1115,6 +1211,279 @@ const TestParams params_verify_ogg_test[] = {TestParams("loopback",
                                             35200,
                                             2048)};
 INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggTest, dmSoundVerifyOggTest, jc_test_values_in(params_verify_ogg_test));
+
+TEST_P(dmSoundVerifyOggCacheTest, Mix)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+    dmSound::HSoundData sd = 0;
+    dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234);
+    ASSERT_FALSE(dmSound::IsPcmCached(sd));
+
+    for (int i = 0; i < 2; ++i)
+    {
+        dmSound::HSoundInstance instance = 0;
+        r = dmSound::NewSoundInstance(sd, &instance);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        ASSERT_NE((dmSound::HSoundInstance) 0, instance);
+        ASSERT_TRUE(dmSound::IsPcmCached(sd));
+
+        r = dmSound::Play(instance);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        do {
+            r = dmSound::Update();
+            ASSERT_EQ(dmSound::RESULT_OK, r);
+        } while (dmSound::IsPlaying(instance));
+
+        // A cached sound is played from the decoded wav stream
+        ASSERT_LT(0, dmSound::GetInternalPos(instance));
+
+        r = dmSound::DeleteSoundInstance(instance);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+
+    // Still cached when no instance is using it
+    ASSERT_TRUE(dmSound::IsPcmCached(sd));
+
+    // Replacing the data drops the cached sound, but the playing instance keeps its copy
+    dmSound::HSoundInstance instance = 0;
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::Update();
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    r = dmSound::SetSoundData(sd, params.m_Sound, params.m_SoundSize);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_FALSE(dmSound::IsPcmCached(sd));
+
+    do {
+        r = dmSound::Update();
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    } while (dmSound::IsPlaying(instance));
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+}
+
+INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggCacheTest, dmSoundVerifyOggCacheTest, jc_test_values_in(params_verify_ogg_test));
+
+TEST_P(dmSoundVerifyOggCacheThreadTest, DecodeInBackground)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+    dmSound::HSoundData sd = 0;
+    dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234);
+
+    // The first instance decodes the compressed data while the worker thread fills the cache
+    dmSound::HSoundInstance instance = 0;
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    for (int i = 0; i < 2000 && !dmSound::IsPcmCached(sd); ++i)
+    {
+        dmTime::Sleep(1000);
+    }
+    ASSERT_TRUE(dmSound::IsPcmCached(sd));
+
+    r = dmSound::Stop(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    // The cached sound stays alive for the instance after the data is replaced and released
+    r = dmSound::SetSoundData(sd, params.m_Sound, params.m_SoundSize);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_FALSE(dmSound::IsPcmCached(sd));
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    dmTime::Sleep(20000);
+
+    r = dmSound::Stop(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+}
+
+INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggCacheThreadTest, dmSoundVerifyOggCacheThreadTest, jc_test_values_in(params_verify_ogg_test));
+
+TEST_P(dmSoundVerifyOggCacheSmallTest, Rejected)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+    dmSound::HSoundData sd = 0;
+    dmSound::NewSoundData(params.m_Sound, params.m_SoundSize, params.m_Type, &sd, 1234);
+
+    // Larger than a quarter of the budget, which is known before decoding
+    for (int i = 0; i < 2; ++i)
+    {
+        dmSound::HSoundInstance instance = 0;
+        r = dmSound::NewSoundInstance(sd, &instance);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        ASSERT_FALSE(dmSound::IsPcmCached(sd));
+
+        r = dmSound::Play(instance);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+        do {
+            r = dmSound::Update();
+            ASSERT_EQ(dmSound::RESULT_OK, r);
+        } while (dmSound::IsPlaying(instance));
+        ASSERT_LT(0, dmSound::GetInternalPos(instance));
+
+        r = dmSound::DeleteSoundInstance(instance);
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    }
+
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+}
+
+INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggCacheSmallTest, dmSoundVerifyOggCacheSmallTest, jc_test_values_in(params_verify_ogg_test));
+
+struct StreamReadContext
+{
+    const uint8_t* m_Data;
+    uint32_t       m_Size;
+    int32_atomic_t m_NumReads;
+    int32_atomic_t m_NumDeletes;
+};
+
+static dmSound::Result StreamRead(void* context, uint32_t offset, uint32_t size, void* out, uint32_t* nread)
+{
+    StreamReadContext* ctx = (StreamReadContext*) context;
+    dmAtomicIncrement32(&ctx->m_NumReads);
+    *nread = 0;
+    if (offset < ctx->m_Size)
+    {
+        *nread = dmMath::Min(size, ctx->m_Size - offset);
+        memcpy(out, ctx->m_Data + offset, *nread);
+    }
+    return dmSound::RESULT_OK;
+}
+
+static void StreamDelete(void* context)
+{
+    StreamReadContext* ctx = (StreamReadContext*) context;
+    dmAtomicIncrement32(&ctx->m_NumDeletes);
+}
+
+TEST_P(dmSoundVerifyOggStreamTest, Mix)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+
+    StreamReadContext ctx;
+    ctx.m_Data = (const uint8_t*) params.m_Sound;
+    ctx.m_Size = params.m_SoundSize;
+    ctx.m_NumReads = 0;
+    ctx.m_NumDeletes = 0;
+
+    // Only pass the first part of the file, the rest must be read through the callback
+    const uint32_t preload_size = 4096;
+    dmSound::HSoundData sd = 0;
+    r = dmSound::NewSoundDataStreaming(StreamRead, StreamDelete, &ctx, params.m_Sound, preload_size, params.m_SoundSize, params.m_Type, &sd, 1234);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_EQ(params.m_SoundSize, dmSound::GetSoundDataSize(sd));
+
+    uint32_t resident_size = 0;
+    ASSERT_EQ((const void*) 0, dmSound::GetResidentSoundData(sd, &resident_size));
+
+    // Reads across the resident part and the streamed chunks
+    uint8_t buffer[6000];
+    uint32_t nread = 0;
+    r = dmSound::GetSoundData(sd, buffer, sizeof(buffer), 1000, &nread);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_EQ((uint32_t) sizeof(buffer), nread);
+    ASSERT_EQ(0, memcmp(buffer, ctx.m_Data + 1000, sizeof(buffer)));
+
+    r = dmSound::GetSoundData(sd, buffer, sizeof(buffer), params.m_SoundSize, &nread);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_EQ(0U, nread);
+
+    dmSound::HSoundInstance instance = 0;
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_NE((dmSound::HSoundInstance) 0, instance);
+
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    do {
+        r = dmSound::Update();
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+    } while (dmSound::IsPlaying(instance));
+
+    ASSERT_LT(0, dmSound::GetInternalPos(instance));
+    ASSERT_LE((int32_t) (params.m_SoundSize / 4096), dmAtomicGet32(&ctx.m_NumReads));
+
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    ASSERT_EQ(0, dmAtomicGet32(&ctx.m_NumDeletes));
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_EQ(1, dmAtomicGet32(&ctx.m_NumDeletes));
+}
+
+INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggStreamTest, dmSoundVerifyOggStreamTest, jc_test_values_in(params_verify_ogg_test));
+
+TEST_P(dmSoundVerifyOggStreamThreadTest, DeleteWhilePlaying)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+
+    StreamReadContext ctx;
+    ctx.m_Data = (const uint8_t*) params.m_Sound;
+    ctx.m_Size = params.m_SoundSize;
+    ctx.m_NumReads = 0;
+    ctx.m_NumDeletes = 0;
+
+    dmSound::HSoundData sd = 0;
+    r = dmSound::NewSoundDataStreaming(StreamRead, StreamDelete, &ctx, params.m_Sound, 4096, params.m_SoundSize, params.m_Type, &sd, 1234);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    dmSound::HSoundInstance instance = 0;
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    // Wait for the sound and stream threads to read a few chunks
+    for (int i = 0; i < 2000 && dmAtomicGet32(&ctx.m_NumReads) < 3; ++i)
+    {
+        dmTime::Sleep(1000);
+    }
+    ASSERT_LE(3, dmAtomicGet32(&ctx.m_NumReads));
+
+    // The resource releases the sound data while the instance is still playing it
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    ASSERT_EQ(0, dmAtomicGet32(&ctx.m_NumDeletes));
+
+    r = dmSound::Stop(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    // A read in flight on the stream thread keeps the context until it's done
+    for (int i = 0; i < 2000 && dmAtomicGet32(&ctx.m_NumDeletes) == 0; ++i)
+    {
+        dmTime::Sleep(1000);
+    }
+    ASSERT_EQ(1, dmAtomicGet32(&ctx.m_NumDeletes));
+}
+
+INSTANTIATE_TEST_CASE_P(dmSoundVerifyOggStreamThreadTest, dmSoundVerifyOggStreamThreadTest, jc_test_values_in(params_verify_ogg_test));
 #endif
 
 #if !defined(GITHUB_CI) || (defined(GITHUB_CI) && !(defined(WIN32) || defined(__MACH__)))
@@ -1610,6 +1979,101 @@ const TestParams2 params_mixer_test[] = {
 INSTANTIATE_TEST_CASE_P(dmSoundMixerTest, dmSoundMixerTest, jc_test_values_in(params_mixer_test));
 #endif
 
+// The vectorized mix kernels must produce the same results as the scalar reference versions
+static const uint32_t MIX_KERNEL_FRAMES = 1027; // not a multiple of the vector width, to exercise the tails
+
+static void FillRandomMixBuffer(float* buffer, uint32_t frame_count, float range)
+{
+    for (uint32_t i = 0; i < frame_count * 2; ++i)
+    {
+        buffer[i] = (rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+    }
+}
+
+static dmSound::MixRamp MakeMixRamp(float from, float to, uint32_t count)
+{
+    dmSound::MixRamp ramp;
+    ramp.m_From = from;
+    ramp.m_To = to;
+    ramp.m_Recip = 1.0f / count;
+    return ramp;
+}
+
+TEST(dmSoundMixKernels, MixMonoStereo)
+{
+    srand(17);
+    int16_t frames[MIX_KERNEL_FRAMES * 2];
+    for (uint32_t i = 0; i < MIX_KERNEL_FRAMES * 2; ++i)
+        frames[i] = (int16_t) (rand() % 65536 - 32768);
+
+    float expected[MIX_KERNEL_FRAMES * 2];
+    float actual[MIX_KERNEL_FRAMES * 2];
+    FillRandomMixBuffer(expected, MIX_KERNEL_FRAMES, 1000.0f);
+    memcpy(actual, expected, sizeof(expected));
+
+    dmSound::MixRamp gain = MakeMixRamp(0.2f, 0.9f, MIX_KERNEL_FRAMES);
+    dmSound::MixMonoScalar<int16_t, 0, 1>(expected, frames, MIX_KERNEL_FRAMES, gain, 0.8f, 0.6f);
+    dmSound::MixMono<int16_t, 0, 1>(actual, frames, MIX_KERNEL_FRAMES, gain, 0.8f, 0.6f);
+    for (uint32_t i = 0; i < MIX_KERNEL_FRAMES * 2; ++i)
+        ASSERT_NEAR(expected[i], actual[i], 0.01f);
+
+    dmSound::MixStereoScalar<int16_t, 0, 1>(expected, frames, MIX_KERNEL_FRAMES, gain, 0.8f, 0.6f);
+    dmSound::MixStereo<int16_t, 0, 1>(actual, frames, MIX_KERNEL_FRAMES, gain, 0.8f, 0.6f);
+    for (uint32_t i = 0; i < MIX_KERNEL_FRAMES * 2; ++i)
+        ASSERT_NEAR(expected[i], actual[i], 0.01f);
+}
+
+TEST(dmSoundMixKernels, MixBuffer)
+{
+    srand(17);
+    float in[MIX_KERNEL_FRAMES * 2];
+    float expected[MIX_KERNEL_FRAMES * 2];
+    float actual[MIX_KERNEL_FRAMES * 2];
+    FillRandomMixBuffer(in, MIX_KERNEL_FRAMES, 32768.0f);
+    FillRandomMixBuffer(expected, MIX_KERNEL_FRAMES, 32768.0f);
+    memcpy(actual, expected, sizeof(expected));
+
+    // Ramp outside [0,1] to verify the clamping
+    dmSound::MixRamp gain = MakeMixRamp(-0.5f, 1.5f, MIX_KERNEL_FRAMES);
+    dmSound::MixBufferScalar(expected, in, MIX_KERNEL_FRAMES, gain);
+    dmSound::MixBuffer(actual, in, MIX_KERNEL_FRAMES, gain);
+    for (uint32_t i = 0; i < MIX_KERNEL_FRAMES * 2; ++i)
+        ASSERT_EQ(expected[i], actual[i]);
+}
+
+TEST(dmSoundMixKernels, ConvertToS16)
+{
+    srand(17);
+    float in[MIX_KERNEL_FRAMES * 2];
+    FillRandomMixBuffer(in, MIX_KERNEL_FRAMES, 50000.0f); // exceeds the int16 range, to verify the clipping
+
+    int16_t expected[MIX_KERNEL_FRAMES * 2];
+    int16_t actual[MIX_KERNEL_FRAMES * 2];
+    dmSound::MixRamp gain = MakeMixRamp(0.5f, 1.0f, MIX_KERNEL_FRAMES);
+    dmSound::ConvertToS16Scalar(expected, in, MIX_KERNEL_FRAMES, gain);
+    dmSound::ConvertToS16(actual, in, MIX_KERNEL_FRAMES, gain);
+    for (uint32_t i = 0; i < MIX_KERNEL_FRAMES * 2; ++i)
+        ASSERT_EQ(expected[i], actual[i]);
+}
+
+TEST(dmSoundMixKernels, SumSquares)
+{
+    srand(17);
+    float in[MIX_KERNEL_FRAMES * 2];
+    FillRandomMixBuffer(in, MIX_KERNEL_FRAMES, 32768.0f);
+
+    float expected_sum[2], expected_max[2];
+    float actual_sum[2], actual_max[2];
+    dmSound::SumSquaresScalar(in, MIX_KERNEL_FRAMES, 0.7f, expected_sum, expected_max);
+    dmSound::SumSquares(in, MIX_KERNEL_FRAMES, 0.7f, actual_sum, actual_max);
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        // The vectorized sum accumulates in a different order
+        ASSERT_NEAR(expected_sum[c], actual_sum[c], expected_sum[c] * 0.0001f);
+        ASSERT_EQ(expected_max[c], actual_max[c]);
+    }
+}
+
 DM_DECLARE_SOUND_DEVICE(LoopBackDevice, "loopback", DeviceLoopbackOpen, DeviceLoopbackClose, DeviceLoopbackQueue, DeviceLoopbackFreeBufferSlots, DeviceLoopbackDeviceInfo, DeviceLoopbackRestart, DeviceLoopbackStop);
 
 extern "C" void dmExportedSymbols();
@@ -45,12 +45,15 @@ public:
 
     virtual void SetUp()
     {
-
+        // The decoders read through the sound data api. No output device is needed
+        dmSound::InitializeParams params;
+        params.m_UseThread = false;
+        dmSound::Initialize(0, &params);
     }
 
     virtual void TearDown()
     {
-
+        dmSound::Finalize();
     }
 
     char m_UnCache[4*1024*1024];
@@ -66,8 +69,11 @@ public:
         char tmp[4096];
         dmSoundCodec::HDecodeStream stream;
 
+        dmSound::HSoundData sound_data;
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(buf, size, dmSound::SOUND_DATA_TYPE_OGG_VORBIS, &sound_data, 0));
+
         const uint64_t time_beg = dmTime::GetTime();
-        ASSERT_EQ(decoder->m_OpenStream(buf, size, &stream), dmSoundCodec::RESULT_OK);
+        ASSERT_EQ(decoder->m_OpenStream(sound_data, &stream), dmSoundCodec::RESULT_OK);
         const uint64_t time_open = dmTime::GetTime();
 
         uint64_t max_chunk_time = 0;
@@ -114,6 +120,7 @@ public:
         printf(" | In %.1f kbps | Out: %.1f Kb/s\n", (float)size / (128.0f * audio_length), (float)bytes_per_second / 1024.0f);
 
         decoder->m_CloseStream(stream);
+        dmSound::DeleteSoundData(sound_data);
     }
 
     void RunSuite(const char *decoder_name, bool skip)
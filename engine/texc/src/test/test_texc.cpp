@@ -15,6 +15,7 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dlib/image.h>
+#include <dmsdk/dlib/atomic.h>
 #include <string.h> // memcmp
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -229,6 +230,39 @@ TEST_F(TexcTest, MipMaps)
     }
 }
 
+struct BatchTestContext
+{
+    int32_atomic_t m_Processed;
+    int32_atomic_t m_Running;
+    int32_atomic_t m_MaxRunning;
+};
+
+static bool BatchTestProcess(void* _ctx, uint32_t index)
+{
+    BatchTestContext* ctx = (BatchTestContext*)_ctx;
+    int32_t running = dmAtomicIncrement32(&ctx->m_Running) + 1;
+    int32_t max_running = dmAtomicGet32(&ctx->m_MaxRunning);
+    while (running > max_running && dmAtomicCompareStore32(&ctx->m_MaxRunning, running, max_running) != max_running)
+        max_running = dmAtomicGet32(&ctx->m_MaxRunning);
+    dmAtomicIncrement32(&ctx->m_Processed);
+    dmAtomicDecrement32(&ctx->m_Running);
+    return index != 7;
+}
+
+TEST_F(TexcTest, ProcessBatch)
+{
+    BatchTestContext ctx = {};
+    ASSERT_FALSE(dmTexc::ProcessBatch(16, BatchTestProcess, &ctx, 0, 0, 4));
+    ASSERT_EQ(16, dmAtomicGet32(&ctx.m_Processed));
+
+    // Each item needs all the memory, so they have to run one at a time
+    uint64_t memory_sizes[8] = {100, 100, 100, 100, 100, 100, 100, 100};
+    BatchTestContext serial_ctx = {};
+    ASSERT_TRUE(dmTexc::ProcessBatch(7, BatchTestProcess, &serial_ctx, memory_sizes, 100, 4));
+    ASSERT_EQ(7, dmAtomicGet32(&serial_ctx.m_Processed));
+    ASSERT_EQ(1, dmAtomicGet32(&serial_ctx.m_MaxRunning));
+}
+
 
 #define ASSERT_RGBA(exp, act)\
     ASSERT_EQ((exp)[0], (act)[0]);\
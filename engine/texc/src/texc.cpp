@@ -18,6 +18,10 @@
 #include "texc_enc_default.h"
 
 #include <assert.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include <dlib/log.h>
 #include <dlib/math.h>
@@ -49,6 +53,7 @@ namespace dmTexc
         }
 
         t->m_CompressionType = compression_type;
+        t->m_MaxThreads = 1;
         if (!t->m_Encoder.m_FnCreate(t, width, height, pixel_format, color_space, compression_type, data))
         {
             delete t;
@@ -126,6 +131,12 @@ namespace dmTexc
         return t->m_Encoder.m_FnPreMultiplyAlpha(t);
     }
 
+    void SetMaxThreads(HTexture texture, int max_threads)
+    {
+        Texture* t = (Texture*) texture;
+        t->m_MaxThreads = max_threads;
+    }
+
     bool GenMipMaps(HTexture texture)
     {
         Texture* t = (Texture*) texture;
@@ -143,20 +154,6 @@ namespace dmTexc
         return t->m_Encoder.m_FnFlip(t, flip_axis);
     }
 
-    static uint32_t GetNumThreads(int max_threads)
-    {
-        uint32_t num_threads = max_threads;
-        if (max_threads > 1)
-        {
-            num_threads = std::thread::hardware_concurrency();
-            if (num_threads < 1)
-                num_threads = 1;
-            if (num_threads > max_threads)
-                num_threads = max_threads;
-        }
-        return num_threads;
-    }
-
     bool Encode(HTexture texture, PixelFormat pixel_format, ColorSpace color_space,
                 CompressionLevel compression_level, CompressionType compression_type, bool mipmaps, int max_threads)
     {
@@ -166,6 +163,42 @@ namespace dmTexc
         return t->m_Encoder.m_FnEncode(t, num_threads, pixel_format, compression_type, compression_level);
     }
 
+    bool ProcessBatch(uint32_t count, FBatchProcess process, void* context, const uint64_t* memory_sizes, uint64_t max_memory, int max_threads)
+    {
+        std::mutex              mutex;
+        std::condition_variable memory_released;
+        uint64_t                memory  = 0;
+        uint32_t                running = 0;
+        std::atomic<bool>       result(true);
+
+        ParallelFor(count, GetNumThreads(max_threads), [&](uint32_t i)
+        {
+            uint64_t size = memory_sizes ? memory_sizes[i] : 0;
+            if (max_memory != 0)
+            {
+                // An item that is larger than the max memory is allowed to run on its own
+                std::unique_lock<std::mutex> lock(mutex);
+                memory_released.wait(lock, [&]() { return running == 0 || memory + size <= max_memory; });
+                memory += size;
+                running++;
+            }
+
+            if (!process(context, i))
+            {
+                result = false;
+            }
+
+            if (max_memory != 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                memory -= size;
+                running--;
+                memory_released.notify_all();
+            }
+        });
+        return result;
+    }
+
 #define DM_TEXC_TRAMPOLINE1(ret, name, t1) \
     ret TEXC_##name(t1 a1)\
     {\
@@ -223,9 +256,11 @@ namespace dmTexc
     DM_TEXC_TRAMPOLINE1(uint64_t, GetCompressionFlags, HTexture);
     DM_TEXC_TRAMPOLINE3(bool, Resize, HTexture, uint32_t, uint32_t);
     DM_TEXC_TRAMPOLINE1(bool, PreMultiplyAlpha, HTexture);
+    DM_TEXC_TRAMPOLINE2(void, SetMaxThreads, HTexture, int);
     DM_TEXC_TRAMPOLINE1(bool, GenMipMaps, HTexture);
     DM_TEXC_TRAMPOLINE2(bool, Flip, HTexture, FlipAxis);
     DM_TEXC_TRAMPOLINE7(bool, Encode, HTexture, PixelFormat, ColorSpace, CompressionLevel, CompressionType, bool, int);
+    DM_TEXC_TRAMPOLINE6(bool, ProcessBatch, uint32_t, FBatchProcess, void*, const uint64_t*, uint64_t, int);
     DM_TEXC_TRAMPOLINE2(HBuffer, CompressBuffer, void*, uint32_t);
     DM_TEXC_TRAMPOLINE1(uint32_t, GetTotalBufferDataSize, HBuffer);
     DM_TEXC_TRAMPOLINE3(uint32_t, GetBufferData, HBuffer, void*, uint32_t);
@@ -119,6 +119,11 @@ namespace dmTexc
      */
     typedef void* HBuffer;
 
+    /**
+     * Batch item callback, see ProcessBatch. Returns false if the item failed
+     */
+    typedef bool (*FBatchProcess)(void* context, uint32_t index);
+
     /**
      * Invalid texture handle
      */
@@ -177,6 +182,11 @@ namespace dmTexc
      * The texture must have format PF_R8G8B8A8 for the alpha to be pre-multiplied.
      */
     DM_TEXC_PROTO(bool, PreMultiplyAlpha, HTexture texture);
+    /**
+     * Set the max number of threads used when generating mip maps. The default is 1, so that callers that already
+     * run textures in parallel (e.g. Bob) don't get a thread per core for each texture. 0 and 1 run on the calling thread.
+     */
+    DM_TEXC_PROTO(void, SetMaxThreads, HTexture texture, int max_threads);
     /**
      * Generate mip maps.
      * The texture must have format PF_R8G8B8A8 for mip maps to be generated.
@@ -191,6 +201,14 @@ namespace dmTexc
      */
     DM_TEXC_PROTO(bool, Encode, HTexture texture, PixelFormat pixelFormat, ColorSpace color_space, CompressionLevel compressionLevel, CompressionType compression_type, bool mipmaps, int max_threads);
 
+    /**
+     * Calls process for each index in [0, count) on a pool of max_threads threads.
+     * memory_sizes (optional) holds the estimated memory each item needs. If max_memory isn't 0, items are only
+     * started while the running items fit in max_memory bytes. An item larger than max_memory runs on its own.
+     * Returns false if any item failed.
+     */
+    DM_TEXC_PROTO(bool, ProcessBatch, uint32_t count, FBatchProcess process, void* context, const uint64_t* memory_sizes, uint64_t max_memory, int max_threads);
+
     // Now only used for font glyphs
     // Compresses an image buffer
     DM_TEXC_PROTO(HBuffer, CompressBuffer, void* data, uint32_t size);
@@ -35,7 +35,8 @@ namespace dmTexc
         // static int image = 0;
         // ++image;
 
-        for (uint32_t i = 0; i < texture->m_Mips.Size(); ++i)
+        // The mip levels are converted independently of each other
+        ParallelFor(texture->m_Mips.Size(), num_threads, [&](uint32_t i)
         {
             TextureData* mip_level = &texture->m_Mips[i];
             uint32_t size = GetDataSize(pixel_format, mip_level->m_Width, mip_level->m_Height);
@@ -61,7 +62,7 @@ namespace dmTexc
             // printf("Wrote %s\n", name);
 
             delete[] old_data;
-        }
+        });
 
         return true;
     }
@@ -141,7 +142,8 @@ namespace dmTexc
         basisu::image origimage;
         origimage.init(mip0, width, height, 4);
 
-        int level = 0;
+        // Add the levels first, since each one is resampled from the original image they can then be generated in parallel
+        uint32_t first_level = texture->m_Mips.Size();
         while (width * height != 1)
         {
             width /= 2;
@@ -149,17 +151,21 @@ namespace dmTexc
             width = dmMath::Max(1U, width);
             height = dmMath::Max(1U, height);
 
-            uint8_t* mipmap = GenMipMapDefault(texture, level, origimage, width, height, texture->m_ColorSpace);
-            level++;
-
             TextureData mip_level;
             mip_level.m_Width = width;
             mip_level.m_Height = height;
-            mip_level.m_Data = mipmap;
+            mip_level.m_Data = 0;
             mip_level.m_ByteSize = width * height * 4;
             mip_level.m_IsCompressed = false;
             texture->m_Mips.Push(mip_level);
         }
+
+        uint32_t num_levels = texture->m_Mips.Size() - first_level;
+        ParallelFor(num_levels, GetNumThreads(texture->m_MaxThreads), [&](uint32_t level)
+        {
+            TextureData* mip_level = &texture->m_Mips[first_level + level];
+            mip_level->m_Data = GenMipMapDefault(texture, level, origimage, mip_level->m_Width, mip_level->m_Height, texture->m_ColorSpace);
+        });
         return true;
     }
 
@@ -19,8 +19,44 @@
 #include "texc_private.h"
 #include <dlib/log.h>
 
+#include <thread>
+
 namespace dmTexc
 {
+    uint32_t GetNumThreads(int max_threads)
+    {
+        uint32_t num_threads = max_threads;
+        if (max_threads > 1)
+        {
+            num_threads = std::thread::hardware_concurrency();
+            if (num_threads < 1)
+                num_threads = 1;
+            if (num_threads > (uint32_t)max_threads)
+                num_threads = max_threads;
+        }
+        return num_threads;
+    }
+
+    void ParallelFor(uint32_t count, uint32_t num_threads, const std::function<void(uint32_t)>& fn)
+    {
+        if (num_threads > count)
+            num_threads = count;
+
+        if (num_threads <= 1)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                fn(i);
+            return;
+        }
+
+        basisu::job_pool jpool(num_threads);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            jpool.add_job([&fn, i]() { fn(i); });
+        }
+        jpool.wait_for_all();
+    }
+
     void RGB565ToRGB888(const uint16_t* data, const uint32_t width, const uint32_t height, uint8_t* color_rgb)
     {
         for(uint32_t i = 0; i < width*height; ++i)
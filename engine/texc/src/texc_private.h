@@ -18,6 +18,7 @@
 #include <dlib/array.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <functional>
 #include "texc.h"
 
 #include <basis/encoder/basisu_enc.h>
@@ -64,6 +65,7 @@ namespace dmTexc
         uint32_t m_Width;
         uint32_t m_Height;
         uint64_t m_CompressionFlags;
+        int      m_MaxThreads; // Max number of threads used when generating mipmaps (1 by default), see SetMaxThreads
 
         Encoder m_Encoder;
 
@@ -101,6 +103,12 @@ namespace dmTexc
     void        DitherRGBx565(uint8_t* data, uint32_t width, uint32_t height);
 
     void        DebugPrint(uint8_t* p, uint32_t width, uint32_t height, uint32_t num_channels);
+
+    // Clamps max_threads to the number of cores. Values of 1 or less are returned as they are.
+    uint32_t    GetNumThreads(int max_threads);
+
+    // Calls fn(i) for each i in [0, count), spread over num_threads threads (including the calling thread)
+    void        ParallelFor(uint32_t count, uint32_t num_threads, const std::function<void(uint32_t)>& fn);
 }
 
 #endif // DM_TEXC_PRIVATE_H
@@ -12,6 +12,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <dlib/array.h>
 #include <dlib/dstrings.h>
 
 #include "texc/texc.h"
@@ -36,6 +37,9 @@ struct EncodeParams
 {
     const char*              m_PathIn;
     const char*              m_PathOut;
+    const char*              m_BatchPath;
+    int                      m_MaxThreads;
+    uint32_t                 m_MaxMemory; // In MB, 0 means no limit
     dmTexc::ColorSpace       m_ColorSpace;
     dmTexc::CompressionType  m_CompressionType;
     dmTexc::CompressionLevel m_CompressionLevel;
@@ -54,6 +58,8 @@ EncodeParams GetDefaultEncodeParams()
     params.m_ColorSpace       = dmTexc::CS_SRGB;
     params.m_CompressionType  = dmTexc::CT_DEFAULT;
     params.m_CompressionLevel = dmTexc::CL_NORMAL;
+    params.m_MaxThreads       = 4;
+    params.m_MaxMemory        = 0;
     return params;
 }
 
@@ -141,13 +147,21 @@ void PrintEncodeParams(EncodeParams params)
     printf("Flip-x            : %s\n", TRUE_FALSE_LABEL(params.m_FlipX));
     printf("Flip-y            : %s\n", TRUE_FALSE_LABEL(params.m_FlipY));
     printf("Mipmaps           : %s\n", TRUE_FALSE_LABEL(params.m_MipMaps));
+    printf("Max threads       : %d\n", params.m_MaxThreads);
 #undef TRUE_FALSE_LABEL
 }
 
 void GetEncodeParamsFromArgs(int argc, const char* argv[], EncodeParams& params)
 {
-    params.m_PathIn  = argc > 1 ? argv[1] : 0;
-    params.m_PathOut = argc > 2 ? argv[2] : 0;
+    if (argc > 1 && dmStrCaseCmp(argv[1], "--batch") == 0)
+    {
+        params.m_BatchPath = argc > 2 ? argv[2] : 0;
+    }
+    else
+    {
+        params.m_PathIn  = argc > 1 ? argv[1] : 0;
+        params.m_PathOut = argc > 2 ? argv[2] : 0;
+    }
 
     for (int i = 3; i < argc; ++i)
     {
@@ -173,6 +187,10 @@ void GetEncodeParamsFromArgs(int argc, const char* argv[], EncodeParams& params)
                 params.m_CompressionType = GetArgTypeValue(argv[++i], g_ct_lut, params.m_CompressionType);
             else if (CMP_ARG_1_OP("compression-level"))
                 params.m_CompressionLevel = GetArgTypeValue(argv[++i], g_cl_lut, params.m_CompressionLevel);
+            else if (CMP_ARG_1_OP("threads"))
+                params.m_MaxThreads = atoi(argv[++i]);
+            else if (CMP_ARG_1_OP("max-memory"))
+                params.m_MaxMemory = (uint32_t)atoi(argv[++i]);
 
             #undef CMP_ARG_1_OP
             #undef CMP_ARG
@@ -180,62 +198,170 @@ void GetEncodeParamsFromArgs(int argc, const char* argv[], EncodeParams& params)
     }
 }
 
-int DoEncode(EncodeParams params)
+static bool ProcessTexture(dmTexc::HTexture tex, const EncodeParams& params)
 {
-    int x,y,n;
-    unsigned char *data = stbi_load(params.m_PathIn, &x, &y, &n, 0);
-
-    dmTexc::HTexture tex = dmTexc::Create(params.m_PathIn, x, y,
-        GetPixelFormatFromChannels(n), params.m_ColorSpace, params.m_CompressionType, data);
+    dmTexc::SetMaxThreads(tex, params.m_MaxThreads);
 
     if (params.m_PremultiplyAlpha && !dmTexc::PreMultiplyAlpha(tex))
     {
         printf("Unable to premultiply alpha\n");
-        return -1;
+        return false;
     }
 
     if (params.m_FlipY && !dmTexc::Flip(tex, dmTexc::FLIP_AXIS_Y))
     {
         printf("Unable to flip Y\n");
-        return -1;
+        return false;
     }
 
     if (params.m_FlipX && !dmTexc::Flip(tex, dmTexc::FLIP_AXIS_X))
     {
-        printf("Unable to flip Y\n");
-        return -1;
+        printf("Unable to flip X\n");
+        return false;
     }
 
     // Note: For basis, the mipmaps are actually created when we encode, this call just requests that we want mipmaps later
     if (params.m_MipMaps && !dmTexc::GenMipMaps(tex))
     {
         printf("Unable to generate mipmaps\n");
-        return -1;
+        return false;
     }
 
     if (params.m_CompressionType != dmTexc::CT_DEFAULT &&
         !dmTexc::Encode(tex, dmTexc::PF_RGBA_BC3, params.m_ColorSpace,
-            params.m_CompressionLevel, params.m_CompressionType, params.m_MipMaps, 4))
+            params.m_CompressionLevel, params.m_CompressionType, params.m_MipMaps, params.m_MaxThreads))
     {
         printf("Unable to encode texture data\n");
+        return false;
+    }
+    return true;
+}
+
+int DoEncode(EncodeParams params)
+{
+    int x,y,n;
+    unsigned char *data = stbi_load(params.m_PathIn, &x, &y, &n, 0);
+    if (!data)
+    {
+        printf("Unable to load '%s'\n", params.m_PathIn);
+        return -1;
+    }
+
+    dmTexc::HTexture tex = dmTexc::Create(params.m_PathIn, x, y,
+        GetPixelFormatFromChannels(n), params.m_ColorSpace, params.m_CompressionType, data);
+    if (!tex)
+    {
+        printf("Unable to create texture from '%s'\n", params.m_PathIn);
+        stbi_image_free(data);
         return -1;
     }
 
-    uint32_t out_data_size = dmTexc::GetTotalDataSize(tex);
-    void* out_data         = malloc(out_data_size);
-    dmTexc::GetData(tex, out_data, out_data_size);
+    void* out_data         = 0;
+    uint32_t out_data_size = 0;
+    if (ProcessTexture(tex, params))
+    {
+        out_data_size = dmTexc::GetTotalDataSize(tex);
+        out_data      = malloc(out_data_size);
+        dmTexc::GetData(tex, out_data, out_data_size);
+    }
 
     dmTexc::Destroy(tex);
-
     stbi_image_free(data);
 
-    FILE* f = fopen(params.m_PathOut, "w");
+    if (!out_data)
+    {
+        return -1;
+    }
 
-    fwrite(out_data, out_data_size, 1, f);
-    fclose(f);
+    FILE* f = fopen(params.m_PathOut, "wb");
+    if (!f)
+    {
+        printf("Unable to open '%s' for writing\n", params.m_PathOut);
+        free(out_data);
+        return -1;
+    }
+
+    bool written = fwrite(out_data, 1, out_data_size, f) == out_data_size;
+    written = (fclose(f) == 0) && written;
+    free(out_data);
+    if (!written)
+    {
+        printf("Unable to write '%s'\n", params.m_PathOut);
+        return -1;
+    }
     return 0;
 }
 
+struct BatchContext
+{
+    dmArray<EncodeParams> m_Items;
+};
+
+static bool EncodeBatchItem(void* context, uint32_t index)
+{
+    BatchContext* batch = (BatchContext*)context;
+    const EncodeParams& item = batch->m_Items[index];
+    if (DoEncode(item) != 0)
+    {
+        printf("Failed to convert '%s' to '%s'\n", item.m_PathIn, item.m_PathOut);
+        return false;
+    }
+    return true;
+}
+
+// Each line in the batch file is "<input-file> <output-file>"
+int DoEncodeBatch(EncodeParams params)
+{
+    FILE* f = fopen(params.m_BatchPath, "r");
+    if (!f)
+    {
+        printf("Unable to open batch file '%s'\n", params.m_BatchPath);
+        return -1;
+    }
+
+    BatchContext batch;
+    dmArray<uint64_t> memory_sizes;
+    char line[2048];
+    while (fgets(line, sizeof(line), f))
+    {
+        char path_in[1024];
+        char path_out[1024];
+        if (sscanf(line, "%1023s %1023s", path_in, path_out) != 2)
+            continue;
+
+        EncodeParams item = params;
+        item.m_PathIn     = strdup(path_in);
+        item.m_PathOut    = strdup(path_out);
+        // The pool is already using the cores, so each texture is processed on a single thread
+        item.m_MaxThreads = 1;
+
+        // Source image, the RGBA copy and the encoded data are alive at the same time
+        int x = 0, y = 0, n = 0;
+        stbi_info(item.m_PathIn, &x, &y, &n);
+
+        if (batch.m_Items.Full())
+        {
+            batch.m_Items.OffsetCapacity(64);
+            memory_sizes.OffsetCapacity(64);
+        }
+        batch.m_Items.Push(item);
+        memory_sizes.Push((uint64_t)x * y * 4 * 3);
+    }
+    fclose(f);
+
+    PrintEncodeParams(params);
+
+    bool result = dmTexc::ProcessBatch(batch.m_Items.Size(), EncodeBatchItem, &batch,
+        memory_sizes.Begin(), (uint64_t)params.m_MaxMemory * 1024 * 1024, params.m_MaxThreads);
+
+    for (uint32_t i = 0; i < batch.m_Items.Size(); ++i)
+    {
+        free((void*)batch.m_Items[i].m_PathIn);
+        free((void*)batch.m_Items[i].m_PathOut);
+    }
+    return result ? 0 : -1;
+}
+
 void ShowHelp()
 {
 #define PRINT_ARG_LIST(lst) \
@@ -244,6 +370,8 @@ void ShowHelp()
             printf("    %s\n", lst[i].m_Name); \
     }
     printf("Usage: texconvert <input-file> <output-file> [options]\n");
+    printf("       texconvert --batch <batch-file> [options]\n");
+    printf("         Converts each '<input-file> <output-file>' line in the batch file, in parallel\n");
     printf("Options:\n");
     printf("  --premultiply-alpha         : Use premultiply alpha\n");
     printf("  --flip-x                    : Flip image on X axis\n");
@@ -256,6 +384,8 @@ void ShowHelp()
     PRINT_ARG_LIST(g_ct_lut);
     printf("  --compression-level <level> : Sets the compression level, defaults to 'NORMAL'. Supported values are:\n");
     PRINT_ARG_LIST(g_cl_lut);
+    printf("  --threads <count>           : Max number of threads, defaults to 4. Capped at the number of cores\n");
+    printf("  --max-memory <mb>           : Max estimated memory used by textures in flight in batch mode, defaults to no limit\n");
 #undef PRINT_ARG_LIST
 }
 
@@ -264,6 +394,11 @@ int main(int argc, char const *argv[])
     EncodeParams params = GetDefaultEncodeParams();
     GetEncodeParamsFromArgs(argc, argv, params);
 
+    if (params.m_BatchPath)
+    {
+        return DoEncodeBatch(params);
+    }
+
     if (!params.m_PathIn || !params.m_PathOut)
     {
         if (!params.m_PathIn)